@@ -697,6 +697,7 @@ static int agilent_82350b_generic_attach(struct gpib_board *board,
 		return -EIO;
 	}
 	a_priv->irq = a_priv->pci_device->irq;
+	gpib_pio_spin_set_handler(&tms_priv->pio_spin, agilent_82350b_interrupt, a_priv->irq, board);
 	dev_dbg(board->gpib_dev, " IRQ %d\n", a_priv->irq);
 
 	writeb(0, a_priv->gpib_base + SRAM_ACCESS_CONTROL_REG);
@@ -209,6 +209,31 @@ static void agilent_82357a_dump_raw_block(const u8 *raw_data, int length)
 	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 8, 1, raw_data, length, true);
 }
 
+/*
+ * Grow the buffer used for the data phase of reads and writes.  It is kept
+ * between transfers so a transaction does not cost an allocation.  The
+ * caller must hold bulk_transfer_lock.
+ */
+static int agilent_82357a_reserve_io_buffer(struct agilent_82357a_priv *a_priv, size_t length)
+{
+	u8 *buffer;
+
+	if (length <= a_priv->io_buffer_length)
+		return 0;
+	buffer = kmalloc(length, GFP_KERNEL);
+	if (!buffer)
+		return -ENOMEM;
+	kfree(a_priv->io_buffer);
+	a_priv->io_buffer = buffer;
+	a_priv->io_buffer_length = length;
+	return 0;
+}
+
+/*
+ * All the writes are sent in a single DATA_PIPE_CMD_WR_REGS message, so
+ * callers should pass every register write of a sequence in one call
+ * rather than paying a bulk round trip for each of them.
+ */
 static int agilent_82357a_write_registers(struct agilent_82357a_priv *a_priv,
 					  const struct agilent_82357a_register_pairlet *writes,
 					  int num_writes)
@@ -216,23 +241,20 @@ static int agilent_82357a_write_registers(struct agilent_82357a_priv *a_priv,
 	struct usb_device *usb_dev = interface_to_usbdev(a_priv->bus_interface);
 	int retval;
 	u8 *out_data, *in_data;
-	int out_data_length, in_data_length;
 	int bytes_written, bytes_read;
 	int i = 0;
 	int j;
-	static const int bytes_per_write = 2;
-	static const int header_length = 2;
 	static const int max_writes = 31;
 
 	if (num_writes > max_writes) {
 		dev_err(&usb_dev->dev, "bug! num_writes=%i too large\n", num_writes);
 		return -EIO;
 	}
-	out_data_length = num_writes * bytes_per_write + header_length;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
 
+	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
+	if (retval)
+		return retval;
+	out_data = a_priv->register_out_buffer;
 	out_data[i++] = DATA_PIPE_CMD_WR_REGS;
 	out_data[i++] = num_writes;
 	for (j = 0; j < num_writes; j++)	{
@@ -240,49 +262,37 @@ static int agilent_82357a_write_registers(struct agilent_82357a_priv *a_priv,
 		out_data[i++] = writes[j].value;
 	}
 
-	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-	if (retval) {
-		kfree(out_data);
-		return retval;
-	}
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if (retval) {
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
 			retval, bytes_written, i);
 		mutex_unlock(&a_priv->bulk_transfer_lock);
 		return retval;
 	}
-	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&a_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = agilent_82357a_receive_bulk_msg(a_priv, in_data, in_data_length,
+	in_data = a_priv->register_in_buffer;
+	retval = agilent_82357a_receive_bulk_msg(a_priv, in_data, REGISTER_BUF_LEN,
 						 &bytes_read, 1000);
-	mutex_unlock(&a_priv->bulk_transfer_lock);
-
 	if (retval) {
 		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
 			retval, bytes_read);
 		agilent_82357a_dump_raw_block(in_data, bytes_read);
-		kfree(in_data);
-		return -EIO;
-	}
-	if (in_data[0] != (0xff & ~DATA_PIPE_CMD_WR_REGS)) {
+		retval = -EIO;
+	} else if (in_data[0] != (0xff & ~DATA_PIPE_CMD_WR_REGS)) {
 		dev_err(&usb_dev->dev, "bulk command=0x%x != ~DATA_PIPE_CMD_WR_REGS\n", in_data[0]);
-		return -EIO;
-	}
-	if (in_data[1])	{
+		retval = -EIO;
+	} else if (in_data[1])	{
 		dev_err(&usb_dev->dev, "nonzero error code 0x%x in DATA_PIPE_CMD_WR_REGS response\n",
 			in_data[1]);
-		return -EIO;
+		retval = -EIO;
 	}
-	kfree(in_data);
-	return 0;
+	mutex_unlock(&a_priv->bulk_transfer_lock);
+	return retval;
 }
 
+/*
+ * Like agilent_82357a_write_registers(), all the reads are done by one
+ * DATA_PIPE_CMD_RD_REGS message.
+ */
 static int agilent_82357a_read_registers(struct agilent_82357a_priv *a_priv,
 					 struct agilent_82357a_register_pairlet *reads,
 					 int num_reads, int blocking)
@@ -290,79 +300,60 @@ static int agilent_82357a_read_registers(struct agilent_82357a_priv *a_priv,
 	struct usb_device *usb_dev = interface_to_usbdev(a_priv->bus_interface);
 	int retval;
 	u8 *out_data, *in_data;
-	int out_data_length, in_data_length;
 	int bytes_written, bytes_read;
 	int i = 0;
 	int j;
 	static const int header_length = 2;
-	static const int max_reads = 62;
+	static const int max_reads = REGISTER_BUF_LEN - 2;
 
 	if (num_reads > max_reads) {
 		dev_err(&usb_dev->dev, "bug! num_reads=%i too large\n", num_reads);
 		return -EIO;
 	}
-	out_data_length = num_reads + header_length;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
-
-	out_data[i++] = DATA_PIPE_CMD_RD_REGS;
-	out_data[i++] = num_reads;
-	for (j = 0; j < num_reads; j++)
-		out_data[i++] = reads[j].address;
 
 	if (blocking) {
 		retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-		if (retval) {
-			kfree(out_data);
+		if (retval)
 			return retval;
-		}
 	} else {
 		retval = mutex_trylock(&a_priv->bulk_transfer_lock);
-		if (retval == 0) {
-			kfree(out_data);
+		if (retval == 0)
 			return -EAGAIN;
-		}
 	}
+	out_data = a_priv->register_out_buffer;
+	out_data[i++] = DATA_PIPE_CMD_RD_REGS;
+	out_data[i++] = num_reads;
+	for (j = 0; j < num_reads; j++)
+		out_data[i++] = reads[j].address;
+
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if (retval) {
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
 			retval, bytes_written, i);
 		mutex_unlock(&a_priv->bulk_transfer_lock);
 		return retval;
 	}
-	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&a_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = agilent_82357a_receive_bulk_msg(a_priv, in_data, in_data_length,
+	in_data = a_priv->register_in_buffer;
+	retval = agilent_82357a_receive_bulk_msg(a_priv, in_data, REGISTER_BUF_LEN,
 						 &bytes_read, 10000);
-	mutex_unlock(&a_priv->bulk_transfer_lock);
-
 	if (retval) {
 		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
 			retval, bytes_read);
 		agilent_82357a_dump_raw_block(in_data, bytes_read);
-		kfree(in_data);
-		return -EIO;
-	}
-	i = 0;
-	if (in_data[i++] != (0xff & ~DATA_PIPE_CMD_RD_REGS)) {
+		retval = -EIO;
+	} else if (in_data[0] != (0xff & ~DATA_PIPE_CMD_RD_REGS)) {
 		dev_err(&usb_dev->dev, "bulk command=0x%x != ~DATA_PIPE_CMD_RD_REGS\n",	in_data[0]);
-		return -EIO;
-	}
-	if (in_data[i++]) {
+		retval = -EIO;
+	} else if (in_data[1]) {
 		dev_err(&usb_dev->dev, "nonzero error code 0x%x in DATA_PIPE_CMD_RD_REGS response\n",
 			in_data[1]);
-		return -EIO;
+		retval = -EIO;
+	} else {
+		for (j = 0; j < num_reads; j++)
+			reads[j].value = in_data[header_length + j];
 	}
-	for (j = 0; j < num_reads; j++)
-		reads[j].value = in_data[i++];
-	kfree(in_data);
-	return 0;
+	mutex_unlock(&a_priv->bulk_transfer_lock);
+	return retval;
 }
 
 static int agilent_82357a_abort(struct agilent_82357a_priv *a_priv, int flush)
@@ -430,7 +421,7 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 	struct agilent_82357a_priv *a_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written, bytes_read;
 	int i = 0;
 	u8 trailing_flags;
@@ -443,10 +434,17 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 	if (!a_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(a_priv->bus_interface);
-	out_data_length = 0x9;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
+	if (retval)
+		return retval;
+	in_data_length = length + 1;
+	retval = agilent_82357a_reserve_io_buffer(a_priv, in_data_length);
+	if (retval) {
+		mutex_unlock(&a_priv->bulk_transfer_lock);
+		return retval;
+	}
+	in_data = a_priv->io_buffer;
+	out_data = a_priv->register_out_buffer;
 	out_data[i++] = DATA_PIPE_CMD_READ;
 	out_data[i++] = 0;	// primary address when ARF_NO_ADDR is not set
 	out_data[i++] = 0;	// secondary address when ARF_NO_ADDR is not set
@@ -460,13 +458,7 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 	out_data[i++] = (length >> 24) & 0xff;
 	out_data[i++] = a_priv->eos_char;
 	msec_timeout = (board->usec_timeout + 999) / 1000;
-	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-	if (retval) {
-		kfree(out_data);
-		return retval;
-	}
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &bytes_written, msec_timeout);
-	kfree(out_data);
 	if (retval || bytes_written != i) {
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
 			retval, bytes_written, i);
@@ -475,12 +467,6 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 			return retval;
 		return -EIO;
 	}
-	in_data_length = length + 1;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&a_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
 	if (board->usec_timeout != 0)
 		msec_timeout -= jiffies_to_msecs(jiffies - start_jiffies) - 1;
 	if (msec_timeout >= 0) {
@@ -509,7 +495,6 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 			retval, bytes_read);
 		agilent_82357a_abort(a_priv, 0);
 	}
-	mutex_unlock(&a_priv->bulk_transfer_lock);
 	if (bytes_read > length + 1) {
 		bytes_read = length + 1;
 		dev_warn(&usb_dev->dev, "bytes_read > length? truncating");
@@ -522,14 +507,21 @@ static int agilent_82357a_read(struct gpib_board *board, u8 *buffer, size_t leng
 		if (trailing_flags & (ATRF_EOI | ATRF_EOS))
 			*end = 1;
 	}
-	kfree(in_data);
-
 	/*
-	 * Fix for a bug in 9914A that does not return the contents of ADSR
-	 * when the board is in listener active state and ATN is not asserted.
-	 * Set ATN here to obtain a valid board level ibsta
+	 * The 9914A does not return the contents of ADSR when the board is
+	 * in listener active state and ATN is not asserted.  Rather than
+	 * asserting ATN after every read to get a valid board level ibsta,
+	 * which costs a bulk round trip per read, agilent_82357a_update_status()
+	 * reports the addressed state known from here until ATN is asserted.
+	 * Only as controller-in-charge, and only once bytes have actually
+	 * been received, is the board known to still be addressed: in device
+	 * mode a remote controller may unlisten it at any time.
 	 */
-	agilent_82357a_take_control_internal(board, 0);
+	if (retval == 0 && *nbytes && a_priv->is_cic)
+		a_priv->listener_active = 1;
+	else
+		a_priv->listener_active = 0;
+	mutex_unlock(&a_priv->bulk_transfer_lock);
 
 	// FIXME check trailing flags for error
 	return retval;
@@ -543,24 +535,30 @@ static ssize_t agilent_82357a_generic_write(struct gpib_board *board,
 	int retval;
 	struct agilent_82357a_priv *a_priv = board->private_data;
 	struct usb_device *usb_dev;
-	u8 *out_data = NULL;
-	u8 *status_data = NULL;
+	u8 *out_data;
+	u8 *status_data;
 	int out_data_length;
 	int raw_bytes_written;
 	int i = 0, j;
 	int msec_timeout;
 	unsigned short bsr, adsr;
-	struct agilent_82357a_register_pairlet read_reg;
+	struct agilent_82357a_register_pairlet read_regs[2];
 
 	*bytes_written = 0;
 	if (!a_priv->bus_interface)
 		return -ENODEV;
 
 	usb_dev = interface_to_usbdev(a_priv->bus_interface);
+	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
+	if (retval)
+		return retval;
 	out_data_length = length + 0x8;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+	retval = agilent_82357a_reserve_io_buffer(a_priv, out_data_length);
+	if (retval) {
+		mutex_unlock(&a_priv->bulk_transfer_lock);
+		return retval;
+	}
+	out_data = a_priv->io_buffer;
 	out_data[i++] = DATA_PIPE_CMD_WRITE;
 	out_data[i++] = 0; // primary address when AWF_NO_ADDRESS is not set
 	out_data[i++] = 0; // secondary address when AWF_NO_ADDRESS is not set
@@ -578,16 +576,12 @@ static ssize_t agilent_82357a_generic_write(struct gpib_board *board,
 		out_data[i++] = buffer[j];
 
 	clear_bit(AIF_WRITE_COMPLETE_BN, &a_priv->interrupt_flags);
+	// both commands and data end the listener state set by the last read
+	a_priv->listener_active = 0;
 
 	msec_timeout = (board->usec_timeout + 999) / 1000;
-	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-	if (retval) {
-		kfree(out_data);
-		return retval;
-	}
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &raw_bytes_written,
 					      msec_timeout);
-	kfree(out_data);
 	if (retval || raw_bytes_written != i) {
 		agilent_82357a_abort(a_priv, 0);
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, raw_bytes_written=%i, i=%i\n",
@@ -617,14 +611,16 @@ static ssize_t agilent_82357a_generic_write(struct gpib_board *board,
 
 		mutex_unlock(&a_priv->bulk_transfer_lock);
 
-		read_reg.address = BSR;
-		retval = agilent_82357a_read_registers(a_priv, &read_reg, 1, 1);
+		read_regs[0].address = BSR;
+		read_regs[1].address = ADSR;
+		retval = agilent_82357a_read_registers(a_priv, read_regs, 2, 1);
 		if (retval) {
 			dev_err(&usb_dev->dev, "read_registers() returned error\n");
 			return -ETIMEDOUT;
 		}
 
-		bsr = read_reg.value;
+		bsr = read_regs[0].value;
+		adsr = read_regs[1].value;
 		dev_dbg(&usb_dev->dev, "write aborted bsr 0x%x\n", bsr);
 
 		if (send_commands) {/* check for no listeners */
@@ -634,13 +630,6 @@ static ssize_t agilent_82357a_generic_write(struct gpib_board *board,
 				return -ENOTCONN; // no listener on bus
 			}
 		} else {
-			read_reg.address = ADSR;
-			retval = agilent_82357a_read_registers(a_priv, &read_reg, 1, 1);
-			if (retval) {
-				dev_err(&usb_dev->dev, "read_registers() returned error\n");
-				return -ETIMEDOUT;
-			}
-			adsr = read_reg.value;
 			if ((adsr & HR_TA) && !(bsr & (BSR_NDAC_BIT | BSR_NRFD_BIT))) {
 				dev_dbg(&usb_dev->dev, "No listener on write\n");
 				clear_bit(TIMO_NUM, &board->status);
@@ -651,28 +640,22 @@ static ssize_t agilent_82357a_generic_write(struct gpib_board *board,
 		return -ETIMEDOUT;
 	}
 
-	status_data = kmalloc(STATUS_DATA_LEN, GFP_KERNEL);
-	if (!status_data) {
-		mutex_unlock(&a_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
-
+	status_data = a_priv->register_in_buffer;
 	retval = agilent_82357a_receive_control_msg(a_priv, agilent_82357a_control_request,
 						    USB_DIR_IN | USB_TYPE_VENDOR | USB_RECIP_DEVICE,
 						    XFER_STATUS, 0, status_data, STATUS_DATA_LEN,
 						    100);
-	mutex_unlock(&a_priv->bulk_transfer_lock);
 	if (retval < 0)	{
 		dev_err(&usb_dev->dev, "receive_control_msg() returned %i\n", retval);
-		kfree(status_data);
+		mutex_unlock(&a_priv->bulk_transfer_lock);
 		return -EIO;
 	}
 	*bytes_written	= (u32)status_data[2];
 	*bytes_written |= (u32)status_data[3] << 8;
 	*bytes_written |= (u32)status_data[4] << 16;
 	*bytes_written |= (u32)status_data[5] << 24;
+	mutex_unlock(&a_priv->bulk_transfer_lock);
 
-	kfree(status_data);
 	return 0;
 }
 
@@ -703,6 +686,8 @@ int agilent_82357a_take_control_internal(struct gpib_board *board, int synchrono
 	retval = agilent_82357a_write_registers(a_priv, &write, 1);
 	if (retval)
 		dev_err(&usb_dev->dev, "write_registers() returned error\n");
+	else
+		a_priv->listener_active = 0;
 
 	return retval;
 }
@@ -802,6 +787,8 @@ static void agilent_82357a_interface_clear(struct gpib_board *board, int assert)
 	if (assert) {
 		write.value |= AUX_CS;
 		a_priv->is_cic = 1;
+		// ifc unaddresses every device, including us
+		a_priv->listener_active = 0;
 	}
 	retval = agilent_82357a_write_registers(a_priv, &write, 1);
 	if (retval)
@@ -857,7 +844,8 @@ static unsigned int agilent_82357a_update_status(struct gpib_board *board,
 {
 	struct agilent_82357a_priv *a_priv = board->private_data;
 	struct usb_device *usb_dev;
-	struct agilent_82357a_register_pairlet address_status, bus_status;
+	struct agilent_82357a_register_pairlet status_regs[2];
+	unsigned short address_status, bus_status;
 	int retval;
 
 	if (!a_priv->bus_interface)
@@ -868,46 +856,55 @@ static unsigned int agilent_82357a_update_status(struct gpib_board *board,
 		set_bit(CIC_NUM, &board->status);
 	else
 		clear_bit(CIC_NUM, &board->status);
-	address_status.address = ADSR;
-	retval = agilent_82357a_read_registers(a_priv, &address_status, 1, 0);
+	// read both status registers in one bulk transaction
+	status_regs[0].address = ADSR;
+	status_regs[1].address = BSR;
+	retval = agilent_82357a_read_registers(a_priv, status_regs, 2, 0);
 	if (retval) {
 		if (retval != -EAGAIN)
 			dev_err(&usb_dev->dev, "read_registers() returned error\n");
 		return board->status;
 	}
+	address_status = status_regs[0].value;
+	bus_status = status_regs[1].value;
+	/*
+	 * ADSR is not valid while we are an active listener with ATN
+	 * unasserted (see agilent_82357a_read()), so use what we know of
+	 * the addressed state and the last ADSR read while it was valid.
+	 */
+	if (a_priv->listener_active && !(bus_status & BSR_ATN_BIT)) {
+		address_status = (a_priv->last_adsr & ~(HR_TA | HR_ATN)) | HR_LA;
+	} else {
+		// with ATN asserted the addressing may change, trust ADSR from now on
+		a_priv->listener_active = 0;
+		a_priv->last_adsr = address_status;
+	}
 	// check for remote/local
-	if (address_status.value & HR_REM)
+	if (address_status & HR_REM)
 		set_bit(REM_NUM, &board->status);
 	else
 		clear_bit(REM_NUM, &board->status);
 	// check for lockout
-	if (address_status.value & HR_LLO)
+	if (address_status & HR_LLO)
 		set_bit(LOK_NUM, &board->status);
 	else
 		clear_bit(LOK_NUM, &board->status);
 	// check for ATN
-	if (address_status.value & HR_ATN)
+	if (address_status & HR_ATN)
 		set_bit(ATN_NUM, &board->status);
 	else
 		clear_bit(ATN_NUM, &board->status);
 	// check for talker/listener addressed
-	if (address_status.value & HR_TA)
+	if (address_status & HR_TA)
 		set_bit(TACS_NUM, &board->status);
 	else
 		clear_bit(TACS_NUM, &board->status);
-	if (address_status.value & HR_LA)
+	if (address_status & HR_LA)
 		set_bit(LACS_NUM, &board->status);
 	else
 		clear_bit(LACS_NUM, &board->status);
 
-	bus_status.address = BSR;
-	retval = agilent_82357a_read_registers(a_priv, &bus_status, 1, 0);
-	if (retval) {
-		if (retval != -EAGAIN)
-			dev_err(&usb_dev->dev, "read_registers() returned error\n");
-		return board->status;
-	}
-	if (bus_status.value & BSR_SRQ_BIT)
+	if (bus_status & BSR_SRQ_BIT)
 		set_bit(SRQI_NUM, &board->status);
 	else
 		clear_bit(SRQI_NUM, &board->status);
@@ -925,6 +922,8 @@ static int agilent_82357a_primary_address(struct gpib_board *board, unsigned int
 	if (!a_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(a_priv->bus_interface);
+	// a new address unaddresses us
+	a_priv->listener_active = 0;
 	// put primary address in address0
 	write.address = ADR;
 	write.value = address & ADDRESS_MASK;
@@ -955,7 +954,8 @@ static int agilent_82357a_parallel_poll(struct gpib_board *board, u8 *result)
 	if (!a_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(a_priv->bus_interface);
-	// execute parallel poll
+	// execute parallel poll, which asserts ATN
+	a_priv->listener_active = 0;
 	writes[0].address = AUXCR;
 	writes[0].value = AUX_CS | AUX_RPP;
 	writes[1].address = HW_CONTROL;
@@ -1203,11 +1203,27 @@ static int agilent_82357a_allocate_private(struct gpib_board *board)
 	mutex_init(&a_priv->bulk_alloc_lock);
 	mutex_init(&a_priv->control_alloc_lock);
 	mutex_init(&a_priv->interrupt_alloc_lock);
+	a_priv->register_out_buffer = kmalloc(REGISTER_BUF_LEN, GFP_KERNEL);
+	a_priv->register_in_buffer = kmalloc(REGISTER_BUF_LEN, GFP_KERNEL);
+	if (!a_priv->register_out_buffer || !a_priv->register_in_buffer) {
+		kfree(a_priv->register_out_buffer);
+		kfree(a_priv->register_in_buffer);
+		kfree(a_priv);
+		board->private_data = NULL;
+		return -ENOMEM;
+	}
 	return 0;
 }
 
 static void agilent_82357a_free_private(struct gpib_board *board)
 {
+	struct agilent_82357a_priv *a_priv = board->private_data;
+
+	if (a_priv) {
+		kfree(a_priv->register_out_buffer);
+		kfree(a_priv->register_in_buffer);
+		kfree(a_priv->io_buffer);
+	}
 	kfree(board->private_data);
 	board->private_data = NULL;
 }
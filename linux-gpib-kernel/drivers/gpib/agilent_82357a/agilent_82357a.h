@@ -113,6 +113,8 @@ enum xfer_abort_type {
 
 #define STATUS_DATA_LEN 8
 #define INTERRUPT_BUF_LEN 8
+// holds a register read/write message or its reply, and status data
+#define REGISTER_BUF_LEN 0x40
 
 struct agilent_82357a_urb_ctx {
 	struct completion complete;
@@ -129,6 +131,10 @@ struct agilent_82357a_priv {
 	struct urb *bulk_urb;
 	struct urb *interrupt_urb;
 	u8 *interrupt_buffer;
+	u8 *register_out_buffer;
+	u8 *register_in_buffer;
+	u8 *io_buffer;			// data phase of reads and writes
+	size_t io_buffer_length;
 	struct mutex bulk_transfer_lock;	// bulk transfer lock
 	struct mutex bulk_alloc_lock;		// bulk transfer allocation lock
 	struct mutex interrupt_alloc_lock;	// interrupt allocation lock
@@ -137,6 +143,8 @@ struct agilent_82357a_priv {
 	struct agilent_82357a_urb_ctx context;
 	unsigned int bulk_out_endpoint;
 	unsigned int interrupt_in_endpoint;
+	int listener_active;		// addressed to listen by the last read
+	unsigned short last_adsr;	// last ADSR read while it was valid
 	unsigned is_cic : 1;
 	unsigned ren_state : 1;
 };
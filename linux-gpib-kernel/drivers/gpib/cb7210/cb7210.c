@@ -30,7 +30,7 @@ MODULE_DESCRIPTION("GPIB driver Measurement Computing boards using cb7210.2 and
 static int cb7210_read(struct gpib_board *board, u8 *buffer, size_t length,
 		       int *end, size_t *bytes_read);
 
-	static inline int have_fifo_word(const struct cb7210_priv *cb_priv)
+	static inline int have_fifo_word(struct cb7210_priv *cb_priv)
 {
 	if (((cb7210_read_byte(cb_priv, HS_STATUS)) &
 	     (HS_RX_MSB_NOT_EMPTY | HS_RX_LSB_NOT_EMPTY)) ==
@@ -67,8 +67,7 @@ static inline void input_fifo_enable(struct gpib_board *board, int enable)
 		nec7210_set_reg_bits(nec_priv, IMR2, HR_DMAI, 0);
 
 		cb_priv->hs_mode_bits &= ~HS_ENABLE_MASK;
-		cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits, nec7210_iobase(cb_priv) +
-				  HS_MODE);
+		cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits, HS_MODE);
 
 		clear_bit(READ_READY_BN, &nec_priv->state);
 	}
@@ -76,13 +75,56 @@ static inline void input_fifo_enable(struct gpib_board *board, int enable)
 	spin_unlock_irqrestore(&board->spinlock, flags);
 }
 
+static u8 cb7210_ioport_hs_read_byte(struct cb7210_priv *cb_priv, unsigned int register_num)
+{
+	return inb(nec7210_iobase(cb_priv) + register_num * cb_priv->nec7210_priv.offset);
+}
+
+static void cb7210_ioport_hs_write_byte(struct cb7210_priv *cb_priv, u8 data,
+					unsigned int register_num)
+{
+	outb(data, nec7210_iobase(cb_priv) + register_num * cb_priv->nec7210_priv.offset);
+}
+
+static void cb7210_ioport_read_fifo_words(struct cb7210_priv *cb_priv, u8 *buffer,
+					  unsigned int num_words)
+{
+	u16 word;
+
+	if (IS_ALIGNED((unsigned long)buffer, 2)) {
+		insw(cb_priv->fifo_iobase + DIR, buffer, num_words);
+		return;
+	}
+	while (num_words--) {
+		word = inw(cb_priv->fifo_iobase + DIR);
+		*buffer++ = word & 0xff;
+		*buffer++ = (word >> 8) & 0xff;
+	}
+}
+
+static void cb7210_ioport_write_fifo_words(struct cb7210_priv *cb_priv, const u8 *buffer,
+					   unsigned int num_words)
+{
+	u16 word;
+
+	if (IS_ALIGNED((unsigned long)buffer, 2)) {
+		outsw(cb_priv->fifo_iobase + CDOR, buffer, num_words);
+		return;
+	}
+	while (num_words--) {
+		word = *buffer++ & 0xff;
+		word |= (*buffer++ << 8) & 0xff00;
+		outw(word, cb_priv->fifo_iobase + CDOR);
+	}
+}
+
 static int fifo_read(struct gpib_board *board, struct cb7210_priv *cb_priv, u8 *buffer,
 		     size_t length, int *end, size_t *bytes_read)
 {
 	ssize_t retval = 0;
 	struct nec7210_priv *nec_priv = &cb_priv->nec7210_priv;
 	int hs_status;
-	u16 word;
+	u8 last_word[2];
 	unsigned long flags;
 
 	*bytes_read = 0;
@@ -116,13 +158,28 @@ static int fifo_read(struct gpib_board *board, struct cb7210_priv *cb_priv, u8 *
 
 		nec7210_set_reg_bits(nec_priv, IMR2, HR_DMAI, 0);
 
+		/*
+		 * HS_HALF_FULL is the latched half full interrupt, which the
+		 * interrupt handler has already cleared by now, so the flag it
+		 * left is all there is to go by.  The fifo stops filling while
+		 * HR_DMAI is off, and the latch is cleared below after each
+		 * drain, so the flag means half a fifo of words came in since
+		 * the fifo was last emptied.
+		 */
+		if (cb_priv->in_fifo_half_full) {
+			cb_priv->read_fifo_words(cb_priv, &buffer[*bytes_read],
+						 cb7210_fifo_size / 2 / cb7210_fifo_width);
+			*bytes_read += cb7210_fifo_size / 2;
+		}
 		while (have_fifo_word(cb_priv))	{
-			word = inw(cb_priv->fifo_iobase + DIR);
-			buffer[(*bytes_read)++] = word & 0xff;
-			buffer[(*bytes_read)++] = (word >> 8) & 0xff;
+			cb_priv->read_fifo_words(cb_priv, &buffer[*bytes_read], 1);
+			*bytes_read += cb7210_fifo_width;
 		}
 
+		/* a half full interrupt still latched was for words drained above */
 		cb_priv->in_fifo_half_full = 0;
+		cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits | HS_CLR_HF_INT, HS_MODE);
+		cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits, HS_MODE);
 
 		hs_status = cb7210_read_byte(cb_priv, HS_STATUS);
 
@@ -145,8 +202,8 @@ static int fifo_read(struct gpib_board *board, struct cb7210_priv *cb_priv, u8 *
 	}
 	hs_status = cb7210_read_byte(cb_priv, HS_STATUS);
 	if (hs_status & HS_RX_LSB_NOT_EMPTY) {
-		word = inw(cb_priv->fifo_iobase + DIR);
-		buffer[(*bytes_read)++] = word & 0xff;
+		cb_priv->read_fifo_words(cb_priv, last_word, 1);
+		buffer[(*bytes_read)++] = last_word[0];
 	}
 
 	input_fifo_enable(board, 0);
@@ -170,8 +227,8 @@ static int fifo_read(struct gpib_board *board, struct cb7210_priv *cb_priv, u8 *
 	return retval;
 }
 
-static int cb7210_accel_read(struct gpib_board *board, u8 *buffer,
-			     size_t length, int *end, size_t *bytes_read)
+int cb7210_accel_read(struct gpib_board *board, u8 *buffer, size_t length, int *end,
+		      size_t *bytes_read)
 {
 	ssize_t retval;
 	struct cb7210_priv *cb_priv = board->private_data;
@@ -219,8 +276,9 @@ static int cb7210_accel_read(struct gpib_board *board, u8 *buffer,
 
 	return 0;
 }
+EXPORT_SYMBOL(cb7210_accel_read);
 
-static int output_fifo_empty(const struct cb7210_priv *cb_priv)
+static int output_fifo_empty(struct cb7210_priv *cb_priv)
 {
 	if ((cb7210_read_byte(cb_priv, HS_STATUS) & (HS_TX_MSB_NOT_EMPTY | HS_TX_LSB_NOT_EMPTY))
 	    == 0)
@@ -271,7 +329,7 @@ static int fifo_write(struct gpib_board *board, u8 *buffer, size_t length,
 	ssize_t retval = 0;
 	struct cb7210_priv *cb_priv = board->private_data;
 	struct nec7210_priv *nec_priv = &cb_priv->nec7210_priv;
-	unsigned int num_bytes, i;
+	unsigned int num_bytes;
 	unsigned long flags;
 
 	*bytes_written = 0;
@@ -316,13 +374,8 @@ static int fifo_write(struct gpib_board *board, u8 *buffer, size_t length,
 		}
 
 		spin_lock_irqsave(&board->spinlock, flags);
-		for (i = 0; i < num_bytes / cb7210_fifo_width; i++) {
-			u16 word;
-
-			word = buffer[count++] & 0xff;
-			word |= (buffer[count++] << 8) & 0xff00;
-			outw(word, cb_priv->fifo_iobase + CDOR);
-		}
+		cb_priv->write_fifo_words(cb_priv, &buffer[count], num_bytes / cb7210_fifo_width);
+		count += num_bytes;
 		cb_priv->out_fifo_half_empty = 0;
 		cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits |
 				  HS_CLR_EOI_EMPTY_INT | HS_CLR_HF_INT, HS_MODE);
@@ -350,8 +403,8 @@ static int fifo_write(struct gpib_board *board, u8 *buffer, size_t length,
 	return retval;
 }
 
-static int cb7210_accel_write(struct gpib_board *board, u8 *buffer,
-			      size_t length, int send_eoi, size_t *bytes_written)
+int cb7210_accel_write(struct gpib_board *board, u8 *buffer, size_t length, int send_eoi,
+		       size_t *bytes_written)
 {
 	struct cb7210_priv *cb_priv = board->private_data;
 	struct nec7210_priv *nec_priv = &cb_priv->nec7210_priv;
@@ -377,6 +430,7 @@ static int cb7210_accel_write(struct gpib_board *board, u8 *buffer,
 	*bytes_written += num_bytes;
 	return retval;
 }
+EXPORT_SYMBOL(cb7210_accel_write);
 
 static int cb7210_line_status(const struct gpib_board *board)
 {
@@ -463,7 +517,7 @@ static irqreturn_t cb_pci_interrupt(int irq, void *arg PT_REGS_ARG)
 	return cb7210_locked_internal_interrupt(arg);
 }
 
-static irqreturn_t cb7210_internal_interrupt(struct gpib_board *board)
+irqreturn_t cb7210_internal_interrupt(struct gpib_board *board)
 {
 	int hs_status, status1, status2;
 	struct cb7210_priv *priv = board->private_data;
@@ -516,6 +570,7 @@ static irqreturn_t cb7210_internal_interrupt(struct gpib_board *board)
 
 	return IRQ_HANDLED;
 }
+EXPORT_SYMBOL(cb7210_internal_interrupt);
 
 static irqreturn_t cb7210_locked_internal_interrupt(struct gpib_board *board)
 {
@@ -885,6 +940,10 @@ static int cb7210_generic_attach(struct gpib_board *board)
 	nec_priv = &cb_priv->nec7210_priv;
 	nec_priv->read_byte = nec7210_locking_ioport_read_byte;
 	nec_priv->write_byte = nec7210_locking_ioport_write_byte;
+	cb_priv->hs_read_byte = cb7210_ioport_hs_read_byte;
+	cb_priv->hs_write_byte = cb7210_ioport_hs_write_byte;
+	cb_priv->read_fifo_words = cb7210_ioport_read_fifo_words;
+	cb_priv->write_fifo_words = cb7210_ioport_write_fifo_words;
 	nec_priv->offset = cb7210_reg_offset;
 	nec_priv->type = CB7210;
 	return 0;
@@ -993,6 +1052,7 @@ static int cb_pci_attach(struct gpib_board *board, const struct gpib_board_confi
 		return -EBUSY;
 	}
 	cb_priv->irq = cb_priv->pci_device->irq;
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, cb_pci_interrupt, cb_priv->irq, board);
 
 	switch (cb_priv->pci_chip) {
 	case PCI_CHIP_AMCC_S5933:
@@ -1064,6 +1124,7 @@ static int cb_isa_attach(struct gpib_board *board, const struct gpib_board_confi
 		return -EBUSY;
 	}
 	cb_priv->irq = config->ibirq;
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, cb7210_interrupt, cb_priv->irq, board);
 
 	return cb7210_init(cb_priv, board);
 }
@@ -1452,6 +1513,7 @@ static int cb_pcmcia_attach(struct gpib_board *board, const struct gpib_board_co
 		return -EBUSY;
 	}
 	cb_priv->irq = curr_dev->irq;
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, cb7210_interrupt, cb_priv->irq, board);
 
 	return cb7210_init(cb_priv, board);
 }
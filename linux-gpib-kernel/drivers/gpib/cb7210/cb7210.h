@@ -34,6 +34,12 @@ struct cb7210_priv {
 	u8 hs_mode_bits;
 	unsigned out_fifo_half_empty : 1;
 	unsigned in_fifo_half_full : 1;
+	// high speed register and fifo accessors, io ports unless the board is emulated
+	u8 (*hs_read_byte)(struct cb7210_priv *cb_priv, unsigned int register_num);
+	void (*hs_write_byte)(struct cb7210_priv *cb_priv, u8 data, unsigned int register_num);
+	void (*read_fifo_words)(struct cb7210_priv *cb_priv, u8 *buffer, unsigned int num_words);
+	void (*write_fifo_words)(struct cb7210_priv *cb_priv, const u8 *buffer,
+				 unsigned int num_words);
 };
 
 // pci-gpib register offset
@@ -89,14 +95,9 @@ static inline u8 cb7210_paged_read_byte(struct cb7210_priv *cb_priv,
 }
 
 // don't use for register_num < 8, since it doesn't lock
-static inline u8 cb7210_read_byte(const struct cb7210_priv *cb_priv,
-				  enum hs_regs register_num)
+static inline u8 cb7210_read_byte(struct cb7210_priv *cb_priv, enum hs_regs register_num)
 {
-	const struct nec7210_priv *nec_priv = &cb_priv->nec7210_priv;
-	u8 retval;
-
-	retval = inb(nec7210_iobase(cb_priv) + register_num * nec_priv->offset);
-	return retval;
+	return cb_priv->hs_read_byte(cb_priv, register_num);
 }
 
 static inline void cb7210_paged_write_byte(struct cb7210_priv *cb_priv, u8 data,
@@ -113,12 +114,10 @@ static inline void cb7210_paged_write_byte(struct cb7210_priv *cb_priv, u8 data,
 }
 
 // don't use for register_num < 8, since it doesn't lock
-static inline void cb7210_write_byte(const struct cb7210_priv *cb_priv, u8 data,
+static inline void cb7210_write_byte(struct cb7210_priv *cb_priv, u8 data,
 				     enum hs_regs register_num)
 {
-	const struct nec7210_priv *nec_priv = &cb_priv->nec7210_priv;
-
-	outb(data, nec7210_iobase(cb_priv) + register_num * nec_priv->offset);
+	cb_priv->hs_write_byte(cb_priv, data, register_num);
 }
 
 enum bus_status_bits {
@@ -201,3 +200,10 @@ enum cb7210_aux_cmds {
 	AUX_LO_SPEED = 0x40,
 	AUX_HI_SPEED = 0x41,
 };
+
+// used by the emulated cbi488.2 board of gpib_emu
+int cb7210_accel_read(struct gpib_board *board, u8 *buffer, size_t length, int *end,
+		      size_t *bytes_read);
+int cb7210_accel_write(struct gpib_board *board, u8 *buffer, size_t length, int send_eoi,
+		       size_t *bytes_written);
+irqreturn_t cb7210_internal_interrupt(struct gpib_board *board);
@@ -17,6 +17,7 @@
 #include <linux/pci.h>
 #include <linux/device.h>
 #include <linux/init.h>
+#include <linux/ktime.h>
 #include <linux/string.h>
 #include <linux/vmalloc.h>
 #include <linux/fcntl.h>
@@ -35,6 +36,14 @@ static int write_ioctl(struct gpib_file_private *file_priv, struct gpib_board *b
 		       unsigned long arg);
 static int command_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
 			 unsigned long arg);
+static int readv_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+		       unsigned long arg);
+static int writev_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			unsigned long arg);
+static int read_file_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			   unsigned long arg);
+static int write_file_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			    unsigned long arg);
 static int open_dev_ioctl(struct file *filep, struct gpib_board *board, unsigned long arg);
 static int close_dev_ioctl(struct file *filep, struct gpib_board *board, unsigned long arg);
 static int serial_poll_ioctl(struct gpib_board *board, unsigned long arg);
@@ -72,6 +81,14 @@ static int select_device_path_ioctl(struct gpib_board_config *config, unsigned l
 static int event_ioctl(struct gpib_board *board, unsigned long arg);
 static int request_system_control_ioctl(struct gpib_board *board, unsigned long arg);
 static int t1_delay_ioctl(struct gpib_board *board, unsigned long arg);
+static int stream_start_ioctl(struct gpib_file_private *file_priv,
+			      struct gpib_board *board, unsigned long arg);
+static int probe_listeners_ioctl(struct gpib_board *board, unsigned long arg);
+static int transfer_engine_ioctl(struct gpib_board *board, unsigned long arg);
+static int responder_start_ioctl(struct gpib_file_private *file_priv,
+				 struct gpib_board *board, unsigned long arg);
+static int responder_message_ioctl(struct gpib_board *board, unsigned int cmd,
+				   unsigned long arg);
 
 static int cleanup_open_devices(struct gpib_file_private *file_priv, struct gpib_board *board);
 
@@ -178,6 +195,62 @@ void gpib_free_pseudo_irq(struct gpib_board *board)
 }
 EXPORT_SYMBOL(gpib_free_pseudo_irq);
 
+static unsigned int pio_spin_usec[GPIB_MAX_NUM_BOARDS];
+module_param_array(pio_spin_usec, uint, NULL, 0644);
+MODULE_PARM_DESC(pio_spin_usec,
+		 " per board index, longest busy wait for the next byte in PIO transfers before sleeping (0 = off)");
+
+/* pick up the board's pio_spin_usec setting at the start of a transfer */
+void gpib_pio_spin_start(const struct gpib_board *board, struct gpib_pio_spin *spin,
+			 void (*mask_irq)(struct gpib_board *board, struct gpib_pio_spin *spin,
+					  int mask))
+{
+	unsigned int limit = 0;
+
+	spin->mask_irq = mask_irq;
+	if (spin->handler)
+		limit = min_t(unsigned int, pio_spin_usec[board->minor],
+			      GPIB_PIO_SPIN_MAX_USEC);
+
+	if (spin->limit_usec != limit) {
+		spin->limit_usec = limit;
+		spin->budget_usec = limit;
+	}
+}
+EXPORT_SYMBOL(gpib_pio_spin_start);
+
+/*
+ * Retune the spin budget from how long the last wait took.  A wait which
+ * ended within the limit sets the budget to twice its length, a longer one
+ * halves it.  The budget stays at a microsecond or more, so bytes arriving
+ * back to back again are noticed.
+ */
+void gpib_pio_spin_tune(struct gpib_pio_spin *spin, s64 waited_ns)
+{
+	s64 waited_usec = div_s64(waited_ns, NSEC_PER_USEC);
+
+	if (waited_usec < spin->limit_usec)
+		spin->budget_usec = min_t(s64, 2 * waited_usec + 1, spin->limit_usec);
+	else if (spin->budget_usec > 1)
+		spin->budget_usec /= 2;
+}
+EXPORT_SYMBOL(gpib_pio_spin_tune);
+
+/* run the board's interrupt handler with interrupts off, as the irq would */
+void gpib_pio_spin_poll(struct gpib_pio_spin *spin)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	spin->handler(spin->irq, spin->dev_id
+#ifdef HAVE_PT_REGS
+		      , NULL
+#endif
+		      );
+	local_irq_restore(flags);
+}
+EXPORT_SYMBOL(gpib_pio_spin_poll);
+
 static const unsigned int serial_timeout = 1000000;
 
 unsigned int num_status_bytes(const struct gpib_status_queue *dev)
@@ -293,6 +366,17 @@ int autopoll_all_devices(struct gpib_board *board)
 
 	dev_dbg(board->gpib_dev, "autopoll has board lock\n");
 
+	/*
+	 * A stream may have been started while we waited for the locks.  Leave
+	 * the SRQ to be polled once it has been stopped.
+	 */
+	if (board->stream) {
+		set_bit(SRQI_NUM, &board->status);
+		mutex_unlock(&board->big_gpib_mutex);
+		mutex_unlock(&board->user_mutex);
+		return 1;
+	}
+
 	retval = serial_poll_all(board, serial_timeout);
 	if (retval < 0)	{
 		mutex_unlock(&board->big_gpib_mutex);
@@ -596,6 +680,14 @@ int ibclose(struct inode *inode, struct file *filep)
 			dev_err(board->gpib_dev, "Unexpected null gpib_descriptor\n");
 		}
 
+		/* ibpoll, ibmmap and the stop ioctls look at these under the same mutex */
+		mutex_lock(&board->big_gpib_mutex);
+		if (board->stream && board->stream->file_priv == priv)
+			gpib_stream_stop(board);
+		if (board->responder && board->responder->file_priv == priv)
+			gpib_responder_stop(board);
+		mutex_unlock(&board->big_gpib_mutex);
+
 		cleanup_open_devices(priv, board);
 
 		if (atomic_read(&priv->holding_mutex))
@@ -703,6 +795,23 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 		goto done;
 	}
 
+	/*
+	 * These don't need the board lock, but still go to the interface or
+	 * event queue which the stream thread is using until it is stopped.
+	 * IBWAIT only reports cached status while a stream runs.
+	 */
+	if (board->stream) {
+		switch (cmd) {
+		case IBEVENT:
+		case IBLINES:
+		case IBLOC:
+			retval = -EBUSY;
+			goto done;
+		default:
+			break;
+		}
+	}
+
 	switch (cmd) {
 	case IBEVENT:
 		retval = event_ioctl(board, arg);
@@ -740,6 +849,27 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	}
 	spin_unlock(&board->locking_pid_spinlock);
 
+	/* the stream thread owns the bus until it is stopped */
+	if (board->stream && cmd != IBSTREAM_STOP) {
+		retval = -EBUSY;
+		goto done;
+	}
+	/* so does the responder thread, but the status byte may still be changed */
+	if (board->responder) {
+		switch (cmd) {
+		case IBRESPONDER_STOP:
+		case IBRESPONDER_QUEUE:
+		case IBRESPONDER_READ:
+		case IBRSV:
+		case IBRSV2:
+		case IBQUERY_BOARD_RSV:
+			break;
+		default:
+			retval = -EBUSY;
+			goto done;
+		}
+	}
+
 	switch (cmd) {
 	case IB_T1_DELAY:
 		retval = t1_delay_ioctl(board, arg);
@@ -769,6 +899,12 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	case IBPP2_GET:
 		retval = get_local_ppoll_mode_ioctl(board, arg);
 		goto done;
+	case IBPROBE_LISTENERS:
+		retval = probe_listeners_ioctl(board, arg);
+		goto done;
+	case IBXFER_ENGINE:
+		retval = transfer_engine_ioctl(board, arg);
+		goto done;
 	case IBQUERY_BOARD_RSV:
 		retval = query_board_rsv_ioctl(board, arg);
 		goto done;
@@ -779,9 +915,28 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 		 */
 		mutex_unlock(&board->big_gpib_mutex);
 		return read_ioctl(file_priv, board, arg);
+	case IBRDV:
+		mutex_unlock(&board->big_gpib_mutex);
+		return readv_ioctl(file_priv, board, arg);
+	case IBRDF:
+		mutex_unlock(&board->big_gpib_mutex);
+		return read_file_ioctl(file_priv, board, arg);
 	case IBRPP:
 		retval = parallel_poll_ioctl(board, arg);
 		goto done;
+	case IBRESPONDER_START:
+		retval = responder_start_ioctl(file_priv, board, arg);
+		goto done;
+	case IBRESPONDER_STOP:
+		retval = gpib_responder_stop(board);
+		goto done;
+	case IBRESPONDER_QUEUE:
+		retval = responder_message_ioctl(board, cmd, arg);
+		goto done;
+	case IBRESPONDER_READ:
+		/* waits for the controller, like the other io ioctls */
+		mutex_unlock(&board->big_gpib_mutex);
+		return responder_message_ioctl(board, cmd, arg);
 	case IBRSC:
 		retval = request_system_control_ioctl(board, arg);
 		goto done;
@@ -800,6 +955,12 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	case IBSRE:
 		retval = remote_enable_ioctl(board, arg);
 		goto done;
+	case IBSTREAM_START:
+		retval = stream_start_ioctl(file_priv, board, arg);
+		goto done;
+	case IBSTREAM_STOP:
+		retval = gpib_stream_stop(board);
+		goto done;
 	case IBTMO:
 		retval = timeout_ioctl(board, arg);
 		goto done;
@@ -810,6 +971,12 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 		 */
 		mutex_unlock(&board->big_gpib_mutex);
 		return write_ioctl(file_priv, board, arg);
+	case IBWRTV:
+		mutex_unlock(&board->big_gpib_mutex);
+		return writev_ioctl(file_priv, board, arg);
+	case IBWRTF:
+		mutex_unlock(&board->big_gpib_mutex);
+		return write_file_ioctl(file_priv, board, arg);
 	default:
 		retval = -ENOTTY;
 		goto done;
@@ -1107,6 +1274,382 @@ static int write_ioctl(struct gpib_file_private *file_priv, struct gpib_board *b
 	return retval;
 }
 
+/*
+ * Copy n bytes between buffer and the user segments, starting at segment
+ * *seg and byte *offset within it.  The position is left just past the last
+ * byte copied.  With a NULL buffer the position is only advanced.
+ */
+static int iov_copy(const struct gpib_iovec *iov, unsigned int iov_count,
+		    unsigned int *seg, u64 *offset, u8 *buffer, size_t n, bool to_user)
+{
+	while (n > 0) {
+		u8 __user *userbuf;
+		size_t block;
+
+		if (*offset == iov[*seg].len) {
+			if (*seg + 1 >= iov_count)
+				return -EINVAL;
+			++*seg;
+			*offset = 0;
+			continue;
+		}
+		block = min_t(u64, n, iov[*seg].len - *offset);
+		if (buffer) {
+			userbuf = (u8 __user *)(unsigned long)(iov[*seg].base + *offset);
+			if (to_user ? copy_to_user(userbuf, buffer, block) :
+			    copy_from_user(buffer, userbuf, block))
+				return -EFAULT;
+			buffer += block;
+		}
+		*offset += block;
+		n -= block;
+	}
+	return 0;
+}
+
+static struct gpib_iovec *iov_from_user(const struct gpib_read_write_vec_ioctl *cmd,
+					unsigned long *total)
+{
+	struct gpib_iovec *iov;
+	unsigned int i;
+
+	if (cmd->iov_count == 0 || cmd->iov_count > GPIB_MAX_IOVEC)
+		return ERR_PTR(-EINVAL);
+
+	iov = memdup_user((void __user *)(unsigned long)cmd->iov_ptr,
+			  cmd->iov_count * sizeof(*iov));
+	if (IS_ERR(iov))
+		return iov;
+
+	*total = 0;
+	for (i = 0; i < cmd->iov_count; i++) {
+		/* the count of completed bytes has to fit in 32 bits */
+		if (iov[i].len > U32_MAX - *total ||
+		    !COMPAT_ACCESS_OK((void __user *)(unsigned long)iov[i].base, iov[i].len)) {
+			kfree(iov);
+			return ERR_PTR(-EFAULT);
+		}
+		*total += iov[i].len;
+	}
+	return iov;
+}
+
+static int readv_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+		       unsigned long arg)
+{
+	struct gpib_read_write_vec_ioctl read_cmd;
+	struct gpib_iovec *iov;
+	struct gpib_descriptor *desc;
+	unsigned long total, remain;
+	unsigned int seg = 0;
+	u64 offset = 0;
+	int end_flag = 0;
+	int retval;
+	ssize_t read_ret = 0;
+	size_t nbytes;
+
+	retval = copy_from_user(&read_cmd, (void __user *)arg, sizeof(read_cmd));
+	if (retval)
+		return -EFAULT;
+
+	desc = handle_to_descriptor(file_priv, read_cmd.handle);
+	if (!desc)
+		return -EINVAL;
+
+	iov = iov_from_user(&read_cmd, &total);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	if (read_cmd.completed_transfer_count > total) {
+		kfree(iov);
+		return -EINVAL;
+	}
+	iov_copy(iov, read_cmd.iov_count, &seg, &offset, NULL,
+		 read_cmd.completed_transfer_count, true);
+	remain = total - read_cmd.completed_transfer_count;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	/* Read buffer loads, scattering each one over the segments in order */
+	while (remain > 0 && end_flag == 0) {
+		nbytes = 0;
+		read_ret = ibrd(board, board->buffer, (board->buffer_length < remain) ?
+				board->buffer_length : remain, &end_flag, &nbytes);
+		if (nbytes == 0)
+			break;
+		retval = iov_copy(iov, read_cmd.iov_count, &seg, &offset, board->buffer,
+				  nbytes, true);
+		if (retval)
+			break;
+		remain -= nbytes;
+		if (read_ret < 0)
+			break;
+	}
+	read_cmd.completed_transfer_count = total - remain;
+	read_cmd.end = end_flag;
+	read_cmd.end_segment = end_flag ? seg : 0;
+	read_cmd.end_offset = end_flag ? offset : 0;
+	/* see read_ioctl() */
+	if (remain == 0 || end_flag)
+		read_ret = 0;
+	if (retval == 0 && copy_to_user((void __user *)arg, &read_cmd, sizeof(read_cmd)))
+		retval = -EFAULT;
+
+	atomic_set(&desc->io_in_progress, 0);
+
+	wake_up_interruptible(&board->wait);
+	kfree(iov);
+	if (retval)
+		return retval;
+
+	return read_ret;
+}
+
+static int writev_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			unsigned long arg)
+{
+	struct gpib_read_write_vec_ioctl write_cmd;
+	struct gpib_iovec *iov;
+	struct gpib_descriptor *desc;
+	unsigned long total, remain;
+	unsigned int seg = 0;
+	u64 offset = 0;
+	int retval = 0;
+	int fault = 0;
+
+	if (copy_from_user(&write_cmd, (void __user *)arg, sizeof(write_cmd)))
+		return -EFAULT;
+
+	desc = handle_to_descriptor(file_priv, write_cmd.handle);
+	if (!desc)
+		return -EINVAL;
+
+	iov = iov_from_user(&write_cmd, &total);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	if (write_cmd.completed_transfer_count > total) {
+		kfree(iov);
+		return -EINVAL;
+	}
+	iov_copy(iov, write_cmd.iov_count, &seg, &offset, NULL,
+		 write_cmd.completed_transfer_count, false);
+	remain = total - write_cmd.completed_transfer_count;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	/*
+	 * Gather as many segments as fit into each buffer load, so a short
+	 * header and the start of its payload go out in one driver call.
+	 */
+	while (remain > 0) {
+		unsigned int load_seg = seg;
+		u64 load_offset = offset;
+		size_t load = (board->buffer_length < remain) ? board->buffer_length : remain;
+		size_t bytes_written = 0;
+		int send_eoi;
+
+		send_eoi = load == remain && write_cmd.end;
+		fault = iov_copy(iov, write_cmd.iov_count, &load_seg, &load_offset,
+				 board->buffer, load, false);
+		if (fault) {
+			retval = fault;
+			break;
+		}
+		retval = ibwrt(board, board->buffer, load, send_eoi, &bytes_written);
+		iov_copy(iov, write_cmd.iov_count, &seg, &offset, NULL, bytes_written, false);
+		remain -= bytes_written;
+		if (retval < 0)
+			break;
+	}
+	write_cmd.completed_transfer_count = total - remain;
+	/* see write_ioctl() */
+	if (remain == 0)
+		retval = 0;
+	if (fault == 0 && copy_to_user((void __user *)arg, &write_cmd, sizeof(write_cmd)))
+		fault = -EFAULT;
+
+	atomic_set(&desc->io_in_progress, 0);
+
+	wake_up_interruptible(&board->wait);
+	kfree(iov);
+	if (fault)
+		return fault;
+
+	return retval;
+}
+
+/*
+ * The file ioctls read or write the file through the page cache straight
+ * from and into the board's buffer, so the data never passes through user
+ * space and the whole file goes out in one ioctl.
+ */
+static int read_file_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			   unsigned long arg)
+{
+	struct gpib_file_io_ioctl read_cmd;
+	struct gpib_descriptor *desc;
+	struct file *filep;
+	u64 remain;
+	loff_t pos;
+	int end_flag = 0;
+	ssize_t read_ret = 0;
+	size_t nbytes;
+
+	if (copy_from_user(&read_cmd, (void __user *)arg, sizeof(read_cmd)))
+		return -EFAULT;
+
+	if (read_cmd.completed_transfer_count > read_cmd.requested_transfer_count)
+		return -EINVAL;
+
+	desc = handle_to_descriptor(file_priv, read_cmd.handle);
+	if (!desc)
+		return -EINVAL;
+
+	filep = fget(read_cmd.fd);
+	if (!filep)
+		return -EBADF;
+	if (!(filep->f_mode & FMODE_WRITE)) {
+		fput(filep);
+		return -EBADF;
+	}
+
+	pos = read_cmd.offset + read_cmd.completed_transfer_count;
+	remain = read_cmd.requested_transfer_count - read_cmd.completed_transfer_count;
+	read_cmd.file_error = 0;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	while (remain > 0 && end_flag == 0) {
+		ssize_t written;
+
+		nbytes = 0;
+		read_ret = ibrd(board, board->buffer, min_t(u64, board->buffer_length, remain),
+				&end_flag, &nbytes);
+		if (nbytes == 0)
+			break;
+		written = kernel_write(filep, board->buffer, nbytes, &pos);
+		if (written != nbytes) {
+			read_cmd.file_error = written < 0 ? -written : EIO;
+			break;
+		}
+		remain -= nbytes;
+		if (read_ret < 0)
+			break;
+	}
+	read_cmd.completed_transfer_count = read_cmd.requested_transfer_count - remain;
+	read_cmd.end = end_flag;
+	/* see read_ioctl() */
+	if (remain == 0 || end_flag)
+		read_ret = 0;
+
+	atomic_set(&desc->io_in_progress, 0);
+
+	wake_up_interruptible(&board->wait);
+	fput(filep);
+	if (copy_to_user((void __user *)arg, &read_cmd, sizeof(read_cmd)))
+		return -EFAULT;
+
+	return read_ret;
+}
+
+// length of data up to and including the first eos character, 0 if there is none
+static size_t eos_length(const u8 *data, size_t length, int eos, int eos_flags)
+{
+	u8 mask = (eos_flags & BIN) ? 0xff : 0x7f;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		if ((data[i] & mask) == (eos & mask))
+			return i + 1;
+	}
+	return 0;
+}
+
+static int write_file_ioctl(struct gpib_file_private *file_priv, struct gpib_board *board,
+			    unsigned long arg)
+{
+	struct gpib_file_io_ioctl write_cmd;
+	struct gpib_descriptor *desc;
+	struct file *filep;
+	u64 remain;
+	loff_t pos;
+	int retval = 0;
+
+	if (copy_from_user(&write_cmd, (void __user *)arg, sizeof(write_cmd)))
+		return -EFAULT;
+
+	if (write_cmd.completed_transfer_count > write_cmd.requested_transfer_count)
+		return -EINVAL;
+
+	desc = handle_to_descriptor(file_priv, write_cmd.handle);
+	if (!desc)
+		return -EINVAL;
+
+	filep = fget(write_cmd.fd);
+	if (!filep)
+		return -EBADF;
+	if (!(filep->f_mode & FMODE_READ)) {
+		fput(filep);
+		return -EBADF;
+	}
+
+	pos = write_cmd.offset + write_cmd.completed_transfer_count;
+	remain = write_cmd.requested_transfer_count - write_cmd.completed_transfer_count;
+	write_cmd.file_error = 0;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	while (remain > 0) {
+		size_t load, offset = 0;
+		ssize_t got;
+
+		got = kernel_read(filep, board->buffer, min_t(u64, board->buffer_length, remain), &pos);
+		if (got <= 0) {
+			// a file shorter than requested is an error too
+			write_cmd.file_error = got < 0 ? -got : EIO;
+			break;
+		}
+		load = got;
+
+		while (offset < load) {
+			size_t block = load - offset;
+			size_t bytes_written = 0;
+			int send_eoi;
+
+			send_eoi = block == remain && write_cmd.end;
+			if (write_cmd.eos_flags & XEOS) {
+				size_t eos_block = eos_length(board->buffer + offset, block,
+							      write_cmd.eos, write_cmd.eos_flags);
+
+				if (eos_block) {
+					block = eos_block;
+					send_eoi = 1;
+				}
+			}
+			retval = ibwrt(board, board->buffer + offset, block, send_eoi, &bytes_written);
+			offset += bytes_written;
+			remain -= bytes_written;
+			if (retval < 0)
+				goto out;
+		}
+	}
+out:
+	write_cmd.completed_transfer_count = write_cmd.requested_transfer_count - remain;
+	/* see write_ioctl() */
+	if (remain == 0)
+		retval = 0;
+
+	atomic_set(&desc->io_in_progress, 0);
+
+	wake_up_interruptible(&board->wait);
+	fput(filep);
+	if (copy_to_user((void __user *)arg, &write_cmd, sizeof(write_cmd)))
+		return -EFAULT;
+
+	return retval;
+}
+
 static int status_bytes_ioctl(struct gpib_board *board, unsigned long arg)
 {
 	struct gpib_status_queue *device;
@@ -2020,6 +2563,207 @@ static int t1_delay_ioctl(struct gpib_board *board, unsigned long arg)
 	return 0;
 }
 
+static int stream_start_ioctl(struct gpib_file_private *file_priv,
+			      struct gpib_board *board, unsigned long arg)
+{
+	struct gpib_stream_ioctl cmd;
+	struct gpib_descriptor *desc;
+	int retval;
+
+	retval = copy_from_user(&cmd, (void __user *)arg, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+
+	desc = handle_to_descriptor(file_priv, cmd.handle);
+	if (!desc)
+		return -EINVAL;
+
+	retval = gpib_stream_start(board, file_priv, &cmd);
+	if (retval < 0)
+		return retval;
+
+	retval = copy_to_user((void __user *)arg, &cmd, sizeof(cmd));
+	if (retval) {
+		gpib_stream_stop(board);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static int responder_start_ioctl(struct gpib_file_private *file_priv,
+				 struct gpib_board *board, unsigned long arg)
+{
+	struct gpib_responder_ioctl cmd;
+	int retval;
+
+	retval = copy_from_user(&cmd, (void __user *)arg, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+
+	return gpib_responder_start(board, file_priv, &cmd);
+}
+
+static int responder_message_ioctl(struct gpib_board *board, unsigned int cmd,
+				   unsigned long arg)
+{
+	struct gpib_responder_message_ioctl message;
+	int retval;
+
+	retval = copy_from_user(&message, (void __user *)arg, sizeof(message));
+	if (retval)
+		return -EFAULT;
+
+	if (cmd == IBRESPONDER_QUEUE)
+		retval = gpib_responder_queue(board, &message);
+	else
+		retval = gpib_responder_read(board, &message);
+
+	/* bytes read are reported even when the read ends in an error */
+	if (copy_to_user((void __user *)arg, &message, sizeof(message)))
+		return -EFAULT;
+
+	return retval;
+}
+
+/* default settle time for listener probes, same as the old per address delay */
+static const unsigned int probe_listeners_default_settle_usec = 1500;
+
+static int probe_listeners_ioctl(struct gpib_board *board, unsigned long arg)
+{
+	struct gpib_probe_listeners_ioctl cmd;
+	struct gpib_probe_address *addresses;
+	unsigned int settle_usec;
+	unsigned int num_found;
+	unsigned int i;
+	ktime_t start;
+	int retval;
+
+	retval = copy_from_user(&cmd, (void __user *)arg, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+
+	if (cmd.num_addresses == 0 || cmd.num_addresses > GPIB_MAX_PROBE_ADDRESSES)
+		return -EINVAL;
+	if (cmd.flags & ~GPIB_PROBE_ANY)
+		return -EINVAL;
+	settle_usec = cmd.settle_usec ? cmd.settle_usec : probe_listeners_default_settle_usec;
+	if (settle_usec > USEC_PER_SEC)
+		return -EINVAL;
+
+	addresses = memdup_user((void __user *)(unsigned long)cmd.address_ptr,
+				cmd.num_addresses * sizeof(*addresses));
+	if (IS_ERR(addresses))
+		return PTR_ERR(addresses);
+	for (i = 0; i < cmd.num_addresses; i++) {
+		if (addresses[i].pad > MAX_GPIB_PRIMARY_ADDRESS ||
+		    addresses[i].sad > MAX_GPIB_SECONDARY_ADDRESS) {
+			kfree(addresses);
+			return -EINVAL;
+		}
+	}
+
+	start = ktime_get();
+	retval = ibprobe_listeners(board, addresses, cmd.num_addresses, settle_usec,
+				   cmd.flags & GPIB_PROBE_ANY, &num_found, &cmd.num_probes);
+	cmd.elapsed_usec = ktime_us_delta(ktime_get(), start);
+	if (retval < 0) {
+		kfree(addresses);
+		return retval;
+	}
+	dev_dbg(board->gpib_dev, "found %u of %u listeners in %u probes, %u usec\n",
+		num_found, cmd.num_addresses, cmd.num_probes, cmd.elapsed_usec);
+	cmd.num_addresses = num_found;
+
+	retval = copy_to_user((void __user *)(unsigned long)cmd.address_ptr, addresses,
+			      num_found * sizeof(*addresses));
+	kfree(addresses);
+	if (retval)
+		return -EFAULT;
+	retval = copy_to_user((void __user *)arg, &cmd, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+
+	return 0;
+}
+
+static int transfer_engine_ioctl(struct gpib_board *board, unsigned long arg)
+{
+	struct gpib_transfer_engine_ioctl cmd;
+	unsigned int engines;
+	int retval;
+
+	if (!board->interface->transfer_engines)
+		return -ENOENT;
+
+	retval = copy_from_user(&cmd, (void __user *)arg, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+	if (cmd.flags & ~GPIB_XFER_QUERY)
+		return -EINVAL;
+
+	engines = board->interface->transfer_engines(board) | (1 << GPIB_XFER_DEFAULT);
+	if ((engines & (1 << GPIB_XFER_DMA)) &&
+	    (engines & ((1 << GPIB_XFER_PIO) | (1 << GPIB_XFER_FIFO))))
+		engines |= 1 << GPIB_XFER_AUTO;
+
+	if ((cmd.flags & GPIB_XFER_QUERY) == 0) {
+		if (cmd.engine >= GPIB_XFER_NUM_ENGINES || (engines & (1 << cmd.engine)) == 0)
+			return -EINVAL;
+		board->transfer_engine = cmd.engine;
+		board->small_transfer_engine = (engines & (1 << GPIB_XFER_FIFO)) ?
+			GPIB_XFER_FIFO : GPIB_XFER_PIO;
+		if (cmd.dma_threshold)
+			board->dma_threshold = cmd.dma_threshold;
+	}
+	cmd.engine = board->transfer_engine;
+	cmd.dma_threshold = board->dma_threshold;
+	cmd.engines = engines;
+
+	retval = copy_to_user((void __user *)arg, &cmd, sizeof(cmd));
+	if (retval)
+		return -EFAULT;
+
+	return 0;
+}
+
+static int ibmmap(struct file *filep, struct vm_area_struct *vma)
+{
+	unsigned int minor = iminor(file_inode(filep));
+	struct gpib_board *board;
+	int retval;
+
+	if (minor >= GPIB_MAX_NUM_BOARDS) {
+		pr_err("gpib: invalid minor number of device file\n");
+		return -ENODEV;
+	}
+	board = &board_array[minor];
+
+	if (mutex_lock_interruptible(&board->big_gpib_mutex))
+		return -ERESTARTSYS;
+	retval = gpib_stream_mmap(board, vma);
+	mutex_unlock(&board->big_gpib_mutex);
+
+	return retval;
+}
+
+static __poll_t ibpoll(struct file *filep, poll_table *wait)
+{
+	unsigned int minor = iminor(file_inode(filep));
+	struct gpib_board *board;
+	__poll_t mask;
+
+	if (minor >= GPIB_MAX_NUM_BOARDS)
+		return EPOLLERR;
+	board = &board_array[minor];
+
+	mutex_lock(&board->big_gpib_mutex);
+	mask = gpib_stream_poll(board, filep, wait);
+	mutex_unlock(&board->big_gpib_mutex);
+
+	return mask;
+}
+
 static const struct file_operations ib_fops = {
 	.owner = THIS_MODULE,
 	.llseek = NULL,
@@ -2027,6 +2771,8 @@ static const struct file_operations ib_fops = {
 	.compat_ioctl = &ibioctl,
 	.open = &ibopen,
 	.release = &ibclose,
+	.mmap = &ibmmap,
+	.poll = &ibpoll,
 };
 
 struct gpib_board board_array[GPIB_MAX_NUM_BOARDS];
@@ -2121,6 +2867,9 @@ void init_gpib_board(struct gpib_board *board)
 	board->online = 0;
 	board->autospollers = 0;
 	board->autospoll_task = NULL;
+	board->stream = NULL;
+	init_waitqueue_head(&board->stream_wait);
+	board->responder = NULL;
 	init_event_queue(&board->event_queue);
 	board->minor = -1;
 	init_gpib_pseudo_irq(&board->pseudo_irq);
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Device mode responder: answers the controller-in-charge from responses
+ * queued in advance and buffers what it is sent as listener, so no
+ * process has to be woken before the bus can proceed.
+ ***************************************************************************/
+
+#define dev_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include "ibsys.h"
+#include <linux/kthread.h>
+#include <linux/overflow.h>
+
+/* most responses which may wait to be sent */
+static const unsigned int gpib_responder_max_responses = 256;
+/* longest single response */
+static const size_t gpib_responder_max_response = 1 << 20;
+/* largest listener buffer */
+static const size_t gpib_responder_max_listen_size = 1 << 24;
+/*
+ * Addressing is checked at least this often, for boards whose interrupt
+ * handler doesn't wake board->wait when the board is addressed.  The
+ * interval doubles while the board stays unaddressed, up to the longest,
+ * since update_status() may be a usb transfer.
+ */
+static const long gpib_responder_poll_jiffies = 1;
+static const unsigned int gpib_responder_max_poll_msecs = 20;
+
+struct gpib_responder_msg {
+	struct list_head list;
+	size_t length;
+	/* bytes already sent, or already read by user space */
+	size_t offset;
+	int end;
+	u8 data[];
+};
+
+static void gpib_responder_free_list(struct list_head *head)
+{
+	struct gpib_responder_msg *msg, *next;
+
+	list_for_each_entry_safe(msg, next, head, list) {
+		list_del(&msg->list);
+		kvfree(msg);
+	}
+}
+
+/* a device clear empties the output queue and the input buffer, IEEE 488.2 5.8 */
+static void gpib_responder_clear(struct gpib_responder *responder)
+{
+	mutex_lock(&responder->lock);
+	gpib_responder_free_list(&responder->responses);
+	responder->num_responses = 0;
+	gpib_responder_free_list(&responder->received);
+	responder->received_bytes = 0;
+	mutex_unlock(&responder->lock);
+}
+
+static int gpib_responder_can_talk(struct gpib_board *board, struct gpib_responder *responder)
+{
+	return test_bit(TACS_NUM, &board->status) && READ_ONCE(responder->num_responses);
+}
+
+static int gpib_responder_can_listen(struct gpib_board *board, struct gpib_responder *responder)
+{
+	return test_bit(LACS_NUM, &board->status) &&
+		READ_ONCE(responder->received_bytes) < responder->listen_size;
+}
+
+static int gpib_responder_talk(struct gpib_board *board, struct gpib_responder *responder)
+{
+	struct gpib_responder_msg *msg;
+	size_t bytes_written = 0;
+	int retval;
+
+	/* only this thread removes responses, so msg stays put while it is sent */
+	mutex_lock(&responder->lock);
+	msg = list_first_entry_or_null(&responder->responses, struct gpib_responder_msg, list);
+	mutex_unlock(&responder->lock);
+	if (!msg)
+		return 0;
+
+	retval = ibwrt(board, msg->data + msg->offset, msg->length - msg->offset, msg->end,
+		       &bytes_written);
+	msg->offset += bytes_written;
+	if (retval == -EINTR) {
+		gpib_responder_clear(responder);
+		return 0;
+	}
+	/* a controller that stops listening part way through gets the rest next time */
+	if (retval == -ETIMEDOUT)
+		return 0;
+	if (retval < 0)
+		return retval;
+
+	mutex_lock(&responder->lock);
+	list_del(&msg->list);
+	responder->num_responses--;
+	mutex_unlock(&responder->lock);
+	kvfree(msg);
+	push_gpib_event(board, EVENT_RESPONSE_SENT);
+	return 0;
+}
+
+static int gpib_responder_listen(struct gpib_board *board, struct gpib_responder *responder)
+{
+	struct gpib_responder_msg *msg;
+	size_t space, nbytes = 0;
+	int end = 0;
+	int retval;
+
+	space = responder->listen_size - READ_ONCE(responder->received_bytes);
+	space = min_t(size_t, space, board->buffer_length);
+	retval = ibrd(board, board->buffer, space, &end, &nbytes);
+	if (nbytes) {
+		msg = kvmalloc(struct_size(msg, data, nbytes), GFP_KERNEL);
+		if (!msg)
+			return -ENOMEM;
+		memcpy(msg->data, board->buffer, nbytes);
+		msg->length = nbytes;
+		msg->offset = 0;
+		msg->end = end;
+		mutex_lock(&responder->lock);
+		list_add_tail(&msg->list, &responder->received);
+		responder->received_bytes += nbytes;
+		mutex_unlock(&responder->lock);
+		wake_up_interruptible(&responder->wait);
+	}
+	if (retval == -EINTR) {
+		gpib_responder_clear(responder);
+		return 0;
+	}
+	/* a quiet talker is not an error */
+	if (retval == -ETIMEDOUT)
+		return 0;
+	return retval;
+}
+
+static int gpib_responder_thread(void *data)
+{
+	struct gpib_board *board = data;
+	struct gpib_responder *responder = board->responder;
+	long max_poll_jiffies = max(msecs_to_jiffies(gpib_responder_max_poll_msecs), 1UL);
+	long poll_jiffies = gpib_responder_poll_jiffies;
+	int retval = 0;
+
+	dev_dbg(board->gpib_dev, "entering responder thread\n");
+
+	while (!atomic_read(&responder->stop)) {
+		board->interface->update_status(board, 0);
+		if (gpib_responder_can_talk(board, responder)) {
+			retval = gpib_responder_talk(board, responder);
+		} else if (gpib_responder_can_listen(board, responder)) {
+			retval = gpib_responder_listen(board, responder);
+		} else {
+			if (!wait_event_interruptible_timeout(board->wait,
+							      atomic_read(&responder->stop) ||
+							      gpib_responder_can_talk(board, responder) ||
+							      gpib_responder_can_listen(board, responder),
+							      poll_jiffies))
+				poll_jiffies = min(2 * poll_jiffies, max_poll_jiffies);
+			continue;
+		}
+		poll_jiffies = gpib_responder_poll_jiffies;
+		if (retval < 0) {
+			if (!atomic_read(&responder->stop))
+				responder->error = -retval;
+			break;
+		}
+	}
+
+	atomic_set(&responder->active, 0);
+	wake_up_interruptible(&responder->wait);
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+	}
+	dev_dbg(board->gpib_dev, "exiting responder thread\n");
+	return retval;
+}
+
+/*
+ * Start answering the controller in the background.  Until
+ * gpib_responder_stop() is called the thread owns the board's data
+ * transfers and other io ioctls are refused.
+ */
+int gpib_responder_start(struct gpib_board *board, struct gpib_file_private *file_priv,
+			 const struct gpib_responder_ioctl *cmd)
+{
+	struct gpib_responder *responder;
+
+	if (board->responder || board->stream)
+		return -EBUSY;
+	if (cmd->flags || cmd->listen_buffer_size > gpib_responder_max_listen_size)
+		return -EINVAL;
+
+	responder = kzalloc(sizeof(*responder), GFP_KERNEL);
+	if (!responder)
+		return -ENOMEM;
+	responder->file_priv = file_priv;
+	mutex_init(&responder->lock);
+	INIT_LIST_HEAD(&responder->responses);
+	INIT_LIST_HEAD(&responder->received);
+	responder->listen_size = cmd->listen_buffer_size;
+	init_waitqueue_head(&responder->wait);
+	atomic_set(&responder->stop, 0);
+	atomic_set(&responder->active, 1);
+
+	board->responder = responder;
+	responder->task = kthread_run(&gpib_responder_thread, board, "gpib%d_responder",
+				      board->minor);
+	if (IS_ERR(responder->task)) {
+		int retval = PTR_ERR(responder->task);
+
+		dev_err(board->gpib_dev, "failed to create responder thread\n");
+		board->responder = NULL;
+		kfree(responder);
+		return retval;
+	}
+	return 0;
+}
+
+int gpib_responder_stop(struct gpib_board *board)
+{
+	struct gpib_responder *responder = board->responder;
+
+	if (!responder)
+		return -EINVAL;
+
+	atomic_set(&responder->stop, 1);
+	/* abort a transfer in progress the same way the watchdog timer would */
+	while (atomic_read(&responder->active)) {
+		set_bit(TIMO_NUM, &board->status);
+		wake_up_interruptible(&board->wait);
+		usleep_range(100, 200);
+	}
+	kthread_stop(responder->task);
+	clear_bit(TIMO_NUM, &board->status);
+
+	board->responder = NULL;
+	wake_up_interruptible(&responder->wait);
+	gpib_responder_free_list(&responder->responses);
+	gpib_responder_free_list(&responder->received);
+	kfree(responder);
+	return 0;
+}
+
+int gpib_responder_queue(struct gpib_board *board, struct gpib_responder_message_ioctl *cmd)
+{
+	struct gpib_responder *responder = board->responder;
+	struct gpib_responder_msg *msg;
+
+	if (!responder)
+		return -EINVAL;
+	if (cmd->count == 0 || cmd->count > gpib_responder_max_response)
+		return -EINVAL;
+	if (!atomic_read(&responder->active))
+		return responder->error ? -responder->error : -EPIPE;
+
+	msg = kvmalloc(struct_size(msg, data, cmd->count), GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+	if (copy_from_user(msg->data, (void __user *)(unsigned long)cmd->buffer_ptr, cmd->count)) {
+		kvfree(msg);
+		return -EFAULT;
+	}
+	msg->length = cmd->count;
+	msg->offset = 0;
+	msg->end = cmd->end != 0;
+
+	mutex_lock(&responder->lock);
+	if (responder->num_responses >= gpib_responder_max_responses) {
+		mutex_unlock(&responder->lock);
+		kvfree(msg);
+		return -EAGAIN;
+	}
+	list_add_tail(&msg->list, &responder->responses);
+	responder->num_responses++;
+	cmd->pending = responder->num_responses;
+	mutex_unlock(&responder->lock);
+
+	/* the thread may already be addressed as talker, waiting for this */
+	wake_up_interruptible(&board->wait);
+	return 0;
+}
+
+/*
+ * Take up to cmd->count bytes of listener data, stopping after a byte
+ * received with END.  Waits up to cmd->usec_timeout for data to arrive.
+ */
+int gpib_responder_read(struct gpib_board *board, struct gpib_responder_message_ioctl *cmd)
+{
+	struct gpib_responder *responder = board->responder;
+	u8 __user *userbuf = (u8 __user *)(unsigned long)cmd->buffer_ptr;
+	size_t count = 0;
+	long timeout;
+	int retval = 0;
+
+	cmd->end = 0;
+	if (!responder || responder->listen_size == 0)
+		return -EINVAL;
+	if (cmd->count == 0)
+		return 0;
+
+	timeout = cmd->usec_timeout ? usec_to_jiffies(cmd->usec_timeout) : MAX_SCHEDULE_TIMEOUT;
+	timeout = wait_event_interruptible_timeout(responder->wait,
+						   READ_ONCE(responder->received_bytes) ||
+						   !atomic_read(&responder->active),
+						   timeout);
+	if (timeout < 0)
+		return timeout;
+
+	mutex_lock(&responder->lock);
+	while (count < cmd->count && !cmd->end) {
+		struct gpib_responder_msg *msg;
+		size_t n;
+
+		msg = list_first_entry_or_null(&responder->received, struct gpib_responder_msg, list);
+		if (!msg)
+			break;
+		n = min_t(size_t, msg->length - msg->offset, cmd->count - count);
+		if (copy_to_user(userbuf + count, msg->data + msg->offset, n)) {
+			retval = -EFAULT;
+			break;
+		}
+		count += n;
+		msg->offset += n;
+		responder->received_bytes -= n;
+		if (msg->offset == msg->length) {
+			cmd->end = msg->end;
+			list_del(&msg->list);
+			kvfree(msg);
+		}
+	}
+	cmd->pending = responder->num_responses;
+	mutex_unlock(&responder->lock);
+
+	if (retval == 0 && count == 0) {
+		if (atomic_read(&responder->active))
+			retval = -ETIMEDOUT;
+		else
+			retval = responder->error ? -responder->error : -EPIPE;
+	}
+	cmd->count = count;
+	/* room for the thread to accept more data */
+	wake_up_interruptible(&board->wait);
+	return retval;
+}
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Continuous streaming acquisition into a ring buffer shared with user space
+ ***************************************************************************/
+
+#define dev_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include "ibsys.h"
+#include <linux/kthread.h>
+#include <linux/log2.h>
+#include <linux/vmalloc.h>
+
+/* largest data area we will allocate for a stream */
+static const unsigned int gpib_stream_max_size = 1 << 26;
+/*
+ * Most bytes handed to a single ibrd() call.  Keeping this small bounds the
+ * latency between a byte arriving and the consumer seeing head move past it.
+ */
+static const size_t gpib_stream_chunk = 0x4000;
+
+static void gpib_stream_release(struct kref *ref)
+{
+	struct gpib_stream *stream = container_of(ref, struct gpib_stream, ref);
+
+	vfree(stream->area);
+	kfree(stream);
+}
+
+static void gpib_stream_vm_open(struct vm_area_struct *vma)
+{
+	struct gpib_stream *stream = vma->vm_private_data;
+
+	kref_get(&stream->ref);
+}
+
+static void gpib_stream_vm_close(struct vm_area_struct *vma)
+{
+	struct gpib_stream *stream = vma->vm_private_data;
+
+	kref_put(&stream->ref, gpib_stream_release);
+}
+
+static const struct vm_operations_struct gpib_stream_vm_ops = {
+	.open = gpib_stream_vm_open,
+	.close = gpib_stream_vm_close,
+};
+
+static void gpib_stream_mark_end(struct gpib_stream *stream, u64 head)
+{
+	struct gpib_stream_ring *ring = stream->ring;
+	u64 count = stream->end_count++;
+
+	WRITE_ONCE(ring->end_marks[count % GPIB_STREAM_NUM_END_MARKS], head);
+	/* publish the mark before the count which makes it visible */
+	smp_store_release(&ring->end_count, count + 1);
+}
+
+/* clear GPIB_STREAM_ACTIVE and tell the consumer and gpib_stream_stop() */
+static void gpib_stream_finish(struct gpib_board *board, struct gpib_stream *stream)
+{
+	stream->flags &= ~GPIB_STREAM_ACTIVE;
+	smp_store_release(&stream->ring->flags, stream->flags);
+	complete(&stream->done);
+	wake_up_interruptible(&board->stream_wait);
+}
+
+static int gpib_stream_thread(void *data)
+{
+	struct gpib_board *board = data;
+	struct gpib_stream *stream = board->stream;
+	struct gpib_stream_ring *ring = stream->ring;
+	int stalled = 0;
+	int retval = 0;
+
+	dev_dbg(board->gpib_dev, "entering stream thread\n");
+
+	while (!atomic_read(&stream->stop)) {
+		u64 head = stream->head;
+		u64 tail = smp_load_acquire(&ring->tail);
+		size_t offset = head & (stream->size - 1);
+		size_t space, nbytes = 0;
+		int end = 0;
+
+		/* don't trust a tail from user space that isn't inside the ring */
+		if (tail > head || head - tail > stream->size)
+			tail = head - min_t(u64, head, stream->size);
+		space = stream->size - (head - tail);
+		if (space == 0) {
+			/*
+			 * Consumer fell behind.  Not reading holds off the talker
+			 * through the handshake, so nothing is lost, but record it.
+			 */
+			if (!stalled)
+				WRITE_ONCE(ring->overruns, ++stream->overruns);
+			stalled = 1;
+			schedule_timeout_interruptible(1);
+			continue;
+		}
+		stalled = 0;
+
+		space = min(space, stream->size - offset);
+		space = min(space, gpib_stream_chunk);
+		retval = ibrd(board, stream->data + offset, space, &end, &nbytes);
+		if (nbytes) {
+			/* read by gpib_stream_poll() without the thread's ordering */
+			WRITE_ONCE(stream->head, head + nbytes);
+			smp_store_release(&ring->head, head + nbytes);
+			if (end)
+				gpib_stream_mark_end(stream, head + nbytes);
+			wake_up_interruptible(&board->stream_wait);
+		}
+		/* a quiet talker is not an error while streaming */
+		if (retval == -ETIMEDOUT)
+			continue;
+		if (retval < 0) {
+			if (!atomic_read(&stream->stop))
+				WRITE_ONCE(ring->error, -retval);
+			break;
+		}
+		if (end && (stream->flags & GPIB_STREAM_STOP_ON_END))
+			break;
+	}
+
+	gpib_stream_finish(board, stream);
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+	}
+	dev_dbg(board->gpib_dev, "exiting stream thread\n");
+	return retval;
+}
+
+/*
+ * Start a streaming acquisition.  The caller must already have addressed
+ * the talker and the board as listener.  Until gpib_stream_stop() is called
+ * the board keeps reading into the ring and other io ioctls are refused.
+ */
+int gpib_stream_start(struct gpib_board *board, struct gpib_file_private *file_priv,
+		      struct gpib_stream_ioctl *cmd)
+{
+	struct gpib_stream *stream;
+	unsigned int size;
+
+	if (board->stream)
+		return -EBUSY;
+	if (cmd->ring_size == 0 || cmd->ring_size > gpib_stream_max_size)
+		return -EINVAL;
+	if (cmd->flags & ~GPIB_STREAM_STOP_ON_END)
+		return -EINVAL;
+
+	size = roundup_pow_of_two(max_t(unsigned int, cmd->ring_size, PAGE_SIZE));
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (!stream)
+		return -ENOMEM;
+	kref_init(&stream->ref);
+	atomic_set(&stream->stop, 0);
+	init_completion(&stream->done);
+	stream->flags = cmd->flags | GPIB_STREAM_ACTIVE;
+	stream->file_priv = file_priv;
+	stream->size = size;
+	stream->area_length = PAGE_SIZE + size;
+	stream->area = vmalloc_user(stream->area_length);
+	if (!stream->area) {
+		kfree(stream);
+		return -ENOMEM;
+	}
+	stream->ring = stream->area;
+	stream->data = stream->area + PAGE_SIZE;
+	stream->ring->data_offset = PAGE_SIZE;
+	stream->ring->size = size;
+	stream->ring->flags = stream->flags;
+
+	board->stream = stream;
+	stream->task = kthread_run(&gpib_stream_thread, board, "gpib%d_stream", board->minor);
+	if (IS_ERR(stream->task)) {
+		int retval = PTR_ERR(stream->task);
+
+		dev_err(board->gpib_dev, "failed to create stream thread\n");
+		board->stream = NULL;
+		kref_put(&stream->ref, gpib_stream_release);
+		return retval;
+	}
+
+	cmd->ring_size = size;
+	cmd->map_length = stream->area_length;
+	return 0;
+}
+
+int gpib_stream_stop(struct gpib_board *board)
+{
+	struct gpib_stream *stream = board->stream;
+
+	if (!stream)
+		return -EINVAL;
+
+	atomic_set(&stream->stop, 1);
+	/*
+	 * Abort a read in progress the same way the watchdog timer would.  It
+	 * is repeated in case the thread was between reads and cleared TIMO
+	 * when starting the next one.
+	 */
+	do {
+		set_bit(TIMO_NUM, &board->status);
+		wake_up_interruptible(&board->wait);
+	} while (!wait_for_completion_timeout(&stream->done, 1));
+	kthread_stop(stream->task);
+	clear_bit(TIMO_NUM, &board->status);
+
+	board->stream = NULL;
+	wake_up_interruptible(&board->stream_wait);
+	/* autospoll stays asleep while a stream owns the bus */
+	wake_up_interruptible(&board->wait);
+	/* the ring itself lives on until the last mapping of it goes away */
+	kref_put(&stream->ref, gpib_stream_release);
+	return 0;
+}
+
+int gpib_stream_mmap(struct gpib_board *board, struct vm_area_struct *vma)
+{
+	struct gpib_stream *stream = board->stream;
+	int retval;
+
+	if (!stream)
+		return -EINVAL;
+	if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > stream->area_length)
+		return -EINVAL;
+
+	retval = remap_vmalloc_range(vma, stream->area, 0);
+	if (retval)
+		return retval;
+
+	vma->vm_private_data = stream;
+	vma->vm_ops = &gpib_stream_vm_ops;
+	kref_get(&stream->ref);
+	return 0;
+}
+
+__poll_t gpib_stream_poll(struct gpib_board *board, struct file *filep, poll_table *wait)
+{
+	struct gpib_stream *stream;
+	struct gpib_stream_ring *ring;
+	__poll_t mask = 0;
+
+	poll_wait(filep, &board->stream_wait, wait);
+
+	stream = board->stream;
+	if (!stream)
+		return EPOLLERR;
+
+	ring = stream->ring;
+	if (READ_ONCE(stream->head) != READ_ONCE(ring->tail))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	if (completion_done(&stream->done))
+		mask |= EPOLLHUP;
+
+	return mask;
+}
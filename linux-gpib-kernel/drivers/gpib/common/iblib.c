@@ -9,6 +9,8 @@
 #include "ibsys.h"
 #include <linux/delay.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
 #include <linux/vmalloc.h>
 
 /*
@@ -148,14 +150,178 @@ int ibgts(struct gpib_board *board)
 	return retval;
 }
 
+/*
+ * Address a group of candidates as listeners, with the board as talker,
+ * and release ATN.  Devices which were not addressed let go of NDAC and
+ * NRFD as soon as they see ATN drop, so if both lines stay released there
+ * is no listener in the group and we need not wait out the settle time.
+ * They have to stay released for a while, since a slow device may not have
+ * asserted NDAC again yet right after the last command byte.
+ * Returns 1 if some candidate is listening, 0 if none is.
+ */
+static const unsigned int probe_released_usec = 50;
+
+static int probe_listener_group(struct gpib_board *board, u8 *cmd,
+				const struct gpib_probe_address *addresses,
+				unsigned int count, unsigned int settle_usec)
+{
+	size_t length = 0;
+	size_t bytes_written;
+	ktime_t deadline, released = 0;
+	unsigned int i;
+	int lines;
+	int retval;
+
+	cmd[length++] = UNL;
+	cmd[length++] = MTA(board->pad);
+	if (board->sad >= 0)
+		cmd[length++] = MSA(board->sad);
+	for (i = 0; i < count; i++) {
+		cmd[length++] = MLA(addresses[i].pad);
+		if (addresses[i].sad >= 0)
+			cmd[length++] = MSA(addresses[i].sad);
+	}
+	retval = ibcmd(board, cmd, length, &bytes_written);
+	if (retval < 0)
+		return retval;
+	retval = ibgts(board);
+	if (retval < 0)
+		return retval;
+
+	deadline = ktime_add_us(ktime_get(), settle_usec);
+	while (1) {
+		ktime_t now;
+
+		lines = board->interface->line_status(board);
+		if (lines < 0)
+			return lines;
+		now = ktime_get();
+		if (((lines & VALID_NDAC) == 0 || (lines & BUS_NDAC) == 0) &&
+		    ((lines & VALID_NRFD) == 0 || (lines & BUS_NRFD) == 0)) {
+			if (!released)
+				released = now;
+			if (ktime_us_delta(now, released) >= min(probe_released_usec, settle_usec))
+				return 0;
+		} else {
+			released = 0;
+		}
+		if (ktime_after(now, deadline))
+			break;
+		usleep_range(10, 20);
+	}
+
+	return 1;
+}
+
+/*
+ * Search addresses[0..count) for listeners, appending those found to
+ * found[].  If present is set, the caller already knows some address in
+ * the range has a listener.
+ */
+static int probe_listener_range(struct gpib_board *board, u8 *cmd,
+				const struct gpib_probe_address *addresses, unsigned int count,
+				unsigned int settle_usec, int present,
+				struct gpib_probe_address *found, unsigned int *num_found,
+				unsigned int *num_probes)
+{
+	unsigned int half;
+	int retval;
+
+	if (!present) {
+		++*num_probes;
+		retval = probe_listener_group(board, cmd, addresses, count, settle_usec);
+		if (retval <= 0)
+			return retval;
+	}
+	if (count == 1) {
+		found[(*num_found)++] = addresses[0];
+		return 0;
+	}
+
+	half = count / 2;
+	++*num_probes;
+	retval = probe_listener_group(board, cmd, addresses, half, settle_usec);
+	if (retval < 0)
+		return retval;
+	if (retval > 0) {
+		retval = probe_listener_range(board, cmd, addresses, half, settle_usec, 1,
+					      found, num_found, num_probes);
+		if (retval < 0)
+			return retval;
+		/* the second half still has to be checked */
+		present = 0;
+	} else {
+		/* somebody answered for the whole range, and it wasn't the first half */
+		present = 1;
+	}
+	return probe_listener_range(board, cmd, addresses + half, count - half, settle_usec,
+				    present, found, num_found, num_probes);
+}
+
+/*
+ * IBPROBE_LISTENERS
+ * Find which of the candidate addresses have a listener.  The candidates
+ * found are moved to the front of addresses[] and their number is returned
+ * in num_found.  If any is set, the group is probed once and num_found is
+ * just 0 or 1.  The board is left in standby as talker; the caller
+ * should unaddress the bus afterwards.
+ */
+int ibprobe_listeners(struct gpib_board *board, struct gpib_probe_address *addresses,
+		      unsigned int count, unsigned int settle_usec, int any,
+		      unsigned int *num_found, unsigned int *num_probes)
+{
+	struct gpib_probe_address *found;
+	u8 *cmd;
+	int retval;
+
+	*num_found = 0;
+	*num_probes = 0;
+	if (!board->interface->line_status)
+		return -EOPNOTSUPP;
+	if (count == 0)
+		return 0;
+
+	if (any) {
+		cmd = kmalloc(3 + 2 * count, GFP_KERNEL);
+		if (!cmd)
+			return -ENOMEM;
+		*num_probes = 1;
+		retval = probe_listener_group(board, cmd, addresses, count, settle_usec);
+		kfree(cmd);
+		if (retval < 0)
+			return retval;
+		*num_found = retval;
+		return 0;
+	}
+
+	found = kmalloc_array(count, sizeof(*found), GFP_KERNEL);
+	if (!found)
+		return -ENOMEM;
+	cmd = kmalloc(3 + 2 * count, GFP_KERNEL);
+	if (!cmd) {
+		kfree(found);
+		return -ENOMEM;
+	}
+
+	retval = probe_listener_range(board, cmd, addresses, count, settle_usec, 0,
+				      found, num_found, num_probes);
+	if (retval == 0)
+		memcpy(addresses, found, *num_found * sizeof(*found));
+
+	kfree(cmd);
+	kfree(found);
+	return retval;
+}
+
 static int autospoll_wait_should_wake_up(struct gpib_board *board)
 {
 	int retval;
 
 	mutex_lock(&board->big_gpib_mutex);
 
+	/* a stream owns the bus, gpib_stream_stop() wakes us again */
 	retval = board->master && board->autospollers > 0 &&
-		!atomic_read(&board->stuck_srq) &&
+		!atomic_read(&board->stuck_srq) && !board->stream &&
 		test_and_clear_bit(SRQI_NUM, &board->status);
 
 	mutex_unlock(&board->big_gpib_mutex);
@@ -201,6 +367,11 @@ static int autospoll_thread(void *board_void)
 	return retval;
 }
 
+static unsigned int dma_threshold = 256;
+module_param(dma_threshold, uint, 0644);
+MODULE_PARM_DESC(dma_threshold,
+		 " smallest transfer in bytes done with DMA when the auto transfer engine is selected");
+
 int ibonline(struct gpib_board *board)
 {
 	int retval;
@@ -215,6 +386,9 @@ int ibonline(struct gpib_board *board)
 
 	board->dev = NULL;
 	board->local_ppoll_mode = 0;
+	board->transfer_engine = GPIB_XFER_DEFAULT;
+	board->small_transfer_engine = GPIB_XFER_PIO;
+	board->dma_threshold = dma_threshold;
 	retval = board->interface->attach(board, &board->config);
 	if (retval < 0) {
 		board->interface->detach(board);
@@ -250,6 +424,11 @@ int iboffline(struct gpib_board *board)
 	if (!board->interface)
 		return -ENODEV;
 
+	if (board->stream)
+		gpib_stream_stop(board);
+	if (board->responder)
+		gpib_responder_stop(board);
+
 	if (board->autospoll_task && !IS_ERR(board->autospoll_task)) {
 		retval = kthread_stop(board->autospoll_task);
 		if (retval)
@@ -525,7 +704,13 @@ int general_ibstatus(struct gpib_board *board, const struct gpib_status_queue *d
 	int status = 0;
 	short line_status;
 
-	if (board->private_data) {
+	if (board->private_data && board->stream) {
+		/*
+		 * The stream thread is using the interface, so report what its
+		 * interrupts last left behind rather than touching the chip.
+		 */
+		status = READ_ONCE(board->status) & ~TIMO;
+	} else if (board->private_data) {
 		status = board->interface->update_status(board, clear_mask);
 		/*
 		 * XXX should probably stop having drivers use TIMO bit in
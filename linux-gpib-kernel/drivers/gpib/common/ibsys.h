@@ -10,6 +10,7 @@
 #include <linux/slab.h>
 #include <linux/mm.h>
 #include <linux/timer.h>
+#include <linux/poll.h>
 
 #include <linux/io.h>
 #include <linux/uaccess.h>
@@ -32,3 +33,18 @@ struct gpib_status_queue *get_gpib_status_queue(struct gpib_board *board,
 int get_serial_poll_byte(struct gpib_board *board, unsigned int pad, int sad,
 			 unsigned int usec_timeout, u8 *poll_byte);
 int autopoll_all_devices(struct gpib_board *board);
+int ibprobe_listeners(struct gpib_board *board, struct gpib_probe_address *addresses,
+		      unsigned int count, unsigned int settle_usec, int any,
+		      unsigned int *num_found, unsigned int *num_probes);
+
+int gpib_stream_start(struct gpib_board *board, struct gpib_file_private *file_priv,
+		      struct gpib_stream_ioctl *cmd);
+int gpib_stream_stop(struct gpib_board *board);
+int gpib_stream_mmap(struct gpib_board *board, struct vm_area_struct *vma);
+__poll_t gpib_stream_poll(struct gpib_board *board, struct file *filep, poll_table *wait);
+
+int gpib_responder_start(struct gpib_board *board, struct gpib_file_private *file_priv,
+			 const struct gpib_responder_ioctl *cmd);
+int gpib_responder_stop(struct gpib_board *board);
+int gpib_responder_queue(struct gpib_board *board, struct gpib_responder_message_ioctl *cmd);
+int gpib_responder_read(struct gpib_board *board, struct gpib_responder_message_ioctl *cmd);
@@ -712,6 +712,52 @@ static int fluke_accel_read(struct gpib_board *board, u8 *buffer, size_t length,
 	return retval;
 }
 
+/*
+ * Runtime choice of transfer engine for the accelerated board types.  The
+ * fluke board type runs the chip with holdoff on end, so PIO reads switch to
+ * holdoff on all data for their duration.
+ */
+static unsigned int fluke_transfer_engines(struct gpib_board *board)
+{
+	struct fluke_priv *e_priv = board->private_data;
+	unsigned int engines = 1 << GPIB_XFER_PIO;
+
+	if (e_priv->dma_channel)
+		engines |= 1 << GPIB_XFER_DMA;
+	return engines;
+}
+
+static unsigned int fluke_default_engine(const struct fluke_priv *e_priv)
+{
+	return e_priv->dma_channel ? GPIB_XFER_DMA : GPIB_XFER_PIO;
+}
+
+static int fluke_engine_read(struct gpib_board *board, u8 *buffer, size_t length,
+			     int *end, size_t *bytes_read)
+{
+	struct fluke_priv *e_priv = board->private_data;
+	struct nec7210_priv *nec_priv = &e_priv->nec7210_priv;
+	int retval;
+
+	if (gpib_transfer_engine(board, length, fluke_default_engine(e_priv)) == GPIB_XFER_DMA)
+		return fluke_accel_read(board, buffer, length, end, bytes_read);
+
+	nec7210_set_handshake_mode(board, nec_priv, HR_HLDA);
+	retval = nec7210_read(board, nec_priv, buffer, length, end, bytes_read);
+	nec7210_set_handshake_mode(board, nec_priv, HR_HLDE);
+	return retval;
+}
+
+static int fluke_engine_write(struct gpib_board *board, u8 *buffer, size_t length,
+			      int send_eoi, size_t *bytes_written)
+{
+	struct fluke_priv *e_priv = board->private_data;
+
+	if (gpib_transfer_engine(board, length, fluke_default_engine(e_priv)) == GPIB_XFER_DMA)
+		return fluke_accel_write(board, buffer, length, send_eoi, bytes_written);
+	return fluke_write(board, buffer, length, send_eoi, bytes_written);
+}
+
 static struct gpib_interface fluke_unaccel_interface = {
 	.name = "fluke_unaccel",
 	.attach = fluke_attach_holdoff_all,
@@ -746,6 +792,7 @@ static struct gpib_interface fluke_unaccel_interface = {
  * is due to a hardware bug triggered by the cpu reading a cb7210
  *		}
  * register just as the dma controller is also doing a read.
+ * Selecting the DMA transfer engine only affects its writes.
  */
 
 static struct gpib_interface fluke_hybrid_interface = {
@@ -753,7 +800,7 @@ static struct gpib_interface fluke_hybrid_interface = {
 	.attach = fluke_attach_holdoff_all,
 	.detach = fluke_detach,
 	.read = fluke_read,
-	.write = fluke_accel_write,
+	.write = fluke_engine_write,
 	.command = fluke_command,
 	.take_control = fluke_take_control,
 	.go_to_standby = fluke_go_to_standby,
@@ -773,14 +820,15 @@ static struct gpib_interface fluke_hybrid_interface = {
 	.serial_poll_status = fluke_serial_poll_status,
 	.t1_delay = fluke_t1_delay,
 	.return_to_local = fluke_return_to_local,
+	.transfer_engines = fluke_transfer_engines,
 };
 
 static struct gpib_interface fluke_interface = {
 	.name = "fluke",
 	.attach = fluke_attach_holdoff_end,
 	.detach = fluke_detach,
-	.read = fluke_accel_read,
-	.write = fluke_accel_write,
+	.read = fluke_engine_read,
+	.write = fluke_engine_write,
 	.command = fluke_command,
 	.take_control = fluke_take_control,
 	.go_to_standby = fluke_go_to_standby,
@@ -800,6 +848,7 @@ static struct gpib_interface fluke_interface = {
 	.serial_poll_status = fluke_serial_poll_status,
 	.t1_delay = fluke_t1_delay,
 	.return_to_local = fluke_return_to_local,
+	.transfer_engines = fluke_transfer_engines,
 };
 
 irqreturn_t fluke_gpib_internal_interrupt(struct gpib_board *board)
@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Emulated cbi488.2 board.  The nec7210 model with the high speed fifo of
+ * the Measurement Computing boards around it, so the fifo transfers of the
+ * cb7210 driver can be run and their register accesses counted.  The fifo
+ * is filled and drained through the chip's dma requests, as on the board;
+ * SRQ interrupts and the bus status register are not modelled.
+ ***************************************************************************/
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#define dev_fmt pr_fmt
+
+#include <linux/slab.h>
+#include "cb7210.h"
+#include "nec7210_emu.h"
+
+struct cb7210_emu {
+	struct nec7210_emu chip;
+	u8 hs_mode;
+	// HS_HALF_FULL and HS_EOI_INT while they are latched
+	u8 hs_latched;
+	unsigned tx_empty_int : 1;
+	unsigned eoi_seen : 1;
+	// cb7210_fifo_size bytes
+	u8 fifo[2048];
+	unsigned int fifo_head;
+	unsigned int fifo_count;
+	unsigned long fifo_words_read;
+	unsigned long fifo_words_written;
+};
+
+// struct which defines private_data for the emulated board, the driver expects cb7210_priv first
+struct cb7210_emu_priv {
+	struct cb7210_priv cb7210_priv;
+	struct cb7210_emu emu;
+};
+
+static inline struct cb7210_emu *to_cb7210_emu(struct cb7210_priv *cb_priv)
+{
+	return &container_of(cb_priv, struct cb7210_emu_priv, cb7210_priv)->emu;
+}
+
+static inline struct cb7210_emu *nec_to_cb7210_emu(struct nec7210_priv *nec_priv)
+{
+	return to_cb7210_emu(container_of(nec_priv, struct cb7210_priv, nec7210_priv));
+}
+
+static irqreturn_t cb7210_emu_board_interrupt(int irq, void *arg)
+{
+	struct gpib_board *board = arg;
+	unsigned long flags;
+	irqreturn_t retval;
+
+	spin_lock_irqsave(&board->spinlock, flags);
+	retval = cb7210_internal_interrupt(board);
+	spin_unlock_irqrestore(&board->spinlock, flags);
+	return retval;
+}
+
+static int cb7210_emu_receiving(const struct cb7210_emu *emu)
+{
+	return (emu->hs_mode & HS_ENABLE_MASK) == HS_RX_ENABLE;
+}
+
+static int cb7210_emu_sending(const struct cb7210_emu *emu)
+{
+	return (emu->hs_mode & HS_ENABLE_MASK) == HS_TX_ENABLE;
+}
+
+static void cb7210_emu_fifo_put(struct cb7210_emu *emu, u8 data)
+{
+	emu->fifo[(emu->fifo_head + emu->fifo_count++) % cb7210_fifo_size] = data;
+}
+
+static u8 cb7210_emu_fifo_get(struct cb7210_emu *emu)
+{
+	u8 data;
+
+	if (emu->fifo_count == 0)
+		return 0;
+	data = emu->fifo[emu->fifo_head];
+	emu->fifo_head = (emu->fifo_head + 1) % cb7210_fifo_size;
+	emu->fifo_count--;
+	return data;
+}
+
+// the fifo answers the chip's dma requests, called with the chip's lock held
+static int cb7210_emu_dma(struct nec7210_emu *chip)
+{
+	struct cb7210_emu *emu = container_of(chip, struct cb7210_emu, chip);
+
+	if (cb7210_emu_receiving(emu) && (chip->imr2 & HR_DMAI) && chip->dir_full) {
+		// the byte which ended the message is left in DIR for the driver
+		if (chip->isr1 & HR_END) {
+			if (!emu->eoi_seen)
+				emu->hs_latched |= HS_EOI_INT;
+			emu->eoi_seen = 1;
+			return 0;
+		}
+		if (emu->fifo_count == cb7210_fifo_size)
+			return 0;
+		cb7210_emu_fifo_put(emu, chip->dir);
+		chip->dir_full = 0;
+		chip->isr1 &= ~HR_DI;
+		if (emu->fifo_count == cb7210_fifo_size / 2)
+			emu->hs_latched |= HS_HALF_FULL;
+		return 1;
+	}
+
+	if (cb7210_emu_sending(emu) && (chip->imr2 & HR_DMAO) && emu->fifo_count &&
+	    chip->talker && !chip->atn && !chip->cdor_full) {
+		chip->cdor = cb7210_emu_fifo_get(emu);
+		chip->cdor_full = 1;
+		chip->isr1 &= ~HR_DO;
+		if (emu->fifo_count == cb7210_fifo_size / 2)
+			emu->hs_latched |= HS_HALF_FULL;
+		if (emu->fifo_count == 0)
+			emu->tx_empty_int = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int cb7210_emu_board_irq(struct nec7210_emu *chip)
+{
+	struct cb7210_emu *emu = container_of(chip, struct cb7210_emu, chip);
+
+	if ((emu->hs_mode & HS_ENABLE_MASK) == 0)
+		return nec7210_emu_irq(chip);
+
+	// in high speed mode the interrupt handler only reads ISR2 of the chip
+	if ((emu->hs_latched & HS_HALF_FULL) && (emu->hs_mode & HS_HF_INT_EN))
+		return 1;
+	if ((emu->hs_latched & HS_EOI_INT) || emu->tx_empty_int)
+		return 1;
+	return chip->isr2 & chip->imr2 & IMR2_ENABLE_INTR_MASK;
+}
+
+static u8 cb7210_emu_hs_read_byte(struct cb7210_priv *cb_priv, unsigned int register_num)
+{
+	struct cb7210_emu *emu = to_cb7210_emu(cb_priv);
+	unsigned long flags;
+	u8 data = 0;
+
+	spin_lock_irqsave(&emu->chip.lock, flags);
+	emu->chip.register_reads++;
+	if (register_num == HS_STATUS) {
+		data = emu->hs_latched;
+		if (emu->fifo_count == cb7210_fifo_size)
+			data |= HS_FIFO_FULL;
+		if (emu->hs_mode & HS_TX_ENABLE) {
+			if (emu->fifo_count)
+				data |= HS_TX_LSB_NOT_EMPTY;
+			if (emu->fifo_count > 1)
+				data |= HS_TX_MSB_NOT_EMPTY;
+		} else {
+			if (emu->fifo_count)
+				data |= HS_RX_LSB_NOT_EMPTY;
+			if (emu->fifo_count > 1)
+				data |= HS_RX_MSB_NOT_EMPTY;
+		}
+	}
+	spin_unlock_irqrestore(&emu->chip.lock, flags);
+
+	return data;
+}
+
+static void cb7210_emu_hs_write_byte(struct cb7210_priv *cb_priv, u8 data,
+				     unsigned int register_num)
+{
+	struct cb7210_emu *emu = to_cb7210_emu(cb_priv);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->chip.lock, flags);
+	emu->chip.register_writes++;
+	// HS_INT_LEVEL only selects the isa interrupt line
+	if (register_num == HS_MODE) {
+		if ((data & HS_ENABLE_MASK) == HS_ENABLE_MASK) {
+			// clears the fifo, the latched interrupts and the mode
+			emu->hs_mode = 0;
+			emu->hs_latched = 0;
+			emu->tx_empty_int = 0;
+			emu->eoi_seen = 0;
+			emu->fifo_head = 0;
+			emu->fifo_count = 0;
+		} else {
+			if (data & HS_CLR_HF_INT)
+				emu->hs_latched &= ~HS_HALF_FULL;
+			if (data & HS_CLR_EOI_EMPTY_INT) {
+				emu->hs_latched &= ~HS_EOI_INT;
+				emu->tx_empty_int = 0;
+			}
+			emu->hs_mode = data & ~(HS_CLR_SRQ_INT | HS_CLR_EOI_EMPTY_INT |
+						HS_CLR_HF_INT);
+		}
+		nec7210_emu_step(&emu->chip);
+	}
+	spin_unlock_irqrestore(&emu->chip.lock, flags);
+}
+
+static void cb7210_emu_read_fifo_words(struct cb7210_priv *cb_priv, u8 *buffer,
+				       unsigned int num_words)
+{
+	struct cb7210_emu *emu = to_cb7210_emu(cb_priv);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->chip.lock, flags);
+	emu->fifo_words_read += num_words;
+	while (num_words--) {
+		*buffer++ = cb7210_emu_fifo_get(emu);
+		*buffer++ = cb7210_emu_fifo_get(emu);
+	}
+	nec7210_emu_step(&emu->chip);
+	spin_unlock_irqrestore(&emu->chip.lock, flags);
+}
+
+static void cb7210_emu_write_fifo_words(struct cb7210_priv *cb_priv, const u8 *buffer,
+					unsigned int num_words)
+{
+	struct cb7210_emu *emu = to_cb7210_emu(cb_priv);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->chip.lock, flags);
+	emu->fifo_words_written += num_words;
+	while (num_words--) {
+		// words written to a full fifo are lost
+		if (emu->fifo_count + 2 <= cb7210_fifo_size) {
+			cb7210_emu_fifo_put(emu, buffer[0]);
+			cb7210_emu_fifo_put(emu, buffer[1]);
+		}
+		buffer += 2;
+	}
+	nec7210_emu_step(&emu->chip);
+	spin_unlock_irqrestore(&emu->chip.lock, flags);
+}
+
+static u8 cb7210_emu_read_byte(struct nec7210_priv *nec_priv, unsigned int register_num)
+{
+	return nec7210_emu_chip_read(&nec_to_cb7210_emu(nec_priv)->chip, register_num);
+}
+
+static void cb7210_emu_write_byte(struct nec7210_priv *nec_priv, u8 data,
+				  unsigned int register_num)
+{
+	nec7210_emu_chip_write(&nec_to_cb7210_emu(nec_priv)->chip, data, register_num);
+}
+
+// wrappers for interface functions
+static int cb7210_emu_command(struct gpib_board *board, u8 *buffer, size_t length,
+			      size_t *bytes_written)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_command(board, &priv->nec7210_priv, buffer, length, bytes_written);
+}
+
+static int cb7210_emu_take_control(struct gpib_board *board, int synchronous)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_take_control(board, &priv->nec7210_priv, synchronous);
+}
+
+static int cb7210_emu_go_to_standby(struct gpib_board *board)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_go_to_standby(board, &priv->nec7210_priv);
+}
+
+static int cb7210_emu_request_system_control(struct gpib_board *board, int request_control)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	if (request_control)
+		priv->hs_mode_bits |= HS_SYS_CONTROL;
+	else
+		priv->hs_mode_bits &= ~HS_SYS_CONTROL;
+
+	cb7210_write_byte(priv, priv->hs_mode_bits, HS_MODE);
+	return nec7210_request_system_control(board, &priv->nec7210_priv, request_control);
+}
+
+static void cb7210_emu_interface_clear(struct gpib_board *board, int assert)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_interface_clear(board, &priv->nec7210_priv, assert);
+}
+
+static void cb7210_emu_remote_enable(struct gpib_board *board, int enable)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_remote_enable(board, &priv->nec7210_priv, enable);
+}
+
+static int cb7210_emu_enable_eos(struct gpib_board *board, u8 eos_byte, int compare_8_bits)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_enable_eos(board, &priv->nec7210_priv, eos_byte, compare_8_bits);
+}
+
+static void cb7210_emu_disable_eos(struct gpib_board *board)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_disable_eos(board, &priv->nec7210_priv);
+}
+
+static unsigned int cb7210_emu_update_status(struct gpib_board *board, unsigned int clear_mask)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_update_status(board, &priv->nec7210_priv, clear_mask);
+}
+
+static int cb7210_emu_primary_address(struct gpib_board *board, unsigned int address)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_primary_address(board, &priv->nec7210_priv, address);
+}
+
+static int cb7210_emu_secondary_address(struct gpib_board *board, unsigned int address,
+					int enable)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_secondary_address(board, &priv->nec7210_priv, address, enable);
+}
+
+static int cb7210_emu_parallel_poll(struct gpib_board *board, u8 *result)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_parallel_poll(board, &priv->nec7210_priv, result);
+}
+
+static void cb7210_emu_parallel_poll_configure(struct gpib_board *board, u8 config)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_parallel_poll_configure(board, &priv->nec7210_priv, config);
+}
+
+static void cb7210_emu_parallel_poll_response(struct gpib_board *board, int ist)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_parallel_poll_response(board, &priv->nec7210_priv, ist);
+}
+
+static void cb7210_emu_serial_poll_response(struct gpib_board *board, u8 status)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_serial_poll_response(board, &priv->nec7210_priv, status);
+}
+
+static u8 cb7210_emu_serial_poll_status(struct gpib_board *board)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_serial_poll_status(board, &priv->nec7210_priv);
+}
+
+static int cb7210_emu_t1_delay(struct gpib_board *board, unsigned int nano_sec)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	return nec7210_t1_delay(board, &priv->nec7210_priv, nano_sec);
+}
+
+static void cb7210_emu_return_to_local(struct gpib_board *board)
+{
+	struct cb7210_priv *priv = board->private_data;
+
+	nec7210_return_to_local(board, &priv->nec7210_priv);
+}
+
+static int cb7210_emu_attach(struct gpib_board *board, const struct gpib_board_config *config)
+{
+	struct cb7210_emu_priv *priv;
+	struct cb7210_priv *cb_priv;
+	struct nec7210_priv *nec_priv;
+	int retval;
+
+	board->status = 0;
+	board->private_data = kzalloc(sizeof(struct cb7210_emu_priv), GFP_KERNEL);
+	if (!board->private_data)
+		return -ENOMEM;
+	priv = board->private_data;
+	cb_priv = &priv->cb7210_priv;
+	nec_priv = &cb_priv->nec7210_priv;
+	init_nec7210_private(nec_priv);
+	nec_priv->read_byte = cb7210_emu_read_byte;
+	nec_priv->write_byte = cb7210_emu_write_byte;
+	nec_priv->type = CB7210;
+	cb_priv->hs_read_byte = cb7210_emu_hs_read_byte;
+	cb_priv->hs_write_byte = cb7210_emu_hs_write_byte;
+	cb_priv->read_fifo_words = cb7210_emu_read_fifo_words;
+	cb_priv->write_fifo_words = cb7210_emu_write_fifo_words;
+	// never used as an io port, it only tells the driver there is a fifo
+	cb_priv->fifo_iobase = (unsigned long)priv->emu.fifo;
+
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, cb7210_emu_board_interrupt, 0, board);
+	retval = nec7210_emu_chip_init(&priv->emu.chip, board, cb7210_emu_board_interrupt);
+	if (retval)
+		return retval;
+	priv->emu.chip.dma = cb7210_emu_dma;
+	priv->emu.chip.board_irq = cb7210_emu_board_irq;
+
+	nec7210_board_reset(nec_priv, board);
+	cb7210_write_byte(cb_priv, HS_TX_ENABLE | HS_RX_ENABLE | HS_CLR_SRQ_INT |
+			  HS_CLR_EOI_EMPTY_INT | HS_CLR_HF_INT, HS_MODE);
+	cb_priv->hs_mode_bits = HS_HF_INT_EN;
+	cb7210_write_byte(cb_priv, cb_priv->hs_mode_bits, HS_MODE);
+	nec7210_board_online(nec_priv, board);
+
+	return 0;
+}
+
+static void cb7210_emu_detach(struct gpib_board *board)
+{
+	struct cb7210_emu_priv *priv = board->private_data;
+
+	if (priv) {
+		if (priv->emu.chip.bus.wake) {
+			nec7210_board_reset(&priv->cb7210_priv.nec7210_priv, board);
+			dev_info(board->gpib_dev,
+				 "%lu register reads, %lu register writes, %lu fifo words read, %lu fifo words written\n",
+				 priv->emu.chip.register_reads, priv->emu.chip.register_writes,
+				 priv->emu.fifo_words_read, priv->emu.fifo_words_written);
+		}
+		nec7210_emu_chip_cleanup(&priv->emu.chip);
+	}
+	kfree(board->private_data);
+	board->private_data = NULL;
+}
+
+struct gpib_interface cb7210_emu_interface = {
+	.name =	"cbi_emu",
+	.attach =	cb7210_emu_attach,
+	.detach =	cb7210_emu_detach,
+	.read =	cb7210_accel_read,
+	.write =	cb7210_accel_write,
+	.command =	cb7210_emu_command,
+	.take_control =	cb7210_emu_take_control,
+	.go_to_standby =	cb7210_emu_go_to_standby,
+	.request_system_control =	cb7210_emu_request_system_control,
+	.interface_clear =	cb7210_emu_interface_clear,
+	.remote_enable =	cb7210_emu_remote_enable,
+	.enable_eos =	cb7210_emu_enable_eos,
+	.disable_eos =	cb7210_emu_disable_eos,
+	.parallel_poll =	cb7210_emu_parallel_poll,
+	.parallel_poll_configure =	cb7210_emu_parallel_poll_configure,
+	.parallel_poll_response =	cb7210_emu_parallel_poll_response,
+	.local_parallel_poll_mode = NULL, // XXX
+	.line_status =	NULL,
+	.update_status =	cb7210_emu_update_status,
+	.primary_address =	cb7210_emu_primary_address,
+	.secondary_address =	cb7210_emu_secondary_address,
+	.serial_poll_response =	cb7210_emu_serial_poll_response,
+	.serial_poll_status =	cb7210_emu_serial_poll_status,
+	.t1_delay = cb7210_emu_t1_delay,
+	.return_to_local = cb7210_emu_return_to_local,
+};
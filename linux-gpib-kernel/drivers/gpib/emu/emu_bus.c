@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Emulated nec7210, cbi488.2 and tms9914 boards.  The chip register
+ * accessors run a software model of the chip and of one instrument on the
+ * bus, so the chip libraries and the core can be exercised and timed
+ * without hardware.
+ ***************************************************************************/
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/version.h>
+#include "emu_bus.h"
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("GPIB driver for emulated nec7210, cbi488.2 and tms9914 boards");
+
+static unsigned int peer_pad = 1;
+module_param(peer_pad, uint, 0444);
+MODULE_PARM_DESC(peer_pad, " primary address of the emulated instrument (default 1)");
+
+static unsigned int peer_count = 1;
+module_param(peer_count, uint, 0444);
+MODULE_PARM_DESC(peer_count,
+		 " number of consecutive primary addresses from peer_pad the emulated instrument answers at");
+
+static unsigned int peer_delay_ns;
+module_param(peer_delay_ns, uint, 0644);
+MODULE_PARM_DESC(peer_delay_ns, " time the emulated instrument takes to handshake each data byte");
+
+static unsigned int peer_response_length;
+module_param(peer_response_length, uint, 0644);
+MODULE_PARM_DESC(peer_response_length,
+		 " length of the message the emulated instrument talks, 0 echoes the last message it received");
+
+static unsigned int peer_buffer_size = 0x10000;
+module_param(peer_buffer_size, uint, 0444);
+MODULE_PARM_DESC(peer_buffer_size, " bytes of a received message the emulated instrument keeps to echo");
+
+static enum hrtimer_restart emu_bus_timer(struct hrtimer *timer)
+{
+	struct emu_bus *bus = container_of(timer, struct emu_bus, timer);
+
+	bus->wake(bus);
+	return HRTIMER_NORESTART;
+}
+
+int emu_bus_init(struct emu_bus *bus, void (*wake)(struct emu_bus *bus))
+{
+	memset(bus, 0, sizeof(*bus));
+	bus->buffer_size = peer_buffer_size ? peer_buffer_size : 1;
+	bus->buffer = kmalloc(bus->buffer_size, GFP_KERNEL);
+	if (!bus->buffer)
+		return -ENOMEM;
+	bus->pad = gpib_address_restrict(peer_pad);
+	bus->count = clamp(peer_count, 1U, 31 - bus->pad);
+	bus->wake = wake;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+	hrtimer_setup(&bus->timer, emu_bus_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#else
+	hrtimer_init(&bus->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	bus->timer.function = emu_bus_timer;
+#endif
+	return 0;
+}
+
+void emu_bus_cleanup(struct emu_bus *bus)
+{
+	if (bus->wake)
+		hrtimer_cancel(&bus->timer);
+	kfree(bus->buffer);
+	bus->buffer = NULL;
+}
+
+void emu_bus_interface_clear(struct emu_bus *bus)
+{
+	bus->listening = 0;
+	bus->talking = 0;
+}
+
+// nonzero if command is the LAD or TAD (group) of one of the instrument's addresses
+static int emu_bus_addressed(struct emu_bus *bus, u8 command, u8 group)
+{
+	return (command & 0xe0) == group && (command & 0x1f) - bus->pad < bus->count;
+}
+
+// the instrument's side of a command byte sent with ATN asserted
+void emu_bus_command(struct emu_bus *bus, u8 command)
+{
+	if (emu_bus_addressed(bus, command, LAD)) {
+		bus->listening = 1;
+		bus->received = 0;
+	} else if (command == UNL) {
+		bus->listening = 0;
+	} else if (emu_bus_addressed(bus, command, TAD)) {
+		bus->talking = 1;
+		bus->response_length = READ_ONCE(peer_response_length);
+		bus->talk_length = bus->response_length ? bus->response_length : bus->received;
+		bus->talk_index = 0;
+	} else if ((command & 0xe0) == TAD) {
+		// other talk address or UNT
+		bus->talking = 0;
+	} else if (command == DCL || (command == SDC && bus->listening)) {
+		bus->received = 0;
+		bus->talk_length = 0;
+	}
+}
+
+/*
+ * Returns nonzero if the instrument can handshake a data byte now.  Otherwise
+ * the wake callback is run once it can.
+ */
+int emu_bus_ready(struct emu_bus *bus)
+{
+	if (bus->delay_ns == 0)
+		return 1;
+	if (ktime_compare(ktime_get(), bus->ready) >= 0)
+		return 1;
+	hrtimer_start(&bus->timer, bus->ready, HRTIMER_MODE_ABS);
+	return 0;
+}
+
+static void emu_bus_handshake(struct emu_bus *bus)
+{
+	bus->delay_ns = READ_ONCE(peer_delay_ns);
+	if (bus->delay_ns)
+		bus->ready = ktime_add_ns(ktime_get(), bus->delay_ns);
+}
+
+// returns zero if the instrument is not listening, so nobody accepts the byte
+int emu_bus_accept(struct emu_bus *bus, u8 data)
+{
+	if (!bus->listening)
+		return 0;
+	if (bus->received < bus->buffer_size)
+		bus->buffer[bus->received++] = data;
+	emu_bus_handshake(bus);
+	return 1;
+}
+
+// returns zero if the instrument has nothing to talk
+int emu_bus_source(struct emu_bus *bus, u8 *data, int *eoi)
+{
+	static const char pattern[] = "0123456789";
+
+	if (!bus->talking || bus->talk_index >= bus->talk_length)
+		return 0;
+	if (bus->response_length)
+		*data = bus->talk_index + 1 < bus->talk_length ?
+			pattern[bus->talk_index % (sizeof(pattern) - 1)] : '\n';
+	else
+		*data = bus->buffer[bus->talk_index];
+	*eoi = ++bus->talk_index == bus->talk_length;
+	emu_bus_handshake(bus);
+	return 1;
+}
+
+static int __init emu_init_module(void)
+{
+	int ret;
+
+	ret = gpib_register_driver(&nec7210_emu_interface, THIS_MODULE);
+	if (ret) {
+		pr_err("gpib_register_driver failed: error = %d\n", ret);
+		return ret;
+	}
+
+	ret = gpib_register_driver(&cb7210_emu_interface, THIS_MODULE);
+	if (ret) {
+		pr_err("gpib_register_driver failed: error = %d\n", ret);
+		gpib_unregister_driver(&nec7210_emu_interface);
+		return ret;
+	}
+
+	ret = gpib_register_driver(&tms9914_emu_interface, THIS_MODULE);
+	if (ret) {
+		pr_err("gpib_register_driver failed: error = %d\n", ret);
+		gpib_unregister_driver(&cb7210_emu_interface);
+		gpib_unregister_driver(&nec7210_emu_interface);
+		return ret;
+	}
+
+	return 0;
+}
+
+static void __exit emu_exit_module(void)
+{
+	gpib_unregister_driver(&nec7210_emu_interface);
+	gpib_unregister_driver(&cb7210_emu_interface);
+	gpib_unregister_driver(&tms9914_emu_interface);
+}
+
+module_init(emu_init_module);
+module_exit(emu_exit_module);
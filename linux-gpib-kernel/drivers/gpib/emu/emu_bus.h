@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/***************************************************************************
+ * Simulated bus and instrument for the emulated chip drivers
+ ***************************************************************************/
+
+#ifndef _GPIB_EMU_BUS_H
+#define _GPIB_EMU_BUS_H
+
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/types.h>
+
+#include "gpibP.h"
+
+/*
+ * The instrument on the other end of the emulated bus.  It echoes back the
+ * last message it was sent, or talks a generated message of response_length
+ * bytes if that is nonzero.  It answers at count consecutive primary
+ * addresses from pad, standing in for several instruments which share its
+ * state.  All of it is protected by the lock of the emulated chip which
+ * owns the bus.
+ */
+struct emu_bus {
+	unsigned int pad;
+	unsigned int count;
+	unsigned listening : 1;
+	unsigned talking : 1;
+	u8 *buffer;
+	size_t buffer_size;
+	size_t received;
+	size_t talk_length;
+	size_t talk_index;
+	unsigned int response_length;
+	u8 ppoll_response;
+	// time the instrument takes to handshake a data byte
+	unsigned int delay_ns;
+	ktime_t ready;
+	struct hrtimer timer;
+	// called from the timer when the instrument becomes ready again
+	void (*wake)(struct emu_bus *bus);
+};
+
+int emu_bus_init(struct emu_bus *bus, void (*wake)(struct emu_bus *bus));
+void emu_bus_cleanup(struct emu_bus *bus);
+void emu_bus_interface_clear(struct emu_bus *bus);
+void emu_bus_command(struct emu_bus *bus, u8 command);
+int emu_bus_ready(struct emu_bus *bus);
+int emu_bus_accept(struct emu_bus *bus, u8 data);
+int emu_bus_source(struct emu_bus *bus, u8 *data, int *eoi);
+
+extern struct gpib_interface nec7210_emu_interface;
+extern struct gpib_interface cb7210_emu_interface;
+extern struct gpib_interface tms9914_emu_interface;
+
+#endif	// _GPIB_EMU_BUS_H
@@ -0,0 +1,587 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Emulated nec7210 board.  Models the registers and the controller, talker
+ * and listener functions the nec7210 library relies on; secondary
+ * addressing, serial polls of the board and device mode are not modelled.
+ ***************************************************************************/
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#define dev_fmt pr_fmt
+
+#include <linux/slab.h>
+#include "nec7210_emu.h"
+
+// struct which defines private_data for the emulated board
+struct nec7210_emu_priv {
+	struct nec7210_priv nec7210_priv;
+	struct nec7210_emu emu;
+};
+
+static inline struct nec7210_emu *to_nec7210_emu(struct nec7210_priv *nec_priv)
+{
+	return &container_of(nec_priv, struct nec7210_emu_priv, nec7210_priv)->emu;
+}
+
+static irqreturn_t nec7210_emu_board_interrupt(int irq, void *arg)
+{
+	struct gpib_board *board = arg;
+	struct nec7210_emu_priv *priv = board->private_data;
+	unsigned long flags;
+	irqreturn_t retval;
+
+	spin_lock_irqsave(&board->spinlock, flags);
+	retval = nec7210_interrupt(board, &priv->nec7210_priv);
+	spin_unlock_irqrestore(&board->spinlock, flags);
+	return retval;
+}
+
+/*
+ * The interrupt line of the model.  The handler is run from irq_work, never
+ * from the register accessors, since those are called with board->spinlock
+ * held.
+ */
+static void nec7210_emu_interrupt(struct irq_work *work)
+{
+	struct nec7210_emu *emu = container_of(work, struct nec7210_emu, irq_work);
+
+	emu->interrupt(0, emu->board);
+}
+
+// nonzero if the chip asserts its interrupt output
+int nec7210_emu_irq(const struct nec7210_emu *emu)
+{
+	return (emu->isr1 & emu->imr1) || (emu->isr2 & emu->imr2 & IMR2_ENABLE_INTR_MASK);
+}
+
+static void nec7210_emu_update_irq(struct nec7210_emu *emu)
+{
+	if (emu->reset)
+		return;
+	if (emu->board_irq ? emu->board_irq(emu) : nec7210_emu_irq(emu))
+		irq_work_queue(&emu->irq_work);
+}
+
+static void nec7210_emu_set_addressed(struct nec7210_emu *emu, int talker, int listener)
+{
+	if (emu->talker != talker || emu->listener != listener)
+		emu->isr2 |= HR_ADSC;
+	emu->talker = talker;
+	emu->listener = listener;
+}
+
+// the chip recognizes its own addresses among the commands it sends
+static void nec7210_emu_send_command(struct nec7210_emu *emu, u8 command)
+{
+	unsigned int pad = emu->adr0 & ADDRESS_MASK;
+
+	if (command == MLA(pad) && (emu->adr0 & HR_DL) == 0)
+		nec7210_emu_set_addressed(emu, emu->talker, 1);
+	else if (command == UNL)
+		nec7210_emu_set_addressed(emu, emu->talker, 0);
+	else if (command == MTA(pad) && (emu->adr0 & HR_DT) == 0)
+		nec7210_emu_set_addressed(emu, 1, emu->listener);
+	else if ((command & 0xe0) == TAD)
+		nec7210_emu_set_addressed(emu, 0, emu->listener);
+
+	emu_bus_command(&emu->bus, command);
+}
+
+static int nec7210_emu_end(struct nec7210_emu *emu, u8 data)
+{
+	u8 mask = (emu->auxa & HR_BIN) ? 0xff : 0x7f;
+
+	return (emu->auxa & HR_REOS) && ((data ^ emu->eosr) & mask) == 0;
+}
+
+// moves at most one byte each way between the chip and the bus
+static void nec7210_emu_transfer(struct nec7210_emu *emu)
+{
+	u8 data;
+	int eoi;
+
+	if (emu->cdor_full) {
+		if (emu->atn) {
+			if (emu->cic) {
+				nec7210_emu_send_command(emu, emu->cdor);
+				emu->cdor_full = 0;
+				emu->isr2 |= HR_CO;
+			}
+		} else if (emu->talker && emu_bus_ready(&emu->bus)) {
+			// with no listener the byte is lost and ERR is set
+			if (!emu_bus_accept(&emu->bus, emu->cdor))
+				emu->isr1 |= HR_ERR;
+			emu->cdor_full = 0;
+			emu->send_eoi = 0;
+			emu->isr1 |= HR_DO;
+		}
+	}
+
+	if (emu->listener && !emu->atn && !emu->dir_full && !emu->holdoff &&
+	    emu->bus.talking && emu_bus_ready(&emu->bus) &&
+	    emu_bus_source(&emu->bus, &data, &eoi)) {
+		emu->dir = data;
+		emu->dir_full = 1;
+		emu->isr1 |= HR_DI;
+		if (eoi || nec7210_emu_end(emu, data))
+			emu->isr1 |= HR_END;
+		switch (emu->auxa & HR_HANDSHAKE_MASK) {
+		case HR_HLDA:
+			emu->holdoff = 1;
+			break;
+		case HR_HLDE:
+			if (emu->isr1 & HR_END)
+				emu->holdoff = 1;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// let the bus make whatever progress it can, called with emu->lock held
+void nec7210_emu_step(struct nec7210_emu *emu)
+{
+	if (emu->reset)
+		return;
+
+	do {
+		nec7210_emu_transfer(emu);
+	} while (emu->dma && emu->dma(emu));
+
+	nec7210_emu_update_irq(emu);
+}
+
+static void nec7210_emu_wake(struct emu_bus *bus)
+{
+	struct nec7210_emu *emu = container_of(bus, struct nec7210_emu, bus);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	nec7210_emu_step(emu);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void nec7210_emu_chip_reset(struct nec7210_emu *emu)
+{
+	emu->reset = 1;
+	emu->isr1 = 0;
+	emu->isr2 = 0;
+	emu->cic = 0;
+	emu->atn = 0;
+	emu->talker = 0;
+	emu->listener = 0;
+	emu->cdor_full = 0;
+	emu->dir_full = 0;
+	emu->holdoff = 0;
+	emu->send_eoi = 0;
+}
+
+static void nec7210_emu_aux(struct nec7210_emu *emu, u8 data)
+{
+	switch (data & 0xe0) {
+	case 0:
+		break;
+	case AUXRA:
+		emu->auxa = data & ~AUXRA;
+		return;
+	default:
+		// ICR, PPR, AUXRB and AUXRE do not affect the model
+		return;
+	}
+
+	switch (data) {
+	case AUX_PON:
+		emu->reset = 0;
+		break;
+	case AUX_CR:
+		nec7210_emu_chip_reset(emu);
+		break;
+	case AUX_FH:
+		emu->holdoff = 0;
+		break;
+	case AUX_SEOI:
+		emu->send_eoi = 1;
+		break;
+	case AUX_GTS:
+		if (emu->cic && emu->atn) {
+			emu->atn = 0;
+			if (emu->talker && !emu->cdor_full)
+				emu->isr1 |= HR_DO;
+		}
+		break;
+	case AUX_TCA:
+	case AUX_TCS:
+	case AUX_TCSE:
+		if (emu->cic && !emu->atn) {
+			emu->atn = 1;
+			// a data byte not yet accepted is lost
+			emu->cdor_full = 0;
+			emu->send_eoi = 0;
+			emu->isr2 |= HR_CO;
+		}
+		break;
+	case AUX_LTN:
+	case AUX_LTNC:
+		nec7210_emu_set_addressed(emu, emu->talker, 1);
+		break;
+	case AUX_LUN:
+		nec7210_emu_set_addressed(emu, emu->talker, 0);
+		break;
+	case AUX_SIFC:
+		// the system controller becomes active controller
+		emu->cic = 1;
+		emu->atn = 1;
+		emu->cdor_full = 0;
+		nec7210_emu_set_addressed(emu, 0, 0);
+		emu_bus_interface_clear(&emu->bus);
+		emu->isr2 |= HR_CO;
+		break;
+	case AUX_EPP:
+		emu->cptr = emu->bus.ppoll_response;
+		emu->isr2 |= HR_CO;
+		break;
+	default:
+		break;
+	}
+}
+
+u8 nec7210_emu_chip_read(struct nec7210_emu *emu, unsigned int register_num)
+{
+	unsigned long flags;
+	u8 data = 0;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	emu->register_reads++;
+	switch (register_num) {
+	case DIR:
+		data = emu->dir;
+		emu->dir_full = 0;
+		nec7210_emu_step(emu);
+		break;
+	case ISR1:
+		data = emu->isr1;
+		emu->isr1 = 0;
+		break;
+	case ISR2:
+		data = emu->isr2;
+		if (nec7210_emu_irq(emu))
+			data |= HR_INT;
+		emu->isr2 = 0;
+		break;
+	case SPSR:
+		data = emu->spmr;
+		break;
+	case ADSR:
+		if (emu->cic)
+			data |= HR_CIC;
+		if (!emu->atn)
+			data |= HR_NATN;
+		if (emu->talker)
+			data |= HR_TA;
+		if (emu->listener)
+			data |= HR_LA;
+		break;
+	case CPTR:
+		data = emu->cptr;
+		break;
+	case ADR0:
+		data = emu->adr0;
+		break;
+	case ADR1:
+		data = emu->adr1;
+		break;
+	default:
+		break;
+	}
+	spin_unlock_irqrestore(&emu->lock, flags);
+
+	return data;
+}
+
+void nec7210_emu_chip_write(struct nec7210_emu *emu, u8 data, unsigned int register_num)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	emu->register_writes++;
+	switch (register_num) {
+	case CDOR:
+		emu->cdor = data;
+		emu->cdor_full = 1;
+		break;
+	case IMR1:
+		emu->imr1 = data;
+		break;
+	case IMR2:
+		emu->imr2 = data;
+		break;
+	case SPMR:
+		emu->spmr = data;
+		break;
+	case ADMR:
+		emu->admr = data;
+		break;
+	case AUXMR:
+		nec7210_emu_aux(emu, data);
+		break;
+	case ADR:
+		if (data & HR_ARS)
+			emu->adr1 = data;
+		else
+			emu->adr0 = data;
+		break;
+	case EOSR:
+		emu->eosr = data;
+		break;
+	default:
+		break;
+	}
+	nec7210_emu_step(emu);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+int nec7210_emu_chip_init(struct nec7210_emu *emu, struct gpib_board *board,
+			  irqreturn_t (*interrupt)(int irq, void *arg))
+{
+	spin_lock_init(&emu->lock);
+	init_irq_work(&emu->irq_work, nec7210_emu_interrupt);
+	emu->interrupt = interrupt;
+	emu->board = board;
+	emu->reset = 1;
+	return emu_bus_init(&emu->bus, nec7210_emu_wake);
+}
+
+void nec7210_emu_chip_cleanup(struct nec7210_emu *emu)
+{
+	emu_bus_cleanup(&emu->bus);
+	irq_work_sync(&emu->irq_work);
+}
+
+static u8 nec7210_emu_read_byte(struct nec7210_priv *nec_priv, unsigned int register_num)
+{
+	return nec7210_emu_chip_read(to_nec7210_emu(nec_priv), register_num);
+}
+
+static void nec7210_emu_write_byte(struct nec7210_priv *nec_priv, u8 data,
+				   unsigned int register_num)
+{
+	nec7210_emu_chip_write(to_nec7210_emu(nec_priv), data, register_num);
+}
+
+// wrappers for interface functions
+static int nec7210_emu_read(struct gpib_board *board, u8 *buffer, size_t length, int *end,
+			    size_t *bytes_read)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_read(board, &priv->nec7210_priv, buffer, length, end, bytes_read);
+}
+
+static int nec7210_emu_write(struct gpib_board *board, u8 *buffer, size_t length, int send_eoi,
+			     size_t *bytes_written)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_write(board, &priv->nec7210_priv, buffer, length, send_eoi, bytes_written);
+}
+
+static int nec7210_emu_command(struct gpib_board *board, u8 *buffer, size_t length,
+			       size_t *bytes_written)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_command(board, &priv->nec7210_priv, buffer, length, bytes_written);
+}
+
+static int nec7210_emu_take_control(struct gpib_board *board, int synchronous)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_take_control(board, &priv->nec7210_priv, synchronous);
+}
+
+static int nec7210_emu_go_to_standby(struct gpib_board *board)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_go_to_standby(board, &priv->nec7210_priv);
+}
+
+static int nec7210_emu_request_system_control(struct gpib_board *board, int request_control)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_request_system_control(board, &priv->nec7210_priv, request_control);
+}
+
+static void nec7210_emu_interface_clear(struct gpib_board *board, int assert)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_interface_clear(board, &priv->nec7210_priv, assert);
+}
+
+static void nec7210_emu_remote_enable(struct gpib_board *board, int enable)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_remote_enable(board, &priv->nec7210_priv, enable);
+}
+
+static int nec7210_emu_enable_eos(struct gpib_board *board, u8 eos_byte, int compare_8_bits)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_enable_eos(board, &priv->nec7210_priv, eos_byte, compare_8_bits);
+}
+
+static void nec7210_emu_disable_eos(struct gpib_board *board)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_disable_eos(board, &priv->nec7210_priv);
+}
+
+static unsigned int nec7210_emu_update_status(struct gpib_board *board, unsigned int clear_mask)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_update_status(board, &priv->nec7210_priv, clear_mask);
+}
+
+static int nec7210_emu_primary_address(struct gpib_board *board, unsigned int address)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_primary_address(board, &priv->nec7210_priv, address);
+}
+
+static int nec7210_emu_secondary_address(struct gpib_board *board, unsigned int address,
+					 int enable)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_secondary_address(board, &priv->nec7210_priv, address, enable);
+}
+
+static int nec7210_emu_parallel_poll(struct gpib_board *board, u8 *result)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_parallel_poll(board, &priv->nec7210_priv, result);
+}
+
+static void nec7210_emu_parallel_poll_configure(struct gpib_board *board, u8 config)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_parallel_poll_configure(board, &priv->nec7210_priv, config);
+}
+
+static void nec7210_emu_parallel_poll_response(struct gpib_board *board, int ist)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_parallel_poll_response(board, &priv->nec7210_priv, ist);
+}
+
+static void nec7210_emu_serial_poll_response(struct gpib_board *board, u8 status)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_serial_poll_response(board, &priv->nec7210_priv, status);
+}
+
+static u8 nec7210_emu_serial_poll_status(struct gpib_board *board)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_serial_poll_status(board, &priv->nec7210_priv);
+}
+
+static int nec7210_emu_t1_delay(struct gpib_board *board, unsigned int nano_sec)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	return nec7210_t1_delay(board, &priv->nec7210_priv, nano_sec);
+}
+
+static void nec7210_emu_return_to_local(struct gpib_board *board)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	nec7210_return_to_local(board, &priv->nec7210_priv);
+}
+
+static int nec7210_emu_attach(struct gpib_board *board, const struct gpib_board_config *config)
+{
+	struct nec7210_emu_priv *priv;
+	struct nec7210_priv *nec_priv;
+	int retval;
+
+	board->status = 0;
+	board->private_data = kzalloc(sizeof(struct nec7210_emu_priv), GFP_KERNEL);
+	if (!board->private_data)
+		return -ENOMEM;
+	priv = board->private_data;
+	nec_priv = &priv->nec7210_priv;
+	init_nec7210_private(nec_priv);
+	nec_priv->read_byte = nec7210_emu_read_byte;
+	nec_priv->write_byte = nec7210_emu_write_byte;
+	nec_priv->type = NEC7210;
+
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, nec7210_emu_board_interrupt, 0, board);
+	retval = nec7210_emu_chip_init(&priv->emu, board, nec7210_emu_board_interrupt);
+	if (retval)
+		return retval;
+
+	nec7210_board_reset(nec_priv, board);
+	nec7210_board_online(nec_priv, board);
+
+	return 0;
+}
+
+static void nec7210_emu_detach(struct gpib_board *board)
+{
+	struct nec7210_emu_priv *priv = board->private_data;
+
+	if (priv) {
+		if (priv->emu.bus.wake) {
+			nec7210_board_reset(&priv->nec7210_priv, board);
+			dev_info(board->gpib_dev, "%lu register reads, %lu register writes\n",
+				 priv->emu.register_reads, priv->emu.register_writes);
+		}
+		nec7210_emu_chip_cleanup(&priv->emu);
+	}
+	kfree(board->private_data);
+	board->private_data = NULL;
+}
+
+struct gpib_interface nec7210_emu_interface = {
+	.name =	"nec7210_emu",
+	.attach =	nec7210_emu_attach,
+	.detach =	nec7210_emu_detach,
+	.read =	nec7210_emu_read,
+	.write =	nec7210_emu_write,
+	.command =	nec7210_emu_command,
+	.take_control =	nec7210_emu_take_control,
+	.go_to_standby =	nec7210_emu_go_to_standby,
+	.request_system_control =	nec7210_emu_request_system_control,
+	.interface_clear =	nec7210_emu_interface_clear,
+	.remote_enable =	nec7210_emu_remote_enable,
+	.enable_eos =	nec7210_emu_enable_eos,
+	.disable_eos =	nec7210_emu_disable_eos,
+	.parallel_poll =	nec7210_emu_parallel_poll,
+	.parallel_poll_configure =	nec7210_emu_parallel_poll_configure,
+	.parallel_poll_response =	nec7210_emu_parallel_poll_response,
+	.local_parallel_poll_mode = NULL, // XXX
+	.line_status =	NULL,
+	.update_status =	nec7210_emu_update_status,
+	.primary_address =	nec7210_emu_primary_address,
+	.secondary_address =	nec7210_emu_secondary_address,
+	.serial_poll_response =	nec7210_emu_serial_poll_response,
+	.serial_poll_status =	nec7210_emu_serial_poll_status,
+	.t1_delay = nec7210_emu_t1_delay,
+	.return_to_local = nec7210_emu_return_to_local,
+};
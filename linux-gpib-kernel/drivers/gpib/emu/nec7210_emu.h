@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/***************************************************************************
+ * Model of the nec7210, shared by the emulated boards built around one
+ ***************************************************************************/
+
+#ifndef _GPIB_NEC7210_EMU_H
+#define _GPIB_NEC7210_EMU_H
+
+#include <linux/interrupt.h>
+#include <linux/irq_work.h>
+#include <linux/spinlock.h>
+#include "nec7210.h"
+#include "emu_bus.h"
+
+struct nec7210_emu {
+	// protects the chip model, the bus and whatever the board adds around them
+	spinlock_t lock;
+	u8 isr1;
+	u8 isr2;
+	u8 imr1;
+	u8 imr2;
+	u8 spmr;
+	u8 admr;
+	u8 adr0;
+	u8 adr1;
+	u8 eosr;
+	u8 auxa;
+	u8 cdor;
+	u8 dir;
+	u8 cptr;
+	unsigned reset : 1;
+	unsigned cic : 1;
+	unsigned atn : 1;
+	unsigned talker : 1;
+	unsigned listener : 1;
+	unsigned cdor_full : 1;
+	unsigned dir_full : 1;
+	unsigned holdoff : 1;
+	unsigned send_eoi : 1;
+	unsigned long register_reads;
+	unsigned long register_writes;
+	struct emu_bus bus;
+	struct irq_work irq_work;
+	struct gpib_board *board;
+	irqreturn_t (*interrupt)(int irq, void *arg);
+	/*
+	 * Optional hooks for the board around the chip, called with lock held.
+	 * dma moves a byte between the chip and the board and returns nonzero
+	 * if it did, board_irq returns nonzero if the board's interrupt line
+	 * is asserted.
+	 */
+	int (*dma)(struct nec7210_emu *emu);
+	int (*board_irq)(struct nec7210_emu *emu);
+};
+
+int nec7210_emu_chip_init(struct nec7210_emu *emu, struct gpib_board *board,
+			  irqreturn_t (*interrupt)(int irq, void *arg));
+void nec7210_emu_chip_cleanup(struct nec7210_emu *emu);
+u8 nec7210_emu_chip_read(struct nec7210_emu *emu, unsigned int register_num);
+void nec7210_emu_chip_write(struct nec7210_emu *emu, u8 data, unsigned int register_num);
+void nec7210_emu_step(struct nec7210_emu *emu);
+int nec7210_emu_irq(const struct nec7210_emu *emu);
+
+#endif	// _GPIB_NEC7210_EMU_H
@@ -0,0 +1,547 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/***************************************************************************
+ * Emulated tms9914 board.  Models the registers and the controller, talker
+ * and listener functions the tms9914 library relies on; secondary
+ * addressing, serial polls of the board and device mode are not modelled.
+ ***************************************************************************/
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#define dev_fmt pr_fmt
+
+#include <linux/irq_work.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include "tms9914.h"
+#include "emu_bus.h"
+
+struct tms9914_emu {
+	// protects the chip model and the bus
+	spinlock_t lock;
+	u8 isr0;
+	u8 isr1;
+	u8 imr0;
+	u8 imr1;
+	u8 adr;
+	u8 spmr;
+	u8 ppr;
+	u8 cdor;
+	u8 dir;
+	u8 cptr;
+	unsigned reset : 1;
+	unsigned dai : 1;
+	unsigned cic : 1;
+	unsigned atn : 1;
+	unsigned ifc : 1;
+	unsigned ren : 1;
+	unsigned talker : 1;
+	unsigned listener : 1;
+	unsigned cdor_full : 1;
+	unsigned dir_full : 1;
+	unsigned holdoff : 1;
+	unsigned holdoff_on_all : 1;
+	unsigned holdoff_on_end : 1;
+	unsigned send_eoi : 1;
+	struct emu_bus bus;
+	struct irq_work irq_work;
+	struct gpib_board *board;
+};
+
+// struct which defines private_data for the emulated board
+struct tms9914_emu_priv {
+	struct tms9914_priv tms9914_priv;
+	struct tms9914_emu emu;
+};
+
+static inline struct tms9914_emu *to_tms9914_emu(struct tms9914_priv *tms_priv)
+{
+	return &container_of(tms_priv, struct tms9914_emu_priv, tms9914_priv)->emu;
+}
+
+static irqreturn_t tms9914_emu_board_interrupt(int irq, void *arg)
+{
+	struct gpib_board *board = arg;
+	struct tms9914_emu_priv *priv = board->private_data;
+	unsigned long flags;
+	irqreturn_t retval;
+
+	spin_lock_irqsave(&board->spinlock, flags);
+	retval = tms9914_interrupt(board, &priv->tms9914_priv);
+	spin_unlock_irqrestore(&board->spinlock, flags);
+	return retval;
+}
+
+// the interrupt line of the model, see nec7210_emu_interrupt()
+static void tms9914_emu_interrupt(struct irq_work *work)
+{
+	struct tms9914_emu *emu = container_of(work, struct tms9914_emu, irq_work);
+
+	tms9914_emu_board_interrupt(0, emu->board);
+}
+
+static void tms9914_emu_update_irq(struct tms9914_emu *emu)
+{
+	if (emu->reset || emu->dai)
+		return;
+	if ((emu->isr0 & emu->imr0) || (emu->isr1 & emu->imr1))
+		irq_work_queue(&emu->irq_work);
+}
+
+// let the bus make whatever progress it can, called with emu->lock held
+static void tms9914_emu_step(struct tms9914_emu *emu)
+{
+	u8 data;
+	int eoi;
+
+	if (emu->reset)
+		return;
+
+	if (emu->cdor_full) {
+		if (emu->atn) {
+			/*
+			 * The library addresses the chip itself with AUX_LON
+			 * and AUX_TON, only the instrument needs the command.
+			 */
+			if (emu->cic) {
+				emu_bus_command(&emu->bus, emu->cdor);
+				emu->cdor_full = 0;
+				emu->isr0 |= HR_BO;
+			}
+		} else if (emu->talker && emu_bus_ready(&emu->bus)) {
+			// with no listener the byte is lost and ERR is set
+			if (!emu_bus_accept(&emu->bus, emu->cdor))
+				emu->isr1 |= HR_ERR;
+			emu->cdor_full = 0;
+			emu->send_eoi = 0;
+			emu->isr0 |= HR_BO;
+		}
+	}
+
+	if (emu->listener && !emu->atn && !emu->dir_full && !emu->holdoff &&
+	    emu->bus.talking && emu_bus_ready(&emu->bus) &&
+	    emu_bus_source(&emu->bus, &data, &eoi)) {
+		emu->dir = data;
+		emu->dir_full = 1;
+		emu->isr0 |= HR_BI;
+		if (eoi)
+			emu->isr0 |= HR_END;
+		if (emu->holdoff_on_all || (emu->holdoff_on_end && eoi))
+			emu->holdoff = 1;
+	}
+
+	tms9914_emu_update_irq(emu);
+}
+
+static void tms9914_emu_wake(struct emu_bus *bus)
+{
+	struct tms9914_emu *emu = container_of(bus, struct tms9914_emu, bus);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	tms9914_emu_step(emu);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void tms9914_emu_chip_reset(struct tms9914_emu *emu)
+{
+	emu->reset = 1;
+	emu->isr0 = 0;
+	emu->isr1 = 0;
+	emu->cic = 0;
+	emu->atn = 0;
+	emu->talker = 0;
+	emu->listener = 0;
+	emu->cdor_full = 0;
+	emu->dir_full = 0;
+	emu->holdoff = 0;
+	emu->send_eoi = 0;
+}
+
+static void tms9914_emu_aux(struct tms9914_emu *emu, u8 data)
+{
+	int set = (data & AUX_CS) != 0;
+
+	switch (data & ~AUX_CS) {
+	case AUX_CHIP_RESET:
+		if (set)
+			tms9914_emu_chip_reset(emu);
+		else
+			emu->reset = 0;
+		break;
+	case AUX_RHDF:
+		emu->holdoff = 0;
+		break;
+	case AUX_HLDA:
+		emu->holdoff_on_all = set;
+		break;
+	case AUX_HLDE:
+		emu->holdoff_on_end = set;
+		break;
+	case AUX_SEOI:
+		emu->send_eoi = 1;
+		break;
+	case AUX_LON:
+		emu->listener = set;
+		break;
+	case AUX_TON:
+		emu->talker = set;
+		break;
+	case AUX_GTS:
+		if (emu->cic && emu->atn) {
+			emu->atn = 0;
+			if (emu->talker && !emu->cdor_full)
+				emu->isr0 |= HR_BO;
+		}
+		break;
+	case AUX_TCA:
+	case AUX_TCS:
+		if (emu->cic && !emu->atn) {
+			emu->atn = 1;
+			// a data byte not yet accepted is lost
+			emu->cdor_full = 0;
+			emu->send_eoi = 0;
+			emu->isr0 |= HR_BO;
+		}
+		break;
+	case AUX_RPP:
+		if (set)
+			emu->cptr = emu->bus.ppoll_response;
+		break;
+	case AUX_SIC:
+		emu->ifc = set;
+		if (set) {
+			// the system controller becomes active controller
+			emu->cic = 1;
+			emu->atn = 1;
+			emu->cdor_full = 0;
+			emu->talker = 0;
+			emu->listener = 0;
+			emu_bus_interface_clear(&emu->bus);
+			emu->isr0 |= HR_BO;
+		}
+		break;
+	case AUX_SRE:
+		emu->ren = set;
+		break;
+	case AUX_RLC:
+		emu->cic = 0;
+		emu->atn = 0;
+		break;
+	case AUX_DAI:
+		emu->dai = set;
+		break;
+	default:
+		break;
+	}
+}
+
+static u8 tms9914_emu_read_byte(struct tms9914_priv *tms_priv, unsigned int register_num)
+{
+	struct tms9914_emu *emu = to_tms9914_emu(tms_priv);
+	unsigned long flags;
+	u8 data = 0;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	switch (register_num) {
+	case ISR0:
+		data = emu->isr0;
+		emu->isr0 = 0;
+		break;
+	case ISR1:
+		data = emu->isr1;
+		emu->isr1 = 0;
+		break;
+	case ADSR:
+		if (emu->talker)
+			data |= HR_TA;
+		if (emu->listener)
+			data |= HR_LA;
+		if (emu->atn)
+			data |= HR_ATN;
+		break;
+	case BSR:
+		if (emu->ren)
+			data |= BSR_REN_BIT;
+		if (emu->ifc)
+			data |= BSR_IFC_BIT;
+		if (emu->atn)
+			data |= BSR_ATN_BIT;
+		break;
+	case CPTR:
+		data = emu->cptr;
+		break;
+	case DIR:
+		data = emu->dir;
+		emu->dir_full = 0;
+		tms9914_emu_step(emu);
+		break;
+	default:
+		break;
+	}
+	spin_unlock_irqrestore(&emu->lock, flags);
+
+	return data;
+}
+
+static void tms9914_emu_write_byte(struct tms9914_priv *tms_priv, u8 data,
+				   unsigned int register_num)
+{
+	struct tms9914_emu *emu = to_tms9914_emu(tms_priv);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	switch (register_num) {
+	case IMR0:
+		emu->imr0 = data;
+		break;
+	case IMR1:
+		emu->imr1 = data;
+		break;
+	case AUXCR:
+		tms9914_emu_aux(emu, data);
+		break;
+	case ADR:
+		emu->adr = data;
+		break;
+	case SPMR:
+		emu->spmr = data;
+		break;
+	case PPR:
+		emu->ppr = data;
+		break;
+	case CDOR:
+		emu->cdor = data;
+		emu->cdor_full = 1;
+		break;
+	default:
+		break;
+	}
+	tms9914_emu_step(emu);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+// wrappers for interface functions
+static int tms9914_emu_read(struct gpib_board *board, u8 *buffer, size_t length,
+			    int *end, size_t *bytes_read)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_read(board, &priv->tms9914_priv, buffer, length, end, bytes_read);
+}
+
+static int tms9914_emu_write(struct gpib_board *board, u8 *buffer, size_t length, int send_eoi,
+			     size_t *bytes_written)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_write(board, &priv->tms9914_priv, buffer, length, send_eoi, bytes_written);
+}
+
+static int tms9914_emu_command(struct gpib_board *board, u8 *buffer, size_t length,
+			       size_t *bytes_written)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_command(board, &priv->tms9914_priv, buffer, length, bytes_written);
+}
+
+static int tms9914_emu_take_control(struct gpib_board *board, int synchronous)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_take_control(board, &priv->tms9914_priv, synchronous);
+}
+
+static int tms9914_emu_go_to_standby(struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_go_to_standby(board, &priv->tms9914_priv);
+}
+
+static int tms9914_emu_request_system_control(struct gpib_board *board, int request_control)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_request_system_control(board, &priv->tms9914_priv, request_control);
+}
+
+static void tms9914_emu_interface_clear(struct gpib_board *board, int assert)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_interface_clear(board, &priv->tms9914_priv, assert);
+}
+
+static void tms9914_emu_remote_enable(struct gpib_board *board, int enable)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_remote_enable(board, &priv->tms9914_priv, enable);
+}
+
+static int tms9914_emu_enable_eos(struct gpib_board *board, u8 eos_byte, int compare_8_bits)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_enable_eos(board, &priv->tms9914_priv, eos_byte, compare_8_bits);
+}
+
+static void tms9914_emu_disable_eos(struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_disable_eos(board, &priv->tms9914_priv);
+}
+
+static unsigned int tms9914_emu_update_status(struct gpib_board *board, unsigned int clear_mask)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_update_status(board, &priv->tms9914_priv, clear_mask);
+}
+
+static int tms9914_emu_primary_address(struct gpib_board *board, unsigned int address)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_primary_address(board, &priv->tms9914_priv, address);
+}
+
+static int tms9914_emu_secondary_address(struct gpib_board *board, unsigned int address,
+					 int enable)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_secondary_address(board, &priv->tms9914_priv, address, enable);
+}
+
+static int tms9914_emu_parallel_poll(struct gpib_board *board, u8 *result)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_parallel_poll(board, &priv->tms9914_priv, result);
+}
+
+static void tms9914_emu_parallel_poll_configure(struct gpib_board *board, u8 config)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_parallel_poll_configure(board, &priv->tms9914_priv, config);
+}
+
+static void tms9914_emu_parallel_poll_response(struct gpib_board *board, int ist)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_parallel_poll_response(board, &priv->tms9914_priv, ist);
+}
+
+static void tms9914_emu_serial_poll_response(struct gpib_board *board, u8 status)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_serial_poll_response(board, &priv->tms9914_priv, status);
+}
+
+static u8 tms9914_emu_serial_poll_status(struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_serial_poll_status(board, &priv->tms9914_priv);
+}
+
+static int tms9914_emu_line_status(const struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_line_status(board, &priv->tms9914_priv);
+}
+
+static int tms9914_emu_t1_delay(struct gpib_board *board, unsigned int nano_sec)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	return tms9914_t1_delay(board, &priv->tms9914_priv, nano_sec);
+}
+
+static void tms9914_emu_return_to_local(struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	tms9914_return_to_local(board, &priv->tms9914_priv);
+}
+
+static struct gpib_interface tms9914_emu_interface = {
+
+static int tms9914_emu_attach(struct gpib_board *board, const struct gpib_board_config *config)
+{
+	struct tms9914_emu_priv *priv;
+	struct tms9914_priv *tms_priv;
+	int retval;
+
+	board->status = 0;
+	board->private_data = kzalloc(sizeof(struct tms9914_emu_priv), GFP_KERNEL);
+	if (!board->private_data)
+		return -ENOMEM;
+	priv = board->private_data;
+	tms_priv = &priv->tms9914_priv;
+	tms_priv->read_byte = tms9914_emu_read_byte;
+	tms_priv->write_byte = tms9914_emu_write_byte;
+
+	spin_lock_init(&priv->emu.lock);
+	init_irq_work(&priv->emu.irq_work, tms9914_emu_interrupt);
+	gpib_pio_spin_set_handler(&tms_priv->pio_spin, tms9914_emu_board_interrupt, 0, board);
+	priv->emu.board = board;
+	priv->emu.reset = 1;
+	retval = emu_bus_init(&priv->emu.bus, tms9914_emu_wake);
+	if (retval)
+		return retval;
+
+	tms9914_board_reset(tms_priv);
+	tms9914_online(board, tms_priv);
+
+	return 0;
+}
+
+static void tms9914_emu_detach(struct gpib_board *board)
+{
+	struct tms9914_emu_priv *priv = board->private_data;
+
+	if (priv) {
+		if (priv->emu.bus.wake)
+			tms9914_board_reset(&priv->tms9914_priv);
+		emu_bus_cleanup(&priv->emu.bus);
+		irq_work_sync(&priv->emu.irq_work);
+	}
+	kfree(board->private_data);
+	board->private_data = NULL;
+}
+
+struct gpib_interface tms9914_emu_interface = {
+	.name = "tms9914_emu",
+	.attach = tms9914_emu_attach,
+	.detach = tms9914_emu_detach,
+	.read = tms9914_emu_read,
+	.write = tms9914_emu_write,
+	.command = tms9914_emu_command,
+	.request_system_control = tms9914_emu_request_system_control,
+	.take_control = tms9914_emu_take_control,
+	.go_to_standby = tms9914_emu_go_to_standby,
+	.interface_clear = tms9914_emu_interface_clear,
+	.remote_enable = tms9914_emu_remote_enable,
+	.enable_eos = tms9914_emu_enable_eos,
+	.disable_eos = tms9914_emu_disable_eos,
+	.parallel_poll = tms9914_emu_parallel_poll,
+	.parallel_poll_configure = tms9914_emu_parallel_poll_configure,
+	.parallel_poll_response = tms9914_emu_parallel_poll_response,
+	.local_parallel_poll_mode = NULL, // XXX
+	.line_status = tms9914_emu_line_status,
+	.update_status = tms9914_emu_update_status,
+	.primary_address = tms9914_emu_primary_address,
+	.secondary_address = tms9914_emu_secondary_address,
+	.serial_poll_response = tms9914_emu_serial_poll_response,
+	.serial_poll_status = tms9914_emu_serial_poll_status,
+	.t1_delay = tms9914_emu_t1_delay,
+	.return_to_local = tms9914_emu_return_to_local,
+};
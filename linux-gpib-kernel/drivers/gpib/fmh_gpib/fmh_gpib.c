@@ -1031,6 +1031,64 @@ static int fmh_gpib_fifo_read(struct gpib_board *board, u8 *buffer, size_t lengt
 	return retval;
 }
 
+/*
+ * Runtime choice of transfer engine for the accelerated board types.  They
+ * run the chip with holdoff on end, so PIO reads switch to holdoff on all
+ * data for their duration, as the unaccelerated board types are set up.
+ */
+static unsigned int fmh_gpib_transfer_engines(struct gpib_board *board)
+{
+	struct fmh_priv *e_priv = board->private_data;
+	unsigned int engines = 1 << GPIB_XFER_PIO;
+
+	if (e_priv->supports_fifo_interrupts)
+		engines |= 1 << GPIB_XFER_FIFO;
+	if (e_priv->dma_channel)
+		engines |= 1 << GPIB_XFER_DMA;
+	return engines;
+}
+
+static unsigned int fmh_gpib_default_engine(const struct fmh_priv *e_priv)
+{
+	return e_priv->dma_channel ? GPIB_XFER_DMA : GPIB_XFER_FIFO;
+}
+
+static int fmh_gpib_engine_read(struct gpib_board *board, u8 *buffer, size_t length,
+				int *end, size_t *bytes_read)
+{
+	struct fmh_priv *e_priv = board->private_data;
+	struct nec7210_priv *nec_priv = &e_priv->nec7210_priv;
+	int retval;
+
+	switch (gpib_transfer_engine(board, length, fmh_gpib_default_engine(e_priv))) {
+	case GPIB_XFER_DMA:
+		return fmh_gpib_accel_read(board, buffer, length, end, bytes_read);
+	case GPIB_XFER_FIFO:
+		return fmh_gpib_fifo_read(board, buffer, length, end, bytes_read);
+	default:
+		break;
+	}
+	nec7210_set_handshake_mode(board, nec_priv, HR_HLDA);
+	retval = nec7210_read(board, nec_priv, buffer, length, end, bytes_read);
+	nec7210_set_handshake_mode(board, nec_priv, HR_HLDE);
+	return retval;
+}
+
+static int fmh_gpib_engine_write(struct gpib_board *board, u8 *buffer, size_t length,
+				 int send_eoi, size_t *bytes_written)
+{
+	struct fmh_priv *e_priv = board->private_data;
+
+	switch (gpib_transfer_engine(board, length, fmh_gpib_default_engine(e_priv))) {
+	case GPIB_XFER_DMA:
+		return fmh_gpib_accel_write(board, buffer, length, send_eoi, bytes_written);
+	case GPIB_XFER_FIFO:
+		return fmh_gpib_fifo_write(board, buffer, length, send_eoi, bytes_written);
+	default:
+		return fmh_gpib_write(board, buffer, length, send_eoi, bytes_written);
+	}
+}
+
 static struct gpib_interface fmh_gpib_unaccel_interface = {
 	.name = "fmh_gpib_unaccel",
 	.attach = fmh_gpib_attach_holdoff_all,
@@ -1063,8 +1121,8 @@ static struct gpib_interface fmh_gpib_interface = {
 	.name = "fmh_gpib",
 	.attach = fmh_gpib_attach_holdoff_end,
 	.detach = fmh_gpib_detach,
-	.read = fmh_gpib_accel_read,
-	.write = fmh_gpib_accel_write,
+	.read = fmh_gpib_engine_read,
+	.write = fmh_gpib_engine_write,
 	.command = fmh_gpib_command,
 	.take_control = fmh_gpib_take_control,
 	.go_to_standby = fmh_gpib_go_to_standby,
@@ -1085,14 +1143,15 @@ static struct gpib_interface fmh_gpib_interface = {
 	.serial_poll_status = fmh_gpib_serial_poll_status,
 	.t1_delay = fmh_gpib_t1_delay,
 	.return_to_local = fmh_gpib_return_to_local,
+	.transfer_engines = fmh_gpib_transfer_engines,
 };
 
 static struct gpib_interface fmh_gpib_pci_interface = {
 	.name = "fmh_gpib_pci",
 	.attach = fmh_gpib_pci_attach_holdoff_end,
 	.detach = fmh_gpib_pci_detach,
-	.read = fmh_gpib_fifo_read,
-	.write = fmh_gpib_fifo_write,
+	.read = fmh_gpib_engine_read,
+	.write = fmh_gpib_engine_write,
 	.command = fmh_gpib_command,
 	.take_control = fmh_gpib_take_control,
 	.go_to_standby = fmh_gpib_go_to_standby,
@@ -1113,6 +1172,7 @@ static struct gpib_interface fmh_gpib_pci_interface = {
 	.serial_poll_status = fmh_gpib_serial_poll_status,
 	.t1_delay = fmh_gpib_t1_delay,
 	.return_to_local = fmh_gpib_return_to_local,
+	.transfer_engines = fmh_gpib_transfer_engines,
 };
 
 static struct gpib_interface fmh_gpib_pci_unaccel_interface = {
@@ -29,8 +29,8 @@
 #define dev_fmt pr_fmt
 #define NAME KBUILD_MODNAME
 
-#define ENABLE_IRQ(IRQ, TYPE) irq_set_irq_type(IRQ, TYPE)
-#define DISABLE_IRQ(IRQ) irq_set_irq_type(IRQ, IRQ_TYPE_NONE)
+#define ENABLE_IRQ(IRQ, TYPE) bb_set_irq_type(IRQ, TYPE)
+#define DISABLE_IRQ(IRQ) bb_set_irq_type(IRQ, IRQ_TYPE_NONE)
 
 /*
  * Debug print levels:
@@ -61,11 +61,13 @@
 #include <linux/string.h>
 #include <linux/init.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 #include <linux/gpio/consumer.h>
 #include <linux/gpio/driver.h>
 #include <linux/gpio/machine.h>
 #include <linux/gpio.h>
 #include <linux/irq.h>
+#include <linux/interrupt.h>
 
 static int sn7516x_used = 1, sn7516x;
 module_param(sn7516x_used, int, 0660);
@@ -73,9 +75,10 @@ module_param(sn7516x_used, int, 0660);
 #define PINMAP_0 "elektronomikon"
 #define PINMAP_1 "gpib4pi-1.1"
 #define PINMAP_2 "yoga"
+#define PINMAP_3 "sim"
 static char *pin_map = PINMAP_0;
 module_param(pin_map, charp, 0660);
-MODULE_PARM_DESC(pin_map, " valid values: " PINMAP_0 " " PINMAP_1 " " PINMAP_2);
+MODULE_PARM_DESC(pin_map, " valid values: " PINMAP_0 " " PINMAP_1 " " PINMAP_2 " " PINMAP_3);
 
 /**********************************************
  *  Signal pairing and pin wiring between the *
@@ -132,6 +135,7 @@ enum lines_t {
  */
 
 #define GPIB_PINS 16
+#define DATA_LINES 8
 #define SN7516X_PINS 4
 #define NUM_PINS (GPIB_PINS + SN7516X_PINS)
 
@@ -265,6 +269,47 @@ static struct gpiod_lookup_table *lookup_tables[] = {
 	NULL
 };
 
+/*
+ * Lookup table for the "sim" pin map: a gpio-sim bank labelled "gpib-sim"
+ * with at least 28 lines, wired like the elektronomikon board so that
+ * simulated line n stands for Pi gpio n.
+ */
+#define SIM_CHIP "gpib-sim"
+
+static struct gpiod_lookup_table gpib_gpio_table_sim = {
+	.dev_id = "",	 // device id of board device
+	.table = {
+		GPIO_LOOKUP_IDX(SIM_CHIP,  4, NULL,  4, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP,  5, NULL,  5, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP,  6, NULL,  6, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP,  7, NULL,  7, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP,  8, NULL,  8, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP,  9, NULL,  9, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 10, NULL, 10, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 11, NULL, 11, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 12, NULL, 12, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 13, NULL, 13, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 16, NULL, 16, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 17, NULL, 17, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 18, NULL, 18, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 19, NULL, 19, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 20, NULL, 20, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 21, NULL, 21, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 22, NULL, 22, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 23, NULL, 23, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 24, NULL, 24, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 25, NULL, 25, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 26, NULL, 26, GPIO_ACTIVE_HIGH),
+		GPIO_LOOKUP_IDX(SIM_CHIP, 27, NULL, 27, GPIO_ACTIVE_HIGH),
+		{ }
+	},
+};
+
+static struct gpiod_lookup_table *sim_lookup_tables[] = {
+	&gpib_gpio_table_sim,
+	NULL
+};
+
 /* struct which defines private_data for gpio driver */
 
 struct bb_priv {
@@ -323,6 +368,7 @@ static void set_atn(struct gpib_board *board, int atn_asserted);
 
 static inline void SET_DIR_WRITE(struct bb_priv *priv);
 static inline void SET_DIR_READ(struct bb_priv *priv);
+static void bb_set_irq_type(int irq, unsigned int type);
 
 #define DIR_READ 0
 #define DIR_WRITE 1
@@ -334,6 +380,14 @@ MODULE_DESCRIPTION("GPIB helper functions for bitbanging I/O");
 static int debug;
 module_param(debug, int, 0644);
 
+static int poll_length;
+module_param(poll_length, int, 0644);
+MODULE_PARM_DESC(poll_length, " transfers up to this many bytes use a polled handshake (0 = off)");
+
+static int poll_usec = 50;
+module_param(poll_usec, int, 0644);
+MODULE_PARM_DESC(poll_usec, " longest busy wait for one handshake edge in polled mode");
+
 static char printable(char x)
 {
 	if (x < 32 || x > 126)
@@ -341,6 +395,135 @@ static char printable(char x)
 	return x;
 }
 
+/***************************************************************************
+ *									   *
+ * INTERRUPT triggers							   *
+ *									   *
+ ***************************************************************************/
+
+/*
+ * gpio-sim only raises interrupts on edges of the simulated pull and
+ * cannot turn a trigger off.  With the "sim" pin map a level trigger is
+ * armed as the matching edge, and raised by hand when the line already
+ * sits at that level; a disabled interrupt keeps its last edge and the
+ * handlers count what arrives as idle interrupts.
+ */
+static int edge_irqs_only;
+
+#define NUM_IRQ_LINES 4
+static struct {
+	int irq;
+	struct gpio_desc *line;
+} irq_lines[NUM_IRQ_LINES];
+
+static void bb_set_irq_type(int irq, unsigned int type)
+{
+	struct gpio_desc *line = NULL;
+	int level, j;
+
+	if (!edge_irqs_only) {
+		irq_set_irq_type(irq, type);
+		return;
+	}
+
+	switch (type) {
+	case IRQ_TYPE_LEVEL_HIGH:
+		irq_set_irq_type(irq, IRQ_TYPE_EDGE_RISING);
+		level = 1;
+		break;
+	case IRQ_TYPE_LEVEL_LOW:
+		irq_set_irq_type(irq, IRQ_TYPE_EDGE_FALLING);
+		level = 0;
+		break;
+	case IRQ_TYPE_NONE:
+		return;
+	default:
+		irq_set_irq_type(irq, type);
+		return;
+	}
+
+	for (j = 0; j < NUM_IRQ_LINES; j++) {
+		if (irq_lines[j].irq == irq)
+			line = irq_lines[j].line;
+	}
+	if (line && gpiod_get_value(line) == level)
+		irq_set_irqchip_state(irq, IRQCHIP_STATE_PENDING, true);
+}
+
+/***************************************************************************
+ *									   *
+ * POLLED handshake							   *
+ *									   *
+ ***************************************************************************/
+
+/*
+ * Transfers of up to poll_length bytes run the handshake in a busy loop
+ * instead of taking two or three interrupts per byte.  Each wait for a
+ * handshake edge spins for at most poll_usec; if the other side is slower
+ * than that, the transfer carries on from the same point under interrupt
+ * control.
+ */
+static int bb_spin_for(struct gpio_desc *line, int value)
+{
+	ktime_t deadline = ktime_add_us(ktime_get(), poll_usec);
+
+	while (gpiod_get_value(line) != value) {
+		if (ktime_after(ktime_get(), deadline))
+			return -ETIMEDOUT;
+		cpu_relax();
+	}
+	return 0;
+}
+
+/* returns true once the last byte has been fully handshaken */
+static bool bb_poll_read(struct gpib_board *board)
+{
+	struct bb_priv *priv = board->private_data;
+	u8 byte;
+
+	while (!priv->end_flag) {
+		gpiod_set_value(NRFD, 1); // ready for data
+		if (bb_spin_for(DAV, 0))
+			return false;
+		gpiod_set_value(NRFD, 0); // not ready for data
+		byte = get_data_lines();
+		priv->rbuf[priv->count++] = byte;
+		priv->end = !gpiod_get_value(EOI);
+		gpiod_set_value(NDAC, 1); // data accepted
+		priv->end |= check_for_eos(priv, byte);
+		priv->end_flag = ((priv->count >= priv->request) || priv->end);
+		priv->dav_rx = 0;
+		if (bb_spin_for(DAV, 1))
+			return false;
+		gpiod_set_value(NDAC, 0); // data not accepted
+		priv->dav_rx = 1;
+	}
+	priv->phase = 240;
+	return true;
+}
+
+static bool bb_poll_write(struct gpib_board *board)
+{
+	struct bb_priv *priv = board->private_data;
+
+	while (priv->w_cnt < priv->length) {
+		if (bb_spin_for(NRFD, 1))
+			return false;
+		set_data_lines(priv->w_buf[priv->w_cnt++]); // put the data on the lines
+		if (priv->w_cnt == priv->length && priv->end)
+			gpiod_set_value(EOI, 0); // Assert EOI
+		gpiod_set_value(DAV, 0); // Data available
+		priv->dav_tx = 0;
+		if (bb_spin_for(NDAC, 1))
+			return false;
+		gpiod_set_value(DAV, 1); // Data not available
+		priv->dav_tx = 1;
+	}
+	priv->write_done = 1;
+	priv->phase = 420;
+	return true;
+}
+
 /***************************************************************************
  *									   *
  * READ									   *
@@ -372,12 +555,20 @@ static int bb_read(struct gpib_board *board, u8 *buffer, size_t length,
 
 	dbg_printk(3, ".........." LINFMT "\n", LINVAL);
 
-	spin_lock_irqsave(&priv->rw_lock, flags);
-	priv->dav_mode = 1;
 	priv->dav_rx = 1;
-	ENABLE_IRQ(priv->irq_DAV, IRQ_TYPE_LEVEL_LOW);
 	priv->end_flag = 0;
-	gpiod_set_value(NRFD, 1); // ready for data
+	if (length <= poll_length && bb_poll_read(board))
+		goto read_done;
+
+	spin_lock_irqsave(&priv->rw_lock, flags);
+	priv->dav_mode = 1;
+	if (priv->dav_rx) {
+		ENABLE_IRQ(priv->irq_DAV, IRQ_TYPE_LEVEL_LOW);
+		gpiod_set_value(NRFD, 1); // ready for data
+	} else {
+		/* polled read stopped waiting for the talker to release DAV */
+		ENABLE_IRQ(priv->irq_DAV, IRQ_TYPE_LEVEL_HIGH);
+	}
 	priv->r_busy = 1;
 	priv->phase = 100;
 	spin_unlock_irqrestore(&priv->rw_lock, flags);
@@ -385,7 +576,8 @@ static int bb_read(struct gpib_board *board, u8 *buffer, size_t length,
 	/* wait for the interrupt routines finish their work */
 
 	retval = wait_event_interruptible(board->wait,
-					  (priv->end_flag || board->status & TIMO));
+					  ((priv->end_flag && !priv->r_busy) ||
+					   board->status & TIMO));
 
 	dbg_printk(3, "awake from wait queue: %d\n", retval);
 
@@ -397,6 +589,7 @@ static int bb_read(struct gpib_board *board, u8 *buffer, size_t length,
 	}
 
 	DISABLE_IRQ(priv->irq_DAV);
+read_done:
 	spin_lock_irqsave(&priv->rw_lock, flags);
 	gpiod_set_value(NRFD, 0); // DIR_READ line state
 	priv->r_busy = 0;
@@ -520,12 +713,17 @@ static int bb_write(struct gpib_board *board, u8 *buffer, size_t length,
 		goto write_end;
 	}
 
+	priv->write_done = 0;
+	priv->dav_tx = 1;
+	if (length <= poll_length && bb_poll_write(board)) {
+		retval = priv->w_cnt;
+		goto write_done;
+	}
+
 	spin_lock_irqsave(&priv->rw_lock, flags);
 	priv->w_busy = 1;	   /* make the interrupt routines active */
-	priv->write_done = 0;
 	priv->nrfd_mode = 1;
 	priv->ndac_mode = 1;
-	priv->dav_tx = 1;
 	ENABLE_IRQ(priv->irq_NDAC, IRQ_TYPE_LEVEL_HIGH);
 	ENABLE_IRQ(priv->irq_NRFD, IRQ_TYPE_LEVEL_HIGH);
 	spin_unlock_irqrestore(&priv->rw_lock, flags);
@@ -552,6 +750,7 @@ static int bb_write(struct gpib_board *board, u8 *buffer, size_t length,
 	DISABLE_IRQ(priv->irq_NRFD);
 	DISABLE_IRQ(priv->irq_NDAC);
 
+write_done:
 	spin_lock_irqsave(&priv->rw_lock, flags);
 	priv->w_busy = 0;
 	gpiod_set_value(DAV, 1); // DIR_WRITE line state
@@ -1082,6 +1281,8 @@ static int bb_get_irq(struct gpib_board *board, char *name,
 		      struct gpio_desc *gpio, int *irq,
 		      irq_handler_t handler, irq_handler_t thread_fn, unsigned long flags)
 {
+	int j;
+
 	if (!gpio)
 		return -1;
 	gpiod_direction_input(gpio);
@@ -1096,13 +1297,26 @@ static int bb_get_irq(struct gpib_board *board, char *name,
 		*irq = 0;
 		return -1;
 	}
+	for (j = 0; j < NUM_IRQ_LINES; j++) {
+		if (!irq_lines[j].irq) {
+			irq_lines[j].irq = *irq;
+			irq_lines[j].line = gpio;
+			break;
+		}
+	}
 	DISABLE_IRQ(*irq);
 	return 0;
 }
 
 static void bb_free_irq(struct gpib_board *board, int *irq, char *name)
 {
+	int j;
+
 	if (*irq) {
+		for (j = 0; j < NUM_IRQ_LINES; j++) {
+			if (irq_lines[j].irq == *irq)
+				irq_lines[j].irq = 0;
+		}
 		free_irq(*irq, board);
 		dbg_printk(2, "IRQ %d(%s) freed\n", *irq, name);
 		*irq = 0;
@@ -1121,7 +1335,7 @@ static void release_gpios(void)
 	}
 }
 
-static int allocate_gpios(struct gpib_board *board)
+static int allocate_gpios(struct gpib_board *board, struct gpiod_lookup_table **tables)
 {
 	int j;
 	int table_index = 0;
@@ -1134,7 +1348,7 @@ static int allocate_gpios(struct gpib_board *board)
 		return -ENOENT;
 	}
 
-	lookup_table = lookup_tables[table_index];
+	lookup_table = tables[table_index];
 	lookup_table->dev_id = dev_name(board->gpib_dev);
 	gpiod_add_lookup_table(lookup_table);
 	dbg_printk(1, "Allocating gpios using table index %d\n", table_index);
@@ -1151,7 +1365,7 @@ try_again:
 		if (IS_ERR(desc)) {
 			gpiod_remove_lookup_table(lookup_table);
 			table_index++;
-			lookup_table = lookup_tables[table_index];
+			lookup_table = tables[table_index];
 			if (!lookup_table) {
 				dev_err(board->gpib_dev, "Unable to obtain gpio descriptor for pin %d error %ld\n",
 					gpios_vector[j], PTR_ERR(desc));
@@ -1220,6 +1434,7 @@ static int bb_attach(struct gpib_board *board, const struct gpib_board_config *c
 	priv->talker_state = talker_idle;
 
 	sn7516x = sn7516x_used;
+	edge_irqs_only = 0;
 	if (strcmp(PINMAP_0, pin_map) == 0) {
 		if (!sn7516x) {
 			gpios_vector[&(PE) - &all_descriptors[0]] = -1;
@@ -1241,6 +1456,12 @@ static int bb_attach(struct gpib_board *board, const struct gpib_board_config *c
 		gpios_vector[&(D06) - &all_descriptors[0]] = YOGA_D06_pin_nr;
 		gpios_vector[&(PE)  - &all_descriptors[0]] = -1;
 		gpios_vector[&(DC)  - &all_descriptors[0]] = -1;
+	} else if (strcmp(PINMAP_3, pin_map) == 0) { /* gpio-sim */
+		sn7516x = 0;
+		edge_irqs_only = 1;
+		gpios_vector[&(PE) - &all_descriptors[0]] = -1;
+		gpios_vector[&(DC) - &all_descriptors[0]] = -1;
+		gpios_vector[&(TE) - &all_descriptors[0]] = -1;
 	} else {
 		dev_err(board->gpib_dev, "Unrecognized pin map %s\n", pin_map);
 		goto bb_attach_fail;
@@ -1248,7 +1469,7 @@ static int bb_attach(struct gpib_board *board, const struct gpib_board_config *c
 	dbg_printk(0, "Using pin map \"%s\" %s\n", pin_map, (sn7516x) ?
 		   " with SN7516x driver support" : "");
 
-	if (allocate_gpios(board))
+	if (allocate_gpios(board, edge_irqs_only ? sim_lookup_tables : lookup_tables))
 		goto bb_attach_fail;
 
 /*
@@ -1389,31 +1610,26 @@ static void set_data_lines_output(void)
 	gpiod_direction_output(D08, 1);
 }
 
+/*
+ * D01..D08 are the first eight entries of all_descriptors[], so they are
+ * passed to gpiolib as one array.  gpiolib groups the lines by chip and
+ * sets or reads each chip with a single set_multiple/get_multiple call,
+ * i.e. one register access per byte when all the data lines are on the
+ * same bank, as they are on the Pi.  Data lines are active low.
+ */
 static void set_data_lines(u8 byte)
 {
-	gpiod_set_value(D01, !(byte & 0x01));
-	gpiod_set_value(D02, !(byte & 0x02));
-	gpiod_set_value(D03, !(byte & 0x04));
-	gpiod_set_value(D04, !(byte & 0x08));
-	gpiod_set_value(D05, !(byte & 0x10));
-	gpiod_set_value(D06, !(byte & 0x20));
-	gpiod_set_value(D07, !(byte & 0x40));
-	gpiod_set_value(D08, !(byte & 0x80));
+	unsigned long bitmap = (u8)~byte;
+
+	gpiod_set_array_value(DATA_LINES, &D01, NULL, &bitmap);
 }
 
 static u8 get_data_lines(void)
 {
-	u8 ret;
-
-	ret = gpiod_get_value(D01);
-	ret |= gpiod_get_value(D02) << 1;
-	ret |= gpiod_get_value(D03) << 2;
-	ret |= gpiod_get_value(D04) << 3;
-	ret |= gpiod_get_value(D05) << 4;
-	ret |= gpiod_get_value(D06) << 5;
-	ret |= gpiod_get_value(D07) << 6;
-	ret |= gpiod_get_value(D08) << 7;
-	return ~ret;
+	unsigned long bitmap = 0;
+
+	gpiod_get_array_value(DATA_LINES, &D01, NULL, &bitmap);
+	return ~bitmap;
 }
 
 static void set_data_lines_input(void)
@@ -296,6 +296,7 @@ static int hp82335_attach(struct gpib_board *board, const struct gpib_board_conf
 		return retval;
 	}
 	hp_priv->irq = config->ibirq;
+	gpib_pio_spin_set_handler(&tms_priv->pio_spin, hp82335_interrupt, config->ibirq, board);
 
 	tms9914_board_reset(tms_priv);
 
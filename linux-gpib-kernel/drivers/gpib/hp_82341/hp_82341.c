@@ -754,6 +754,7 @@ static int hp_82341_attach(struct gpib_board *board, const struct gpib_board_con
 		return -EIO;
 	}
 	hp_priv->irq = irq;
+	gpib_pio_spin_set_handler(&tms_priv->pio_spin, hp_82341_interrupt, irq, board);
 	hp_priv->config_control_bits &= ~IRQ_SELECT_MASK;
 	hp_priv->config_control_bits |= IRQ_SELECT_BITS(irq);
 	outb(hp_priv->config_control_bits, hp_priv->iobase[0] + CONFIG_CONTROL_STATUS_REG);
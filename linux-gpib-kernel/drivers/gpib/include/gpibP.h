@@ -18,6 +18,8 @@
 #include <linux/fs.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/wait.h>
 
 int gpib_register_driver(struct gpib_interface *interface, struct module *mod);
 void gpib_unregister_driver(struct gpib_interface *interface);
@@ -34,6 +36,71 @@ int gpib_request_pseudo_irq(struct gpib_board *board,
 void gpib_free_pseudo_irq(struct gpib_board *board);
 int gpib_match_device_path(struct device *dev, const char *device_path_in);
 
+/*
+ * Spin-then-sleep waiting for the per byte PIO loops of chips without a
+ * fifo.  Before sleeping on board->wait the caller runs the board's
+ * interrupt handler for up to budget_usec, which follows the gaps between
+ * bytes and never exceeds the board's pio_spin_usec setting.  The whole
+ * handler has to run, not just the chip library's part of it, since board
+ * status registers and interrupt latches must be cleared as well.
+ */
+#define GPIB_PIO_SPIN_MAX_USEC 1000
+
+void gpib_pio_spin_start(const struct gpib_board *board, struct gpib_pio_spin *spin,
+			 void (*mask_irq)(struct gpib_board *board, struct gpib_pio_spin *spin,
+					  int mask));
+void gpib_pio_spin_tune(struct gpib_pio_spin *spin, s64 waited_ns);
+void gpib_pio_spin_poll(struct gpib_pio_spin *spin);
+
+/* let the pio loops spin, calling handler as if irq had fired */
+static inline void gpib_pio_spin_set_handler(struct gpib_pio_spin *spin,
+					     irqreturn_t (*handler)(int irq, void *arg PT_REGS_ARG),
+					     int irq, void *dev_id)
+{
+	spin->handler = handler;
+	spin->irq = irq;
+	spin->dev_id = dev_id;
+}
+
+/* like wait_event_interruptible(), but spins on the interrupt handler first */
+#define gpib_pio_wait_event(board, spin, condition)			\
+({									\
+	int __ret = 0;							\
+									\
+	if ((spin)->limit_usec) {					\
+		ktime_t __start = ktime_get();				\
+		s64 __budget = (s64)(spin)->budget_usec * NSEC_PER_USEC; \
+									\
+		(spin)->mask_irq(board, spin, 1);			\
+		while (!(condition) &&					\
+		       ktime_to_ns(ktime_sub(ktime_get(), __start)) < __budget) { \
+			gpib_pio_spin_poll(spin);			\
+			cpu_relax();					\
+		}							\
+		(spin)->mask_irq(board, spin, 0);			\
+		if (!(condition))					\
+			__ret = wait_event_interruptible((board)->wait, condition); \
+		gpib_pio_spin_tune(spin, ktime_to_ns(ktime_sub(ktime_get(), __start))); \
+	} else {							\
+		__ret = wait_event_interruptible((board)->wait, condition); \
+	}								\
+	__ret;								\
+})
+
+/* engine to move a transfer of length bytes with, given the driver's default */
+static inline unsigned int gpib_transfer_engine(const struct gpib_board *board, size_t length,
+						unsigned int default_engine)
+{
+	switch (board->transfer_engine) {
+	case GPIB_XFER_DEFAULT:
+		return default_engine;
+	case GPIB_XFER_AUTO:
+		return length >= board->dma_threshold ? GPIB_XFER_DMA : board->small_transfer_engine;
+	default:
+		return board->transfer_engine;
+	}
+}
+
 extern struct gpib_board board_array[GPIB_MAX_NUM_BOARDS];
 
 extern struct list_head registered_drivers;
@@ -16,8 +16,10 @@
 #include <linux/sched.h>
 #include <linux/timer.h>
 #include <linux/interrupt.h>
+#include <linux/kref.h>
 
 struct gpib_board;
+struct gpib_file_private;
 
 /* config parameters that are only used by driver attach functions */
 struct gpib_board_config {
@@ -190,6 +192,12 @@ struct gpib_interface {
 	int (*t1_delay)(struct gpib_board *board, unsigned int nano_sec);
 	/* go to local mode */
 	void (*return_to_local)(struct gpib_board *board);
+	/*
+	 * returns the mask of (1 << enum gpib_transfer_engine) the board can
+	 * use for reads and writes.  Drivers providing this pick the engine
+	 * of each transfer with gpib_transfer_engine().
+	 */
+	unsigned int (*transfer_engines)(struct gpib_board *board);
 	/* board does not support 7 bit eos comparisons */
 	unsigned no_7_bit_eos : 1;
 	/* skip check for listeners before trying to send command bytes */
@@ -226,6 +234,76 @@ static inline void init_gpib_pseudo_irq(struct gpib_pseudo_irq *pseudo_irq)
 	atomic_set(&pseudo_irq->active, 0);
 }
 
+/* busy wait budget of a PIO transfer, see gpib_pio_wait_event() */
+struct gpib_pio_spin {
+	unsigned int limit_usec;	/* 0 turns spinning off */
+	unsigned int budget_usec;
+	/*
+	 * The board's interrupt handler, run while spinning.  Boards which
+	 * haven't set it with gpib_pio_spin_set_handler() never spin.
+	 */
+	irqreturn_t (*handler)(int irq, void *arg PT_REGS_ARG);
+	int irq;
+	void *dev_id;
+	/*
+	 * Set by the chip library: masks the chip's interrupts while spinning,
+	 * so the real irq doesn't find the status already taken and go
+	 * unhandled, and unmasks them again before sleeping.
+	 */
+	void (*mask_irq)(struct gpib_board *board, struct gpib_pio_spin *spin, int mask);
+};
+
+/* state of a streaming acquisition started by IBSTREAM_START */
+struct gpib_stream {
+	/* freed once the board and every user mapping have let go */
+	struct kref ref;
+	/* vmalloc_user() area: one header page followed by the data ring */
+	void *area;
+	unsigned long area_length;
+	struct gpib_stream_ring *ring;
+	u8 *data;
+	/* size of data ring, a power of two */
+	size_t size;
+	struct task_struct *task;
+	/* file which started the stream, it is stopped when that is closed */
+	struct gpib_file_private *file_priv;
+	atomic_t stop;
+	/*
+	 * The driver's own copies of the ring header fields it writes.  The
+	 * ring page is writable by user space, so these are only ever copied
+	 * out to it, never read back.
+	 */
+	u64 head;
+	u32 flags;
+	u64 overruns;
+	u64 end_count;
+	/* completed when the thread has finished reading */
+	struct completion done;
+};
+
+/* state of the device mode responder started by IBRESPONDER_START */
+struct gpib_responder {
+	struct task_struct *task;
+	/* file which started the responder, it is stopped when that is closed */
+	struct gpib_file_private *file_priv;
+	/* protects the message lists and counts below */
+	struct mutex lock;
+	/* responses waiting for the board to be addressed to talk */
+	struct list_head responses;
+	unsigned int num_responses;
+	/* data received as listener and not yet read */
+	struct list_head received;
+	size_t received_bytes;
+	/* most bytes of listener data held, 0 if the responder doesn't listen */
+	size_t listen_size;
+	/* woken when listener data arrives or the thread exits */
+	wait_queue_head_t wait;
+	atomic_t stop;
+	atomic_t active;
+	/* errno which stopped the thread, if any */
+	int error;
+};
+
 /* list so we can make a linked list of drivers */
 struct gpib_interface_list {
 	struct list_head list;
@@ -302,12 +380,24 @@ struct gpib_board {
 	u8 parallel_poll_configuration;
 	/* t1 delay we are using */
 	unsigned int t1_nano_sec;
+	/* enum gpib_transfer_engine selected with IBXFER_ENGINE */
+	unsigned int transfer_engine;
+	/* engine GPIB_XFER_AUTO uses for transfers below dma_threshold */
+	unsigned int small_transfer_engine;
+	/* smallest transfer GPIB_XFER_AUTO does with DMA, in bytes */
+	unsigned int dma_threshold;
 	/* Count that keeps track of whether board is up and running or not */
 	unsigned int online;
 	/* number of processes trying to autopoll */
 	int autospollers;
 	/* autospoll kernel thread */
 	struct task_struct *autospoll_task;
+	/* streaming acquisition in progress, if any */
+	struct gpib_stream *stream;
+	/* woken when stream data arrives or the stream stops */
+	wait_queue_head_t stream_wait;
+	/* device mode responder, if running */
+	struct gpib_responder *responder;
 	/* queue for recording received trigger/clear/ifc events */
 	struct gpib_event_queue event_queue;
 	/* minor number for this board's device file */
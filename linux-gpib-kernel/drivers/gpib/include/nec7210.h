@@ -42,6 +42,8 @@ struct nec7210_priv {
 	enum talker_function_state talker_state;
 	enum listener_function_state listener_state;
 	void *private;
+	// busy wait budget of the pio loops
+	struct gpib_pio_spin pio_spin;
 	unsigned srq_pending : 1;
 };
 
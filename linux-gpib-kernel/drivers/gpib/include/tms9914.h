@@ -48,6 +48,8 @@ struct tms9914_priv {
 	unsigned holdoff_on_end : 1;
 	unsigned holdoff_on_all : 1;
 	unsigned holdoff_active : 1;
+	// busy wait budget of the pio loops
+	struct gpib_pio_spin pio_spin;
 	// wrappers for outb, inb, readb, or writeb
 	u8 (*read_byte)(struct tms9914_priv *priv, unsigned int register_number);
 	void (*write_byte)(struct tms9914_priv *priv, u8 byte, unsigned int
@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/***************************************************************************
+ * Read reply parser of the lpvo_usb_gpib adapter.  It only needs memchr(),
+ * memcpy() and dev_err(), so test/lpvo_parser_bench.c in the user space
+ * tree can build it with stand-ins for those and time it on recorded
+ * adapter output.
+ ***************************************************************************/
+
+#ifndef _LPVO_READ_PARSER_H
+#define _LPVO_READ_PARSER_H
+
+/* special characters used by the adapter */
+
+#define DLE ('\020')
+#define STX ('\02')
+#define ETX ('\03')
+#define ACK ('\06')
+#define NODATA ('\03')
+#define NODAV ('\011')
+
+/*
+ * Receive parser for the <DLE><STX> data <DLE><ETX><ACK> reply to a read
+ * command.  A data <DLE> is sent as <DLE><DLE>.  Whole blocks from the
+ * adapter are parsed at once: runs of plain data are found with memchr()
+ * and copied with memcpy(), so only the escapes are handled byte by byte.
+ */
+
+#define MAX_READ_EXCESS 16384
+
+enum read_parser_state {
+	RP_START,		/* expecting <DLE> of <DLE><STX> */
+	RP_START_DLE,		/* expecting <STX> */
+	RP_DATA,		/* in the data */
+	RP_DLE,			/* after a <DLE> in the data */
+	RP_ETX,			/* expecting the closing <ACK> */
+	RP_FLUSH,		/* buffer full or eos seen, discard the data */
+	RP_FLUSH_DLE,
+	RP_FLUSH_ETX,
+};
+
+struct read_parser {
+	enum read_parser_state state;
+	u8 *buffer;		/* destination */
+	size_t length;		/* room in buffer */
+	size_t count;		/* bytes stored in buffer */
+	size_t excess;		/* bytes discarded while flushing */
+	u8 eos;
+	int end;
+};
+
+static void read_parser_init(struct read_parser *p, u8 *buffer, size_t length, u8 eos)
+{
+	p->state = RP_START;
+	p->buffer = buffer;
+	p->length = length;
+	p->count = 0;
+	p->excess = 0;
+	p->eos = eos;
+	p->end = 0;
+}
+
+/* store data bytes; returns the number consumed from data */
+static size_t read_parser_store(struct read_parser *p, const u8 *data, size_t n)
+{
+	const u8 *eos;
+	size_t room = p->length - p->count;
+
+	if (room == 0) {
+		/* data overflow - flush excess data */
+		p->state = RP_FLUSH;
+		return 0;
+	}
+	if (n > room)
+		n = room;
+	eos = memchr(data, p->eos, n);
+	if (eos) {
+		n = eos - data + 1;
+		p->end = 1;
+		p->state = RP_FLUSH;
+	}
+	memcpy(p->buffer + p->count, data, n);
+	p->count += n;
+	return n;
+}
+
+/*
+ * read_parser_feed() - parse a block received from the adapter
+ *
+ * Returns 1 once the closing <ACK> has been seen, 0 if more input is
+ * needed, or a negative error.
+ */
+static int read_parser_feed(struct device *dev, struct read_parser *p,
+			    const u8 *in, size_t n)
+{
+	const u8 *dle;
+	size_t run;
+
+	while (n) {
+		switch (p->state) {
+		case RP_START:
+		case RP_START_DLE:
+			if (in[0] != (p->state == RP_START ? DLE : STX)) {
+				dev_err(dev, "wrong <DLE><STX> sequence\n");
+				return -EIO;
+			}
+			p->state = p->state == RP_START ? RP_START_DLE : RP_DATA;
+			in++;
+			n--;
+			break;
+		case RP_DATA:
+			dle = memchr(in, DLE, n);
+			run = dle ? dle - in : n;
+			if (run) {
+				run = read_parser_store(p, in, run);
+				in += run;
+				n -= run;
+			} else {
+				p->state = RP_DLE;
+				in++;
+				n--;
+			}
+			break;
+		case RP_DLE:
+			if (in[0] == DLE) {
+				/* escaped data <DLE> */
+				p->state = RP_DATA;
+				read_parser_store(p, in, 1);
+			} else if (in[0] == ETX) {
+				/* we are in the closing <DLE><ETX> sequence */
+				p->state = RP_ETX;
+			} else {
+				dev_err(dev, "lone <DLE> in stream");
+				return -EIO;
+			}
+			in++;
+			n--;
+			break;
+		case RP_ETX:
+			if (in[0] == ACK) {
+				p->end = 1;
+				return 1;
+			}
+			dev_err(dev, "wrong end of message %x", in[0]);
+			return -ETIME;
+		case RP_FLUSH:
+			dle = memchr(in, DLE, n);
+			run = dle ? dle - in + 1 : n;
+			if (dle)
+				p->state = RP_FLUSH_DLE;
+			p->excess += run;
+			in += run;
+			n -= run;
+			if (p->excess > MAX_READ_EXCESS) {
+				dev_err(dev, "no input end - board in odd state\n");
+				return -EIO;
+			}
+			break;
+		case RP_FLUSH_DLE:
+			p->state = in[0] == ETX ? RP_FLUSH_ETX : RP_FLUSH;
+			p->excess++;
+			in++;
+			n--;
+			break;
+		case RP_FLUSH_ETX:
+			if (in[0] == ACK) {
+				if (p->excess > 2)
+					dev_dbg(dev, "small buffer - maybe some data lost");
+				return 1;
+			}
+			dev_err(dev, "no input end - board in odd state\n");
+			return -EIO;
+		}
+	}
+	return 0;
+}
+
+#endif	/* _LPVO_READ_PARSER_H */
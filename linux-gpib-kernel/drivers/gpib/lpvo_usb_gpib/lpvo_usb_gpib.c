@@ -121,14 +121,9 @@ module_param(debug, int, 0644);
 #define USB_GPIB_UNTALK "\nIBC_\n"
 #define USB_GPIB_UNLISTEN "\nIBC?\n"
 
-/* special characters used by the adapter */
+/* special characters used by the adapter, and the read reply parser */
 
-#define DLE ('\020')
-#define STX ('\02')
-#define ETX ('\03')
-#define ACK ('\06')
-#define NODATA ('\03')
-#define NODAV ('\011')
+#include "lpvo_read_parser.h"
 
 #define IB_BUS_REN  0x01
 #define IB_BUS_IFC  0x02
@@ -139,19 +134,15 @@ module_param(debug, int, 0644);
 #define IB_BUS_ATN  0x40
 #define IB_BUS_SRQ  0x80
 
-#define INBUF_SIZE 128
-
-struct char_buf {		/* used by one_char() routine */
-	char *inbuf;
-	int last;
-	int nchar;
-};
+/* large enough for the biggest bulk in transfer, see skel_probe() */
+#define INBUF_SIZE 4096
 
 struct usb_gpib_priv {		/* private data to the device */
 	u8 eos;			/* eos character */
 	short eos_flags;	/* eos mode */
 	int timeout;		/* current value for timeout */
 	void *dev;		/* the usb device private data structure */
+	char *inbuf;		/* receive buffer for usb_gpib_read() */
 };
 
 #define GPIB_DEV (((struct usb_gpib_priv *)board->private_data)->dev)
@@ -299,36 +290,6 @@ static int set_control_line(struct gpib_board *board, int line, int value)
 	return retval;
 }
 
-/*
- * one_char() - read one single byte from input buffer
- *
- * @board:	the gpib_board_struct data area for this gpib interface
- * @char_buf:	the routine private data structure
- */
-
-static int one_char(struct gpib_board *board, struct char_buf *b)
-{
-	struct timespec64 before, after;
-
-	if (b->nchar) {
-		DIA_LOG(2, "-> %x\n", b->inbuf[b->last - b->nchar]);
-		return b->inbuf[b->last - b->nchar--];
-	}
-	ktime_get_real_ts64 (&before);
-	b->nchar = skel_do_read(GPIB_DEV, b->inbuf, INBUF_SIZE);
-	b->last = b->nchar;
-	ktime_get_real_ts64 (&after);
-
-	DIA_LOG(2, "read %d bytes in %d usec\n",
-		b->nchar, usec_diff(&after, &before));
-
-	if (b->nchar > 0) {
-		DIA_LOG(2, "--> %x\n", b->inbuf[b->last - b->nchar]);
-		return b->inbuf[b->last - b->nchar--];
-	}
-	return -EIO;
-}
-
 /**
  * set_timeout() - set single byte / total timeouts on the adapter
  *
@@ -449,6 +410,12 @@ static int usb_gpib_attach(struct gpib_board *board, const struct gpib_board_con
 	board->private_data = kzalloc(sizeof(struct usb_gpib_priv), GFP_KERNEL);
 	if (!board->private_data)
 		return -ENOMEM;
+	((struct usb_gpib_priv *)board->private_data)->inbuf = kmalloc(INBUF_SIZE, GFP_KERNEL);
+	if (!((struct usb_gpib_priv *)board->private_data)->inbuf) {
+		kfree(board->private_data);
+		board->private_data = NULL;
+		return -ENOMEM;
+	}
 
 	retval = skel_do_open(board, usb_minors[j]);
 
@@ -456,6 +423,7 @@ static int usb_gpib_attach(struct gpib_board *board, const struct gpib_board_con
 
 	if (retval) {
 		dev_err(board->gpib_dev, "skel open failed.\n");
+		kfree(((struct usb_gpib_priv *)board->private_data)->inbuf);
 		kfree(board->private_data);
 		board->private_data = NULL;
 		return -ENODEV;
@@ -525,6 +493,7 @@ static void usb_gpib_detach(struct gpib_board *board)
 			retval = skel_do_release(board);
 			DIA_LOG(1, "skel release -> %d\n", retval);
 		}
+		kfree(((struct usb_gpib_priv *)board->private_data)->inbuf);
 		kfree(board->private_data);
 		board->private_data = NULL;
 	}
@@ -746,15 +715,10 @@ static int usb_gpib_read(struct gpib_board *board,
 			 int *end,
 			 size_t *bytes_read)
 {
-#define MAX_READ_EXCESS 16384
-
-	struct char_buf b = {NULL, 0};
-
+	struct read_parser parser;
 	int retval;
-	char c, nc;
-	int ic;
+	int nchar;
 	struct timespec64 before, after;
-	int read_count = MAX_READ_EXCESS;
 	struct usb_gpib_priv *pd = (struct usb_gpib_priv *)board->private_data;
 
 	DIA_LOG(1, "enter %p -> %zu\n", board, length);
@@ -767,9 +731,9 @@ static int usb_gpib_read(struct gpib_board *board,
 	/* single byte read has a special handling */
 
 	if (length == 1) {
-		char inbuf[2] = {0, 0};
+		char *inbuf = pd->inbuf;
 
-		/* read a single character */
+		/* read a single character, usually received together with <ACK> */
 
 		ktime_get_real_ts64 (&before);
 
@@ -777,8 +741,12 @@ static int usb_gpib_read(struct gpib_board *board,
 		if (retval < 0)
 			return retval;
 
-		retval = skel_do_read(GPIB_DEV, inbuf, 1);
-		retval += skel_do_read(GPIB_DEV, inbuf + 1, 1);
+		inbuf[1] = 0;
+		retval = skel_do_read(GPIB_DEV, inbuf, INBUF_SIZE);
+		if (retval == 1) {
+			nchar = skel_do_read(GPIB_DEV, inbuf + 1, INBUF_SIZE - 1);
+			retval = nchar < 0 ? nchar : retval + nchar;
+		}
 
 		ktime_get_real_ts64 (&after);
 
@@ -799,97 +767,34 @@ static int usb_gpib_read(struct gpib_board *board,
 			return -ETIME;
 	}
 
-	/* allocate buffer for multibyte read */
-
-	b.inbuf = kmalloc(INBUF_SIZE, GFP_KERNEL);
-	if (!b.inbuf)
-		return -ENOMEM;
-
-	/* send read command and check <DLE><STX> sequence */
+	/* send read command and parse the reply as it arrives */
 
 	retval = write_loop(GPIB_DEV, USB_GPIB_READ, strlen(USB_GPIB_READ));
 	if (retval < 0)
 		goto read_return;
 
-	if (one_char(board, &b) != DLE || one_char(board, &b) != STX) {
-		dev_err(board->gpib_dev, "wrong <DLE><STX> sequence\n");
-		retval = -EIO;
-		goto read_return;
-	}
-
-	/* get data flow */
+	read_parser_init(&parser, buffer, length, pd->eos);
 
-	while (1) {
-		ic = one_char(board, &b);
-		if (ic == -EIO) {
-			retval = -EIO;
-			goto read_return;
-		}
-		c = ic;
-
-		if (c == DLE)
-			nc = one_char(board, &b);
-		if (c != DLE || nc == DLE) {
-			/* data byte - store into buffer */
-
-			if (*bytes_read == length)
-				break; /* data overflow */
-			if (c == DLE)
-				c = nc;
-			buffer[(*bytes_read)++] = c;
-			if (c == pd->eos) {
-				*end = 1;
-				break;
-			}
+	do {
+		ktime_get_real_ts64 (&before);
+		nchar = skel_do_read(GPIB_DEV, pd->inbuf, INBUF_SIZE);
+		ktime_get_real_ts64 (&after);
 
-		} else {
-			/* we are in the closing <DLE><ETX> sequence */
-			c = nc;
-			if (c == ETX) {
-				c = one_char(board, &b);
-				if (c == ACK) {
-					*end = 1;
-					retval = 0;
-					goto read_return;
-				} else {
-					dev_err(board->gpib_dev, "wrong end of message %x", c);
-					retval = -ETIME;
-					goto read_return;
-				}
-			} else {
-				dev_err(board->gpib_dev, "lone <DLE> in stream");
-				retval = -EIO;
-				goto read_return;
-			}
-		}
-	}
+		DIA_LOG(2, "read %d bytes in %d usec\n",
+			nchar, usec_diff(&after, &before));
 
-	/* we had a data overflow - flush excess data */
-
-	while (read_count--) {
-		if (one_char(board, &b) != DLE)
-			continue;
-		c = one_char(board, &b);
-		if (c == DLE)
-			continue;
-		if (c == ETX) {
-			c = one_char(board, &b);
-			if (c == ACK) {
-				if (MAX_READ_EXCESS - read_count > 1)
-					dev_dbg(board->gpib_dev, "small buffer - maybe some data lost");
-				retval = 0;
-				goto read_return;
-			}
+		if (nchar <= 0) {
+			retval = -EIO;
 			break;
 		}
-	}
-
-	dev_err(board->gpib_dev, "no input end - board in odd state\n");
-	retval = -EIO;
+		retval = read_parser_feed(board->gpib_dev, &parser, (u8 *)pd->inbuf, nchar);
+	} while (retval == 0);
+	if (retval > 0)
+		retval = 0;
+	*bytes_read = parser.count;
+	*end = parser.end;
 
 read_return:
-	kfree(b.inbuf);
-
 	DIA_LOG(1, "done with byte/status: %d %x %d\n",	(int)*bytes_read, retval, *end);
 
 	if (retval == 0 || retval == -ETIME) {
@@ -1258,6 +1163,7 @@ struct usb_skel {
 	struct urb	      *bulk_in_urb;	     /* the urb to read data with */
 	unsigned char	      *bulk_in_buffer;	     /* the buffer to receive data */
 	size_t		      bulk_in_size;	     /* the size of the receive buffer */
+	size_t		      bulk_in_maxp;	     /* max packet size of the bulk in endpoint */
 	size_t		      bulk_in_filled;	     /* number of bytes in the buffer */
 	size_t		      bulk_in_copied;	     /* already copied to user space */
 	__u8		      bulk_in_endpoint_addr;  /* the address of the bulk in endpoint */
@@ -1349,6 +1255,29 @@ static int skel_do_release(struct gpib_board *board)
  * read functions
  */
 
+/*
+ * The ftdi chip starts every packet with two status bytes.  A transfer
+ * spans several packets, so drop the status of all but the first one,
+ * which skel_do_read() discards itself.  Returns the remaining length.
+ */
+static size_t skel_strip_status(struct usb_skel *dev, size_t length)
+{
+	unsigned char *buffer = dev->bulk_in_buffer;
+	size_t maxp = dev->bulk_in_maxp;
+	size_t in, out, n;
+
+	if (length <= maxp)
+		return length;
+	for (in = maxp, out = maxp; in < length; in += maxp) {
+		n = min(maxp, length - in);
+		if (n > 2) {
+			memmove(buffer + out, buffer + in + 2, n - 2);
+			out += n - 2;
+		}
+	}
+	return out;
+}
+
 static void skel_read_bulk_callback(struct urb *urb)
 {
 	struct usb_skel *dev;
@@ -1367,7 +1296,7 @@ static void skel_read_bulk_callback(struct urb *urb)
 
 		dev->errors = urb->status;
 	} else {
-		dev->bulk_in_filled = urb->actual_length;
+		dev->bulk_in_filled = skel_strip_status(dev, urb->actual_length);
 	}
 	dev->ongoing_read = 0;
 	spin_unlock_irqrestore(&dev->err_lock, flags);
@@ -1504,9 +1433,9 @@ retry:
 		 */
 
 		/*
-		 * Condition dev->bulk_in_copied > 0 maybe will never happen. In case,
-		 * signal the event and copy using the original procedure, i.e., copy
-		 * first two bytes also
+		 * A caller asking for less than a transfer holds leaves the rest
+		 * for its next read, whose data follows the status bytes already
+		 * discarded.
 		 */
 
 		if (dev->bulk_in_copied) {
@@ -1527,7 +1456,7 @@ retry:
 			}
 
 			memcpy(buffer, dev->bulk_in_buffer + 2, chunk - 2);
-			rv = chunk;
+			rv = chunk - 2;
 			dev->bulk_in_copied += chunk;
 		}
 
@@ -1550,11 +1479,9 @@ retry:
 	}
 exit:
 	mutex_unlock(&dev->io_mutex);
-	if (rv == 2)
+	if (rv == 0)
 		goto restart;	/* ftdi chip returns two status bytes after a latency anyhow */
 
-	if (rv > 0)
-		return rv - 2;	/* account for 2 discarded bytes in a valid buffer */
 	return rv;
 }
 
@@ -1894,7 +1821,12 @@ static int skel_probe(struct usb_interface *interface,
 		goto error;
 	}
 
-	dev->bulk_in_size = usb_endpoint_maxp(bulk_in);
+	/*
+	 * Receive several packets per transfer; a packet carrying only the
+	 * ftdi status ends it early when the adapter has nothing more to send.
+	 */
+	dev->bulk_in_maxp = usb_endpoint_maxp(bulk_in);
+	dev->bulk_in_size = rounddown(INBUF_SIZE, dev->bulk_in_maxp);
 	dev->bulk_in_endpoint_addr = bulk_in->bEndpointAddress;
 	dev->bulk_in_buffer = kmalloc(dev->bulk_in_size, GFP_KERNEL);
 	if (!dev->bulk_in_buffer) {
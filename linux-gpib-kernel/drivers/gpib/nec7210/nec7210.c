@@ -418,6 +418,28 @@ static inline short nec7210_atn_has_changed(struct gpib_board *board, struct nec
 	return -1;
 }
 
+/*
+ * Keep the chip's interrupt line quiet while the pio loops spin on the
+ * interrupt handler.  Only the registers are written, reg_bits keeps the
+ * mask the handler checks status against.
+ */
+static void nec7210_pio_spin_mask_irq(struct gpib_board *board, struct gpib_pio_spin *spin,
+				      int mask)
+{
+	struct nec7210_priv *priv = container_of(spin, struct nec7210_priv, pio_spin);
+	unsigned long flags;
+
+	spin_lock_irqsave(&board->spinlock, flags);
+	if (mask) {
+		write_byte(priv, 0, IMR1);
+		write_byte(priv, priv->reg_bits[IMR2] & ~IMR2_ENABLE_INTR_MASK, IMR2);
+	} else {
+		write_byte(priv, priv->reg_bits[IMR1], IMR1);
+		write_byte(priv, priv->reg_bits[IMR2], IMR2);
+	}
+	spin_unlock_irqrestore(&board->spinlock, flags);
+}
+
 int nec7210_command(struct gpib_board *board, struct nec7210_priv *priv, u8
 		    *buffer, size_t length, size_t *bytes_written)
 {
@@ -427,12 +449,13 @@ int nec7210_command(struct gpib_board *board, struct nec7210_priv *priv, u8
 	*bytes_written = 0;
 
 	clear_bit(BUS_ERROR_BN, &priv->state);
+	gpib_pio_spin_start(board, &priv->pio_spin, nec7210_pio_spin_mask_irq);
 
 	while (*bytes_written < length)	{
-		if (wait_event_interruptible(board->wait,
-					     test_bit(COMMAND_READY_BN, &priv->state) ||
-					     test_bit(BUS_ERROR_BN, &priv->state) ||
-					     test_bit(TIMO_NUM, &board->status))) {
+		if (gpib_pio_wait_event(board, &priv->pio_spin,
+					test_bit(COMMAND_READY_BN, &priv->state) ||
+					test_bit(BUS_ERROR_BN, &priv->state) ||
+					test_bit(TIMO_NUM, &board->status))) {
 			dev_dbg(board->gpib_dev, "command wait interrupted\n");
 			retval = -ERESTARTSYS;
 			break;
@@ -452,9 +475,10 @@ int nec7210_command(struct gpib_board *board, struct nec7210_priv *priv, u8
 			schedule();
 	}
 	// wait for last byte to get sent
-	if (wait_event_interruptible(board->wait, test_bit(COMMAND_READY_BN, &priv->state) ||
-				     test_bit(BUS_ERROR_BN, &priv->state) ||
-				     test_bit(TIMO_NUM, &board->status)))
+	if (gpib_pio_wait_event(board, &priv->pio_spin,
+				test_bit(COMMAND_READY_BN, &priv->state) ||
+				test_bit(BUS_ERROR_BN, &priv->state) ||
+				test_bit(TIMO_NUM, &board->status)))
 		retval = -ERESTARTSYS;
 
 	if (test_bit(TIMO_NUM, &board->status))
@@ -476,10 +500,10 @@ static int pio_read(struct gpib_board *board, struct nec7210_priv *priv, u8 *buf
 	*end = 0;
 
 	while (*bytes_read < length) {
-		if (wait_event_interruptible(board->wait,
-					     test_bit(READ_READY_BN, &priv->state) ||
-					     test_bit(DEV_CLEAR_BN, &priv->state) ||
-					     test_bit(TIMO_NUM, &board->status))) {
+		if (gpib_pio_wait_event(board, &priv->pio_spin,
+					test_bit(READ_READY_BN, &priv->state) ||
+					test_bit(DEV_CLEAR_BN, &priv->state) ||
+					test_bit(TIMO_NUM, &board->status))) {
 			retval = -ERESTARTSYS;
 			break;
 		}
@@ -611,6 +635,7 @@ int nec7210_read(struct gpib_board *board, struct nec7210_priv *priv, u8 *buffer
 		return 0;
 
 	clear_bit(DEV_CLEAR_BN, &priv->state); // XXX wrong
+	gpib_pio_spin_start(board, &priv->pio_spin, nec7210_pio_spin_mask_irq);
 
 	nec7210_release_rfd_holdoff(board, priv);
 
@@ -624,14 +649,14 @@ static int pio_write_wait(struct gpib_board *board, struct nec7210_priv *priv,
 			  short wake_on_lacs, short wake_on_atn, short wake_on_bus_error)
 {
 	// wait until byte is ready to be sent
-	if (wait_event_interruptible(board->wait,
-				     (test_bit(TACS_NUM, &board->status) &&
-				      test_bit(WRITE_READY_BN, &priv->state)) ||
-				     test_bit(DEV_CLEAR_BN, &priv->state) ||
-				     (wake_on_bus_error && test_bit(BUS_ERROR_BN, &priv->state)) ||
-				     (wake_on_lacs && test_bit(LACS_NUM, &board->status)) ||
-				     (wake_on_atn && test_bit(ATN_NUM, &board->status)) ||
-				     test_bit(TIMO_NUM, &board->status)))
+	if (gpib_pio_wait_event(board, &priv->pio_spin,
+				(test_bit(TACS_NUM, &board->status) &&
+				 test_bit(WRITE_READY_BN, &priv->state)) ||
+				test_bit(DEV_CLEAR_BN, &priv->state) ||
+				(wake_on_bus_error && test_bit(BUS_ERROR_BN, &priv->state)) ||
+				(wake_on_lacs && test_bit(LACS_NUM, &board->status)) ||
+				(wake_on_atn && test_bit(ATN_NUM, &board->status)) ||
+				test_bit(TIMO_NUM, &board->status)))
 		return -ERESTARTSYS;
 
 	if (test_bit(TIMO_NUM, &board->status))
@@ -780,6 +805,7 @@ int nec7210_write(struct gpib_board *board, struct nec7210_priv *priv,
 	*bytes_written = 0;
 
 	clear_bit(DEV_CLEAR_BN, &priv->state); // XXX
+	gpib_pio_spin_start(board, &priv->pio_spin, nec7210_pio_spin_mask_irq);
 
 	if (send_eoi)
 		length-- ; // save the last byte for sending EOI
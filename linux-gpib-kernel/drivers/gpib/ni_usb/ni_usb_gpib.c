@@ -100,6 +100,19 @@ static void ni_usb_timeout_handler(COMPAT_TIMER_ARG_TYPE t)
 	complete(&context->complete);
 };
 
+// use the preallocated dma mapping if data is one of the board's transfer buffers
+static void ni_usb_set_transfer_dma(struct ni_usb_priv *ni_priv, struct urb *urb, void *data)
+{
+	urb->transfer_flags &= ~URB_NO_TRANSFER_DMA_MAP;
+	if (data == ni_priv->out_buffer) {
+		urb->transfer_dma = ni_priv->out_buffer_dma;
+		urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+	} else if (data == ni_priv->in_buffer) {
+		urb->transfer_dma = ni_priv->in_buffer_dma;
+		urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+	}
+}
+
 // I'm using nonblocking loosely here, it only means -EAGAIN can be returned in certain cases
 static int ni_usb_nonblocking_send_bulk_msg(struct ni_usb_priv *ni_priv, void *data,
 					    int data_length, int *actual_data_length,
@@ -120,17 +133,14 @@ static int ni_usb_nonblocking_send_bulk_msg(struct ni_usb_priv *ni_priv, void *d
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -EAGAIN;
 	}
-	ni_priv->bulk_urb = usb_alloc_urb(0, GFP_KERNEL);
-	if (!ni_priv->bulk_urb) {
-		mutex_unlock(&ni_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
+	ni_priv->bulk_urb = ni_priv->bulk_pool_urb;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
 	out_pipe = usb_sndbulkpipe(usb_dev, ni_priv->bulk_out_endpoint);
 	init_completion(&context->complete);
 	context->timed_out = 0;
 	usb_fill_bulk_urb(ni_priv->bulk_urb, usb_dev, out_pipe, data, data_length,
 			  &ni_usb_bulk_complete, context);
+	ni_usb_set_transfer_dma(ni_priv, ni_priv->bulk_urb, data);
 
 	if (timeout_msecs)
 		mod_timer(&ni_priv->bulk_timer, jiffies + msecs_to_jiffies(timeout_msecs));
@@ -138,7 +148,6 @@ static int ni_usb_nonblocking_send_bulk_msg(struct ni_usb_priv *ni_priv, void *d
 	retval = usb_submit_urb(ni_priv->bulk_urb, GFP_KERNEL);
 	if (retval) {
 		COMPAT_DEL_TIMER_SYNC(&ni_priv->bulk_timer);
-		usb_free_urb(ni_priv->bulk_urb);
 		ni_priv->bulk_urb = NULL;
 		dev_err(&usb_dev->dev, "failed to submit bulk out urb, retval=%i\n",
 			retval);
@@ -158,7 +167,6 @@ static int ni_usb_nonblocking_send_bulk_msg(struct ni_usb_priv *ni_priv, void *d
 	COMPAT_DEL_TIMER_SYNC(&ni_priv->bulk_timer);
 	*actual_data_length = ni_priv->bulk_urb->actual_length;
 	mutex_lock(&ni_priv->bulk_transfer_lock);
-	usb_free_urb(ni_priv->bulk_urb);
 	ni_priv->bulk_urb = NULL;
 	mutex_unlock(&ni_priv->bulk_transfer_lock);
 	return retval;
@@ -202,21 +210,19 @@ static int ni_usb_nonblocking_receive_bulk_msg(struct ni_usb_priv *ni_priv,
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -ENODEV;
 	}
-	if (ni_priv->bulk_urb) {
+	// a second bulk in urb could take the reply of a ni_usb_bulk_transaction()
+	if (ni_priv->bulk_urb || ni_priv->reply_pending) {
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -EAGAIN;
 	}
-	ni_priv->bulk_urb = usb_alloc_urb(0, GFP_KERNEL);
-	if (!ni_priv->bulk_urb) {
-		mutex_unlock(&ni_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
+	ni_priv->bulk_urb = ni_priv->bulk_pool_urb;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
 	in_pipe = usb_rcvbulkpipe(usb_dev, ni_priv->bulk_in_endpoint);
 	init_completion(&context->complete);
 	context->timed_out = 0;
 	usb_fill_bulk_urb(ni_priv->bulk_urb, usb_dev, in_pipe, data, data_length,
 			  &ni_usb_bulk_complete, context);
+	ni_usb_set_transfer_dma(ni_priv, ni_priv->bulk_urb, data);
 
 	if (timeout_msecs)
 		mod_timer(&ni_priv->bulk_timer, jiffies + msecs_to_jiffies(timeout_msecs));
@@ -224,7 +230,6 @@ static int ni_usb_nonblocking_receive_bulk_msg(struct ni_usb_priv *ni_priv,
 	retval = usb_submit_urb(ni_priv->bulk_urb, GFP_KERNEL);
 	if (retval) {
 		COMPAT_DEL_TIMER_SYNC(&ni_priv->bulk_timer);
-		usb_free_urb(ni_priv->bulk_urb);
 		ni_priv->bulk_urb = NULL;
 		dev_err(&usb_dev->dev, "failed to submit bulk in urb, retval=%i\n", retval);
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
@@ -262,7 +267,6 @@ static int ni_usb_nonblocking_receive_bulk_msg(struct ni_usb_priv *ni_priv,
 	COMPAT_DEL_TIMER_SYNC(&ni_priv->bulk_timer);
 	*actual_data_length = ni_priv->bulk_urb->actual_length;
 	mutex_lock(&ni_priv->bulk_transfer_lock);
-	usb_free_urb(ni_priv->bulk_urb);
 	ni_priv->bulk_urb = NULL;
 	mutex_unlock(&ni_priv->bulk_transfer_lock);
 	return retval;
@@ -292,6 +296,107 @@ static int ni_usb_receive_bulk_msg(struct ni_usb_priv *ni_priv, void *data,
 	return retval;
 }
 
+static void ni_usb_reply_timeout_handler(COMPAT_TIMER_ARG_TYPE t)
+{
+	struct ni_usb_priv *ni_priv = COMPAT_FROM_TIMER(ni_priv, t, reply_timer);
+	struct ni_usb_urb_ctx *context = &ni_priv->reply_context;
+
+	context->timed_out = 1;
+	complete(&context->complete);
+};
+
+/*
+ * Sends a request and receives the adapter's reply to it.  The bulk in urb for
+ * the reply is submitted before the request goes out, so the host controller
+ * already has it queued when the adapter answers, instead of after the out
+ * urb's completion has made its way back to us.  Only one reply is ever
+ * outstanding, so the adapter's replies still can't be matched to the wrong
+ * request.
+ */
+static int ni_usb_bulk_transaction(struct ni_usb_priv *ni_priv,
+				   void *out_data, int out_data_length, int *bytes_written,
+				   int out_timeout_msecs,
+				   void *in_data, int in_data_length, int *bytes_read,
+				   int in_timeout_msecs, int interruptible)
+{
+	struct usb_device *usb_dev;
+	struct ni_usb_urb_ctx *context = &ni_priv->reply_context;
+	int timeout_msecs_remaining = out_timeout_msecs;
+	int retval;
+
+	*bytes_written = 0;
+	*bytes_read = 0;
+	mutex_lock(&ni_priv->bulk_transfer_lock);
+	// wait out any bulk in transfer which isn't part of a transaction
+	while (ni_priv->bus_interface && (ni_priv->bulk_urb || ni_priv->reply_pending)) {
+		mutex_unlock(&ni_priv->bulk_transfer_lock);
+		if (out_timeout_msecs && timeout_msecs_remaining-- <= 0)
+			return -ETIMEDOUT;
+		usleep_range(1000, 1500);
+		mutex_lock(&ni_priv->bulk_transfer_lock);
+	}
+	if (!ni_priv->bus_interface) {
+		mutex_unlock(&ni_priv->bulk_transfer_lock);
+		return -ENODEV;
+	}
+	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
+	init_completion(&context->complete);
+	context->timed_out = 0;
+	usb_fill_bulk_urb(ni_priv->reply_urb, usb_dev,
+			  usb_rcvbulkpipe(usb_dev, ni_priv->bulk_in_endpoint),
+			  in_data, in_data_length, &ni_usb_bulk_complete, context);
+	ni_usb_set_transfer_dma(ni_priv, ni_priv->reply_urb, in_data);
+	retval = usb_submit_urb(ni_priv->reply_urb, GFP_KERNEL);
+	if (retval) {
+		mutex_unlock(&ni_priv->bulk_transfer_lock);
+		dev_err(&usb_dev->dev, "failed to submit bulk in urb, retval=%i\n", retval);
+		return retval;
+	}
+	ni_priv->reply_pending = 1;
+	mutex_unlock(&ni_priv->bulk_transfer_lock);
+
+	retval = ni_usb_send_bulk_msg(ni_priv, out_data, out_data_length, bytes_written,
+				      out_timeout_msecs);
+	if (retval || *bytes_written != out_data_length) {
+		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, length=%i\n",
+			retval, *bytes_written, out_data_length);
+		if (retval == 0)
+			retval = -EIO;
+		usb_kill_urb(ni_priv->reply_urb);
+		goto out;
+	}
+
+	if (in_timeout_msecs)
+		mod_timer(&ni_priv->reply_timer, jiffies + msecs_to_jiffies(in_timeout_msecs));
+	if (interruptible) {
+		if (wait_for_completion_interruptible(&context->complete)) {
+			/*
+			 * Have the adapter finish up and send its reply now,
+			 * as ni_usb_nonblocking_receive_bulk_msg() does.
+			 */
+			ni_usb_stop(ni_priv);
+			retval = -ERESTARTSYS;
+			wait_for_completion(&context->complete);
+		}
+	} else {
+		wait_for_completion(&context->complete);
+	}
+	if (context->timed_out) {
+		usb_kill_urb(ni_priv->reply_urb);
+		dev_err(&usb_dev->dev, "killed urb due to timeout\n");
+		retval = -ETIMEDOUT;
+	} else if (ni_priv->reply_urb->status) {
+		retval = ni_priv->reply_urb->status;
+	}
+	COMPAT_DEL_TIMER_SYNC(&ni_priv->reply_timer);
+	*bytes_read = ni_priv->reply_urb->actual_length;
+out:
+	mutex_lock(&ni_priv->bulk_transfer_lock);
+	ni_priv->reply_pending = 0;
+	mutex_unlock(&ni_priv->bulk_transfer_lock);
+	return retval;
+}
+
 static int ni_usb_receive_control_msg(struct ni_usb_priv *ni_priv, __u8 request,
 				      __u8 requesttype, __u16 value, __u16 index,
 				      void *data, __u16 size, int timeout_msecs)
@@ -532,9 +637,12 @@ static int ni_usb_write_registers(struct ni_usb_priv *ni_priv,
 	int reg_writes_completed;
 
 	out_data_length = num_writes * bytes_per_write + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+	if (out_data_length > NIUSB_OUT_BUFFER_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	i += ni_usb_bulk_register_write_header(&out_data[i], num_writes);
 	for (j = 0; j < num_writes; j++)
 		i += ni_usb_bulk_register_write(&out_data[i], writes[j]);
@@ -542,37 +650,20 @@ static int ni_usb_write_registers(struct ni_usb_priv *ni_priv,
 		out_data[i++] = 0x00;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
-	if (retval) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
-			retval, bytes_written, i);
-		return retval;
-	}
-
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &bytes_written, 1000,
+					 in_data, in_data_length, &bytes_read, 1000, 0);
 	if (retval || bytes_read != 16) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, bytes_read=%i\n",
 			retval, bytes_read);
 		ni_usb_dump_raw_block(in_data, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		return retval;
 	}
 
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
-
 	ni_usb_parse_reg_write_status_block(in_data, &status, &reg_writes_completed);
 	// FIXME parse extra 09 status bits and termination
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	if (status.id != NIUSB_REG_WRITE_ID) {
 		dev_err(&usb_dev->dev, "parse error, id=0x%x != NIUSB_REG_WRITE_ID\n", status.id);
 		return -EIO;
@@ -599,25 +690,24 @@ static int ni_usb_read(struct gpib_board *board, u8 *buffer, size_t length,
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	static const int out_data_length = 0x20;
 	int in_data_length;
 	int usb_bytes_written = 0, usb_bytes_read = 0;
 	int i = 0;
 	int complement_count;
 	int actual_length;
 	struct ni_usb_status_block status;
-	static const int max_read_length = 0xffff;
 	struct ni_usb_register reg;
 
 	*bytes_read = 0;
 	if (!ni_priv->bus_interface)
 		return -ENODEV;
-	if (length > max_read_length)
+	if (length > NIUSB_MAX_READ_LENGTH)
 		return -EINVAL;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = 0x0a;
 	out_data[i++] = ni_priv->eos_mode >> 8;
 	out_data[i++] = ni_priv->eos_char;
@@ -639,44 +729,27 @@ static int ni_usb_read(struct gpib_board *board, u8 *buffer, size_t length,
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &usb_bytes_written, 1000);
-	kfree(out_data);
-	if (retval || usb_bytes_written != i) {
-		if (retval == 0)
-			retval = -EIO;
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, usb_bytes_written=%i, i=%i\n",
-			retval, usb_bytes_written, i);
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return retval;
-	}
-
-	in_data_length = (length / 30 + 1) * 0x20 + 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &usb_bytes_read,
+	in_data_length = ni_usb_read_in_length(length);
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &usb_bytes_written, 1000,
+					 in_data, in_data_length, &usb_bytes_read,
 					 ni_usb_timeout_msecs(board->usec_timeout), 1);
 
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
-
 	if (retval == -ERESTARTSYS) {
 	} else if (retval) {
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, usb_bytes_read=%i\n",
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, usb_bytes_read=%i\n",
 			retval, usb_bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		return retval;
 	}
+	// the data is parsed straight out of the transfer buffer into the caller's buffer
 	parse_retval = parse_board_ibrd_readback(in_data, &status, buffer, length, &actual_length);
 	if (parse_retval != usb_bytes_read) {
 		if (parse_retval >= 0)
 			parse_retval = -EIO;
 		dev_err(&usb_dev->dev, "retval=%i usb_bytes_read=%i\n",
 			parse_retval, usb_bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		return parse_retval;
 	}
 	if (actual_length != length - status.count) {
@@ -684,7 +757,7 @@ static int ni_usb_read(struct gpib_board *board, u8 *buffer, size_t length,
 			actual_length, (long)(length - status.count));
 		ni_usb_dump_raw_block(in_data, usb_bytes_read);
 	}
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	switch (status.error_code) {
 	case NIUSB_NO_ERROR:
 		retval = 0;
@@ -734,23 +807,21 @@ static int ni_usb_write(struct gpib_board *board, u8 *buffer, size_t length,
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	int out_data_length;
 	static const int in_data_length = 0x10;
 	int usb_bytes_written = 0, usb_bytes_read = 0;
-	int i = 0, j;
+	int i = 0;
 	int complement_count;
 	struct ni_usb_status_block status;
-	static const int max_write_length = 0xffff;
 
 	if (!ni_priv->bus_interface)
 		return -ENODEV;
-	if (length > max_write_length)
+	if (length > NIUSB_MAX_WRITE_LENGTH)
 		return -EINVAL;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data_length = length + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = 0x0d;
 	complement_count = length - 1;
 	complement_count = ~complement_count;
@@ -764,42 +835,26 @@ static int ni_usb_write(struct gpib_board *board, u8 *buffer, size_t length,
 	else
 		out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
-	for (j = 0; j < length; j++)
-		out_data[i++] = buffer[j];
+	memcpy(&out_data[i], buffer, length);
+	i += length;
 	while (i % 4)	// pad with zeros to 4-byte boundary
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &usb_bytes_written,
-				      ni_usb_timeout_msecs(board->usec_timeout));
-	kfree(out_data);
-	if (retval || usb_bytes_written != i)	{
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, usb_bytes_written=%i, i=%i\n",
-			retval, usb_bytes_written, i);
-		return retval;
-	}
-
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &usb_bytes_read,
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &usb_bytes_written,
+					 ni_usb_timeout_msecs(board->usec_timeout),
+					 in_data, in_data_length, &usb_bytes_read,
 					 ni_usb_timeout_msecs(board->usec_timeout), 1);
 
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
-
 	if ((retval && retval != -ERESTARTSYS) || usb_bytes_read != 12) {
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, usb_bytes_read=%i\n",
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, usb_bytes_read=%i\n",
 			retval, usb_bytes_read);
-		kfree(in_data);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	switch	(status.error_code) {
 	case NIUSB_NO_ERROR:
 		retval = 0;
@@ -838,10 +893,9 @@ static int ni_usb_command_chunk(struct gpib_board *board, u8 *buffer, size_t len
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	int out_data_length;
 	static const int in_data_length = 0x10;
 	int bytes_written = 0, bytes_read = 0;
-	int i = 0, j;
+	int i = 0;
 	unsigned int complement_count;
 	struct ni_usb_status_block status;
 	// usb-b gives error 4 if you try to send more than 16 command bytes at once
@@ -853,53 +907,36 @@ static int ni_usb_command_chunk(struct gpib_board *board, u8 *buffer, size_t len
 	if (length > max_command_length)
 		length = max_command_length;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data_length = length + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = 0x0c;
 	complement_count = length - 1;
 	complement_count = ~complement_count;
 	out_data[i++] = complement_count;
 	out_data[i++] = 0x0;
 	out_data[i++] = ni_usb_timeout_code(board->usec_timeout);
-	for (j = 0; j < length; j++)
-		out_data[i++] = buffer[j];
+	memcpy(&out_data[i], buffer, length);
+	i += length;
 	while (i % 4)	// pad with zeros to 4-byte boundary
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written,
-				      ni_usb_timeout_msecs(board->usec_timeout));
-	kfree(out_data);
-	if (retval || bytes_written != i) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
-			retval, bytes_written, i);
-		return retval;
-	}
-
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read,
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &bytes_written,
+					 ni_usb_timeout_msecs(board->usec_timeout),
+					 in_data, in_data_length, &bytes_read,
 					 ni_usb_timeout_msecs(board->usec_timeout), 1);
 
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
-
 	if ((retval && retval != -ERESTARTSYS) || bytes_read != 12) {
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, bytes_read=%i\n",
 			retval, bytes_read);
-		kfree(in_data);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	*command_bytes_written = length - status.count;
 	switch (status.error_code) {
 	case NIUSB_NO_ERROR:
@@ -948,7 +985,6 @@ static int ni_usb_take_control(struct gpib_board *board, int synchronous)
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	static const int out_data_length = 0x10;
 	static const int  in_data_length = 0x10;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
@@ -957,9 +993,10 @@ static int ni_usb_take_control(struct gpib_board *board, int synchronous)
 	if (!ni_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
+
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBCAC_ID;
 	if (synchronous)
 		out_data[i++] = 0x1;
@@ -969,36 +1006,20 @@ static int ni_usb_take_control(struct gpib_board *board, int synchronous)
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
-	if (retval || bytes_written != i) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
-			retval, bytes_written, i);
-		return retval;
-	}
-
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 1);
-
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &bytes_written, 1000,
+					 in_data, in_data_length, &bytes_read, 1000, 1);
 
 	if ((retval && retval != -ERESTARTSYS) || bytes_read != 12) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		if (retval == 0)
 			retval = -EIO;
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, bytes_read=%i\n",
 			retval, bytes_read);
-		kfree(in_data);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	ni_usb_soft_update_status(board, status.ibsta, 0);
 	return retval;
 }
@@ -1009,7 +1030,6 @@ static int ni_usb_go_to_standby(struct gpib_board *board)
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	static const int out_data_length = 0x10;
 	static const int  in_data_length = 0x20;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
@@ -1018,44 +1038,28 @@ static int ni_usb_go_to_standby(struct gpib_board *board)
 	if (!ni_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
 
+	mutex_lock(&ni_priv->addressed_transfer_lock);
+
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBGTS_ID;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 
-	mutex_lock(&ni_priv->addressed_transfer_lock);
-
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
-	if (retval || bytes_written != i) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
-			retval, bytes_written, i);
-		return retval;
-	}
-
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
-
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_bulk_transaction(ni_priv, out_data, i, &bytes_written, 1000,
+					 in_data, in_data_length, &bytes_read, 1000, 0);
 
 	if (retval || bytes_read != 12) {
-		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
+		dev_err(&usb_dev->dev, "bulk transaction returned %i, bytes_read=%i\n",
 			retval, bytes_read);
-		kfree(in_data);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	if (status.id != NIUSB_IBGTS_ID)
 		dev_err(&usb_dev->dev, "bug: status.id 0x%x != INUSB_IBGTS_ID\n", status.id);
 	ni_usb_soft_update_status(board, status.ibsta, 0);
@@ -1134,6 +1138,8 @@ static void ni_usb_interface_clear(struct gpib_board *board, int assert)
 	out_data = kmalloc(out_data_length, GFP_KERNEL);
 	if (!out_data)
 		return;
+	// keeps a transfer in progress from taking the reply
+	mutex_lock(&ni_priv->addressed_transfer_lock);
 	out_data[i++] = NIUSB_IBSIC_ID;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
@@ -1142,15 +1148,19 @@ static void ni_usb_interface_clear(struct gpib_board *board, int assert)
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
 	kfree(out_data);
 	if (retval || bytes_written != i) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
 			retval, bytes_written, i);
 		return;
 	}
 	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data)
+	if (!in_data) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		return;
+	}
 
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	if (retval || bytes_read != 12) {
 		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
 			retval, bytes_read);
@@ -1367,6 +1377,8 @@ static int ni_usb_parallel_poll(struct gpib_board *board, u8 *result)
 	out_data = kmalloc(out_data_length, GFP_KERNEL);
 	if (!out_data)
 		return -ENOMEM;
+	// keeps a transfer in progress from taking the reply
+	mutex_lock(&ni_priv->addressed_transfer_lock);
 
 	out_data[i++] = NIUSB_IBRPP_ID;
 	out_data[i++] = 0xf0;	// FIXME: this should be the parallel poll timeout code
@@ -1378,17 +1390,21 @@ static int ni_usb_parallel_poll(struct gpib_board *board, u8 *result)
 
 	kfree(out_data);
 	if (retval || bytes_written != i) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		dev_err(&usb_dev->dev, "send_bulk_msg returned %i, bytes_written=%i, i=%i\n",
 			retval, bytes_written, i);
 		return retval;
 	}
 	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data)
+	if (!in_data) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		return -ENOMEM;
+	}
 
 	/*FIXME: should use parallel poll timeout (not supported yet)*/
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length,
 					 &bytes_read, 1000, 1);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 
 	if (retval && retval != -ERESTARTSYS)	{
 		dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
@@ -1517,7 +1533,6 @@ static int ni_usb_line_status(const struct gpib_board *board)
 	struct ni_usb_priv *ni_priv = board->private_data;
 	struct usb_device *usb_dev;
 	u8 *out_data, *in_data;
-	static const int out_data_length = 0x20;
 	static const int  in_data_length = 0x20;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
@@ -1528,24 +1543,19 @@ static int ni_usb_line_status(const struct gpib_board *board)
 	if (!ni_priv->bus_interface)
 		return -ENODEV;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if (!out_data)
-		return -ENOMEM;
 
 	/* line status gets called during ibwait */
 	retval = mutex_trylock(&ni_priv->addressed_transfer_lock);
 
-	if (retval == 0) {
-		kfree(out_data);
+	if (retval == 0)
 		return -EBUSY;
-	}
+	out_data = ni_priv->out_buffer;
 	i += ni_usb_bulk_register_read_header(&out_data[i], 1);
 	i += ni_usb_bulk_register_read(&out_data[i], NIUSB_SUBDEV_TNT4882, BSR);
 	while (i % 4)
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_nonblocking_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if (retval || bytes_written != i) {
 		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		if (retval != -EAGAIN)
@@ -1554,26 +1564,20 @@ static int ni_usb_line_status(const struct gpib_board *board)
 		return retval;
 	}
 
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if (!in_data) {
-		mutex_unlock(&ni_priv->addressed_transfer_lock);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_nonblocking_receive_bulk_msg(ni_priv, in_data, in_data_length,
 						     &bytes_read, 1000, 0);
 
-	mutex_unlock(&ni_priv->addressed_transfer_lock);
-
 	if (retval) {
+		mutex_unlock(&ni_priv->addressed_transfer_lock);
 		if (retval != -EAGAIN)
 			dev_err(&usb_dev->dev, "receive_bulk_msg returned %i, bytes_read=%i\n",
 				retval, bytes_read);
-		kfree(in_data);
 		return retval;
 	}
 
 	ni_usb_parse_register_read_block(in_data, &bsr_bits, 1);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->addressed_transfer_lock);
 	if (bsr_bits & BCSR_REN_BIT)
 		line_status |= BUS_REN;
 	if (bsr_bits & BCSR_IFC_BIT)
@@ -1667,12 +1671,43 @@ static int ni_usb_allocate_private(struct gpib_board *board)
 	mutex_init(&ni_priv->control_transfer_lock);
 	mutex_init(&ni_priv->interrupt_transfer_lock);
 	mutex_init(&ni_priv->addressed_transfer_lock);
+	ni_priv->bulk_pool_urb = usb_alloc_urb(0, GFP_KERNEL);
+	ni_priv->reply_urb = usb_alloc_urb(0, GFP_KERNEL);
+	if (!ni_priv->bulk_pool_urb || !ni_priv->reply_urb)
+		return -ENOMEM;
+	return 0;
+}
+
+static int ni_usb_alloc_transfer_buffers(struct ni_usb_priv *ni_priv, struct usb_device *usb_dev)
+{
+	ni_priv->buffer_dev = usb_get_dev(usb_dev);
+	ni_priv->out_buffer = usb_alloc_coherent(usb_dev, NIUSB_OUT_BUFFER_SIZE, GFP_KERNEL,
+						 &ni_priv->out_buffer_dma);
+	ni_priv->in_buffer = usb_alloc_coherent(usb_dev, NIUSB_IN_BUFFER_SIZE, GFP_KERNEL,
+						&ni_priv->in_buffer_dma);
+	if (!ni_priv->out_buffer || !ni_priv->in_buffer)
+		return -ENOMEM;
 	return 0;
 }
 
+static void ni_usb_free_transfer_buffers(struct ni_usb_priv *ni_priv)
+{
+	if (!ni_priv->buffer_dev)
+		return;
+	usb_free_coherent(ni_priv->buffer_dev, NIUSB_OUT_BUFFER_SIZE, ni_priv->out_buffer,
+			  ni_priv->out_buffer_dma);
+	usb_free_coherent(ni_priv->buffer_dev, NIUSB_IN_BUFFER_SIZE, ni_priv->in_buffer,
+			  ni_priv->in_buffer_dma);
+	usb_put_dev(ni_priv->buffer_dev);
+	ni_priv->buffer_dev = NULL;
+}
+
 static void ni_usb_free_private(struct ni_usb_priv *ni_priv)
 {
 	usb_free_urb(ni_priv->interrupt_urb);
+	usb_free_urb(ni_priv->bulk_pool_urb);
+	usb_free_urb(ni_priv->reply_urb);
+	ni_usb_free_transfer_buffers(ni_priv);
 	kfree(ni_priv);
 }
 
@@ -1920,6 +1955,8 @@ static void ni_usb_cleanup_urbs(struct ni_usb_priv *ni_priv)
 			usb_kill_urb(ni_priv->interrupt_urb);
 		if (ni_priv->bulk_urb)
 			usb_kill_urb(ni_priv->bulk_urb);
+		if (ni_priv->reply_urb)
+			usb_kill_urb(ni_priv->reply_urb);
 	}
 }
 
@@ -2256,10 +2293,17 @@ static int ni_usb_attach(struct gpib_board *board, const struct gpib_board_confi
 	if (usb_reset_configuration(interface_to_usbdev(ni_priv->bus_interface)))
 		dev_err(&usb_dev->dev, "usb_reset_configuration() failed.\n");
 
+	retval = ni_usb_alloc_transfer_buffers(ni_priv, usb_dev);
+	if (retval < 0) {
+		mutex_unlock(&ni_usb_hotplug_lock);
+		return retval;
+	}
+
 	product_id = USBID_TO_CPU(usb_dev->descriptor.idProduct);
 	ni_priv->product_id = product_id;
 
 	COMPAT_TIMER_SETUP(&ni_priv->bulk_timer, ni_usb_timeout_handler, 0);
+	COMPAT_TIMER_SETUP(&ni_priv->reply_timer, ni_usb_reply_timeout_handler, 0);
 
 	switch (product_id) {
 	case USB_DEVICE_ID_NI_USB_B:
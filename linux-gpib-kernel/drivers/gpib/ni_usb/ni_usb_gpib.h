@@ -55,6 +55,20 @@ enum hs_plus_endpoint_addresses {
 	NIUSB_HS_PLUS_INTERRUPT_IN_ENDPOINT = 0x3,
 };
 
+enum ni_usb_transfer_limits {
+	NIUSB_MAX_READ_LENGTH = 0xffff,
+	NIUSB_MAX_WRITE_LENGTH = 0xffff,
+	// bulk in reply to a read of NIUSB_MAX_READ_LENGTH bytes, see ni_usb_read_in_length()
+	NIUSB_IN_BUFFER_SIZE = (NIUSB_MAX_READ_LENGTH / 30 + 1) * 0x20 + 0x20,
+	// a write of NIUSB_MAX_WRITE_LENGTH bytes with its header and termination
+	NIUSB_OUT_BUFFER_SIZE = NIUSB_MAX_WRITE_LENGTH + 0x10,
+};
+
+static inline int ni_usb_read_in_length(size_t length)
+{
+	return (length / 30 + 1) * 0x20 + 0x20;
+}
+
 struct ni_usb_urb_ctx {
 	struct completion complete;
 	unsigned timed_out : 1;
@@ -69,8 +83,23 @@ struct ni_usb_priv {
 	u8 eos_char;
 	unsigned short eos_mode;
 	unsigned int monitored_ibsta_bits;
-	struct urb *bulk_urb;
+	struct urb *bulk_urb;	// bulk_pool_urb while a bulk transfer is in flight, else NULL
+	struct urb *bulk_pool_urb;
+	struct urb *reply_urb;	// bulk in urb submitted ahead of the request it answers
+	unsigned reply_pending : 1;
+	struct timer_list reply_timer;
+	struct ni_usb_urb_ctx reply_context;
 	struct urb *interrupt_urb;
+	/*
+	 * Transfer buffers for the frequent requests, allocated at attach and used
+	 * with addressed_transfer_lock held.  buffer_dev keeps the usb_device
+	 * around until they are freed, which may be after a disconnect.
+	 */
+	struct usb_device *buffer_dev;
+	u8 *out_buffer;
+	u8 *in_buffer;
+	dma_addr_t out_buffer_dma;
+	dma_addr_t in_buffer_dma;
 	u8 interrupt_buffer[0x11];
 	struct mutex addressed_transfer_lock;	// protect transfer lock
 	struct mutex bulk_transfer_lock;	// protect bulk message sends
@@ -327,6 +327,7 @@ static int pc2_attach(struct gpib_board *board, const struct gpib_board_config *
 		}
 	}
 	pc2_priv->irq = config->ibirq;
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, pc2_interrupt, config->ibirq, board);
 	/* poll so we can detect assertion of ATN */
 	if (gpib_request_pseudo_irq(board, pc2_interrupt)) {
 		dev_err(board->gpib_dev, "failed to allocate pseudo_irq\n");
@@ -441,6 +442,7 @@ static int pc2a_common_attach(struct gpib_board *board, const struct gpib_board_
 		}
 	}
 	pc2_priv->irq = config->ibirq;
+	gpib_pio_spin_set_handler(&nec_priv->pio_spin, pc2a_interrupt, config->ibirq, board);
 	/* poll so we can detect assertion of ATN */
 	if (gpib_request_pseudo_irq(board, pc2_interrupt)) {
 		dev_err(board->gpib_dev, "failed to allocate pseudo_irq\n");
@@ -439,12 +439,29 @@ static int check_for_eos(struct tms9914_priv *priv, u8 byte)
 	return 0;
 }
 
+/*
+ * Keep the chip's interrupt line quiet while the pio loops spin on the
+ * interrupt handler.  Only the registers are written, imr0_bits and
+ * imr1_bits keep the mask the handler checks status against.
+ */
+static void tms9914_pio_spin_mask_irq(struct gpib_board *board, struct gpib_pio_spin *spin,
+				      int mask)
+{
+	struct tms9914_priv *priv = container_of(spin, struct tms9914_priv, pio_spin);
+	unsigned long flags;
+
+	spin_lock_irqsave(&board->spinlock, flags);
+	write_byte(priv, mask ? 0 : priv->imr0_bits, IMR0);
+	write_byte(priv, mask ? 0 : priv->imr1_bits, IMR1);
+	spin_unlock_irqrestore(&board->spinlock, flags);
+}
+
 static int wait_for_read_byte(struct gpib_board *board, struct tms9914_priv *priv)
 {
-	if (wait_event_interruptible(board->wait,
-				     test_bit(READ_READY_BN, &priv->state) ||
-				     test_bit(DEV_CLEAR_BN, &priv->state) ||
-				     test_bit(TIMO_NUM, &board->status)))
+	if (gpib_pio_wait_event(board, &priv->pio_spin,
+				test_bit(READ_READY_BN, &priv->state) ||
+				test_bit(DEV_CLEAR_BN, &priv->state) ||
+				test_bit(TIMO_NUM, &board->status)))
 		return -ERESTARTSYS;
 
 	if (test_bit(TIMO_NUM, &board->status))
@@ -520,6 +537,7 @@ int tms9914_read(struct gpib_board *board, struct tms9914_priv *priv, u8 *buffer
 		return 0;
 
 	clear_bit(DEV_CLEAR_BN, &priv->state);
+	gpib_pio_spin_start(board, &priv->pio_spin, tms9914_pio_spin_mask_irq);
 
 	// transfer data (except for last byte)
 	if (length > 1)	{
@@ -551,11 +569,11 @@ EXPORT_SYMBOL(tms9914_read);
 static int pio_write_wait(struct gpib_board *board, struct tms9914_priv *priv)
 {
 	// wait until next byte is ready to be sent
-	if (wait_event_interruptible(board->wait,
-				     test_bit(WRITE_READY_BN, &priv->state) ||
-				     test_bit(BUS_ERROR_BN, &priv->state) ||
-				     test_bit(DEV_CLEAR_BN, &priv->state) ||
-				     test_bit(TIMO_NUM, &board->status)))
+	if (gpib_pio_wait_event(board, &priv->pio_spin,
+				test_bit(WRITE_READY_BN, &priv->state) ||
+				test_bit(BUS_ERROR_BN, &priv->state) ||
+				test_bit(DEV_CLEAR_BN, &priv->state) ||
+				test_bit(TIMO_NUM, &board->status)))
 		return -ERESTARTSYS;
 
 	if (test_bit(TIMO_NUM, &board->status))
@@ -603,6 +621,7 @@ int tms9914_write(struct gpib_board *board, struct tms9914_priv *priv,
 
 	clear_bit(BUS_ERROR_BN, &priv->state);
 	clear_bit(DEV_CLEAR_BN, &priv->state);
+	gpib_pio_spin_start(board, &priv->pio_spin, tms9914_pio_spin_mask_irq);
 
 	if (send_eoi)
 		length-- ; /* save the last byte for sending EOI */
@@ -670,11 +689,11 @@ int tms9914_command(struct gpib_board *board, struct tms9914_priv *priv,  u8 *bu
 	unsigned long flags;
 
 	*bytes_written = 0;
+	gpib_pio_spin_start(board, &priv->pio_spin, tms9914_pio_spin_mask_irq);
 	while (*bytes_written < length) {
-		if (wait_event_interruptible(board->wait,
-					     test_bit(COMMAND_READY_BN,
-						      &priv->state) ||
-					     test_bit(TIMO_NUM, &board->status)))
+		if (gpib_pio_wait_event(board, &priv->pio_spin,
+					test_bit(COMMAND_READY_BN, &priv->state) ||
+					test_bit(TIMO_NUM, &board->status)))
 			break;
 		if (test_bit(TIMO_NUM, &board->status))
 			break;
@@ -689,9 +708,9 @@ int tms9914_command(struct gpib_board *board, struct tms9914_priv *priv,  u8 *bu
 		++(*bytes_written);
 	}
 	// wait until last command byte is written
-	if (wait_event_interruptible(board->wait,
-				     test_bit(COMMAND_READY_BN,
-					      &priv->state) || test_bit(TIMO_NUM, &board->status)))
+	if (gpib_pio_wait_event(board, &priv->pio_spin,
+				test_bit(COMMAND_READY_BN, &priv->state) ||
+				test_bit(TIMO_NUM, &board->status)))
 		retval = -ERESTARTSYS;
 	if (test_bit(TIMO_NUM, &board->status))
 		retval = -ETIMEDOUT;
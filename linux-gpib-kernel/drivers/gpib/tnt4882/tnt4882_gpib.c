@@ -58,6 +58,8 @@ static const int atgpib_reg_offset = 2;
 
 // number of ioports used
 static const int atgpib_iosize = 32;
+// bytes held by fifos A and B together
+static const int tnt4882_fifo_size = 16;
 
 /* paged io */
 static inline unsigned int tnt_paged_readb(struct tnt4882_priv *priv, unsigned long offset)
@@ -236,17 +238,67 @@ static int fifo_xfer_done(struct tnt4882_priv *tnt_priv)
 	return retval;
 }
 
+/*
+ * Status register 2 only tells whether each half of the fifo is empty or
+ * full, so a burst of more than one word is only read from (or written to)
+ * a full (or empty) fifo.
+ */
 static int drain_fifo_words(struct tnt4882_priv *tnt_priv, u8 *buffer, int num_bytes)
 {
 	int count = 0;
 	struct nec7210_priv *nec_priv = &tnt_priv->nec7210_priv;
 
-	while (fifo_word_available(tnt_priv) && count + 2 <= num_bytes)	{
-		short word;
+	while (count + 2 <= num_bytes)	{
+		int status2 = tnt_readb(tnt_priv, STS2);
+		int num_words = 1;
+
+		if ((status2 & (AEFN | BEFN)) != (AEFN | BEFN))
+			break;
+		if ((status2 & (AFFN | BFFN)) == 0)
+			num_words = min(tnt4882_fifo_size, num_bytes - count) / 2;
+		if (IS_ALIGNED((unsigned long)&buffer[count], 2)) {
+			ioread16_rep(nec_priv->mmiobase + FIFOB, &buffer[count], num_words);
+			count += 2 * num_words;
+		} else {
+			while (num_words--) {
+				u16 word;
+
+				word = ioread16(nec_priv->mmiobase + FIFOB);
+				buffer[count++] = word & 0xff;
+				buffer[count++] = (word >> 8) & 0xff;
+			}
+		}
+	}
+	return count;
+}
+
+static size_t fill_fifo_words(struct tnt4882_priv *tnt_priv, const u8 *buffer, size_t length)
+{
+	size_t count = 0;
+	struct nec7210_priv *nec_priv = &tnt_priv->nec7210_priv;
+
+	while (count < length) {
+		int status2 = tnt_readb(tnt_priv, STS2);
+		size_t num_words = 1;
+
+		if ((status2 & (AFFN | BFFN)) != (AFFN | BFFN))
+			break;
+		if ((status2 & (AEFN | BEFN)) == 0 && length - count >= 4)
+			num_words = min_t(size_t, tnt4882_fifo_size, length - count) / 2;
+		if (num_words > 1 && IS_ALIGNED((unsigned long)&buffer[count], 2)) {
+			iowrite16_rep(nec_priv->mmiobase + FIFOB, &buffer[count], num_words);
+			count += 2 * num_words;
+			continue;
+		}
+		// the transfer counter drops the pad byte of an odd length
+		while (num_words-- && count < length) {
+			u16 word;
 
-		word = ioread16(nec_priv->mmiobase + FIFOB);
-		buffer[count++] = word & 0xff;
-		buffer[count++] = (word >> 8) & 0xff;
+			word = buffer[count++] & 0xff;
+			if (count < length)
+				word |= (buffer[count++] << 8) & 0xff00;
+			iowrite16(word, nec_priv->mmiobase + FIFOB);
+		}
 	}
 	return count;
 }
@@ -508,14 +560,7 @@ static int generic_write(struct gpib_board *board, u8 *buffer, size_t length,
 		if (fifo_xfer_done(tnt_priv))
 			break;
 		spin_lock_irqsave(&board->spinlock, flags);
-		while (fifo_space_available(tnt_priv) && count < length) {
-			u16 word;
-
-			word = buffer[count++] & 0xff;
-			if (count < length)
-				word |= (buffer[count++] << 8) & 0xff00;
-			iowrite16(word, nec_priv->mmiobase + FIFOB);
-		}
+		count += fill_fifo_words(tnt_priv, &buffer[count], length - count);
 //  avoid unnecessary HR_NFF interrupts
 //		tnt_priv->imr3_bits |= HR_NFF;
 //		tnt_writeb(tnt_priv, tnt_priv->imr3_bits, IMR3);
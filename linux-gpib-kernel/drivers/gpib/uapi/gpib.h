@@ -97,7 +97,8 @@ enum gpib_events {
 	EVENT_NONE = 0,
 	EVENT_DEV_TRG = 1,
 	EVENT_DEV_CLR = 2,
-	EVENT_IFC = 3
+	EVENT_IFC = 3,
+	EVENT_RESPONSE_SENT = 4
 };
 
 #endif	/* _GPIB_H */
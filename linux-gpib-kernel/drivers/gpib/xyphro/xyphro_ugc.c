@@ -72,11 +72,32 @@ static int xugc_line_status(const struct gpib_board *board);
 
 static unsigned int io_buffer_size = USBTMC_BUFSIZE;
 
+/*
+ * Bulk urbs are allocated once per board.  A read may spread one
+ * DEV_DEP_MSG_IN reply over read_urbs transfers queued together, and a
+ * write keeps up to write_urbs DEV_DEP_MSG_OUT transfers in flight.
+ */
+#define XUGC_MAX_URBS 8
+
+static unsigned int read_urbs = 1;
+module_param(read_urbs, uint, 0644);
+MODULE_PARM_DESC(read_urbs, "bulk-in transfers queued per read request (1-8)");
+
+static unsigned int write_urbs = 4;
+module_param(write_urbs, uint, 0644);
+MODULE_PARM_DESC(write_urbs, "bulk-out transfers kept in flight by a write (1-8)");
+
 struct xugc_urb_ctx {
-	struct completion complete;
 	unsigned timed_out : 1;
 };
 
+struct xugc_transfer {
+	struct urb *urb;
+	struct xugc_priv *priv;
+	u32 length;		/* data bytes carried by a bulk-out transfer */
+	int done;
+};
+
 /*
  * This structure holds private data for each adapter device allocated in attach
  */
@@ -122,6 +143,9 @@ struct xugc_priv {
 
 	struct timer_list bulk_timer;
 	struct xugc_urb_ctx context;
+	struct xugc_transfer in_transfers[XUGC_MAX_URBS];
+	struct xugc_transfer out_transfers[XUGC_MAX_URBS];
+	u8 *request_buffer;	/* REQUEST_DEV_DEP_MSG_IN header */
 	unsigned is_cic : 1;
 	unsigned ren_state : 1;
 	unsigned atn_asserted : 1;
@@ -141,9 +165,10 @@ static void xugc_delete(struct kref *kref)
 
 static void xugc_bulk_complete(struct urb *urb)
 {
-	struct xugc_urb_ctx *context = urb->context;
+	struct xugc_transfer *transfer = urb->context;
 
-	complete(&context->complete);
+	WRITE_ONCE(transfer->done, 1);
+	wake_up_interruptible(&transfer->priv->wait_bulk_in);
 }
 
 static void xugc_timeout_handler(COMPAT_TIMER_ARG_TYPE t)
@@ -152,7 +177,44 @@ static void xugc_timeout_handler(COMPAT_TIMER_ARG_TYPE t)
 	struct xugc_urb_ctx *context = &priv->context;
 
 	context->timed_out = 1;
-	complete(&context->complete);
+	wake_up_interruptible(&priv->wait_bulk_in);
+}
+
+static int xugc_submit_transfer(struct xugc_transfer *transfer, unsigned int pipe, u32 length)
+{
+	struct xugc_priv *priv = transfer->priv;
+	struct urb *urb = transfer->urb;
+
+	transfer->done = 0;
+	usb_fill_bulk_urb(urb, priv->usb_dev, pipe, urb->transfer_buffer, length,
+			  xugc_bulk_complete, transfer);
+	return usb_submit_urb(urb, GFP_KERNEL);
+}
+
+/*
+ * Wait for a transfer submitted by xugc_submit_transfer().  Returns 0 when it
+ * has completed, -ETIMEDOUT if the bulk timer fired first or -ERESTARTSYS.
+ */
+static int xugc_wait_transfer(struct xugc_transfer *transfer)
+{
+	struct xugc_priv *priv = transfer->priv;
+
+	if (wait_event_interruptible(priv->wait_bulk_in, READ_ONCE(transfer->done) ||
+				     priv->context.timed_out))
+		return -ERESTARTSYS;
+	if (!READ_ONCE(transfer->done))
+		return -ETIMEDOUT;
+	return 0;
+}
+
+static void xugc_kill_transfers(struct xugc_transfer *transfers)
+{
+	int i;
+
+	for (i = 0; i < XUGC_MAX_URBS; i++) {
+		if (transfers[i].urb)
+			usb_kill_urb(transfers[i].urb);
+	}
 }
 
 static int xugc_abort_bulk_in_tag(struct xugc_priv *priv, u8 tag)
@@ -485,12 +547,9 @@ static int send_request_dev_dep_msg_in(struct gpib_board *board, u32 transfer_si
 {
 	struct xugc_priv *priv = board->private_data;
 	int retval;
-	u8 *buffer;
+	u8 *buffer = priv->request_buffer;
 	int actual;
 
-	buffer = kmalloc(USBTMC_HEADER_SIZE, GFP_KERNEL);
-	if (!buffer)
-		return -ENOMEM;
 	/* Setup IO buffer for REQUEST_DEV_DEP_MSG_IN message
 	 * Refer to class specs for details
 	 */
@@ -526,7 +585,6 @@ static int send_request_dev_dep_msg_in(struct gpib_board *board, u32 transfer_si
 	if (!priv->b_tag)
 		priv->b_tag++;
 
-	kfree(buffer);
 	if (retval < 0)
 		dev_err(&priv->intf->dev, "%s returned %d\n", __func__, retval);
 
@@ -711,6 +769,42 @@ static void xugc_free_int(struct xugc_priv *priv)
 	kref_put(&priv->kref, xugc_delete);
 }
 
+static int xugc_alloc_transfers(struct xugc_priv *priv)
+{
+	int i;
+
+	priv->request_buffer = kmalloc(USBTMC_HEADER_SIZE, GFP_KERNEL);
+	if (!priv->request_buffer)
+		return -ENOMEM;
+	for (i = 0; i < XUGC_MAX_URBS; i++) {
+		priv->in_transfers[i].priv = priv;
+		priv->in_transfers[i].urb = xugc_create_urb(priv->bin_bsiz);
+		if (!priv->in_transfers[i].urb)
+			return -ENOMEM;
+		priv->out_transfers[i].priv = priv;
+		priv->out_transfers[i].urb = xugc_create_urb(priv->bout_bsiz);
+		if (!priv->out_transfers[i].urb)
+			return -ENOMEM;
+	}
+	return 0;
+}
+
+static void xugc_free_transfers(struct xugc_priv *priv)
+{
+	int i;
+
+	xugc_kill_transfers(priv->in_transfers);
+	xugc_kill_transfers(priv->out_transfers);
+	for (i = 0; i < XUGC_MAX_URBS; i++) {
+		usb_free_urb(priv->in_transfers[i].urb);
+		priv->in_transfers[i].urb = NULL;
+		usb_free_urb(priv->out_transfers[i].urb);
+		priv->out_transfers[i].urb = NULL;
+	}
+	kfree(priv->request_buffer);
+	priv->request_buffer = NULL;
+}
+
 /****************************
  *			    *
  * gpib_interface functions *
@@ -722,166 +816,172 @@ static int xugc_read(struct gpib_board *board, u8 *buf, size_t count, int *end,
 	struct xugc_priv *priv = board->private_data;
 	struct device *dev = &priv->intf->dev;
 	const u32 bufsize = (u32)priv->bin_bsiz;
+	const unsigned int in_pipe = usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in);
+	const unsigned int num_urbs = clamp_val(read_urbs, 1, XUGC_MAX_URBS);
 	struct xugc_urb_ctx *context = &priv->context;
-	struct urb *urb = NULL;
+	struct xugc_transfer *transfer;
 	u8 *buffer;
-	int buflen;
 	u32 bytes_to_read;	 /* # data bytes to read in this xfer			*/
 	u32 bytes_transferred;	 /* # bytes xferred in urb: header + data [+ pad]	*/
 	u32 bytes_read;		 /* # data bytes received in the usbtmc message		*/
+	u32 bytes_copied;	 /* # data bytes of the message copied so far		*/
 	u32 remaining;		 /* total # data still remaining in current xfer	*/
 	int done;		 /* total # data bytes read so far			*/
+	unsigned int urbs_needed, i;
 	u32 msec_timeout;
 	int retval;
 
 	mutex_lock(&priv->io_mutex);
 
-	if (!priv->intf) {
-		retval = -ENODEV;
-		goto exit;
-	}
-
 	remaining = count;
 	bytes_read = 0;
 	done = 0;
 	*end = 0;
+	msec_timeout = 0;
 
-	dev_dbg(dev, "%s(count:%zu)\n", __func__, count);
-
-	urb = xugc_create_urb(priv->bin_bsiz);
-	if (!urb) {
-		retval = -ENOMEM;
+	if (!priv->intf) {
+		retval = -ENODEV;
 		goto exit;
 	}
 
-	buffer = urb->transfer_buffer;
-	buflen = urb->transfer_buffer_length;
+	dev_dbg(dev, "%s(count:%zu)\n", __func__, count);
+
 	msec_timeout = (board->usec_timeout + 999) / 1000;
 	priv->start_jiffies = jiffies;
-
-	/* We will always get a full message since bufsize > xyphro buffer */
-
+	context->timed_out = 0;
+	if (msec_timeout)
+		mod_timer(&priv->bulk_timer, priv->start_jiffies +
+			  msecs_to_jiffies(msec_timeout));
+
+	/*
+	 * We will always get a full message since the transfers queued for it
+	 * are larger than the xyphro buffer.  The header and any alignment
+	 * padding are counted so the whole reply fits in the queued urbs.
+	 */
 	while (remaining > 0) {
-		if (remaining > bufsize - USBTMC_HEADER_SIZE - 3)
-			bytes_to_read = bufsize - USBTMC_HEADER_SIZE - 3;
+		if (remaining > num_urbs * bufsize - USBTMC_HEADER_SIZE - 3)
+			bytes_to_read = num_urbs * bufsize - USBTMC_HEADER_SIZE - 3;
 		else
 			bytes_to_read = remaining;
+		urbs_needed = DIV_ROUND_UP(USBTMC_HEADER_SIZE + bytes_to_read + 3, bufsize);
 
-		if (board->usec_timeout != 0)
-			msec_timeout -= jiffies_to_msecs(jiffies - priv->start_jiffies);
-
-		if (msec_timeout < 0) {
+		if (context->timed_out) {
 			retval = -ETIMEDOUT;
 			goto exit;
 		}
 
-		retval = send_request_dev_dep_msg_in(board, bytes_to_read, msec_timeout);
+		/* queue the bulk-in transfers first so the reply is not held off */
+		for (i = 0; i < urbs_needed; i++) {
+			retval = xugc_submit_transfer(&priv->in_transfers[i], in_pipe, bufsize);
+			if (retval) {
+				dev_err(dev, "%s: submit urb failed %d\n", __func__, retval);
+				xugc_kill_transfers(priv->in_transfers);
+				goto exit;
+			}
+		}
 
+		retval = send_request_dev_dep_msg_in(board, bytes_to_read, msec_timeout);
 		if (retval < 0) {
+			xugc_kill_transfers(priv->in_transfers);
 			xugc_abort_bulk_out(priv);
 			goto exit;
 		}
 
-		if (board->usec_timeout != 0)
-			msec_timeout -= jiffies_to_msecs(jiffies - priv->start_jiffies) - 1;
-
-		if (msec_timeout < 0) {
-			retval = -ETIMEDOUT;
-			goto exit;
-		}
+		bytes_copied = 0;
+		for (i = 0; i < urbs_needed; i++) {
+			transfer = &priv->in_transfers[i];
+			buffer = transfer->urb->transfer_buffer;
+
+			retval = xugc_wait_transfer(transfer);
+			if (retval == -ERESTARTSYS)
+				dev_dbg(dev, "wait read complete interrupted\n");
+			else if (retval == -ETIMEDOUT)
+				dev_dbg(dev, "read timedout\n");
+			else
+				retval = transfer->urb->status;
+			if (retval) {
+				xugc_kill_transfers(priv->in_transfers);
+				xugc_abort_bulk_in(priv);
+				goto exit;
+			}
+			bytes_transferred = transfer->urb->actual_length;
 
-		init_completion(&context->complete);
-		context->timed_out = 0;
+			dev_dbg(dev, "bulk_in urb %u, bytes_transferred(%u) timeout(%u)\n",
+				i, bytes_transferred, msec_timeout);
 
-		usb_fill_bulk_urb(urb, priv->usb_dev,
-				  usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in),
-				  urb->transfer_buffer, buflen,
-				  xugc_bulk_complete, context);
+			if (i == 0) {
+				/* Store bTag (in case we need to abort) */
+				priv->b_tag_last_read = priv->b_tag;
 
-		if (msec_timeout)
-			mod_timer(&priv->bulk_timer, priv->start_jiffies +
-				  msecs_to_jiffies(msec_timeout));
+				/* Sanity checks for the header */
+				if (bytes_transferred < USBTMC_HEADER_SIZE) {
+					dev_err(dev, "Device sent too small first packet: %u < %u\n",
+						bytes_transferred, USBTMC_HEADER_SIZE);
+					retval = -EIO;
+					break;
+				}
 
-		retval = usb_submit_urb(urb, GFP_KERNEL);
+				if (buffer[0] != 2) {
+					dev_err(dev, "Device sent reply with wrong MsgID: %u != 2\n",
+						buffer[0]);
+					retval = -EIO;
+					break;
+				}
 
-		if (retval) {
-			dev_err(dev, "%s: submit urb failed %d\n", __func__, retval);
-			xugc_abort_bulk_in(priv);
-			goto exit;
-		}
+				if (buffer[1] != priv->b_tag_last_write) {
+					dev_err(dev, "Device sent reply with wrong bTag: %u != %u\n",
+						buffer[1], priv->b_tag_last_write);
+					retval = -EIO;
+					break;
+				}
 
-		if (wait_for_completion_interruptible(&context->complete)) {
-			dev_dbg(dev, "wait read complete interrupted\n");
-			xugc_abort_bulk_in(priv);
-			usb_kill_urb(urb);
-			mutex_unlock(&priv->io_mutex);
-			return -ERESTARTSYS;
-		}
+				/* How many characters did the adapter send this time? */
+				bytes_read = buffer[4] +
+					(buffer[5] << 8) +
+					(buffer[6] << 16) +
+					(buffer[7] << 24);
 
-		if (context->timed_out) {
-			dev_dbg(dev, "read timedout\n");
-			xugc_abort_bulk_in(priv);
-			usb_kill_urb(urb);
-			retval = -ETIMEDOUT;
-			goto exit;
-		} else {
-			retval = urb->status;
-			bytes_transferred = urb->actual_length;
-		}
+				dev_dbg(dev, "Bulk-IN header: bytes_read(%u), bTransAttr(%u)\n",
+					bytes_read, buffer[8]);
 
-		dev_dbg(dev, "bulk_in retval(%d), bytes_transferred(%u) timeout(%u)\n",
-			retval, bytes_transferred, msec_timeout);
+				if (bytes_read > bytes_to_read) {
+					dev_err(dev, "Device wants to return more data than requested: %u > %u\n",
+						bytes_read, bytes_to_read);
+					retval = -EIO;
+					break;
+				}
 
-		/* Store bTag (in case we need to abort) */
-		priv->b_tag_last_read = priv->b_tag;
+				if (buffer[8]) { /* if eos (aka termchar) or eoi (aka eom) */
+					remaining = bytes_read;
+					*end = 1;
+				}
+				buffer += USBTMC_HEADER_SIZE;
+				bytes_transferred -= USBTMC_HEADER_SIZE;
+			}
 
-		/* Sanity checks for the header */
-		if (bytes_transferred < USBTMC_HEADER_SIZE) {
-			dev_err(dev, "Device sent too small first packet: %u < %u\n",
-				bytes_transferred, USBTMC_HEADER_SIZE);
-			xugc_abort_bulk_in(priv);
-			goto exit;
-		}
+			bytes_transferred = min(bytes_transferred, bytes_read - bytes_copied);
+			memcpy(buf + done + bytes_copied, buffer, bytes_transferred);
+			bytes_copied += bytes_transferred;
 
-		if (buffer[0] != 2) {
-			dev_err(dev, "Device sent reply with wrong MsgID: %u != 2\n", buffer[0]);
-			xugc_abort_bulk_in(priv);
-			goto exit;
+			/* a short transfer ends the reply */
+			if (bytes_copied == bytes_read ||
+			    transfer->urb->actual_length < bufsize)
+				break;
 		}
-
-		if (buffer[1] != priv->b_tag_last_write) {
-			dev_err(dev, "Device sent reply with wrong bTag: %u != %u\n",
-				buffer[1], priv->b_tag_last_write);
+		/* transfers queued for data the device did not send */
+		xugc_kill_transfers(priv->in_transfers);
+		if (retval) {
 			xugc_abort_bulk_in(priv);
 			goto exit;
 		}
 
-		/* How many characters did the adapter send this time? */
-		bytes_read = buffer[4] +
-			(buffer[5] << 8) +
-			(buffer[6] << 16) +
-			(buffer[7] << 24);
-
-		dev_dbg(dev, "Bulk-IN header: bytes_read(%u), bTransAttr(%u)\n",
-			bytes_read, buffer[8]);
-
-		if (bytes_read > bytes_to_read) {
-			dev_err(dev, "Device wants to return more data than requested: %u > %u\n",
-				bytes_read, bytes_to_read);
-			xugc_abort_bulk_in(priv);
+		remaining -= bytes_copied;
+		done += bytes_copied;
+		if (bytes_copied != bytes_read) {
+			dev_err(dev, "Device sent %u of %u data bytes\n", bytes_copied, bytes_read);
+			retval = -EIO;
 			goto exit;
 		}
-
-		remaining -= bytes_read;
-
-		memcpy(buf + done, &buffer[USBTMC_HEADER_SIZE], bytes_read);
-
-		done += bytes_read;
-
-		if (buffer[8]) { /* if eos (aka termchar) or eoi (aka eom) */
-			remaining = 0;
-			*end = 1;
-		}
 	}
 	retval = 0;
 
@@ -892,7 +992,6 @@ exit:
 	}
 	*nbytes = done;
 	mutex_unlock(&priv->io_mutex);
-	usb_free_urb(urb);
 	return retval;
 }
 
@@ -902,14 +1001,17 @@ static int xugc_write(struct gpib_board *board, u8 *buf, size_t count, int send_
 	struct xugc_priv *priv = board->private_data;
 	struct xugc_urb_ctx *context = &priv->context;
 	struct device *dev = &priv->intf->dev;
-	struct usb_device *usb_dev;
-	struct urb *urb = NULL;
+	const unsigned int num_urbs = clamp_val(write_urbs, 1, XUGC_MAX_URBS);
+	struct xugc_transfer *transfer;
+	unsigned int out_pipe;
 	u8 *buffer;		      /* Urb buffer					*/
 	u32 buflen;		      /* Total size of urb buffer			*/
 	u32 bytes_to_transfer;	      /* # bytes to send this round hdr + data + [pad]	*/
 	u32 bytes_to_send;	      /* # data bytes to send this round		*/
 	u32 remaining;		      /* # data bytes remaining to send			*/
 	u32 done;		      /* # data bytes already sent so far		*/
+	u32 sent;		      /* # data bytes handed to the host controller	*/
+	unsigned int head, tail;      /* next transfer to fill, oldest in flight	*/
 	int eoi;		      /* Are we sending eoi this round			*/
 	int timeout_msecs = 0;
 	int retval = 0;
@@ -918,8 +1020,7 @@ static int xugc_write(struct gpib_board *board, u8 *buf, size_t count, int send_
 	if (!priv->intf)
 		return -ENODEV;
 
-	priv = board->private_data;
-	usb_dev = interface_to_usbdev(priv->intf);
+	out_pipe = usb_sndbulkpipe(priv->usb_dev, priv->bulk_out);
 
 	mutex_lock(&priv->io_mutex);
 
@@ -927,101 +1028,103 @@ static int xugc_write(struct gpib_board *board, u8 *buf, size_t count, int send_
 
 	remaining = count;
 	done = 0;
+	sent = 0;
+	head = 0;
+	tail = 0;
 
 	if (!count)
 		goto exit;
 
-	urb = xugc_create_urb(priv->bout_bsiz);
-	if (!urb) {
-		retval = -ENOMEM;
-		goto exit;
-	}
-
-	buffer = urb->transfer_buffer;
-	buflen = urb->transfer_buffer_length;
+	buflen = priv->bout_bsiz;
 	timeout_msecs = (board->usec_timeout + 999) / 1000;
 	priv->start_jiffies = jiffies;
+	context->timed_out = 0;
+	if (timeout_msecs)
+		mod_timer(&priv->bulk_timer, priv->start_jiffies +
+			  msecs_to_jiffies(timeout_msecs));
+
+	/*
+	 * Chunks are sent as separate DEV_DEP_MSG_OUT messages.  Up to num_urbs
+	 * of them are queued on the endpoint before waiting for the oldest, so
+	 * the adapter never waits for us between chunks.
+	 */
+	while (done < count) {
+		if (remaining > 0 && head - tail < num_urbs) {
+			transfer = &priv->out_transfers[head % num_urbs];
+			buffer = transfer->urb->transfer_buffer;
+
+			if (remaining > buflen - USBTMC_HEADER_SIZE - 3) {
+				bytes_to_send = buflen - USBTMC_HEADER_SIZE - 3;
+				buffer[8] = 0;
+				eoi = 0;
+			} else {
+				bytes_to_send = remaining;
+				buffer[8] = send_eoi;
+				eoi  = send_eoi;
+			}
 
-	while (remaining > 0) {
-		if (remaining > buflen - USBTMC_HEADER_SIZE - 3) {
-			bytes_to_send = buflen - USBTMC_HEADER_SIZE - 3;
-			buffer[8] = 0;
-			eoi = 0;
-		} else {
-			bytes_to_send = remaining;
-			buffer[8] = send_eoi;
-			eoi  = send_eoi;
-		}
-
-		/* Setup IO buffer for DEV_DEP_MSG_OUT message */
-		buffer[0] = 1;
-		buffer[1] = priv->b_tag;
-		buffer[2] = ~priv->b_tag;
-		buffer[3] = 0; /* Reserved */
-		buffer[4] = bytes_to_send >> 0;
-		buffer[5] = bytes_to_send >> 8;
-		buffer[6] = bytes_to_send >> 16;
-		buffer[7] = bytes_to_send >> 24;
-		/* buffer[8] is set above... */
-		buffer[9] = 0; /* Reserved */
-		buffer[10] = 0; /* Reserved */
-		buffer[11] = 0; /* Reserved */
-
-		memcpy(&buffer[USBTMC_HEADER_SIZE], buf + done, bytes_to_send);
-
-		bytes_to_transfer = roundup(USBTMC_HEADER_SIZE + bytes_to_send, 4);
-
-		dev_dbg(dev, "%s(data bytes_to_send:%u bytes_to_xfer:%u eoi:%d)\n",
-			__func__, (unsigned int)bytes_to_send,
-			(unsigned int)bytes_to_transfer, eoi);
-
-		init_completion(&context->complete);
-		context->timed_out = 0;
-
-		usb_fill_bulk_urb(urb, priv->usb_dev,
-				  usb_sndbulkpipe(priv->usb_dev, priv->bulk_out),
-				  urb->transfer_buffer, bytes_to_transfer,
-				  xugc_bulk_complete, context);
+			/* Setup IO buffer for DEV_DEP_MSG_OUT message */
+			buffer[0] = 1;
+			buffer[1] = priv->b_tag;
+			buffer[2] = ~priv->b_tag;
+			buffer[3] = 0; /* Reserved */
+			buffer[4] = bytes_to_send >> 0;
+			buffer[5] = bytes_to_send >> 8;
+			buffer[6] = bytes_to_send >> 16;
+			buffer[7] = bytes_to_send >> 24;
+			/* buffer[8] is set above... */
+			buffer[9] = 0; /* Reserved */
+			buffer[10] = 0; /* Reserved */
+			buffer[11] = 0; /* Reserved */
+
+			memcpy(&buffer[USBTMC_HEADER_SIZE], buf + sent, bytes_to_send);
+
+			bytes_to_transfer = roundup(USBTMC_HEADER_SIZE + bytes_to_send, 4);
+
+			dev_dbg(dev, "%s(data bytes_to_send:%u bytes_to_xfer:%u eoi:%d)\n",
+				__func__, (unsigned int)bytes_to_send,
+				(unsigned int)bytes_to_transfer, eoi);
+
+			transfer->length = bytes_to_send;
+			retval = xugc_submit_transfer(transfer, out_pipe, bytes_to_transfer);
+			if (retval < 0) {
+				dev_err(dev, "Failed to submit urb, error %d\n", (int)retval);
+				break;
+			}
 
-		if (timeout_msecs)
-			mod_timer(&priv->bulk_timer, priv->start_jiffies +
-				  msecs_to_jiffies(timeout_msecs));
+			priv->b_tag_last_write = priv->b_tag;
+			priv->b_tag++;
 
-		retval = usb_submit_urb(urb, GFP_KERNEL);
+			if (!priv->b_tag)
+				priv->b_tag++;
 
-		if (retval < 0) {
-			dev_err(dev, "Failed to submit urb, error %d\n", (int)retval);
-			xugc_abort_bulk_out(priv);
-			goto exit;
+			head++;
+			sent += bytes_to_send;
+			remaining -= bytes_to_send;
+			continue;
 		}
 
-		priv->b_tag_last_write = priv->b_tag;
-		priv->b_tag++;
-
-		if (!priv->b_tag)
-			priv->b_tag++;
-
-		if (wait_for_completion_interruptible(&context->complete)) {
+		transfer = &priv->out_transfers[tail % num_urbs];
+		retval = xugc_wait_transfer(transfer);
+		if (retval == -ERESTARTSYS) {
 			dev_dbg(dev, "wait write complete interrupted\n");
-			xugc_abort_bulk_out(priv);
-			mutex_unlock(&priv->io_mutex);
-			return -ERESTARTSYS;
-		}
-
-		if (context->timed_out) {
+			break;
+		} else if (retval == -ETIMEDOUT) {
 			dev_dbg(dev, "write timedout\n");
-			xugc_abort_bulk_out(priv);
-			usb_kill_urb(urb);
-			retval = -ETIMEDOUT;
-			goto exit;
-		} else {
-			retval = urb->status;
-			dev_dbg(dev, "write urb xfer len %d retval %d\n",
-				urb->actual_length, retval);
+			break;
 		}
+		retval = transfer->urb->status;
+		dev_dbg(dev, "write urb xfer len %d retval %d\n",
+			transfer->urb->actual_length, retval);
+		if (retval)
+			break;
 
-		done += bytes_to_send;
-		remaining -= bytes_to_send;
+		tail++;
+		done += transfer->length;
+	}
+	if (retval) {
+		xugc_kill_transfers(priv->out_transfers);
+		xugc_abort_bulk_out(priv);
 	}
 
 exit:
@@ -1030,7 +1133,6 @@ exit:
 			COMPAT_DEL_TIMER_SYNC(&priv->bulk_timer);
 	}
 	*bytes_written = done;
-	usb_free_urb(urb);
 	mutex_unlock(&priv->io_mutex);
 	return retval;
 }
@@ -1391,6 +1493,7 @@ static int xugc_attach(struct gpib_board *board, const struct gpib_board_config
 	priv->usb_dev = usb_dev;
 	kref_init(&priv->kref);
 	mutex_init(&priv->io_mutex);
+	init_waitqueue_head(&priv->wait_bulk_in);
 
 	/* Initialize USBTMC bTag and other fields */
 	priv->b_tag	= 1;
@@ -1413,6 +1516,10 @@ static int xugc_attach(struct gpib_board *board, const struct gpib_board_config
 	priv->bin_bsiz = io_buffer_size;
 	priv->bout_bsiz = io_buffer_size;
 
+	retval = xugc_alloc_transfers(priv);
+	if (retval)
+		goto attach_fail;
+
 	/* allocate int urb */
 	priv->iin_urb = usb_alloc_urb(0, GFP_KERNEL);
 	if (!priv->iin_urb) {
@@ -1456,6 +1563,7 @@ static int xugc_attach(struct gpib_board *board, const struct gpib_board_config
 
 attach_fail:
 	xugc_free_int(priv);
+	xugc_free_transfers(priv);
 	xugc_free_private(board);
 	mutex_unlock(&xugc_hotplug_lock);
 	return retval;
@@ -1473,6 +1581,7 @@ static void xugc_detach(struct gpib_board *board)
 			usb_set_intfdata(priv->intf, NULL);
 
 		xugc_free_int(priv);
+		xugc_free_transfers(priv);
 		xugc_free_private(board);
 	}
 	dev_dbg(board->gpib_dev, "Detached\n");
@@ -1563,6 +1672,8 @@ static void xugc_disconnect(struct usb_interface *intf)
 
 				if (priv) {
 					xugc_free_int(priv);
+					xugc_kill_transfers(priv->in_transfers);
+					xugc_kill_transfers(priv->out_transfers);
 					priv->intf = NULL;
 				}
 			}
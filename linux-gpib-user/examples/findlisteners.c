@@ -22,6 +22,7 @@
 #include <string.h>
 #include <gpib/ib.h>
 #include <getopt.h>
+#include <sys/time.h>
 
 static char* myProg;
 
@@ -67,11 +68,43 @@ int findListeners(int ud, int from, int to) {
   return n;
 }
 
+/* Inventory primary and secondary addresses with FindLstn and time it */
+int findAllListeners(int ud, int from, int to) {
+  Addr4882_t padList[32];
+  Addr4882_t resultList[31 * 31];
+  struct timeval start, end;
+  int bpad, i, n;
+
+  if (ibask(ud, IbaPAD, &bpad) & ERR)    /* Get board primary address */
+    myError(ThreadIberr(), "ibask IbaPAD failed");
+  for (n = 0, i = from; i <= to; i++)
+    if (i != bpad) padList[n++] = i;
+  padList[n] = NOADDR;
+
+  gettimeofday(&start, NULL);
+  FindLstn(ud, padList, resultList, sizeof(resultList) / sizeof(resultList[0]));
+  gettimeofday(&end, NULL);
+  if (ThreadIbsta() & ERR) {
+    if (ThreadIberr() == ENOL) return 0; /* No listeners on the bus */
+    myError(ThreadIberr(), "FindLstn failed");
+  }
+  n = ThreadIbcnt();
+  for (i = 0; i < n; i++) {
+    printf("Listener at pad %2d", GetPAD(resultList[i]));
+    if (GetSAD(resultList[i])) printf(" sad %2d", GetSAD(resultList[i]) - 0x60);
+    printf("\n");
+  }
+  printf("%s: scan took %.3f ms\n", myProg,
+	 (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_usec - start.tv_usec) / 1e3);
+  return n;
+}
+
 void usage(int brief) {
-  fprintf(stderr,"Usage: %s [-h] [-d <device pad>] [[-m <minor>] | <board name>]\n", myProg);
+  fprintf(stderr,"Usage: %s [-h] [-s] [-d <device pad>] [[-m <minor>] | <board name>]\n", myProg);
   if (brief) exit(0);
   fprintf(stderr,"  Where the optional <board name> is the name of the board from gpib.conf\n");
   fprintf(stderr,"  If the <device pad> is not specified all pads are scanned.\n");
+  fprintf(stderr,"  With -s secondary addresses are scanned too and the scan is timed.\n");
   fprintf(stderr,"  Default <minor> is 0\n");
   fprintf(stderr,"  If a <board name> is specified the <minor> is ignored.\n");
   exit(0);
@@ -84,15 +117,17 @@ int main(int argc, char ** argv) {
   int gotdev=0;
   int minor = 0;
   int gotmin = 0;
+  int secondaries = 0;
   int from = 0;
   int to = 30;
   int c;
   myProg = argv[0];
   
-  while ((c = getopt (argc, argv, "m:d:h")) != -1) {
+  while ((c = getopt (argc, argv, "m:d:hs")) != -1) {
     switch (c)  {
     case 'm': minor  = atoi(optarg); gotmin++; break; 
     case 'd': device = atoi(optarg); gotdev++; break; 
+    case 's': secondaries = 1; break;
     case 'h': usage(0); break;
     default: usage(0);
     }
@@ -128,7 +163,8 @@ int main(int argc, char ** argv) {
   if (gotmin) printf(" on minor %d\n", minor);
   else printf(" on board \"%s\" minor %d\n", board, minor);
     
-  n = findListeners(ud, from, to);
+  if (secondaries) n = findAllListeners(ud, from, to);
+  else n = findListeners(ud, from, to);
 
   printf("%s: %d device%s found.\n",myProg, n, (n==1) ? "" : "s");
   exit(n); /* tell invoking script, if any, how many devices were found */
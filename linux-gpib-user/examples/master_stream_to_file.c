@@ -0,0 +1,142 @@
+/***************************************************************************
+                                 master_stream_to_file.c
+                             -------------------
+
+Example program which uses the streaming acquisition calls of the gpib c
+library.  Use it with slave_write_from_file (or any continuously talking
+instrument) on the other end to measure sustained streaming throughput.
+Unlike master_read_to_file, there is no limit on the amount of data read:
+it stops at the first END, or after the requested number of bytes.
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "gpib/ib.h"
+char *myProg;
+
+void usage(int brief) {
+	fprintf(stderr,"Usage: %s [-h] [-b <board index>] [-d <device pad>]"
+		" [-r <ring size>] [-n <byte count>] <file name>\n", myProg);
+	if (brief) exit(1);
+	fprintf(stderr,"  Default <board index> is 0\n");
+	fprintf(stderr,"  Default <device pad> is 1\n");
+	fprintf(stderr,"  Default <ring size> is 4194304\n");
+	fprintf(stderr,"  Default <byte count> is 0, read until END\n");
+	exit(0);
+}
+
+int main( int argc, char *argv[] )
+{
+	int dev;
+	int board_index = 0;
+	int pad = 1;
+	long ring_size = 0x400000;
+	unsigned long byte_limit = 0;
+	unsigned long total = 0;
+	char *file_path;
+	int status;
+	struct timeval start_time, end_time;
+	float elapsed_time;
+	FILE *filep;
+	static char buffer[ 0x10000 ];
+	int c;
+
+	myProg = argv[0];
+	while ((c = getopt (argc, argv, "b:d:r:n:h")) != -1)
+	{
+		switch (c)
+		{
+		case 'b': board_index = atoi(optarg); break;
+		case 'd': pad   = atoi(optarg); break;
+		case 'r': ring_size = atol(optarg); break;
+		case 'n': byte_limit = strtoul(optarg, NULL, 0); break;
+		case 'h': usage(0); break;
+		default:  usage(1);
+		}
+	}
+
+	if (optind == argc)
+	{
+		fprintf( stderr, "Must provide file path as argument\n" );
+		usage(0);
+	}
+
+	file_path = argv[ optind ];
+	filep = fopen( file_path, "w" );
+	if( filep == NULL )
+	{
+		perror( "fopen()");
+		return -1;
+	}
+
+	dev = ibdev( board_index, pad, 0, T3s, 1, 0 );
+	if( dev < 0 )
+	{
+		fprintf( stderr, "ibdev() failed\n" );
+		fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+		return -1;
+	}
+
+	gettimeofday( &start_time, NULL );
+
+	status = ibstream_start( dev, ring_size );
+	if( status & ERR )
+	{
+		fprintf( stderr, "ibstream_start() failed\n" );
+		fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+		return -1;
+	}
+	printf( "Streaming: board index=%i, pad=%i, ring size=%li\n"
+		"\tfile path=%s\n", board_index, pad, ThreadIbcntl(), file_path );
+
+	do
+	{
+		long count = sizeof( buffer );
+
+		if( byte_limit && byte_limit - total < count )
+			count = byte_limit - total;
+		status = ibstream_read( dev, buffer, count );
+		if( status & ERR )
+		{
+			fprintf( stderr, "ibstream_read() failed\n" );
+			fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+			break;
+		}
+		if( fwrite( buffer, 1, ThreadIbcntl(), filep ) != ThreadIbcntl() )
+		{
+			perror( "fwrite()" );
+			break;
+		}
+		total += ThreadIbcntl();
+	} while( ( status & END ) == 0 && ( byte_limit == 0 || total < byte_limit ) );
+
+	gettimeofday( &end_time, NULL );
+
+	if( ibstream_stop( dev ) & ERR )
+		fprintf( stderr, "ibstream_stop() failed\n" );
+	else
+		printf( "Ring filled up %li times\n", ThreadIbcntl() );
+
+	elapsed_time = end_time.tv_sec - start_time.tv_sec +
+		( end_time.tv_usec - start_time.tv_usec ) / 1e6;
+	printf( "Transferred %lu bytes in %g seconds: %g bytes/sec\n",
+		total, elapsed_time, total / elapsed_time );
+
+	fclose( filep );
+	ibonl( dev, 0 );
+
+	return 0;
+}
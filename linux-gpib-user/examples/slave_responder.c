@@ -0,0 +1,126 @@
+/***************************************************************************
+                                 slave_responder.c
+                             -------------------
+
+Example program which uses the device mode responder of the gpib c
+library.  The board answers every query it is sent with the same
+response.  A few responses are queued ahead, so the driver sends one the
+moment the controller addresses the board to talk, and another is queued
+for each query taken from the listener buffer.  Use it with ibterm or
+master_read_to_file on the controller.
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "gpib/ib.h"
+char *myProg;
+
+void usage(int brief) {
+	fprintf(stderr,"Usage: %s [-h] [-b <board index>] [-q <queue depth>]"
+		" [-n <query count>] <response>\n", myProg);
+	if (brief) exit(1);
+	fprintf(stderr,"  Default <board index> is 0\n");
+	fprintf(stderr,"  Default <queue depth> is 4\n");
+	fprintf(stderr,"  Default <query count> is 0, answer until interrupted\n");
+	exit(0);
+}
+
+static int queue_response( int board, const char *response )
+{
+	if( ibresponder_queue( board, response, strlen( response ) ) & ERR )
+	{
+		fprintf( stderr, "ibresponder_queue() failed\n" );
+		fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+		return -1;
+	}
+	return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+	int board;
+	int board_index = 0;
+	int depth = 4;
+	unsigned long query_limit = 0;
+	unsigned long queries = 0;
+	char *response;
+	int status;
+	static char buffer[ 0x1000 ];
+	int i, c;
+
+	myProg = argv[0];
+	while ((c = getopt (argc, argv, "b:q:n:h")) != -1)
+	{
+		switch (c)
+		{
+		case 'b': board_index = atoi(optarg); break;
+		case 'q': depth = atoi(optarg); break;
+		case 'n': query_limit = strtoul(optarg, NULL, 0); break;
+		case 'h': usage(0); break;
+		default:  usage(1);
+		}
+	}
+
+	if (optind == argc || depth <= 0)
+	{
+		fprintf( stderr, "Must provide response as argument\n" );
+		usage(0);
+	}
+
+	response = argv[ optind ];
+
+	board = board_index;
+	ibtmo( board, TNONE );
+
+	status = ibresponder_start( board, sizeof( buffer ) );
+	if( status & ERR )
+	{
+		fprintf( stderr, "ibresponder_start() failed\n" );
+		fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+		return -1;
+	}
+	for( i = 0; i < depth; i++ )
+	{
+		if( queue_response( board, response ) < 0 )
+			goto out;
+	}
+	printf( "Responding: board index=%i, queue depth=%i\n", board_index, depth );
+
+	while( query_limit == 0 || queries < query_limit )
+	{
+		status = ibresponder_read( board, buffer, sizeof( buffer ) - 1 );
+		if( status & ERR )
+		{
+			fprintf( stderr, "ibresponder_read() failed\n" );
+			fprintf( stderr, "%s\n", gpib_error_string( ThreadIberr() ) );
+			break;
+		}
+		buffer[ ThreadIbcntl() ] = '\0';
+		if( ( status & END ) && strchr( buffer, '?' ) )
+		{
+			queries++;
+			if( queue_response( board, response ) < 0 )
+				break;
+		}
+	}
+	printf( "Answered %lu queries\n", queries );
+
+out:
+	if( ibresponder_stop( board ) & ERR )
+		fprintf( stderr, "ibresponder_stop() failed\n" );
+
+	return 0;
+}
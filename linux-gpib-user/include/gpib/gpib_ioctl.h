@@ -25,6 +25,51 @@ struct gpib_read_write_ioctl {
 	__s32 handle;
 };
 
+/* one segment of a vectored read or write */
+struct gpib_iovec {
+	__u64 base;
+	__u64 len;
+};
+
+#define GPIB_MAX_IOVEC 64
+
+/*
+ * argument for vectored read/write ioctls.  completed_transfer_count
+ * counts bytes over all segments.  For writes, end requests EOI with the
+ * last byte of the final segment.  For reads, end is set if the transfer
+ * stopped on END, in which case end_segment/end_offset locate the byte
+ * following the one which carried it.
+ */
+struct gpib_read_write_vec_ioctl {
+	__u64 iov_ptr;	/* array of struct gpib_iovec */
+	__u32 iov_count;
+	__u32 completed_transfer_count;
+	__s32 end;
+	__s32 handle;
+	__u32 end_segment;
+	__u32 end_offset;
+};
+
+/*
+ * argument for the file ioctls, which move data between the bus and the
+ * open file fd inside the kernel.  Writes start at offset in the file, send
+ * EOI with the last byte if end is set, and with each eos character if
+ * eos_flags has XEOS.  Reads go to offset in the file, or its end if it was
+ * opened with O_APPEND, and stop on END; end is set if they did.
+ * file_error is the errno of a failed access to the file.
+ */
+struct gpib_file_io_ioctl {
+	__u64 offset;
+	__u64 requested_transfer_count;
+	__u64 completed_transfer_count;
+	__s32 fd;
+	__s32 handle;
+	__s32 end;
+	__s32 eos;
+	__s32 eos_flags;
+	__s32 file_error;
+};
+
 struct gpib_open_dev_ioctl {
 	__u32 handle;
 	__u32 pad;
@@ -117,11 +162,118 @@ struct gpib_request_service2 {
 	__s32 new_reason_for_service;
 };
 
+/*
+ * Streaming acquisition.  The ring is mapped by mmap() on the board's
+ * device file: the first page holds struct gpib_stream_ring, the data
+ * area follows at data_offset.  head is advanced by the driver, tail by
+ * the consumer; both count bytes since IBSTREAM_START and are never wrapped.
+ */
+#define GPIB_STREAM_NUM_END_MARKS 256
+
+enum gpib_stream_flags {
+	GPIB_STREAM_ACTIVE = 0x1,	/* acquisition thread is running */
+	GPIB_STREAM_STOP_ON_END = 0x2,	/* stop acquiring after first END */
+};
+
+struct gpib_stream_ring {
+	__u32 data_offset;	/* offset of data area from start of mapping */
+	__u32 size;		/* size of data area in bytes, a power of two */
+	__u32 flags;
+	__s32 error;		/* errno which terminated acquisition, if any */
+	__u64 head;		/* bytes produced, written by driver */
+	__u64 tail;		/* bytes consumed, written by user */
+	__u64 overruns;		/* times the ring filled and the talker was held off */
+	__u64 end_count;	/* number of END conditions received */
+	/* head position just past the byte carrying each END, indexed by count % N */
+	__u64 end_marks[GPIB_STREAM_NUM_END_MARKS];
+};
+
+struct gpib_stream_ioctl {
+	__u32 handle;
+	__u32 ring_size;	/* requested data area size, rounded up by driver */
+	__u32 flags;
+	__u32 map_length;	/* returned length to pass to mmap() */
+};
+
+/* a candidate listener address, sad is negative if none */
+struct gpib_probe_address {
+	__u8 pad;
+	__s8 sad;
+};
+
+#define GPIB_MAX_PROBE_ADDRESSES 1024
+
+enum gpib_probe_listeners_flags {
+	/* only report whether any candidate listens, don't say which */
+	GPIB_PROBE_ANY = 0x1,
+};
+
+/*
+ * Listener discovery.  The driver probes groups of candidates at once and
+ * bisects only the groups in which some device answered.  On return the
+ * addresses with a listener have been moved to the front of the array.
+ */
+struct gpib_probe_listeners_ioctl {
+	__u64 address_ptr;	/* array of struct gpib_probe_address */
+	__u32 num_addresses;	/* in: candidates, out: listeners found */
+	__u32 flags;
+	__u32 settle_usec;	/* time allowed for handshake lines to settle, 0 for default */
+	__u32 num_probes;	/* out: group probes performed */
+	__u32 elapsed_usec;	/* out: time taken by the whole search */
+	__u32 reserved;
+};
+
+/* engines a board can move read and write data with */
+enum gpib_transfer_engine {
+	GPIB_XFER_DEFAULT = 0,	/* whatever the board type uses when nothing is selected */
+	GPIB_XFER_PIO = 1,	/* a byte at a time through the chip's data registers */
+	GPIB_XFER_FIFO = 2,	/* through a fifo, by the cpu */
+	GPIB_XFER_DMA = 3,
+	GPIB_XFER_AUTO = 4,	/* DMA for transfers of dma_threshold bytes or more */
+	GPIB_XFER_NUM_ENGINES
+};
+
+enum gpib_transfer_engine_flags {
+	/* only report the current settings */
+	GPIB_XFER_QUERY = 0x1,
+};
+
+struct gpib_transfer_engine_ioctl {
+	__u32 engine;		/* in: engine to select, out: engine selected */
+	__u32 dma_threshold;	/* in: new threshold for GPIB_XFER_AUTO, 0 keeps it; out: threshold */
+	__u32 engines;		/* out: mask of (1 << engine) the board can select */
+	__u32 flags;
+};
+
+/*
+ * Device mode responder.  While it runs, a driver thread sends the queued
+ * responses as soon as the board is addressed to talk and, if
+ * listen_buffer_size is not zero, reads what the controller sends the
+ * board as listener into a buffer of up to that many bytes.
+ */
+struct gpib_responder_ioctl {
+	__u32 listen_buffer_size;
+	__u32 flags;		/* none defined yet, must be zero */
+};
+
+/* a response queued by IBRESPONDER_QUEUE or listener data taken by IBRESPONDER_READ */
+struct gpib_responder_message_ioctl {
+	__u64 buffer_ptr;
+	__u32 count;		/* queue: message length; read: in buffer size, out bytes read */
+	__s32 end;		/* queue: send EOI with the last byte; read: out END was received */
+	__u32 pending;		/* out: responses waiting to be sent */
+	__u32 usec_timeout;	/* read: how long to wait for data, 0 waits forever */
+};
+
 /* Standard functions. */
 enum gpib_ioctl {
 	IBRD = _IOWR(GPIB_CODE, 100, struct gpib_read_write_ioctl),
 	IBWRT = _IOWR(GPIB_CODE, 101, struct gpib_read_write_ioctl),
 	IBCMD = _IOWR(GPIB_CODE, 102, struct gpib_read_write_ioctl),
+	IBRDV = _IOWR(GPIB_CODE, 103, struct gpib_read_write_vec_ioctl),
+	IBWRTV = _IOWR(GPIB_CODE, 104, struct gpib_read_write_vec_ioctl),
+	IBRDF = _IOWR(GPIB_CODE, 105, struct gpib_file_io_ioctl),
+	IBWRTF = _IOWR(GPIB_CODE, 106, struct gpib_file_io_ioctl),
 	IBOPENDEV = _IOWR(GPIB_CODE, 3, struct gpib_open_dev_ioctl),
 	IBCLOSEDEV = _IOW(GPIB_CODE, 4, struct gpib_close_dev_ioctl),
 	IBWAIT = _IOWR(GPIB_CODE, 5, struct gpib_wait_ioctl),
@@ -161,7 +313,15 @@ enum gpib_ioctl {
 	IBPP2_GET = _IOR(GPIB_CODE, 41, __s16),
 	IBSELECT_DEVICE_PATH = _IOW(GPIB_CODE, 43, struct gpib_select_device_path_ioctl),
 	// 44 was IBSELECT_SERIAL_NUMBER
-	IBRSV2 = _IOW(GPIB_CODE, 45, struct gpib_request_service2)
+	IBRSV2 = _IOW(GPIB_CODE, 45, struct gpib_request_service2),
+	IBSTREAM_START = _IOWR(GPIB_CODE, 46, struct gpib_stream_ioctl),
+	IBSTREAM_STOP = _IO(GPIB_CODE, 47),
+	IBPROBE_LISTENERS = _IOWR(GPIB_CODE, 48, struct gpib_probe_listeners_ioctl),
+	IBXFER_ENGINE = _IOWR(GPIB_CODE, 49, struct gpib_transfer_engine_ioctl),
+	IBRESPONDER_START = _IOW(GPIB_CODE, 50, struct gpib_responder_ioctl),
+	IBRESPONDER_STOP = _IO(GPIB_CODE, 51),
+	IBRESPONDER_QUEUE = _IOWR(GPIB_CODE, 52, struct gpib_responder_message_ioctl),
+	IBRESPONDER_READ = _IOWR(GPIB_CODE, 53, struct gpib_responder_message_ioctl)
 };
 
 #endif	/* _GPIB_IOCTL_H */
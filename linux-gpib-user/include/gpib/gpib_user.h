@@ -211,7 +211,8 @@ enum ibask_option {
 	IBA_RSV = 0x21, /* board only */
 	IBA_BNA = 0x200,        /* device only */
 	/* linux-gpib extensions */
-	IBA_7_BIT_EOS = 0x1000  /* board only. Returns 1 if board supports 7 bit eos compares*/
+	IBA_7_BIT_EOS = 0x1000,  /* board only. Returns 1 if board supports 7 bit eos compares*/
+	IBA_DMA_THRESHOLD = 0x1001	/* board only. Smallest transfer done with DMA when enabled */
 };
 
 enum ibconfig_option {
@@ -245,7 +246,9 @@ enum ibconfig_option {
 	IBC_HS_CABLE_LENGTH = 0x1f,     /* board only */
 	IBC_IST = 0x20, /* board only */
 	IBC_RSV = 0x21, /* board only */
-	IBC_BNA = 0x200 /* device only */
+	IBC_BNA = 0x200, /* device only */
+	/* linux-gpib extensions */
+	IBC_DMA_THRESHOLD = 0x1001	/* board only */
 };
 
 enum t1_delays {
@@ -317,6 +320,7 @@ enum gpib_stb {
 #define	IbaRsv		  IBA_RSV
 #define	IbaBNA		  IBA_BNA
 #define Iba7BitEOS        IBA_7_BIT_EOS
+#define IbaDMAThreshold   IBA_DMA_THRESHOLD
 /* ibconfig options */
 #define	IbcPAD            IBC_PAD
 #define	IbcSAD		  IBC_SAD
@@ -350,12 +354,14 @@ enum gpib_stb {
 #define	IbcIst		  IBC_IST
 #define	IbcRsv		  IBC_RSV
 #define	IbcBNA		  IBC_BNA
+#define	IbcDMAThreshold	  IBC_DMA_THRESHOLD
 
 /* gpib events */
 #define	EventNone   EVENT_NONE
 #define	EventDevTrg EVENT_DEV_TRG
 #define	EventDevClr EVENT_DEV_CLR
 #define	EventIFC    EVENT_IFC
+#define	EventResponseSent EVENT_RESPONSE_SENT
 
 /* standard status byte bits */
 #define	IbStbRQS IB_STB_RQS
@@ -32,6 +32,8 @@ extern "C" {
         (GPIB_MAJOR_VERSION == (major) && GPIB_MINOR_VERSION == (minor) && \
         GPIB_MICRO_VERSION >= (micro)))
 
+struct iovec;
+
 typedef uint16_t Addr4882_t;
 static const Addr4882_t NOADDR = (Addr4882_t)-1;
 
@@ -51,6 +53,34 @@ enum send_eotmode
 	NLend = 2
 };
 
+/* values for IbcReadAdjust and IbcWriteAdjust */
+enum byte_adjust_mode
+{
+	NO_SWAP = 0,
+	SWAP_PAIRS = 1,	/* swap the bytes of each 16 bit word */
+	SWAP_QUADS = 2	/* reverse the bytes of each 32 bit word */
+};
+
+/* one device's query for ibquerylist() */
+struct gpib_query
+{
+	int ud;			/* device descriptor */
+	const void *command;	/* written to the device as by ibwrt() */
+	long command_length;
+	void *reply;		/* the reply is read into this as by ibrd() */
+	long reply_size;	/* 0 to only write the command */
+	/* set by ibquerylist() */
+	long reply_length;	/* the entry's ibcnt */
+	int status;		/* the entry's ibsta */
+	int error;		/* the entry's iberr, if status has ERR set */
+};
+
+/* flags for ibquerylist() */
+enum gpib_query_flags
+{
+	GPIB_QUERY_TRIGGER = 0x1	/* trigger all the devices between the commands and the replies */
+};
+
 extern volatile int ibsta, ibcnt, iberr;
 extern volatile long ibcntl;
 
@@ -104,6 +134,7 @@ extern int ibcac( int ud, int synchronous );
 extern int ibclr( int ud );
 extern int ibcmd( int ud, const void *cmd, long cnt );
 extern int ibcmda( int ud, const void *cmd, long cnt );
+extern int ibcompletion_fd( int ud, int *fd );
 extern int ibconfig( int ud, int option, int value );
 extern int ibdev( int board_index, int pad, int sad, int timo, int send_eoi, int eosmode );
 extern int ibdma( int ud, int v );
@@ -120,9 +151,18 @@ extern int ibonl( int ud, int onl );
 extern int ibpad( int ud, int v );
 extern int ibpct( int ud );
 extern int ibppc( int ud, int v );
+extern int ibquerylist( struct gpib_query *queries, int num_queries, int flags );
 extern int ibrd( int ud, void *buf, long count );
 extern int ibrda( int ud, void *buf, long count );
+extern int ibrdblk( int ud, void *buf, long count );
+extern int ibrdblkcb( int ud, int (*callback)( void *context, const void *data, long count, long block_length ),
+	void *context );
 extern int ibrdf( int ud, const char *file_path );
+extern int ibrdv( int ud, const struct iovec *iov, int iovcnt );
+extern int ibresponder_queue( int ud, const void *buf, long count );
+extern int ibresponder_read( int ud, void *buf, long count );
+extern int ibresponder_start( int ud, long listen_buffer_size );
+extern int ibresponder_stop( int ud );
 extern int ibrpp( int ud, char *ppr );
 extern int ibrsc( int ud, int v );
 extern int ibrsp( int ud, char *spr );
@@ -133,13 +173,18 @@ extern int ibsic( int ud );
 extern int ibspb( int ud, short *sp_bytes );
 extern int ibsre( int ud, int v );
 extern int ibstop( int ud );
+extern int ibstream_read( int ud, void *buf, long count );
+extern int ibstream_start( int ud, long ring_size );
+extern int ibstream_stop( int ud );
 extern int ibtmo( int ud, int v );
 extern int ibtrg( int ud );
 extern void ibvers( char **version);
 extern int ibwait( int ud, int mask );
+extern int ibwaita( int ud, int mask );
 extern int ibwrt( int ud, const void *buf, long count );
 extern int ibwrta( int ud, const void *buf, long count );
 extern int ibwrtf( int ud, const char *file_path );
+extern int ibwrtv( int ud, const struct iovec *iov, int iovcnt );
 extern const char* gpib_error_string( int iberr );
 
 static __inline__ Addr4882_t MakeAddr( unsigned int pad, unsigned int sad )
@@ -34,6 +34,7 @@ our %EXPORT_TAGS = ( 'all' => [ qw(
 	ibonl
 	ibpad
 	ibrd
+	ibrdblk
 	ibrdi
 	ibrpp
 	ibrsp
@@ -190,6 +191,7 @@ None by default.
   int ibonl(int ud, int onl)
   int ibpad(int ud, int v)
   int ibrd(int ud, char *rd, unsigned long cnt)
+  int ibrdblk(int ud, char *rd, unsigned long cnt)
   int ibrdi(int ud, char *rd, unsigned long cnt)
   int ibrpp(int ud, char *ppr)
   int ibrsp(int ud, char *spr)
@@ -203,6 +205,15 @@ None by default.
   int ibwrt(int ud, char *rd, unsigned long cnt)
   int ibwrti(int ud, char *rd, unsigned long cnt)
 
+=head2 Bulk reads
+
+  ibrd() and ibrdblk() read straight into the buffer of the scalar
+  passed as rd, which is binary safe and is reused when the same
+  scalar is passed again, so repeated reads don't allocate.  The
+  result is a packed string: use unpack("C*", $rd), vec() or
+  substr() on it rather than ibrdi(), which creates a scalar for
+  every byte read.  examples/bench_read.pl compares them.
+
 
 =head1 AUTHOR
 
@@ -111,14 +111,43 @@ ibrd(ud, rd, cnt)
 	unsigned long	cnt
 PREINIT:
 	char *buf;
+	long count;
 CODE:
-	buf = malloc( cnt + 1 );
-	if( buf == NULL )
-		croak( "malloc() returned NULL in ibrd()\n" );
-
+	/* read straight into the scalar's own buffer, which is kept
+	 * between calls when the same scalar is passed again */
+	sv_setpvn(rd, "", 0);
+	SvUTF8_off(rd);
+	buf = SvGROW(rd, cnt + 1);
 	RETVAL = ibrd(ud, buf, cnt);
-	sv_setpvn(rd, buf, ThreadIbcntl());
-	free( buf );
+	count = ThreadIbcntl();
+	/* after an EDVR error ibcnt holds an errno, not a byte count */
+	if ((RETVAL & ERR) && ThreadIberr() == EDVR)
+		count = 0;
+	SvCUR_set(rd, count);
+	*SvEND(rd) = '\0';
+OUTPUT:
+	RETVAL
+
+int
+ibrdblk(ud, rd, cnt)
+	int	ud
+	SV  *rd
+	unsigned long	cnt
+PREINIT:
+	char *buf;
+	long count;
+CODE:
+	/* read straight into the scalar's own buffer */
+	sv_setpvn(rd, "", 0);
+	SvUTF8_off(rd);
+	buf = SvGROW(rd, cnt + 1);
+	RETVAL = ibrdblk(ud, buf, cnt);
+	count = ThreadIbcntl();
+	/* after an EDVR error ibcnt holds an errno, not a byte count */
+	if ((RETVAL & ERR) && ThreadIberr() == EDVR)
+		count = 0;
+	SvCUR_set(rd, count);
+	*SvEND(rd) = '\0';
 OUTPUT:
 	RETVAL
 
@@ -128,7 +157,7 @@ ibrdi(ud, array, cnt)
 	AV  *array
 	unsigned long	cnt
 PREINIT:
-	int i;
+	long i, count;
 	char *buf;
 CODE:
 	av_clear( array );
@@ -138,9 +167,11 @@ CODE:
 	RETVAL = ibrd(ud, buf, cnt);
 	if( ( RETVAL & ERR ) == 0 )
 	{
-		for( i = 0; i < ThreadIbcntl(); i++ )
+		count = ThreadIbcntl();
+		av_extend( array, count - 1 );
+		for( i = 0; i < count; i++ )
 		{
-			av_push( array, newSViv( buf[ i ] & 0xff ) );
+			av_store( array, i, newSViv( buf[ i ] & 0xff ) );
 		}
 	}
 	free( buf );
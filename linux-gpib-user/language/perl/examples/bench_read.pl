@@ -0,0 +1,49 @@
+#!/usr/bin/perl
+#
+# Times MB-scale reads with ibrd() into a reused scalar, ibrd() followed by
+# unpack(), and ibrdi(), and prints MB/s for each.  Meant to be run on the
+# emulated board set up by test/runemu, with the emulated instrument
+# talking GPIB_LENGTH byte messages:
+#
+#   RESPONSE=1048576 ../../../test/runemu perl bench_read.pl
+#
+# GPIB_MINOR, GPIB_PAD, GPIB_LENGTH and GPIB_LOOPS select the board,
+# device, bytes per read and reads per test.
+
+use strict;
+use warnings;
+use Time::HiRes qw(time);
+use LinuxGpib;
+
+my $minor = $ENV{GPIB_MINOR} // 0;
+my $pad = $ENV{GPIB_PAD} // 1;
+my $length = $ENV{GPIB_LENGTH} // 0x100000;
+my $loops = $ENV{GPIB_LOOPS} // 8;
+
+my $ERR = 0x8000;
+my $T30s = 14;
+
+my $ud = LinuxGpib::ibdev($minor, $pad, 0, $T30s, 1, 0);
+die "ibdev failed\n" if $ud < 0;
+
+sub bench {
+	my ($what, $read) = @_;
+	my $start = time;
+	for (1 .. $loops) {
+		die "$what failed, iberr " . LinuxGpib::ThreadIberr() . "\n"
+			if $read->() & $ERR;
+	}
+	printf "%-14s %10.2f MB/s\n", $what, $length * $loops / (time - $start) / 1e6;
+}
+
+my $buffer;
+my @bytes;
+bench("ibrd", sub { LinuxGpib::ibrd($ud, $buffer, $length) });
+bench("ibrd+unpack", sub {
+	my $status = LinuxGpib::ibrd($ud, $buffer, $length);
+	@bytes = unpack("C*", $buffer);
+	return $status;
+});
+bench("ibrdi", sub { LinuxGpib::ibrdi($ud, \@bytes, $length) });
+
+LinuxGpib::ibonl($ud, 0);
@@ -0,0 +1,90 @@
+import asyncio
+import os
+
+import gpib
+from Gpib import Gpib
+
+
+class AsyncGpib(Gpib):
+	'''A Gpib object whose io can be awaited from an asyncio event loop:
+
+		dev = AsyncGpib(0, 1)
+		await dev.write(b"*IDN?")
+		print(await dev.read())
+
+	Each operation is started with the C library's asynchronous calls
+	(ibwrta(), ibrda(), ibwaita()) and the event loop watches the
+	descriptor's completion fd, so no executor threads are tied up while
+	an instrument is busy.  The C library does run each pending
+	operation in a thread of its own, so a program awaiting hundreds of
+	instruments at once has hundreds of threads.  Only one operation may
+	be in progress on a descriptor at a time, later ones wait their turn.
+	wait() and wait_srq() raise gpib.GpibError if the descriptor's
+	timeout is TNONE.
+
+	Cancelling an awaiting task calls ibstop() from an executor thread.
+	That can't interrupt a transfer or wait already in the driver, so the
+	operation still runs until it ends by itself, at the latest at the
+	descriptor's timeout, and the task only finishes cancelling then.
+	With a timeout of TNONE that may be never.'''
+
+	def __init__(self, *args, **kwargs):
+		Gpib.__init__(self, *args, **kwargs)
+		self._fd = gpib.completion_fd(self.id)
+		self._lock = asyncio.Lock()
+
+	async def _complete(self):
+		loop = asyncio.get_running_loop()
+		ready = loop.create_future()
+		loop.add_reader(self._fd, lambda: ready.done() or ready.set_result(None))
+		try:
+			await ready
+		except asyncio.CancelledError:
+			# ibstop() joins the operation, which may block until it
+			# times out, so it mustn't run on the event loop's thread
+			stopping = loop.run_in_executor(None, gpib.stop, self.id)
+			while not stopping.done():
+				try:
+					await asyncio.shield(stopping)
+				except asyncio.CancelledError:
+					pass
+				except gpib.GpibError:
+					pass
+			raise
+		finally:
+			loop.remove_reader(self._fd)
+			try:
+				os.read(self._fd, 8)
+			except BlockingIOError:
+				pass
+		# the operation has finished, so this only collects its result
+		gpib.wait(self.id, gpib.CMPL)
+		return gpib.ibcnt()
+
+	async def write(self,data):
+		async with self._lock:
+			gpib.write_async(self.id, data)
+			await self._complete()
+
+	async def readinto(self,buf):
+		async with self._lock:
+			gpib.read_async(self.id, buf)
+			self.res = await self._complete()
+		return self.res
+
+	async def read(self,len=512):
+		buf = bytearray(len)
+		count = await self.readinto(buf)
+		self.res = bytes(buf[:count])
+		return self.res
+
+	# returns the status the wait ended with
+	async def wait(self,mask):
+		async with self._lock:
+			gpib.wait_async(self.id, mask)
+			self.res = await self._complete()
+		return self.res
+
+	# board only: wait for a service request, or the board's timeout
+	async def wait_srq(self):
+		return await self.wait(gpib.SRQI | gpib.TIMO)
@@ -59,6 +59,26 @@ class Gpib(object):
 		self.res = gpib.read(self.id,len)
 		return self.res
 
+	def readinto(self,buf,len=-1):
+		self.res = gpib.readinto(self.id,buf,len)
+		return self.res
+
+	def read_block(self,len=-1):
+		self.res = gpib.read_block(self.id,len)
+		return self.res
+
+	def read_block_into(self,buf):
+		self.res = gpib.read_block_into(self.id,buf)
+		return self.res
+
+	# the block's data as a memoryview, which numpy.frombuffer() takes without copying
+	def read_block_view(self,len=-1):
+		if len < 0:
+			return memoryview(gpib.read_block(self.id))
+		buf = bytearray(len)
+		count = gpib.read_block_into(self.id,buf)
+		return memoryview(buf)[:count]
+
 	def listener(self,pad,sad=0):
 		self.res = gpib.listener(self.id,pad,sad)
 		return self.res
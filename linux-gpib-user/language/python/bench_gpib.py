@@ -0,0 +1,57 @@
+# Benchmarks of the buffer protocol calls of the gpib module against the
+# ones which allocate a new object per call, using pytest-benchmark.  They
+# need a board with a device which talks LENGTH byte messages and accepts
+# writes, such as the emulated board set up by test/runemu:
+#
+#   RESPONSE=65536 ../../test/runemu pytest bench_gpib.py
+#
+# GPIB_MINOR, GPIB_PAD and GPIB_LENGTH select the board, the device and
+# the transfer length.
+
+import os
+
+import pytest
+
+import gpib
+
+pytest.importorskip("pytest_benchmark")
+
+MINOR = int(os.environ.get("GPIB_MINOR", "0"))
+PAD = int(os.environ.get("GPIB_PAD", "1"))
+LENGTH = int(os.environ.get("GPIB_LENGTH", "65536"))
+
+
+@pytest.fixture(scope="module")
+def device():
+	try:
+		ud = gpib.dev(MINOR, PAD, 0, gpib.T3s)
+	except gpib.GpibError as e:
+		pytest.skip("no device to benchmark against: %s" % e)
+	yield ud
+	gpib.close(ud)
+
+
+def test_read(benchmark, device):
+	data = benchmark(gpib.read, device, LENGTH)
+	assert len(data) == LENGTH
+
+
+def test_readinto_bytearray(benchmark, device):
+	buf = bytearray(LENGTH)
+	assert benchmark(gpib.readinto, device, buf) == LENGTH
+
+
+def test_readinto_numpy(benchmark, device):
+	numpy = pytest.importorskip("numpy")
+	buf = numpy.empty(LENGTH, dtype=numpy.uint8)
+	assert benchmark(gpib.readinto, device, buf) == LENGTH
+
+
+def test_write_bytes(benchmark, device):
+	benchmark(gpib.write, device, bytes(LENGTH))
+
+
+def test_write_memoryview(benchmark, device):
+	# a slice of a larger buffer, which write() used to have to copy
+	data = bytearray(2 * LENGTH)
+	benchmark(gpib.write, device, memoryview(data)[LENGTH:])
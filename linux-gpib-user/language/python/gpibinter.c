@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static PyObject *GpibError;
@@ -276,24 +277,180 @@ static PyObject* gpib_read(PyObject *self, PyObject *args)
 	return retval;
 }
 
+static char gpib_readinto__doc__[] =
+	"readinto -- read data bytes into a buffer (board or device)\n"
+	"readinto(handle, buffer [, num_bytes]) -> num_bytes_read\n"
+	"buffer may be any writable object supporting the buffer protocol,\n"
+	"such as a bytearray, a numpy array or an mmap.  The data is read\n"
+	"straight into it, up to num_bytes or the size of the buffer.";
+
+static PyObject* gpib_readinto(PyObject *self, PyObject *args)
+{
+	int device;
+	Py_buffer buffer;
+	Py_ssize_t len = -1;
+	int sta;
+
+	if (!PyArg_ParseTuple(args, "iw*|n:readinto", &device, &buffer, &len))
+		return NULL;
+
+	if (len < 0 || len > buffer.len)
+		len = buffer.len;
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibrd(device, buffer.buf, len);
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&buffer);
+	if (sta & ERR)
+	{
+		_SetGpibError("readinto");
+		return NULL;
+	}
+
+	return PyInt_FromLong(ThreadIbcntl());
+}
+
+static char gpib_read_block__doc__[] =
+	"read_block -- read an IEEE 488.2 definite or indefinite length block (board or device)\n"
+	"read_block(handle [, num_bytes]) -> string\n"
+	"Returns the data of the block without its \"#<n><length>\" header.\n"
+	"Without num_bytes the whole block is read, however long it is.";
+
+struct block_data {
+	char *data;
+	long length;
+	long size;
+	int no_memory;
+};
+
+static int gpib_read_block_chunk(void *context, const void *data, long count, long block_length)
+{
+	struct block_data *block = context;
+
+	if (block->length + count > block->size) {
+		long size = block->size ? block->size * 2 : 0x10000;
+		char *new_data;
+
+		if (block_length > size)
+			size = block_length;
+		while (size < block->length + count)
+			size *= 2;
+		new_data = realloc(block->data, size);
+		if (new_data == NULL) {
+			block->no_memory = 1;
+			return -1;
+		}
+		block->data = new_data;
+		block->size = size;
+	}
+	memcpy(&block->data[block->length], data, count);
+	block->length += count;
+	return 0;
+}
+
+static PyObject* gpib_read_block(PyObject *self, PyObject *args)
+{
+	int device;
+	int len = -1;
+	int sta;
+	PyObject *retval;
+
+	if (!PyArg_ParseTuple(args, "i|i:read_block", &device, &len))
+		return NULL;
+
+	if (len < 0) {
+		struct block_data block = {NULL, 0, 0, 0};
+
+		Py_BEGIN_ALLOW_THREADS
+		sta = ibrdblkcb(device, gpib_read_block_chunk, &block);
+		Py_END_ALLOW_THREADS
+
+		if (sta & ERR) {
+			free(block.data);
+			if (block.no_memory)
+				return PyErr_NoMemory();
+			_SetGpibError("read_block");
+			return NULL;
+		}
+		retval = PyString_FromStringAndSize(block.data, block.length);
+		free(block.data);
+		return retval;
+	}
+
+	/* read straight into the string, like read() */
+	retval = PyString_FromStringAndSize(NULL, len);
+	if (retval == NULL)
+	{
+		PyErr_SetString(GpibError, "Read Error: can't get Memory.");
+		return NULL;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibrdblk(device, PyString_AS_STRING(retval), len);
+	Py_END_ALLOW_THREADS
+
+	if (sta & ERR)
+	{
+		_SetGpibError("read_block");
+		Py_DECREF(retval);
+		return NULL;
+	}
+
+	_PyString_Resize(&retval, ThreadIbcntl());
+	return retval;
+}
+
+static char gpib_read_block_into__doc__[] =
+	"read_block_into -- read an IEEE 488.2 block into a buffer (board or device)\n"
+	"read_block_into(handle, buffer) -> num_bytes_read\n"
+	"Like read_block(), but the data of the block goes straight into buffer,\n"
+	"which may be any writable object supporting the buffer protocol.";
+
+static PyObject* gpib_read_block_into(PyObject *self, PyObject *args)
+{
+	int device;
+	Py_buffer buffer;
+	int sta;
+
+	if (!PyArg_ParseTuple(args, "iw*:read_block_into", &device, &buffer))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibrdblk(device, buffer.buf, buffer.len);
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&buffer);
+	if (sta & ERR)
+	{
+		_SetGpibError("read_block_into");
+		return NULL;
+	}
+
+	return PyInt_FromLong(ThreadIbcntl());
+}
+
 static char gpib_write__doc__[] =
 	"write -- write data bytes (board or device)\n"
-	"write(handle, data)";
+	"write(handle, data)\n"
+	"data may be a string or any object supporting the buffer protocol,\n"
+	"such as bytes, a bytearray, a memoryview or a numpy array, which is\n"
+	"written without being copied.";
 
 static PyObject* gpib_write(PyObject *self, PyObject *args)
 {
-	char *command;
-	Py_ssize_t command_len;
+	Py_buffer command;
 	int  device;
 	int sta;
 
-	if (!PyArg_ParseTuple(args, "is#:write",&device, &command, &command_len))
+	if (!PyArg_ParseTuple(args, "is*:write", &device, &command))
 		return NULL;
 
 	Py_BEGIN_ALLOW_THREADS
-	sta = ibwrt(device, command, command_len);
+	sta = ibwrt(device, command.buf, command.len);
 	Py_END_ALLOW_THREADS
 
+	PyBuffer_Release(&command);
 	if( sta & ERR ){
 		_SetGpibError("write");
 		return NULL;
@@ -304,22 +461,24 @@ static PyObject* gpib_write(PyObject *self, PyObject *args)
 
 static char gpib_write_async__doc__[] =
 	"write_async -- write data bytes asynchronously (board or device)\n"
-	"write_async(handle, data)";
+	"write_async(handle, data)\n"
+	"data is written in place, so it must be kept alive and unchanged until\n"
+	"wait(handle, CMPL) or stop(handle) returns.";
 
 static PyObject* gpib_write_async(PyObject *self, PyObject *args)
 {
-	char *command;
-	Py_ssize_t  command_len;
+	Py_buffer command;
 	int  device;
 	int  sta;
 
-	if (!PyArg_ParseTuple(args, "is#:write_async", &device, &command, &command_len))
+	if (!PyArg_ParseTuple(args, "is*:write_async", &device, &command))
 		return NULL;
 
 	Py_BEGIN_ALLOW_THREADS
-	sta = ibwrta(device, command, command_len);
+	sta = ibwrta(device, command.buf, command.len);
 	Py_END_ALLOW_THREADS
 
+	PyBuffer_Release(&command);
 	if( sta & ERR ){
 		_SetGpibError("write_async");
 		return NULL;
@@ -328,6 +487,35 @@ static PyObject* gpib_write_async(PyObject *self, PyObject *args)
 	return PyInt_FromLong(sta);
 }
 
+static char gpib_read_async__doc__[] =
+	"read_async -- read data bytes asynchronously into a buffer (board or device)\n"
+	"read_async(handle, buffer)\n"
+	"buffer is filled in place, so it must be kept alive and must not be\n"
+	"resized until wait(handle, CMPL) or stop(handle) returns.  ibcnt() then\n"
+	"gives the number of bytes read.";
+
+static PyObject* gpib_read_async(PyObject *self, PyObject *args)
+{
+	Py_buffer buffer;
+	int device;
+	int sta;
+
+	if (!PyArg_ParseTuple(args, "iw*:read_async", &device, &buffer))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibrda(device, buffer.buf, buffer.len);
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&buffer);
+	if (sta & ERR)
+	{
+		_SetGpibError("read_async");
+		return NULL;
+	}
+
+	return PyInt_FromLong(sta);
+}
 
 static char gpib_command__doc__[] =
 	"command -- write command bytes (board)\n"
@@ -505,6 +693,75 @@ static PyObject* gpib_wait(PyObject *self, PyObject *args)
 	return PyInt_FromLong(sta);
 }
 
+static char gpib_wait_async__doc__[] =
+	"wait_async -- wait for event asynchronously (board or device)\n"
+	"wait_async(handle, mask)\n"
+	"Once wait(handle, CMPL) returns, ibcnt() gives the status the wait ended with.";
+
+static PyObject* gpib_wait_async(PyObject *self, PyObject *args)
+{
+	int device;
+	int mask;
+	int sta;
+
+	if (!PyArg_ParseTuple(args, "ii:wait_async", &device, &mask))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibwaita(device, mask);
+	Py_END_ALLOW_THREADS
+
+	if(sta & ERR) {
+		_SetGpibError("wait_async");
+		return NULL;
+	}
+
+	return PyInt_FromLong(sta);
+}
+
+static char gpib_stop__doc__[] =
+	"stop -- abort asynchronous operation (board or device)\n"
+	"stop(handle)";
+
+static PyObject* gpib_stop(PyObject *self, PyObject *args)
+{
+	int device;
+	int sta;
+
+	if (!PyArg_ParseTuple(args, "i:stop", &device))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	sta = ibstop(device);
+	Py_END_ALLOW_THREADS
+
+	return PyInt_FromLong(sta);
+}
+
+static char gpib_completion_fd__doc__[] =
+	"completion_fd -- file descriptor signalled when asynchronous operations complete (board or device)\n"
+	"completion_fd(handle) -> fd\n"
+	"The descriptor becomes readable as each asynchronous operation on handle\n"
+	"completes, and is reset by reading 8 bytes from it.  It belongs to the\n"
+	"handle and is closed along with it.";
+
+static PyObject* gpib_completion_fd(PyObject *self, PyObject *args)
+{
+	int device;
+	int fd;
+
+	if (!PyArg_ParseTuple(args, "i:completion_fd", &device))
+		return NULL;
+
+	if (ibcompletion_fd(device, &fd) & ERR)
+	{
+		_SetGpibError("completion_fd");
+		return NULL;
+	}
+
+	return PyInt_FromLong(fd);
+}
+
 static char gpib_timeout__doc__[] =
 	"timeout -- adjust io timeout (board or device)\n"
 	"timeout(handle, timeout)\n\n"
@@ -644,14 +901,21 @@ static struct PyMethodDef gpib_methods[] = {
 	{"listener",		gpib_listener,		METH_VARARGS,	gpib_listener__doc__},
 	{"lines",		gpib_lines, 	METH_VARARGS,	gpib_lines__doc__},
 	{"read",		gpib_read,		METH_VARARGS,	gpib_read__doc__},
+	{"readinto",		gpib_readinto,		METH_VARARGS,	gpib_readinto__doc__},
+	{"read_block",		gpib_read_block,	METH_VARARGS,	gpib_read_block__doc__},
+	{"read_block_into",	gpib_read_block_into,	METH_VARARGS,	gpib_read_block_into__doc__},
 	{"write",		gpib_write,		METH_VARARGS,	gpib_write__doc__},
 	{"write_async",		gpib_write_async,	METH_VARARGS,	gpib_write_async__doc__},
+	{"read_async",		gpib_read_async,	METH_VARARGS,	gpib_read_async__doc__},
 	{"command",		gpib_command,		METH_VARARGS,	gpib_command__doc__},
 	{"remote_enable",	gpib_remote_enable,	METH_VARARGS,	gpib_remote_enable__doc__},
 	{"clear",		gpib_clear,		METH_VARARGS,	gpib_clear__doc__},
 	{"interface_clear",	gpib_interface_clear,	METH_VARARGS,	gpib_interface_clear__doc__},
 	{"close",		gpib_close,		METH_VARARGS,	gpib_close__doc__},
 	{"wait",		gpib_wait,		METH_VARARGS,	gpib_wait__doc__},
+	{"wait_async",		gpib_wait_async,	METH_VARARGS,	gpib_wait_async__doc__},
+	{"stop",		gpib_stop,		METH_VARARGS,	gpib_stop__doc__},
+	{"completion_fd",	gpib_completion_fd,	METH_VARARGS,	gpib_completion_fd__doc__},
 	{"timeout",		gpib_timeout,		METH_VARARGS,	gpib_timeout__doc__},
 	{"serial_poll",		gpib_serial_poll,	METH_VARARGS,	gpib_serial_poll__doc__},
 	{"spoll_bytes",		gpib_spoll_bytes,	METH_VARARGS,	gpib_spoll_bytes_doc__},
@@ -758,6 +1022,7 @@ initgpib(void)
 	PyModule_AddIntConstant(m, "IbcIst", IbcIst);
 	PyModule_AddIntConstant(m, "IbcRsv", IbcRsv);
 	PyModule_AddIntConstant(m, "IbcBNA", IbcBNA);
+	PyModule_AddIntConstant(m, "IbcDMAThreshold", IbcDMAThreshold);
 
 	/* ibask() option values */
 	PyModule_AddIntConstant(m, "IbaPAD", IbaPAD);
@@ -790,10 +1055,13 @@ initgpib(void)
 	PyModule_AddIntConstant(m, "IbaRsv", IbaRsv);
 	PyModule_AddIntConstant(m, "IbaBNA", IbaBNA);
 	PyModule_AddIntConstant(m, "Iba7BitEOS", Iba7BitEOS);
+	PyModule_AddIntConstant(m, "IbaDMAThreshold", IbaDMAThreshold);
 	/* ibwait() condition bits */
 	PyModule_AddIntConstant(m, "RQS", RQS);
 	PyModule_AddIntConstant(m, "SRQI", SRQI);
 	PyModule_AddIntConstant(m, "TIMO", TIMO);
+	PyModule_AddIntConstant(m, "END", END);
+	PyModule_AddIntConstant(m, "CMPL", CMPL);
 	/* GPIB status byte bits */
 	PyModule_AddIntConstant(m, "IbStbRQS", IbStbRQS);
 	PyModule_AddIntConstant(m, "IbStbESB", IbStbESB);
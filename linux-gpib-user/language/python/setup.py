@@ -7,7 +7,7 @@ else:
 setup(name="gpib",
 	version="1.0",
 	description="Linux GPIB Python Bindings",
-	py_modules = ['Gpib'],
+	py_modules = ['Gpib', 'AsyncGpib'],
 	ext_modules=[
 		Extension("gpib",
 		["gpibinter.c"],
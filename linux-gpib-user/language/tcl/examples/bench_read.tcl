@@ -0,0 +1,40 @@
+#!/usr/bin/tclsh
+#
+# Times MB-scale reads with "gpib read", alone and followed by
+# "binary scan", and prints MB/s for each.  Meant to be run on the
+# emulated board set up by test/runemu, with the emulated instrument
+# talking GPIB_LENGTH byte messages:
+#
+#   RESPONSE=1048576 ../../../test/runemu tclsh bench_read.tcl
+#
+# GPIB_MINOR, GPIB_PAD, GPIB_LENGTH and GPIB_LOOPS select the board,
+# device, bytes per read and reads per test.
+
+load ../libgpib_tcl.so
+
+proc env_default { name value } {
+	global env
+	if { [info exists env($name)] } {
+		return $env($name)
+	}
+	return $value
+}
+
+set minor [env_default GPIB_MINOR 0]
+set pad [env_default GPIB_PAD 1]
+set length [env_default GPIB_LENGTH 1048576]
+set loops [env_default GPIB_LOOPS 8]
+
+# T30s, send EOI, no EOS
+set device [gpib dev $minor $pad 0 14 1 0]
+
+proc bench { what script } {
+	global length loops
+	set usec [lindex [uplevel #0 [list time $script $loops]] 0]
+	puts [format "%-14s %10.2f MB/s" $what [expr { $length / $usec }]]
+}
+
+bench "read" { gpib read $device $length }
+bench "read+scan" { binary scan [gpib read $device $length] cu* bytes }
+
+gpib online $device 0
@@ -60,7 +60,8 @@ int ibCmd _ANSI_ARGS_((ClientData clientData, Tcl_Interp *interp, int argc,const
 int ibRead  _ANSI_ARGS_((ClientData clientData, Tcl_Interp *interp, int argc,const char*argv[])){
 
 
-  char *buf;
+  Tcl_Obj *result;
+  unsigned char *buf;
 
   int len;
 	int desc;
@@ -72,33 +73,33 @@ int ibRead  _ANSI_ARGS_((ClientData clientData, Tcl_Interp *interp, int argc,con
 
 	desc = strtol(argv[1], NULL, 0);
 	len = strtol(argv[2], NULL, 0);
-  
-
-  if ((buf = (char *)malloc( len + 1 )) == NULL) {
-    Tcl_SetResult(interp, "Error: Out of Memory", TCL_STATIC);
+  if( len < 0 ){
+    Tcl_SetResult(interp, "Error: read <dev> <num bytes>", TCL_STATIC);
     return TCL_ERROR;
   }
 
+  /* read straight into a byte array, which keeps NULs and binary data
+     and is returned without another copy */
+  result = Tcl_NewObj();
+  buf = Tcl_SetByteArrayLength( result, len );
 
   if( ibrd( desc , buf, len ) & ERR ){
 /*  ib_CreateVerboseError(interp,"ibrd");
     return TCL_ERROR;
 */
 
+  Tcl_DecrRefCount( result );
   Tcl_AppendResult(interp, "ERROR" , (char *) NULL );
-  free(buf);
 
   return TCL_ERROR;
   }
 
 
-  buf[ibcnt] = '\0';
-  Tcl_AppendResult(interp, buf, (char *) NULL );
-  free(buf);
+  Tcl_SetByteArrayLength( result, ThreadIbcntl() );
+  Tcl_SetObjResult( interp, result );
 
   return TCL_OK;
 }
-
 /**********************************************************************/
 
 int ibDev _ANSI_ARGS_((ClientData clientData, Tcl_Interp *interp, int argc, const char *argv[]))
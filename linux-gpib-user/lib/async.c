@@ -19,6 +19,8 @@
 #include <sys/ioctl.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
 
 static void* do_aio(void *varg);
 
@@ -43,6 +45,7 @@ void init_async_op(struct async_operation *async)
 	async->ibcntl = 0;
 	async->in_progress = 0;
 	async->abort = 0;
+	async->notify_fd = -1;
 }
 
 static void cleanup_aio(void *varg)
@@ -50,8 +53,12 @@ static void cleanup_aio(void *varg)
 	struct gpib_aio_arg arg = *((struct gpib_aio_arg*) varg);
 	ibBoard_t *board = interfaceBoard(arg.conf);
 	ibstatus(arg.conf, 0, 0, CMPL); // set CMPL flag
-	int retval = unlock_board_mutex(board);
-	assert(retval == 0);
+	if (arg.gpib_aio_type != GPIB_AIO_WAIT) {
+		int retval = unlock_board_mutex(board);
+		assert(retval == 0);
+	}
+	if (arg.conf->async.notify_fd >= 0)
+		eventfd_write(arg.conf->async.notify_fd, 1);
 }
 
 int gpib_aio_launch(int ud, ibConf_t *conf, int gpib_aio_type,
@@ -122,7 +129,11 @@ static void* do_aio(void *varg)
 	conf = arg.conf;
 	usec_timeout = arg.usec_timeout;
 	board = interfaceBoard(conf);
-	retval = lock_board_mutex(board);
+	// a wait doesn't use the bus, so it mustn't hold up io on the board
+	if (arg.gpib_aio_type == GPIB_AIO_WAIT)
+		retval = 0;
+	else
+		retval = lock_board_mutex(board);
 	if (retval == 0)
 		ibstatus(conf, 0, CMPL, 0);  // clear CMPL flag
 
@@ -150,6 +161,18 @@ static void* do_aio(void *varg)
 	case GPIB_AIO_WRITE:
 		retval = my_ibwrt(conf, usec_timeout, conf->async.buffer, conf->async.buffer_length, &count);
 		break;
+	case GPIB_AIO_WAIT:
+	{
+		// the wait mask is passed as the count, and the status is returned in ibcnt
+		int mask = conf->async.buffer_length;
+		int status = 0;
+
+		/* Cancelling doesn't wake the driver's wait, so always let it time out,
+		 * or ibstop() could block forever joining this thread. */
+		retval = my_wait(conf, mask | TIMO, mask & (DTAS | DCAS | SPOLL), 0, &status);
+		count = status;
+		break;
+	}
 	default:
 		retval = -1;
 		fprintf(stderr, "libgpib: bug! in %s\n", __FUNCTION__);
@@ -168,8 +191,12 @@ static void* do_aio(void *varg)
 		conf->async.ibcntl = count;
 		conf->async.iberr = 0;
 		conf->async.ibsta = CMPL;
-		if (conf->end) conf->async.ibsta |= END;
-		if (conf->timed_out) conf->async.ibsta |= TIMO;
+		if (arg.gpib_aio_type == GPIB_AIO_WAIT) {
+			if (count & TIMO) conf->async.ibsta |= TIMO;
+		} else {
+			if (conf->end) conf->async.ibsta |= END;
+			if (conf->timed_out) conf->async.ibsta |= TIMO;
+		}
 	}
 	pthread_mutex_unlock(&conf->async.lock);
 	pthread_cleanup_pop(1);
@@ -201,3 +228,33 @@ int gpib_aio_join(struct async_operation *async)
 	}
 	return retval;
 }
+
+/* Descriptor which becomes readable when an asynchronous operation on ud completes.
+ * Reading the eventfd resets it.  It is closed when ud is released.
+ */
+int ibcompletion_fd(int ud, int *fd)
+{
+	ibConf_t *conf;
+
+	conf = general_enter_library(ud, 1, 1);
+	if (!conf)
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+
+	if (fd == NULL) {
+		setIberr(EARG);
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+	}
+
+	pthread_mutex_lock(&conf->async.lock);
+	if (conf->async.notify_fd < 0)
+		conf->async.notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	*fd = conf->async.notify_fd;
+	pthread_mutex_unlock(&conf->async.lock);
+	if (*fd < 0) {
+		setIberr(EDVR);
+		setIbcnt(errno);
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+	}
+
+	return general_exit_library(ud, 0, 0, 0, 0, 0, 1);
+}
@@ -431,6 +431,8 @@ int main(int argc, char *argv[])
 		return retval;
 	}
 
+	/* refresh the binary cache, so library users need not parse the file */
+	gpib_conf_cache_update(filename);
 
 	for (i = 0;i < FIND_CONFIGS_LENGTH;i++) {
 		if (configs[i].is_interface == 0)
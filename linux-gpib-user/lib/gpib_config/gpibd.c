@@ -0,0 +1,125 @@
+/***************************************************************************
+                              gpibd.c
+                             -------------------
+
+    Configuration daemon.  Parses the configuration file, initializes
+    every device in it once and hands the parsed configuration to each
+    process which starts using libgpib while it runs, so short lived
+    clients skip parsing the configuration and initializing the devices.
+    Clients still open the boards and devices themselves.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "ib_internal.h"
+
+static volatile sig_atomic_t quit;
+
+static void help(void)
+{
+	printf("gpibd [options] - shares the parsed GPIB configuration with libgpib clients\n");
+	printf("\t-d, --daemon\n"
+		"\t\tDetach from the terminal and run in the background.\n");
+	printf("\t-h, --help\n"
+		"\t\tPrint this help and exit.\n");
+	printf("\t-s, --socket FILE_PATH\n"
+		"\t\tListen on unix socket FILE_PATH instead of %s\n", gpibd_socket_path());
+}
+
+static void quit_handler(int sig)
+{
+	quit = 1;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"daemon", no_argument, NULL, 'd'},
+		{"help", no_argument, NULL, 'h'},
+		{"socket", required_argument, NULL, 's'},
+		{0, 0, 0, 0}
+	};
+	const char *socket_path = NULL;
+	int run_as_daemon = 0;
+	struct sigaction action;
+	int sock;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "dhs:", options, NULL)) != -1) {
+		switch (c) {
+		case 'd':
+			run_as_daemon = 1;
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 's':
+			socket_path = optarg;
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+	if (socket_path == NULL)
+		socket_path = gpibd_socket_path();
+
+	if (gpibd_init_devices() < 0) {
+		fprintf(stderr, "gpibd: failed to parse configuration: %s\n",
+			gpib_error_string(ThreadIberr()));
+		return 1;
+	}
+
+	sock = gpibd_listen(socket_path);
+	if (sock < 0) {
+		perror("gpibd: failed to listen on socket");
+		return 1;
+	}
+
+	if (run_as_daemon && daemon(0, 0) < 0) {
+		perror("gpibd: daemon");
+		unlink(socket_path);
+		return 1;
+	}
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+	action.sa_handler = quit_handler;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+
+	while (quit == 0) {
+		int client = accept4(sock, NULL, NULL, SOCK_CLOEXEC);
+
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			perror("gpibd: accept");
+			break;
+		}
+		if (gpibd_send_config(client) < 0)
+			perror("gpibd: failed to send configuration");
+		close(client);
+	}
+
+	close(sock);
+	unlink(socket_path);
+	return 0;
+}
@@ -0,0 +1,204 @@
+/***************************************************************************
+                          lib/ibAdjust.c
+                             -------------------
+
+    Byte swapping of read and write data for IbcReadAdjust and
+    IbcWriteAdjust.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADJUST_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static size_t swap_pairs_scalar(uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t i;
+
+	for (i = 0; i + 2 <= length; i += 2) {
+		uint16_t word;
+
+		memcpy(&word, &src[i], sizeof(word));
+		word = __builtin_bswap16(word);
+		memcpy(&dst[i], &word, sizeof(word));
+	}
+	return i;
+}
+
+static size_t swap_quads_scalar(uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t i;
+
+	for (i = 0; i + 4 <= length; i += 4) {
+		uint32_t word;
+
+		memcpy(&word, &src[i], sizeof(word));
+		word = __builtin_bswap32(word);
+		memcpy(&dst[i], &word, sizeof(word));
+	}
+	return i;
+}
+
+#ifdef ADJUST_X86
+
+/* pshufb masks, each byte selects the source byte moved into its place */
+#define PAIRS_MASK 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+#define QUADS_MASK 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+
+__attribute__((target("avx2")))
+static size_t shuffle_avx2(uint8_t *dst, const uint8_t *src, size_t length, int quads)
+{
+	const __m256i mask = quads ?
+		_mm256_set_epi8(QUADS_MASK, QUADS_MASK) : _mm256_set_epi8(PAIRS_MASK, PAIRS_MASK);
+	size_t i;
+
+	for (i = 0; i + 32 <= length; i += 32) {
+		__m256i data = _mm256_loadu_si256((const __m256i *)&src[i]);
+
+		_mm256_storeu_si256((__m256i *)&dst[i], _mm256_shuffle_epi8(data, mask));
+	}
+	return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t shuffle_ssse3(uint8_t *dst, const uint8_t *src, size_t length, int quads)
+{
+	const __m128i mask = quads ? _mm_set_epi8(QUADS_MASK) : _mm_set_epi8(PAIRS_MASK);
+	size_t i;
+
+	for (i = 0; i + 16 <= length; i += 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)&src[i]);
+
+		_mm_storeu_si128((__m128i *)&dst[i], _mm_shuffle_epi8(data, mask));
+	}
+	return i;
+}
+
+static size_t shuffle_vector(uint8_t *dst, const uint8_t *src, size_t length, int quads)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return shuffle_avx2(dst, src, length, quads);
+	if (__builtin_cpu_supports("ssse3"))
+		return shuffle_ssse3(dst, src, length, quads);
+	return 0;
+}
+
+#elif defined(__ARM_NEON)
+
+static size_t shuffle_vector(uint8_t *dst, const uint8_t *src, size_t length, int quads)
+{
+	size_t i;
+
+	for (i = 0; i + 16 <= length; i += 16) {
+		uint8x16_t data = vld1q_u8(&src[i]);
+
+		vst1q_u8(&dst[i], quads ? vrev32q_u8(data) : vrev16q_u8(data));
+	}
+	return i;
+}
+
+#else
+
+static size_t shuffle_vector(uint8_t *dst, const uint8_t *src, size_t length, int quads)
+{
+	return 0;
+}
+
+#endif
+
+/*
+ * Copies length bytes from src to dst, reversing the byte order of each
+ * 16 bit (SWAP_PAIRS) or 32 bit (SWAP_QUADS) word.  Trailing bytes which do
+ * not fill a whole word are copied unchanged.  dst may equal src.
+ */
+void byte_adjust(int mode, uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t done = 0;
+
+	switch (mode) {
+	case SWAP_PAIRS:
+		done = shuffle_vector(dst, src, length, 0);
+		done += swap_pairs_scalar(&dst[done], &src[done], length - done);
+		break;
+	case SWAP_QUADS:
+		done = shuffle_vector(dst, src, length, 1);
+		done += swap_quads_scalar(&dst[done], &src[done], length - done);
+		break;
+	default:
+		break;
+	}
+	if (dst != src)
+		memmove(&dst[done], &src[done], length - done);
+}
+
+/*
+ * Swaps the first length bytes of the segments in place as one buffer, so
+ * a word may be split between two segments.  As with byte_adjust(), bytes
+ * which do not fill a whole word at the end are left unchanged.
+ */
+void byte_adjust_iovec(int mode, const struct iovec *iov, int iovcnt, size_t length)
+{
+	size_t word_size = mode == SWAP_QUADS ? 4 : 2;
+	uint8_t *split_word[4];
+	size_t num_split = 0;
+	int i;
+
+	if (mode != SWAP_PAIRS && mode != SWAP_QUADS)
+		return;
+	for (i = 0; i < iovcnt && length; i++) {
+		uint8_t *data = iov[i].iov_base;
+		size_t count = iov[i].iov_len < length ? iov[i].iov_len : length;
+		size_t whole;
+
+		length -= count;
+		// finish a word begun in the previous segment
+		while (num_split && count) {
+			split_word[num_split++] = data++;
+			count--;
+			if (num_split == word_size) {
+				size_t j;
+
+				for (j = 0; j < word_size / 2; j++) {
+					uint8_t byte = *split_word[j];
+
+					*split_word[j] = *split_word[word_size - 1 - j];
+					*split_word[word_size - 1 - j] = byte;
+				}
+				num_split = 0;
+			}
+		}
+		whole = count - count % word_size;
+		byte_adjust(mode, data, data, whole);
+		for (data += whole, count -= whole; count; count--)
+			split_word[num_split++] = data++;
+	}
+}
+
+/* reference implementation without the vector kernels, for comparison */
+void byte_adjust_scalar(int mode, uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t done = 0;
+
+	if (mode == SWAP_PAIRS)
+		done = swap_pairs_scalar(dst, src, length);
+	else if (mode == SWAP_QUADS)
+		done = swap_quads_scalar(dst, src, length);
+	if (dst != src)
+		memmove(&dst[done], &src[done], length - done);
+}
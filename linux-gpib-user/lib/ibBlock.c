@@ -0,0 +1,222 @@
+/***************************************************************************
+                          lib/ibBlock.c
+                             -------------------
+
+    Reads of IEEE 488.2 arbitrary block response data, "#<n><length><data>"
+    definite length blocks and "#0<data>" indefinite length blocks ending
+    with END.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <errno.h>
+#include <stdint.h>
+
+#define BLOCK_CHUNK_SIZE 0x4000
+
+static int bad_block(void)
+{
+	setIberr(EDVR);
+	setIbcnt(EBADMSG);
+	return -1;
+}
+
+// sets block_length to the length of the data, or -1 for an indefinite length block
+static int read_block_header(ibConf_t *conf, unsigned int usec_timeout, long *block_length)
+{
+	uint8_t header[9];
+	size_t bytes_read;
+	unsigned int num_digits, i;
+	long length;
+
+	if (read_data_raw(conf, usec_timeout, header, 2, &bytes_read) < 0)
+		return -1;
+	if (bytes_read < 2 || header[0] != '#' || header[1] < '0' || header[1] > '9')
+		return bad_block();
+
+	num_digits = header[1] - '0';
+	if (num_digits == 0) {
+		*block_length = -1;
+		return 0;
+	}
+	if (conf->end)
+		return bad_block();
+
+	if (read_data_raw(conf, usec_timeout, header, num_digits, &bytes_read) < 0)
+		return -1;
+	if (bytes_read < num_digits)
+		return bad_block();
+	length = 0;
+	for (i = 0; i < num_digits; i++) {
+		if (header[i] < '0' || header[i] > '9')
+			return bad_block();
+		length = length * 10 + header[i] - '0';
+	}
+	*block_length = length;
+	return 0;
+}
+
+/*
+ * Reads the response message terminator following a definite length block,
+ * normally a single NL sent with EOI.  Stops early on anything else, so
+ * a following ',' or ';' separator is consumed but no more.
+ */
+static int read_block_terminator(ibConf_t *conf, unsigned int usec_timeout)
+{
+	uint8_t byte;
+	size_t bytes_read;
+
+	do {
+		if (read_data_raw(conf, usec_timeout, &byte, 1, &bytes_read) < 0)
+			return -1;
+	} while (conf->end == 0 && bytes_read == 1 && (byte == '\r' || byte == '\n'));
+	return 0;
+}
+
+static int read_block_data(ibConf_t *conf, unsigned int usec_timeout, long block_length,
+	uint8_t *buffer, size_t count,
+	int (*callback)(void *context, const void *data, long count, long block_length),
+	void *context, size_t *bytes_read)
+{
+	uint8_t chunk[BLOCK_CHUNK_SIZE];
+	size_t done = 0;
+
+	while (conf->end == 0) {
+		uint8_t *data;
+		size_t request, num_bytes;
+		int retval;
+
+		if (callback) {
+			data = chunk;
+			request = sizeof(chunk);
+		} else {
+			data = &buffer[done];
+			request = count - done;
+		}
+		if (block_length >= 0 && request > (size_t)block_length - done)
+			request = (size_t)block_length - done;
+		if (request == 0)
+			break;
+
+		retval = read_data_raw(conf, usec_timeout, data, request, &num_bytes);
+		// requests other than the last are whole words, so the swap stays aligned
+		if (conf->settings.read_adjust)
+			byte_adjust(conf->settings.read_adjust, data, data, num_bytes);
+		done += num_bytes;
+		*bytes_read = done;
+		if (callback && num_bytes && callback(context, data, num_bytes, block_length)) {
+			setIberr(EABO);
+			return -1;
+		}
+		if (retval < 0)
+			return -1;
+	}
+
+	if (block_length >= 0 && done < (size_t)block_length) {
+		// END before the end of the block
+		if (conf->end)
+			return bad_block();
+		// the caller's buffer is full, the rest is left for ibrd()
+		return 0;
+	}
+	if (block_length >= 0 && conf->end == 0)
+		return read_block_terminator(conf, usec_timeout);
+	return 0;
+}
+
+/*
+ * Reads one block with a single addressing of the device.  The data goes
+ * into buffer, or if callback is not NULL it is passed to the callback in
+ * pieces instead.
+ */
+int my_ibrdblk(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count,
+	int (*callback)(void *context, const void *data, long count, long block_length),
+	void *context, size_t *bytes_read)
+{
+	long block_length;
+	int retval;
+
+	*bytes_read = 0;
+	// the block's data may contain the eos character, only END ends it
+	if (config_read_eos(interfaceBoard(conf), 0, 0, 0) < 0)
+		return -1;
+
+	if (conf->is_interface == 0) {
+		// set up addressing
+		if (InternalReceiveSetup(conf, usec_timeout, packAddress(conf->settings.pad, conf->settings.sad)) < 0)
+			return -1;
+	}
+
+	retval = read_block_header(conf, usec_timeout, &block_length);
+	if (retval == 0)
+		retval = read_block_data(conf, usec_timeout, block_length, buffer, count,
+			callback, context, bytes_read);
+
+	if (!conf->is_interface && conf->settings.send_unt_unl) {
+		if (unlisten_untalk(conf) < 0)
+			retval = -1;
+	}
+
+	return retval;
+}
+
+int ibrdblk(int ud, void *buffer, long cnt)
+{
+	ibConf_t *conf;
+	int retval;
+	size_t bytes_read;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (cnt < 0) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+
+	retval = my_ibrdblk(conf, conf->settings.usec_timeout, buffer, cnt, NULL, NULL, &bytes_read);
+	if (retval < 0) {
+		if (ThreadIberr() != EDVR)
+			setIbcnt(bytes_read);
+		return exit_library(ud, 1);
+	}
+	setIbcnt(bytes_read);
+
+	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
+}
+
+int ibrdblkcb(int ud, int (*callback)(void *context, const void *data, long count, long block_length),
+	void *context)
+{
+	ibConf_t *conf;
+	int retval;
+	size_t bytes_read;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (callback == NULL) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+
+	retval = my_ibrdblk(conf, conf->settings.usec_timeout, NULL, 0, callback, context, &bytes_read);
+	if (retval < 0) {
+		if (ThreadIberr() != EDVR)
+			setIbcnt(bytes_read);
+		return exit_library(ud, 1);
+	}
+	setIbcnt(bytes_read);
+
+	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
+}
@@ -49,6 +49,9 @@ void init_ibboard(ibBoard_t *board)
 	strcpy(board->sysfs_device_path, "");
 	strcpy(board->serial_number, "");
 	board->set_ren_on_sc = 1;
+	board->stream_ring = NULL;
+	board->stream_map_length = 0;
+	board->stream_end_seen = 0;
 }
 
 int configure_autospoll(ibConf_t *conf, int enable)
@@ -102,6 +105,7 @@ int ibBoardClose(ibBoard_t *board)
 		return 0;
 
 	if (board->fileno >= 0)	{
+		ibstream_release(board);
 		close(board->fileno);
 		board->fileno = -1;
 	}
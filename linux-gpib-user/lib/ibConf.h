@@ -20,6 +20,7 @@
 
 #include <unistd.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <pthread.h>
 
 /* meaning for flags */
@@ -46,6 +47,7 @@ struct async_operation
 	volatile short in_progress;
 	volatile short aio_type;  /* The type of aio in progress */
 	volatile short abort;
+	int notify_fd;	/* eventfd signalled as each operation completes, -1 until ibcompletion_fd() */
 };
 
 typedef struct
@@ -63,6 +65,8 @@ typedef struct
 	unsigned local_lockout : 1;	/* send local lockout when device is brought online */
 	unsigned readdr : 1;	/* useless, exists for compatibility only at present */
 	unsigned send_unt_unl : 1;      /* flag to send untalk unlisten after ibrd/ibwrt */
+	unsigned read_adjust : 2;	/* byte swapping of read data, enum byte_adjust_mode */
+	unsigned write_adjust : 2;	/* byte swapping of written data */
 }descriptor_settings_t;
 
 typedef struct ibConfStruct
@@ -84,6 +88,8 @@ typedef struct ibConfStruct
 
 /*---------------------------------------------------------------------- */
 
+struct gpib_stream_ring;
+
 typedef struct ibBoardStruct {
 	char board_type[100];	/* name (model) of interface board */
 	unsigned long base;                          /* base configuration */
@@ -100,6 +106,9 @@ typedef struct ibBoardStruct {
 	char sysfs_device_path[0x1000];	/* sysfs device path, which may be used to select specific piece of hardware */
 	char serial_number[0x1000];	/* serial number, which may be used to select specific piece of hardware */
 	unsigned set_ren_on_sc : 1; /* enable REN when becoming system controlle */
+	struct gpib_stream_ring *stream_ring;	/* mapping of driver's stream ring while streaming */
+	size_t stream_map_length;
+	uint64_t stream_end_seen;	/* number of stream END marks consumed */
 } ibBoard_t;
 
 #endif	/* _IBCONF_H */
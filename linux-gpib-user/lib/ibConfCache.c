@@ -0,0 +1,271 @@
+/***************************************************************************
+                          lib/ibConfCache.c
+                             -------------------
+
+    Binary cache of the parsed configuration file.  Loading it is a stat()
+    of the configuration file and a copy out of a mapped file, instead of
+    lexing and parsing gpib.conf in every process.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include "ib_internal.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define GPIB_CONF_CACHE_MAGIC 0x67636663
+#define GPIB_CONF_CACHE_VERSION 2
+
+struct gpib_conf_cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t conf_size;	/* sizeof(ibConf_t) of the writer */
+	uint32_t board_size;	/* sizeof(ibBoard_t) of the writer */
+	uint32_t configs_length;
+	uint32_t board_mask;	/* configured boards, which follow the configs */
+	/* identity of the configuration file the cache was made from */
+	uint64_t source_dev;
+	uint64_t source_ino;
+	int64_t source_size;
+	int64_t source_mtime_sec;
+	int64_t source_mtime_nsec;
+	int64_t source_ctime_sec;
+	int64_t source_ctime_nsec;
+	char source_path[0x1000];
+};
+
+/*
+ * The cache for the default configuration file lives in DEFAULT_CONFIG_CACHE,
+ * which gpib_config refreshes when a board is configured.  IB_CONFIG_CACHE
+ * selects a cache for a private configuration file.
+ */
+const char *gpib_conf_cache_path(const char *config_file)
+{
+	const char *path = getenv("IB_CONFIG_CACHE");
+
+	if (path)
+		return path[0] ? path : NULL;
+	if (strcmp(config_file, DEFAULT_CONFIG_FILE) == 0)
+		return DEFAULT_CONFIG_CACHE;
+	return NULL;
+}
+
+static void fill_source_identity(struct gpib_conf_cache_header *header,
+	const char *config_file, const struct stat *st)
+{
+	header->source_dev = st->st_dev;
+	header->source_ino = st->st_ino;
+	header->source_size = st->st_size;
+	header->source_mtime_sec = st->st_mtim.tv_sec;
+	header->source_mtime_nsec = st->st_mtim.tv_nsec;
+	header->source_ctime_sec = st->st_ctim.tv_sec;
+	header->source_ctime_nsec = st->st_ctim.tv_nsec;
+	strncpy(header->source_path, config_file, sizeof(header->source_path) - 1);
+}
+
+static int count_boards(uint32_t board_mask)
+{
+	int count = 0;
+
+	for (; board_mask; board_mask &= board_mask - 1)
+		count++;
+	return count;
+}
+
+/*
+ * Fill configs[] and boards[] from the cache for config_file.  Returns 0 on
+ * success, or -1 if there is no cache or it is stale, in which case nothing
+ * has been changed.  If minor is not negative, the cache is only used if it
+ * has an interface entry for that minor.
+ */
+int gpib_conf_cache_load(const char *config_file, ibConf_t *configs, unsigned int configs_length,
+	ibBoard_t *boards, unsigned int boards_length, int minor)
+{
+	const struct gpib_conf_cache_header *header;
+	struct gpib_conf_cache_header expected;
+	const char *cache_file;
+	const ibConf_t *cached_configs;
+	const ibBoard_t *cached_boards;
+	struct stat source_st, cache_st;
+	void *map;
+	size_t map_length;
+	int retval = -1;
+	unsigned int i, j;
+	int fd;
+
+	cache_file = gpib_conf_cache_path(config_file);
+	if (cache_file == NULL || stat(config_file, &source_st) < 0)
+		return -1;
+
+	fd = open(cache_file, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &cache_st) < 0 || cache_st.st_size < sizeof(*header)) {
+		close(fd);
+		return -1;
+	}
+	map_length = cache_st.st_size;
+	map = mmap(NULL, map_length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	header = map;
+	memset(&expected, 0, sizeof(expected));
+	fill_source_identity(&expected, config_file, &source_st);
+	if (header->magic != GPIB_CONF_CACHE_MAGIC ||
+	    header->version != GPIB_CONF_CACHE_VERSION ||
+	    header->conf_size != sizeof(ibConf_t) ||
+	    header->board_size != sizeof(ibBoard_t) ||
+	    header->configs_length != configs_length ||
+	    header->board_mask >> boards_length ||
+	    map_length != sizeof(*header) + configs_length * sizeof(ibConf_t) +
+		count_boards(header->board_mask) * sizeof(ibBoard_t) ||
+	    memcmp(&header->source_dev, &expected.source_dev,
+		   sizeof(expected) - offsetof(struct gpib_conf_cache_header, source_dev)))
+		goto out;
+
+	cached_configs = (const ibConf_t *)(header + 1);
+	cached_boards = (const ibBoard_t *)(cached_configs + configs_length);
+
+	if (minor >= 0) {
+		for (i = 0; i < configs_length; i++) {
+			if (cached_configs[i].is_interface &&
+			    cached_configs[i].defaults.board == minor)
+				break;
+		}
+		if (i == configs_length)
+			goto out;
+	}
+
+	for (i = 0; i < configs_length; i++) {
+		configs[i] = cached_configs[i];
+		init_async_op(&configs[i].async);
+	}
+	for (i = 0, j = 0; i < boards_length; i++) {
+		if (header->board_mask & (1 << i))
+			boards[i] = cached_boards[j++];
+		else
+			init_ibboard(&boards[i]);
+	}
+	retval = 0;
+out:
+	munmap(map, map_length);
+	return retval;
+}
+
+static int write_all(int fd, const void *buffer, size_t length)
+{
+	const uint8_t *p = buffer;
+
+	while (length) {
+		ssize_t retval = write(fd, p, length);
+
+		if (retval < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += retval;
+		length -= retval;
+	}
+	return 0;
+}
+
+/*
+ * Write the result of parse_gpib_conf(config_file, ..., -1) to the cache.
+ * The cache is replaced atomically, so readers never see a partial file.
+ */
+int gpib_conf_cache_store(const char *config_file, const ibConf_t *configs, unsigned int configs_length,
+	const ibBoard_t *boards, unsigned int boards_length)
+{
+	struct gpib_conf_cache_header header;
+	const char *cache_file;
+	struct stat source_st;
+	char *temp_file;
+	unsigned int i;
+	int fd;
+
+	cache_file = gpib_conf_cache_path(config_file);
+	if (cache_file == NULL || stat(config_file, &source_st) < 0)
+		return -1;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = GPIB_CONF_CACHE_MAGIC;
+	header.version = GPIB_CONF_CACHE_VERSION;
+	header.conf_size = sizeof(ibConf_t);
+	header.board_size = sizeof(ibBoard_t);
+	header.configs_length = configs_length;
+	for (i = 0; i < boards_length && i < 32; i++) {
+		if (boards[i].device[0])
+			header.board_mask |= 1 << i;
+	}
+	fill_source_identity(&header, config_file, &source_st);
+
+	if (asprintf(&temp_file, "%s.XXXXXX", cache_file) < 0)
+		return -1;
+	fd = mkostemp(temp_file, O_CLOEXEC);
+	if (fd < 0) {
+		free(temp_file);
+		return -1;
+	}
+	if (fchmod(fd, 0644) < 0 ||
+	    write_all(fd, &header, sizeof(header)) < 0 ||
+	    write_all(fd, configs, configs_length * sizeof(ibConf_t)) < 0)
+		goto fail;
+	for (i = 0; i < boards_length; i++) {
+		if ((header.board_mask & (1 << i)) &&
+		    write_all(fd, &boards[i], sizeof(ibBoard_t)) < 0)
+			goto fail;
+	}
+	if (close(fd) < 0) {
+		fd = -1;
+		goto fail;
+	}
+	if (rename(temp_file, cache_file) < 0) {
+		fd = -1;
+		goto fail;
+	}
+	free(temp_file);
+	return 0;
+
+fail:
+	if (fd >= 0)
+		close(fd);
+	unlink(temp_file);
+	free(temp_file);
+	return -1;
+}
+
+/* parse config_file from scratch and refresh its cache, used by gpib_config */
+int gpib_conf_cache_update(const char *config_file)
+{
+	ibConf_t *configs;
+	ibBoard_t *boards;
+	int retval = -1;
+
+	configs = malloc(sizeof(*configs) * FIND_CONFIGS_LENGTH);
+	boards = malloc(sizeof(*boards) * GPIB_MAX_NUM_BOARDS);
+	if (configs && boards &&
+	    parse_gpib_conf(config_file, configs, FIND_CONFIGS_LENGTH,
+			    boards, GPIB_MAX_NUM_BOARDS, -1) == 0)
+		retval = gpib_conf_cache_store(config_file, configs, FIND_CONFIGS_LENGTH,
+					       boards, GPIB_MAX_NUM_BOARDS);
+	free(configs);
+	free(boards);
+	return retval;
+}
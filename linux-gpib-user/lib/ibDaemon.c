@@ -0,0 +1,296 @@
+/***************************************************************************
+                          lib/ibDaemon.c
+                             -------------------
+
+    Configuration sharing with the gpibd daemon.  gpibd parses the
+    configuration file once, and clears and sends the init string to each
+    configured device once.  Processes which start while it is running
+    receive the parsed configuration over a unix socket instead of parsing
+    the configuration file, without the one-time device initialization.
+    Nothing else is shared: they open the board files, query the boards
+    and bring their descriptors online themselves.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define GPIBD_MAGIC 0x67706962
+#define GPIBD_PROTOCOL_VERSION 3
+
+struct gpibd_header
+{
+	uint32_t magic;
+	uint32_t protocol_version;
+	uint32_t conf_size;	/* sizeof(ibConf_t) of the daemon's library */
+	uint32_t board_size;	/* sizeof(ibBoard_t) of the daemon's library */
+	uint32_t num_configs;
+	uint32_t board_mask;	/* configured boards, which follow the configs */
+};
+
+/* the daemon's descriptor for each entry of ibFindConfigs[] it initialized */
+static int init_ud[FIND_CONFIGS_LENGTH];
+/* set in the daemon itself, which must never attach to another daemon */
+static int is_daemon;
+
+const char *gpibd_socket_path(void)
+{
+	const char *path = getenv("IB_DAEMON_SOCKET");
+
+	return path ? path : GPIBD_SOCKET_PATH;
+}
+
+/* daemon side: clear and initialize every configured device once, with ibfind() */
+int gpibd_init_devices(void)
+{
+	int i;
+	int num_devices = 0;
+
+	is_daemon = 1;
+	if (ibParseConfigFile(-1) < 0)
+		return -1;
+
+	for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+		init_ud[i] = -1;
+		if (ibFindConfigs[i].name[0] == 0)
+			continue;
+		init_ud[i] = ibfind(ibFindConfigs[i].name);
+		if (init_ud[i] < 0)
+			fprintf(stderr, "gpibd: failed to initialize \"%s\": %s\n",
+				ibFindConfigs[i].name, gpib_error_string(ThreadIberr()));
+		else
+			num_devices++;
+	}
+	return num_devices;
+}
+
+/*
+ * daemon side: create the listening socket, with the same access rights
+ * as the board device file so the same users may connect
+ */
+int gpibd_listen(const char *path)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+	int sock;
+	int i;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+	unlink(path);
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		goto fail;
+	for (i = 0; i < GPIB_MAX_NUM_BOARDS; i++) {
+		if (ibBoard[i].device[0] && stat(ibBoard[i].device, &st) == 0) {
+			if (chown(path, -1, st.st_gid) < 0 ||
+			    chmod(path, st.st_mode & 0666) < 0)
+				goto fail_unlink;
+			break;
+		}
+	}
+	if (listen(sock, 16) < 0)
+		goto fail_unlink;
+	return sock;
+
+fail_unlink:
+	unlink(path);
+fail:
+	close(sock);
+	return -1;
+}
+
+static int write_all(int fd, const void *buffer, size_t length)
+{
+	const uint8_t *p = buffer;
+
+	while (length) {
+		ssize_t retval = write(fd, p, length);
+
+		if (retval < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += retval;
+		length -= retval;
+	}
+	return 0;
+}
+
+static int read_all(int fd, void *buffer, size_t length)
+{
+	uint8_t *p = buffer;
+
+	while (length) {
+		ssize_t retval = read(fd, p, length);
+
+		if (retval < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (retval == 0) {
+			errno = EPROTO;
+			return -1;
+		}
+		p += retval;
+		length -= retval;
+	}
+	return 0;
+}
+
+/* daemon side: hand the configuration to a client */
+int gpibd_send_config(int sock)
+{
+	struct gpibd_header header;
+	ibConf_t conf;
+	int i;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = GPIBD_MAGIC;
+	header.protocol_version = GPIBD_PROTOCOL_VERSION;
+	header.conf_size = sizeof(ibConf_t);
+	header.board_size = sizeof(ibBoard_t);
+	header.num_configs = FIND_CONFIGS_LENGTH;
+	for (i = 0; i < GPIB_MAX_NUM_BOARDS; i++) {
+		if (ibBoard[i].device[0])
+			header.board_mask |= 1 << i;
+	}
+	if (write_all(sock, &header, sizeof(header)) < 0)
+		return -1;
+
+	for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+		conf = ibFindConfigs[i];
+		if (init_ud[i] >= 0) {
+			/* the device has already been cleared and sent its init string */
+			conf.flags &= ~CN_SDCL;
+			conf.init_string[0] = 0;
+		}
+		if (write_all(sock, &conf, sizeof(conf)) < 0)
+			return -1;
+	}
+	for (i = 0; i < GPIB_MAX_NUM_BOARDS; i++) {
+		if (header.board_mask & (1 << i)) {
+			if (write_all(sock, &ibBoard[i], sizeof(ibBoard[i])) < 0)
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static int popcount(unsigned int mask)
+{
+	int count = 0;
+
+	for (; mask; mask &= mask - 1)
+		count++;
+	return count;
+}
+
+/*
+ * Client side: fetch the configuration from gpibd.  Each client still opens
+ * the board files and device descriptors itself, so descriptor settings and
+ * open handles stay private to it and are released when it exits.  Returns
+ * 0 on success, or -1 if there is no usable daemon, in which case nothing
+ * has been changed and the caller should parse the configuration itself.
+ */
+int gpibd_fetch_config(void)
+{
+	struct sockaddr_un addr;
+	struct gpibd_header header;
+	struct timeval timeout = {1, 0};
+	ibConf_t *configs = NULL;
+	ibBoard_t *boards = NULL;
+	int num_boards;
+	int sock;
+	int i, j;
+
+	if (is_daemon || getenv("IB_NO_DAEMON"))
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(gpibd_socket_path()) >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, gpibd_socket_path());
+
+	sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+	if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		goto fail;
+	/* a wedged daemon must not hang us, we can always go direct */
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	if (read_all(sock, &header, sizeof(header)) < 0)
+		goto fail;
+	if (header.magic != GPIBD_MAGIC ||
+	    header.protocol_version != GPIBD_PROTOCOL_VERSION ||
+	    header.conf_size != sizeof(ibConf_t) ||
+	    header.board_size != sizeof(ibBoard_t) ||
+	    header.num_configs != FIND_CONFIGS_LENGTH ||
+	    header.board_mask >> GPIB_MAX_NUM_BOARDS)
+		goto fail;
+	num_boards = popcount(header.board_mask);
+
+	configs = malloc(sizeof(*configs) * FIND_CONFIGS_LENGTH);
+	boards = malloc(sizeof(*boards) * (num_boards ? num_boards : 1));
+	if (configs == NULL || boards == NULL)
+		goto fail;
+	if (read_all(sock, configs, sizeof(*configs) * FIND_CONFIGS_LENGTH) < 0 ||
+	    read_all(sock, boards, sizeof(*boards) * num_boards) < 0)
+		goto fail;
+	close(sock);
+
+	for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+		ibFindConfigs[i] = configs[i];
+		init_async_op(&ibFindConfigs[i].async);
+		ibFindConfigs[i].handle = -1;
+		ibFindConfigs[i].board_is_open = 0;
+		ibFindConfigs[i].has_lock = 0;
+	}
+	for (i = 0, j = 0; i < GPIB_MAX_NUM_BOARDS; i++) {
+		ibBoard_t *board = &ibBoard[i];
+
+		init_ibboard(board);
+		if ((header.board_mask & (1 << i)) == 0)
+			continue;
+		*board = boards[j++];
+		board->fileno = -1;
+		board->open_count = 0;
+		board->stream_ring = NULL;
+		board->stream_map_length = 0;
+		board->stream_end_seen = 0;
+	}
+	free(configs);
+	free(boards);
+	return 0;
+
+fail:
+	free(configs);
+	free(boards);
+	close(sock);
+	return -1;
+}
@@ -16,6 +16,130 @@
  ***************************************************************************/
 
 #include "ib_internal.h"
+#include <errno.h>
+#include <string.h>
+
+#define ENGINE_BIT(engine) (1U << (engine))
+
+/* returns 1 if the board has no selectable transfer engines */
+static int transfer_engine_ioctl(ibConf_t *conf, struct gpib_transfer_engine_ioctl *cmd)
+{
+	ibBoard_t *board = interfaceBoard(conf);
+
+	if (ioctl(board->fileno, IBXFER_ENGINE, cmd) < 0) {
+		if (errno == ENOENT || errno == ENOTTY)
+			return 1;
+		setIberr(EDVR);
+		setIbcnt(errno);
+		return -1;
+	}
+	return 0;
+}
+
+static int query_transfer_engine(ibConf_t *conf, struct gpib_transfer_engine_ioctl *cmd)
+{
+	memset(cmd, 0, sizeof(*cmd));
+	cmd->flags = GPIB_XFER_QUERY;
+	return transfer_engine_ioctl(conf, cmd);
+}
+
+/*
+ * Enabling selects the auto engine, which uses DMA for transfers of at least
+ * the board's DMA threshold, or DMA for everything if the board has no other
+ * engine.  Disabling selects the fifo if the board has one, otherwise PIO.
+ */
+int internal_ibdma(ibConf_t *conf, int enable)
+{
+	struct gpib_transfer_engine_ioctl cmd;
+	int retval;
+
+	retval = query_transfer_engine(conf, &cmd);
+	if (retval < 0)
+		return retval;
+	if (retval > 0) {
+		/* the board always uses whatever it was configured with */
+		if (enable)
+			return 0;
+		setIberr(ECAP);
+		return -1;
+	}
+
+	if (enable) {
+		if (cmd.engines & ENGINE_BIT(GPIB_XFER_AUTO))
+			cmd.engine = GPIB_XFER_AUTO;
+		else if (cmd.engines & ENGINE_BIT(GPIB_XFER_DMA))
+			cmd.engine = GPIB_XFER_DMA;
+		else {
+			setIberr(ECAP);
+			return -1;
+		}
+	} else {
+		if (cmd.engines & ENGINE_BIT(GPIB_XFER_FIFO))
+			cmd.engine = GPIB_XFER_FIFO;
+		else
+			cmd.engine = GPIB_XFER_PIO;
+	}
+	cmd.dma_threshold = 0;
+	cmd.flags = 0;
+	retval = transfer_engine_ioctl(conf, &cmd);
+	if (retval > 0) {
+		setIberr(ECAP);
+		return -1;
+	}
+	return retval;
+}
+
+int query_dma(ibConf_t *conf, int *enabled)
+{
+	struct gpib_transfer_engine_ioctl cmd;
+	int retval;
+
+	retval = query_transfer_engine(conf, &cmd);
+	if (retval < 0)
+		return retval;
+	if (retval > 0) {
+		*enabled = interfaceBoard(conf)->dma != 0;
+		return 0;
+	}
+	if (cmd.engine == GPIB_XFER_DEFAULT)
+		*enabled = (cmd.engines & ENGINE_BIT(GPIB_XFER_DMA)) != 0;
+	else
+		*enabled = cmd.engine == GPIB_XFER_DMA || cmd.engine == GPIB_XFER_AUTO;
+	return 0;
+}
+
+int set_dma_threshold(ibConf_t *conf, unsigned int threshold)
+{
+	struct gpib_transfer_engine_ioctl cmd;
+	int retval;
+
+	retval = query_transfer_engine(conf, &cmd);
+	if (retval == 0) {
+		cmd.dma_threshold = threshold;
+		cmd.flags = 0;
+		retval = transfer_engine_ioctl(conf, &cmd);
+	}
+	if (retval > 0) {
+		setIberr(ECAP);
+		return -1;
+	}
+	return retval;
+}
+
+int query_dma_threshold(ibConf_t *conf)
+{
+	struct gpib_transfer_engine_ioctl cmd;
+	int retval;
+
+	retval = query_transfer_engine(conf, &cmd);
+	if (retval > 0) {
+		setIberr(ECAP);
+		return -1;
+	}
+	if (retval < 0)
+		return retval;
+	return cmd.dma_threshold;
+}
 
 int ibdma(int ud, int v)
 {
@@ -25,7 +149,8 @@ int ibdma(int ud, int v)
 	if (!conf)
 		return exit_library( ud, 1 );
 
-	fprintf( stderr, "libgpib: ibdma() unimplemented!\n" );
+	if (internal_ibdma(conf, v) < 0)
+		return exit_library( ud, 1 );
 
 	return exit_library( ud, 0 );
 } /* ibdma */
@@ -18,6 +18,7 @@
 #include "ib_internal.h"
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /* Strictly speaking, addressing the controller as talker is
@@ -118,25 +119,116 @@ int listenerFound(ibConf_t *conf, const Addr4882_t addressList[])
 	return 0;
 }
 
-int secondaryListenerFound(ibConf_t *conf, unsigned int pad)
+/* probe the candidates one at a time, for drivers without IBPROBE_LISTENERS */
+static int probe_listeners_singly(ibConf_t *conf, struct gpib_probe_address *addresses,
+	unsigned int count, int any)
 {
-	Addr4882_t testAddress[32];
-	int j;
+	Addr4882_t testAddress[2];
+	unsigned int i, num_found = 0;
+	int retval;
+
+	if (address_board_as_talker(conf) < 0)
+		return -1;
 
-	for (j = 0; j <= gpib_addr_max; j++)
-		testAddress[j] = packAddress(pad, j);
-	testAddress[j] = NOADDR;
-	return listenerFound(conf, testAddress);
+	for (i = 0; i < count; i++) {
+		testAddress[0] = packAddress(addresses[i].pad, addresses[i].sad);
+		testAddress[1] = NOADDR;
+		retval = listenerFound(conf, testAddress);
+		if (retval < 0)
+			return retval;
+		if (retval > 0) {
+			addresses[num_found++] = addresses[i];
+			if (any)
+				break;
+		}
+	}
+	return num_found;
 }
 
+/*
+ * Find which candidates have a listener.  Those found are moved to the
+ * front of addresses[] and their number is returned.  If any is set, only
+ * whether there is some listener among them (1) or not (0) is returned.
+ */
+static int probe_listeners(ibConf_t *conf, struct gpib_probe_address *addresses,
+	unsigned int count, int any)
+{
+	ibBoard_t *board;
+	struct gpib_probe_listeners_ioctl cmd;
+	int retval;
+
+	board = interfaceBoard(conf);
+
+	retval = is_cic(board);
+	if (retval <= 0) {
+		if (retval == 0)
+			setIberr(ECIC);
+		return -1;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.address_ptr = (uintptr_t)addresses;
+	cmd.num_addresses = count;
+	cmd.flags = any ? GPIB_PROBE_ANY : 0;
+	set_timeout(board, conf->settings.usec_timeout);
+
+	retval = ioctl(board->fileno, IBPROBE_LISTENERS, &cmd);
+	if (retval < 0) {
+		switch (errno) {
+			case ENOTTY:
+				return probe_listeners_singly(conf, addresses, count, any);
+			case EOPNOTSUPP:
+				setIberr(ECAP);
+				break;
+			case ETIMEDOUT:
+				conf->timed_out = 1;
+				setIberr(EBUS);
+				break;
+			case ENOTCONN:
+				setIberr(ENOL);
+				break;
+			case EINTR:
+				setIberr(EABO);
+				break;
+			default:
+				setIberr(EDVR);
+				setIbcnt(errno);
+				break;
+		}
+		return -1;
+	}
+	return cmd.num_addresses;
+}
+
+static int addResult(Addr4882_t resultList[], int *resultIndex, int maxNumResults,
+	Addr4882_t address)
+{
+	if (*resultIndex >= maxNumResults) {
+		setIberr(ETAB);
+		return -1;
+	}
+	resultList[(*resultIndex)++] = address;
+	setIbcnt(*resultIndex);
+	return 0;
+}
+
+/*
+ * All primaries are probed together first.  Secondaries are only tried
+ * for primaries nobody answered on, since a device without extended
+ * addressing listens to its primary whatever secondary follows.
+ */
 void FindLstn(int boardID, const Addr4882_t padList[],
 	Addr4882_t resultList[], int maxNumResults)
 {
-	int i;
+	int i, j;
 	ibConf_t *conf;
 	int retval;
 	int resultIndex;
 	short line_status;
+	struct gpib_probe_address *candidates;
+	unsigned int numCandidates, numPads;
+	unsigned int primaryFound = 0;
+	unsigned int secondaryFound[gpib_addr_max + 1];
 
 	conf = enter_library(boardID);
 	if (conf == NULL) {
@@ -150,6 +242,12 @@ void FindLstn(int boardID, const Addr4882_t padList[],
 		return;
 	}
 
+	if (addressListIsValid(padList) == 0) {
+		setIberr(EARG);
+		exit_library(boardID, 1);
+		return;
+	}
+
 	retval = internal_iblines(conf, &line_status);
 	if (retval < 0)	{
 		exit_library(boardID, 1);
@@ -161,61 +259,70 @@ void FindLstn(int boardID, const Addr4882_t padList[],
 		return;
 	}
 
-	retval = address_board_as_talker(conf);
-	if (retval < 0)	{
+	numPads = numAddresses(padList);
+	candidates = malloc(sizeof(*candidates) * (gpib_addr_max + 1) * (numPads + 1));
+	if (candidates == NULL) {
+		setIberr(EDVR);
+		setIbcnt(ENOMEM);
 		exit_library(boardID, 1);
 		return;
 	}
 
+	numCandidates = 0;
+	for (i = 0; i < numPads; i++) {
+		candidates[numCandidates].pad = GetPAD(padList[i]);
+		candidates[numCandidates++].sad = -1;
+	}
+	retval = numCandidates ? probe_listeners(conf, candidates, numCandidates, 0) : 0;
+	if (retval < 0)
+		goto error;
+	for (i = 0; i < retval; i++)
+		primaryFound |= 1 << candidates[i].pad;
+
+	memset(secondaryFound, 0, sizeof(secondaryFound));
+	numCandidates = 0;
+	for (i = 0; i < numPads; i++) {
+		unsigned int pad = GetPAD(padList[i]);
+
+		if (primaryFound & (1 << pad))
+			continue;
+		for (j = 0; j <= gpib_addr_max; j++) {
+			candidates[numCandidates].pad = pad;
+			candidates[numCandidates++].sad = j;
+		}
+	}
+	while (numCandidates > 0) {
+		unsigned int count = numCandidates < GPIB_MAX_PROBE_ADDRESSES ?
+			numCandidates : GPIB_MAX_PROBE_ADDRESSES;
+
+		numCandidates -= count;
+		retval = probe_listeners(conf, candidates + numCandidates, count, 0);
+		if (retval < 0)
+			goto error;
+		for (i = 0; i < retval; i++) {
+			struct gpib_probe_address *found = candidates + numCandidates + i;
+
+			secondaryFound[found->pad] |= 1 << found->sad;
+		}
+	}
+	free(candidates);
+	candidates = NULL;
+
 	resultIndex = 0;
-	for (i = 0; i < numAddresses(padList); i++) {
-		Addr4882_t pad;
-		Addr4882_t testAddress[2];
+	for (i = 0; i < numPads; i++) {
+		unsigned int pad = GetPAD(padList[i]);
 
-		pad = GetPAD(padList[i]);
-		testAddress[0] = pad;
-		testAddress[1] = NOADDR;
-		retval = listenerFound(conf, testAddress);
-		if (retval < 0)	{
-			// XXX status/error settings
-			exit_library(boardID, 1);
-			return;
+		if (primaryFound & (1 << pad)) {
+			if (addResult(resultList, &resultIndex, maxNumResults, pad) < 0)
+				goto error;
+			continue;
 		}
-		if (retval > 0) {
-			if (resultIndex >= maxNumResults) {
-				setIberr(ETAB);
-				exit_library(boardID, 1);
-				return;
-			}
-			resultList[resultIndex++] = testAddress[0];
-			setIbcnt(resultIndex);
-		} else {
-			retval = secondaryListenerFound(conf, pad);
-			if (retval < 0)	{
-				exit_library(boardID, 1);
-				return;
-			}
-			if (retval > 0)	{
-				int j;
-				for (j = 0; j <= gpib_addr_max; j++) {
-					testAddress[0] = packAddress(pad, j);
-					testAddress[1] = NOADDR;
-					retval = listenerFound(conf, testAddress);
-					if (retval < 0)	{
-						exit_library(boardID, 1);
-						return;
-					}
-					if (retval > 1)	{
-						if (resultIndex >= maxNumResults) {
-							setIberr(ETAB);
-							exit_library(boardID, 1);
-							return;
-						}
-						resultList[resultIndex++] = testAddress[0];
-						setIbcnt(resultIndex);
-					}
-				}
-			}
+		for (j = 0; j <= gpib_addr_max; j++) {
+			if ((secondaryFound[pad] & (1 << j)) == 0)
+				continue;
+			if (addResult(resultList, &resultIndex, maxNumResults,
+				packAddress(pad, j)) < 0)
+				goto error;
 		}
 	}
 
@@ -225,39 +332,55 @@ void FindLstn(int boardID, const Addr4882_t padList[],
 		return;
 	}
 
+	setIbcnt(resultIndex);
 	exit_library(boardID, 0);
+	return;
+
+error:
+	free(candidates);
+	unlisten_untalk(conf);
+	exit_library(boardID, 1);
 } /* FindLstn */
 
 int ibln(int ud, int pad, int sad, short *found_listener)
 {
 	ibConf_t *conf;
-	Addr4882_t addressList[2];
+	struct gpib_probe_address candidates[gpib_addr_max + 1];
+	unsigned int count = 0;
 	int retval;
 
 	conf = enter_library(ud);
 	if (conf == NULL)
 		return exit_library(ud, 1);
 
-	retval = address_board_as_talker(conf);
-	if (retval < 0)	{
+	if (pad < 0 || pad > gpib_addr_max) {
+		setIberr(EARG);
 		return exit_library(ud, 1);
 	}
 
 	switch(sad) {
 	case ALL_SAD:
-		retval = secondaryListenerFound(conf, pad);
+		for (count = 0; count <= gpib_addr_max; count++) {
+			candidates[count].pad = pad;
+			candidates[count].sad = count;
+		}
 		break;
 	case NO_SAD:
 	default:
-		addressList[0] = MakeAddr(pad, sad);
-		addressList[1] = NOADDR;
-		retval = listenerFound(conf, addressList);
+		candidates[0].pad = pad;
+		candidates[0].sad = extractSAD(MakeAddr(pad, sad));
+		if (candidates[0].sad == ADDR_INVALID) {
+			setIberr(EARG);
+			return exit_library(ud, 1);
+		}
+		count = 1;
 		break;
 	}
+	retval = probe_listeners(conf, candidates, count, 1);
 	if (retval < 0)
 		return exit_library(ud, 1);
 
-	*found_listener = retval;
+	*found_listener = retval > 0;
 
 	retval = unlisten_untalk(conf);
 	if (retval < 0)
@@ -0,0 +1,221 @@
+/***************************************************************************
+                          lib/ibQuery.c
+                             -------------------
+
+    Sends queries to several devices on one board and reads back their
+    replies, with the board locked once for all of them.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+static ibConf_t *query_conf(const struct gpib_query *query, int board)
+{
+	ibConf_t *conf;
+	int in_progress;
+
+	if (query->command_length < 0 || query->reply_size < 0) {
+		setIberr(EARG);
+		return NULL;
+	}
+
+	conf = general_enter_library(query->ud, 1, 0);
+	if (conf == NULL)
+		return NULL;
+
+	if (conf->is_interface || conf->settings.board != board) {
+		setIberr(EARG);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&conf->async.lock);
+	in_progress = conf->async.in_progress;
+	pthread_mutex_unlock(&conf->async.lock);
+	if (in_progress) {
+		setIberr(EOIP);
+		return NULL;
+	}
+
+	return conf;
+}
+
+// like my_ibwrt(), but leaves the device listening, the next addressing unlistens it
+static int query_write(ibConf_t *conf, const struct gpib_query *query)
+{
+	const uint8_t *buffer = query->command;
+	size_t count = query->command_length;
+
+	if (send_setup(conf, conf->settings.usec_timeout) < 0)
+		return -1;
+
+	while (count) {
+		size_t block_size;
+
+		if (send_data_smart_eoi(conf, conf->settings.usec_timeout, buffer, count,
+			conf->settings.send_eoi, &block_size) < 0)
+			return -1;
+		count -= block_size;
+		buffer += block_size;
+	}
+
+	return 0;
+}
+
+// like my_ibrd(), but leaves the device talking, the next addressing untalks it
+static int query_read(ibConf_t *conf, struct gpib_query *query)
+{
+	size_t bytes_read;
+	int retval;
+
+	if (iblcleos(conf) < 0)
+		return -1;
+
+	if (InternalReceiveSetup(conf, conf->settings.usec_timeout,
+		packAddress(conf->settings.pad, conf->settings.sad)) < 0)
+		return -1;
+
+	retval = read_data(conf, conf->settings.usec_timeout, query->reply, query->reply_size, &bytes_read);
+	query->reply_length = bytes_read;
+	if (conf->end)
+		query->status |= END;
+
+	return retval;
+}
+
+static void query_failed(ibConf_t *conf, struct gpib_query *query)
+{
+	query->status |= ERR;
+	query->error = ThreadIberr();
+	// errno, as ibcnt would be after ibrd() or ibwrt()
+	if (query->error == EDVR)
+		query->reply_length = ThreadIbcntl();
+	if (conf->timed_out)
+		query->status |= TIMO;
+}
+
+static int query_trigger(ibConf_t *conf, ibConf_t **confs, struct gpib_query *queries, int num_queries)
+{
+	Addr4882_t *addressList;
+	int i, j, retval;
+
+	addressList = malloc((num_queries + 1) * sizeof(*addressList));
+	if (addressList == NULL) {
+		setIberr(EDVR);
+		setIbcnt(ENOMEM);
+		return -1;
+	}
+
+	for (i = j = 0; i < num_queries; i++) {
+		if ((queries[i].status & ERR) == 0)
+			addressList[j++] = packAddress(confs[i]->settings.pad, confs[i]->settings.sad);
+	}
+	addressList[j] = NOADDR;
+
+	retval = j ? my_trigger(conf, addressList) : 0;
+	free(addressList);
+
+	return retval;
+}
+
+int ibquerylist(struct gpib_query *queries, int num_queries, int flags)
+{
+	ibConf_t *conf;
+	ibConf_t **confs;
+	int ud = (queries && num_queries > 0) ? queries[0].ud : -1;
+	int i, num_completed, timed_out, unt_unl, first_error;
+	int retval = 0;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (flags & ~GPIB_QUERY_TRIGGER) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+
+	confs = malloc(num_queries * sizeof(*confs));
+	if (confs == NULL) {
+		setIberr(EDVR);
+		setIbcnt(ENOMEM);
+		return exit_library(ud, 1);
+	}
+
+	unt_unl = 0;
+	for (i = 0; i < num_queries; i++) {
+		confs[i] = query_conf(&queries[i], conf->settings.board);
+		if (confs[i] == NULL) {
+			free(confs);
+			return exit_library(ud, 1);
+		}
+		queries[i].reply_length = 0;
+		queries[i].status = 0;
+		queries[i].error = 0;
+		unt_unl |= confs[i]->settings.send_unt_unl;
+	}
+
+	// all the commands first, so the devices work on them at the same time
+	for (i = 0; i < num_queries; i++) {
+		confs[i]->timed_out = 0;
+		if (query_write(confs[i], &queries[i]) < 0)
+			query_failed(confs[i], &queries[i]);
+	}
+
+	if (flags & GPIB_QUERY_TRIGGER) {
+		conf->timed_out = 0;
+		if (query_trigger(conf, confs, queries, num_queries) < 0) {
+			for (i = 0; i < num_queries; i++) {
+				if ((queries[i].status & ERR) == 0)
+					query_failed(conf, &queries[i]);
+			}
+		}
+	}
+
+	// then the replies, in the order the commands went out
+	for (i = 0; i < num_queries; i++) {
+		if ((queries[i].status & ERR) || queries[i].reply_size == 0)
+			continue;
+		confs[i]->timed_out = 0;
+		if (query_read(confs[i], &queries[i]) < 0)
+			query_failed(confs[i], &queries[i]);
+	}
+
+	if (unt_unl)
+		retval = unlisten_untalk(conf);
+
+	num_completed = timed_out = 0;
+	first_error = -1;
+	for (i = 0; i < num_queries; i++) {
+		queries[i].status |= CMPL;
+		if (queries[i].status & TIMO)
+			timed_out = 1;
+		if ((queries[i].status & ERR) == 0)
+			num_completed++;
+		else if (first_error < 0)
+			first_error = queries[i].error;
+	}
+	free(confs);
+
+	conf->end = 0;
+	conf->timed_out = timed_out;
+	if (first_error >= 0) {
+		setIberr(first_error);
+		setIbcnt(num_completed);
+		return exit_library(ud, 1);
+	}
+	if (retval < 0)
+		return exit_library(ud, 1);
+	setIbcnt(num_completed);
+
+	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
+}
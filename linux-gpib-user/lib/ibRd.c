@@ -16,10 +16,13 @@
  ***************************************************************************/
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ib_internal.h"
 
 // sets up bus to receive data from device with address pad/sad
@@ -62,7 +65,8 @@ int InternalReceiveSetup(ibConf_t *conf, unsigned int usec_timeout, Addr4882_t a
 	return 0;
 }
 
-static int read_data(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read)
+// one IBRD ioctl, without the IbcReadAdjust byte swapping
+int read_data_raw(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read)
 {
 	ibBoard_t *board;
 	struct gpib_read_write_ioctl read_cmd;
@@ -105,6 +109,87 @@ static int read_data(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer,
 	return retval;
 }
 
+int read_data(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read)
+{
+	int retval;
+
+	retval = read_data_raw(conf, usec_timeout, buffer, count, bytes_read);
+	// swap straight after the kernel's copy, while the data is likely still cached
+	if (conf->settings.read_adjust)
+		byte_adjust(conf->settings.read_adjust, buffer, buffer, *bytes_read);
+
+	return retval;
+}
+
+// fills the segments in order with one ioctl, stopping early on END
+static int read_data_vec(ibConf_t *conf, unsigned int usec_timeout, const struct iovec *iov,
+	int iovcnt, size_t *bytes_read)
+{
+	ibBoard_t *board;
+	struct gpib_read_write_vec_ioctl read_cmd;
+	struct gpib_iovec vec[GPIB_MAX_IOVEC];
+	size_t count;
+	int retval;
+
+	*bytes_read = 0;
+	if (fill_gpib_iovec(vec, iov, iovcnt, &count) < 0)
+		return -1;
+
+	board = interfaceBoard(conf);
+
+	read_cmd.iov_ptr = (uintptr_t)vec;
+	read_cmd.iov_count = iovcnt;
+	read_cmd.completed_transfer_count = 0;
+	read_cmd.handle = conf->handle;
+	read_cmd.end = 0;
+	read_cmd.end_segment = 0;
+	read_cmd.end_offset = 0;
+
+	set_timeout(board, usec_timeout);
+	conf->end = 0;
+
+	retval = ioctl(board->fileno, IBRDV, &read_cmd);
+	if (retval < 0 && errno == ENOTTY) {
+		int i;
+
+		// driver predates IBRDV, fall back to one IBRD per segment
+		for (i = 0; i < iovcnt && conf->end == 0; i++) {
+			size_t num_bytes;
+
+			retval = read_data(conf, usec_timeout, iov[i].iov_base, iov[i].iov_len, &num_bytes);
+			*bytes_read += num_bytes;
+			if (retval < 0)
+				break;
+		}
+		return retval;
+	}
+	if (retval < 0)	{
+		switch (errno) {
+			case ETIMEDOUT:
+				conf->timed_out = 1;
+				setIberr(EABO);
+				break;
+			case EINTR:
+				setIberr(EABO);
+				break;
+			default:
+				setIberr(EDVR);
+				setIbcnt(errno);
+				break;
+		}
+	}
+
+	if (read_cmd.end)
+		conf->end = 1;
+
+	*bytes_read = read_cmd.completed_transfer_count;
+	// words may straddle segments, the data is swapped as it came off the bus
+	if (conf->settings.read_adjust)
+		byte_adjust_iovec(conf->settings.read_adjust, iov, iovcnt, *bytes_read);
+
+	return retval;
+}
+
 int my_ibrd(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read)
 {
 	int retval;
@@ -148,6 +233,50 @@ int ibrd(int ud, void *rd, long cnt)
 	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
 }
 
+int my_ibrdv(ibConf_t *conf, unsigned int usec_timeout, const struct iovec *iov, int iovcnt, size_t *bytes_read)
+{
+	int retval;
+
+	*bytes_read = 0;
+	// set eos mode
+	iblcleos(conf);
+
+	if (conf->is_interface == 0) {
+		// set up addressing
+		if (InternalReceiveSetup(conf, usec_timeout, packAddress(conf->settings.pad, conf->settings.sad)) < 0)
+			return -1;
+	}
+
+	retval = read_data_vec(conf, usec_timeout, iov, iovcnt, bytes_read);
+
+	if (!conf->is_interface && conf->settings.send_unt_unl)
+		retval = unlisten_untalk(conf);
+
+	return retval;
+}
+
+int ibrdv(int ud, const struct iovec *iov, int iovcnt)
+{
+	ibConf_t *conf;
+	ssize_t retval;
+	size_t bytes_read;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	retval = my_ibrdv(conf, conf->settings.usec_timeout, iov, iovcnt, &bytes_read);
+	if (retval < 0) {
+		if (ThreadIberr() != EDVR)
+			setIbcnt(bytes_read);
+		return exit_library(ud, 1);
+	} else {
+		setIbcnt(bytes_read);
+	}
+
+	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
+}
+
 int ibrda(int ud, void *buffer, long cnt)
 {
 	ibConf_t *conf;
@@ -165,21 +294,94 @@ int ibrda(int ud, void *buffer, long cnt)
 	return general_exit_library(ud, 0, 0, 0, 0, 0, 1);
 }
 
+/*
+ * Has the driver stream what it reads to the file, without the data
+ * passing through user space.  Returns 1 if the driver can't.
+ */
+static int read_file_ioctl(ibConf_t *conf, int fd, size_t *bytes_read)
+{
+	ibBoard_t *board;
+	struct gpib_file_io_ioctl read_cmd;
+	int retval;
+
+	board = interfaceBoard(conf);
+
+	memset(&read_cmd, 0, sizeof(read_cmd));
+	read_cmd.fd = fd;
+	read_cmd.handle = conf->handle;
+	// the file is opened for appending, so the driver ignores the offset
+	read_cmd.offset = 0;
+	read_cmd.requested_transfer_count = UINT64_MAX;
+
+	set_timeout(board, conf->settings.usec_timeout);
+	conf->end = 0;
+
+	retval = ioctl(board->fileno, IBRDF, &read_cmd);
+	if (retval < 0 && errno == ENOTTY)
+		return 1;
+	*bytes_read = read_cmd.completed_transfer_count;
+	if (read_cmd.end)
+		conf->end = 1;
+	if (read_cmd.file_error) {
+		setIberr(EFSO);
+		setIbcnt(read_cmd.file_error);
+		return -1;
+	}
+	if (retval < 0)	{
+		switch (errno) {
+			case ETIMEDOUT:
+				conf->timed_out = 1;
+				setIberr(EABO);
+				break;
+			case EINTR:
+				setIberr(EABO);
+				break;
+			default:
+				setIberr(EDVR);
+				setIbcnt(errno);
+				break;
+		}
+		return -1;
+	}
+	return 0;
+}
+
+static int read_file_chunks(ibConf_t *conf, int fd, size_t *byte_count)
+{
+	uint8_t buffer[ 0x4000 ];
+	int retval;
+
+	do {
+		ssize_t write_count;
+		size_t bytes_read;
+
+		retval = read_data(conf, conf->settings.usec_timeout,  buffer, sizeof(buffer), &bytes_read);
+		write_count = write(fd, buffer, bytes_read);
+		if (write_count != (ssize_t)bytes_read) {
+			setIberr(EFSO);
+			setIbcnt(write_count < 0 ? errno : EIO);
+			return -1;
+		}
+		*byte_count += write_count;
+	} while (retval >= 0 && conf->end == 0);
+
+	return retval;
+}
+
 int ibrdf(int ud, const char *file_path)
 {
 	ibConf_t *conf;
 	int retval;
-	uint8_t buffer[ 0x4000 ];
-	unsigned long byte_count;
-	FILE *save_file;
-	int error;
+	size_t byte_count = 0;
+	int fd;
+	int error = 0;
 
 	conf = enter_library(ud);
 	if (conf == NULL)
 		return exit_library(ud, 1);
 
-	save_file = fopen(file_path, "a");
-	if (save_file == NULL) {
+	fd = open(file_path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+	if (fd < 0) {
 		setIberr(EFSO);
 		setIbcnt(errno);
 		return exit_library(ud, 1);
@@ -187,43 +389,33 @@ int ibrdf(int ud, const char *file_path)
 
 	if (conf->is_interface == 0) {
 		// set up addressing
-		if (InternalReceiveSetup(conf, conf->settings.usec_timeout, packAddress(conf->settings.pad, conf->settings.sad)) < 0)
+		if (InternalReceiveSetup(conf, conf->settings.usec_timeout, packAddress(conf->settings.pad, conf->settings.sad)) < 0) {
+			close(fd);
 			return exit_library(ud, 1);
+		}
 	}
 
 	// set eos mode
 	iblcleos(conf);
 
-	byte_count = error = 0;
-	do {
-		int fwrite_count;
-		size_t bytes_read;
-
-		retval = read_data(conf, conf->settings.usec_timeout,  buffer, sizeof(buffer), &bytes_read);
-		fwrite_count = fwrite(buffer, 1, bytes_read, save_file);
-		if (fwrite_count != bytes_read)		{
-			setIberr(EFSO);
-			setIbcnt(errno);
-			error++;
-		}
-		byte_count += fwrite_count;
-		if (retval < 0)
-		{
-			error++;
-			break;
-		}
-	} while (conf->end == 0 && error == 0);
+	// swapped data has to pass through user space
+	retval = 1;
+	if (conf->settings.read_adjust == 0)
+		retval = read_file_ioctl(conf, fd, &byte_count);
+	if (retval > 0)
+		retval = read_file_chunks(conf, fd, &byte_count);
+	if (retval < 0)
+		error++;
 
 	if (!conf->is_interface && conf->settings.send_unt_unl) {
-		retval = unlisten_untalk(conf);
-		if (retval < 0)
+		if (unlisten_untalk(conf) < 0)
 			error++;
 	}
 
 	if (!error)
 		setIbcnt(byte_count);
 
-	if (fclose(save_file)) {
+	if (close(fd)) {
 		setIberr(EFSO);
 		setIbcnt(errno);
 		return exit_library(ud, 1);
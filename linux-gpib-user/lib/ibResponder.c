@@ -0,0 +1,145 @@
+/***************************************************************************
+                          lib/ibResponder.c
+                             -------------------
+
+    Device mode responses queued ahead of time, sent by the driver as soon
+    as the controller addresses the board to talk, and listener data the
+    driver accepts without a read pending.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+static void responder_error(void)
+{
+	setIberr(errno == EBUSY ? EOIP : EDVR);
+	setIbcnt(errno);
+}
+
+int ibresponder_start(int ud, long listen_buffer_size)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	struct gpib_responder_ioctl cmd;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (conf->is_interface == 0 || listen_buffer_size < 0) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+	board = interfaceBoard(conf);
+
+	// the driver's reads and writes use the board's eos and timeout settings
+	if (iblcleos(conf) < 0)
+		return exit_library(ud, 1);
+	if (set_timeout(board, conf->settings.usec_timeout) < 0)
+		return exit_library(ud, 1);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.listen_buffer_size = listen_buffer_size;
+	if (ioctl(board->fileno, IBRESPONDER_START, &cmd) < 0) {
+		responder_error();
+		return exit_library(ud, 1);
+	}
+
+	return exit_library(ud, 0);
+}
+
+int ibresponder_stop(int ud)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	board = interfaceBoard(conf);
+	if (ioctl(board->fileno, IBRESPONDER_STOP) < 0) {
+		setIberr(errno == EINVAL ? EARG : EDVR);
+		setIbcnt(errno);
+		return exit_library(ud, 1);
+	}
+
+	return exit_library(ud, 0);
+}
+
+int ibresponder_queue(int ud, const void *buffer, long count)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	struct gpib_responder_message_ioctl cmd;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (count <= 0) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+	board = interfaceBoard(conf);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.buffer_ptr = (uintptr_t)buffer;
+	cmd.count = count;
+	cmd.end = conf->settings.send_eoi;
+	if (ioctl(board->fileno, IBRESPONDER_QUEUE, &cmd) < 0) {
+		responder_error();
+		return exit_library(ud, 1);
+	}
+	setIbcnt(cmd.pending);
+
+	return exit_library(ud, 0);
+}
+
+int ibresponder_read(int ud, void *buffer, long count)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	struct gpib_responder_message_ioctl cmd;
+	int retval;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	if (count < 0) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+	board = interfaceBoard(conf);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.buffer_ptr = (uintptr_t)buffer;
+	cmd.count = count;
+	cmd.usec_timeout = conf->settings.usec_timeout;
+	retval = ioctl(board->fileno, IBRESPONDER_READ, &cmd);
+	conf->end = cmd.end != 0;
+	if (retval < 0) {
+		if (errno == ETIMEDOUT) {
+			conf->timed_out = 1;
+			setIberr(EABO);
+			setIbcnt(cmd.count);
+		} else {
+			responder_error();
+		}
+		return exit_library(ud, 1);
+	}
+	setIbcnt(cmd.count);
+
+	return exit_library(ud, 0);
+}
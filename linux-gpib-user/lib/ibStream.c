@@ -0,0 +1,267 @@
+/***************************************************************************
+                          lib/ibStream.c
+                             -------------------
+
+    Continuous acquisition from a talker into the driver's ring buffer,
+    consumed through a shared mapping instead of one ioctl per chunk.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ib_internal.h"
+#include <stdint.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+static void unmap_stream(ibBoard_t *board)
+{
+	if (board->stream_ring == NULL)
+		return;
+	munmap(board->stream_ring, board->stream_map_length);
+	board->stream_ring = NULL;
+	board->stream_map_length = 0;
+	board->stream_end_seen = 0;
+}
+
+/* wait for the driver to produce data, returns 0 on timeout */
+static int wait_for_stream_data(ibBoard_t *board, unsigned int usec_timeout)
+{
+	struct pollfd pfd;
+	int retval;
+
+	pfd.fd = board->fileno;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	do {
+		retval = poll(&pfd, 1, usec_timeout ? (usec_timeout + 999) / 1000 : -1);
+	} while (retval < 0 && errno == EINTR);
+	if (retval < 0) {
+		setIberr(EDVR);
+		setIbcnt(errno);
+		return -1;
+	}
+	return retval;
+}
+
+/* number of bytes which may be consumed before crossing the next END */
+static uint64_t bytes_before_end(ibBoard_t *board, uint64_t tail, uint64_t head, int *end)
+{
+	struct gpib_stream_ring *ring = board->stream_ring;
+	uint64_t end_count;
+
+	*end = 0;
+	end_count = __atomic_load_n(&ring->end_count, __ATOMIC_ACQUIRE);
+	/* marks older than the table size have been overwritten */
+	if (end_count - board->stream_end_seen > GPIB_STREAM_NUM_END_MARKS)
+		board->stream_end_seen = end_count - GPIB_STREAM_NUM_END_MARKS;
+
+	while (board->stream_end_seen < end_count) {
+		uint64_t mark;
+
+		mark = ring->end_marks[board->stream_end_seen % GPIB_STREAM_NUM_END_MARKS];
+		if (mark > tail) {
+			*end = 1;
+			return mark - tail;
+		}
+		board->stream_end_seen++;
+	}
+	return head - tail;
+}
+
+static int stream_status(ibConf_t *conf, int error)
+{
+	int status = CMPL;
+
+	if (error)
+		status |= ERR;
+	if (conf->timed_out)
+		status |= TIMO;
+	if (conf->end)
+		status |= END;
+	setIbsta(status);
+	return status;
+}
+
+int ibstream_start(int ud, long ring_size)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	struct gpib_stream_ioctl cmd;
+	void *map;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	board = interfaceBoard(conf);
+	if (board->stream_ring) {
+		setIberr(EOIP);
+		return exit_library(ud, 1);
+	}
+	if (ring_size <= 0) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+
+	iblcleos(conf);
+
+	if (conf->is_interface == 0) {
+		if (InternalReceiveSetup(conf, conf->settings.usec_timeout,
+					 packAddress(conf->settings.pad, conf->settings.sad)) < 0)
+			return exit_library(ud, 1);
+	}
+
+	set_timeout(board, conf->settings.usec_timeout);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.handle = conf->handle;
+	cmd.ring_size = ring_size;
+	if (ioctl(board->fileno, IBSTREAM_START, &cmd) < 0) {
+		setIberr(errno == EBUSY ? EOIP : EDVR);
+		setIbcnt(errno);
+		return exit_library(ud, 1);
+	}
+
+	map = mmap(NULL, cmd.map_length, PROT_READ | PROT_WRITE, MAP_SHARED, board->fileno, 0);
+	if (map == MAP_FAILED) {
+		setIberr(EDVR);
+		setIbcnt(errno);
+		ioctl(board->fileno, IBSTREAM_STOP);
+		return exit_library(ud, 1);
+	}
+	board->stream_ring = map;
+	board->stream_map_length = cmd.map_length;
+	board->stream_end_seen = 0;
+	conf->end = 0;
+	setIbcnt(cmd.ring_size);
+
+	return exit_library(ud, 0);
+}
+
+int ibstream_read(int ud, void *buffer, long count)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	struct gpib_stream_ring *ring;
+	uint8_t *data;
+	uint64_t head, tail, available;
+	size_t copied = 0;
+	int end;
+
+	/* no board lock or status ioctl: the ring is read without syscalls */
+	conf = general_enter_library(ud, 1, 0);
+	if (conf == NULL)
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+
+	board = interfaceBoard(conf);
+	ring = board->stream_ring;
+	if (ring == NULL || count < 0) {
+		setIberr(EARG);
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+	}
+	data = (uint8_t *)ring + ring->data_offset;
+	conf->end = 0;
+
+	tail = ring->tail;
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	while (head == tail) {
+		int retval;
+
+		if ((__atomic_load_n(&ring->flags, __ATOMIC_ACQUIRE) & GPIB_STREAM_ACTIVE) == 0) {
+			/* pick up anything written just before the thread stopped */
+			head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+			if (head != tail)
+				break;
+			if (ring->error) {
+				setIberr(EDVR);
+				setIbcnt(ring->error);
+			} else {
+				setIberr(EABO);
+			}
+			stream_status(conf, 1);
+			return general_exit_library(ud, 1, 0, 1, 0, 0, 1);
+		}
+		retval = wait_for_stream_data(board, conf->settings.usec_timeout);
+		if (retval <= 0) {
+			if (retval == 0) {
+				conf->timed_out = 1;
+				setIberr(EABO);
+			}
+			stream_status(conf, 1);
+			return general_exit_library(ud, 1, 0, 1, 0, 0, 1);
+		}
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	}
+
+	available = bytes_before_end(board, tail, head, &end);
+	if (available > (uint64_t)count) {
+		available = count;
+		end = 0;
+	}
+	while (copied < available) {
+		size_t offset = (tail + copied) & (ring->size - 1);
+		size_t block = ring->size - offset;
+
+		if (block > available - copied)
+			block = available - copied;
+		memcpy((uint8_t *)buffer + copied, data + offset, block);
+		copied += block;
+	}
+	__atomic_store_n(&ring->tail, tail + copied, __ATOMIC_RELEASE);
+	if (end) {
+		conf->end = 1;
+		board->stream_end_seen++;
+	}
+
+	setIbcnt(copied);
+	stream_status(conf, 0);
+	return general_exit_library(ud, 0, 0, 1, 0, 0, 1);
+}
+
+int ibstream_stop(int ud)
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	unsigned long overruns;
+	int retval;
+
+	conf = enter_library(ud);
+	if (conf == NULL)
+		return exit_library(ud, 1);
+
+	board = interfaceBoard(conf);
+	if (board->stream_ring == NULL) {
+		setIberr(EARG);
+		return exit_library(ud, 1);
+	}
+
+	retval = ioctl(board->fileno, IBSTREAM_STOP);
+	if (retval < 0 && errno != EINVAL) {
+		setIberr(EDVR);
+		setIbcnt(errno);
+		return exit_library(ud, 1);
+	}
+	overruns = board->stream_ring->overruns;
+	unmap_stream(board);
+
+	if (!conf->is_interface && conf->settings.send_unt_unl) {
+		if (unlisten_untalk(conf) < 0)
+			return exit_library(ud, 1);
+	}
+
+	setIbcnt(overruns);
+	return exit_library(ud, 0);
+}
+
+void ibstream_release(ibBoard_t *board)
+{
+	unmap_stream(board);
+}
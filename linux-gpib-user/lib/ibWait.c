@@ -164,6 +164,36 @@ int ibwait(int ud, int mask)
 	return status;
 }
 
+/* ibwait() in the background, the status it returned is in ibcnt after ibwait(ud, CMPL) */
+int ibwaita(int ud, int mask)
+{
+	ibConf_t *conf;
+	int valid_mask;
+
+	conf = general_enter_library(ud, 1, 0);
+	if (!conf)
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+
+	valid_mask = conf->is_interface ? board_wait_mask : device_wait_mask;
+	valid_mask &= ~CMPL;
+	if (mask == 0 || (mask & valid_mask) != mask) {
+		fprintf(stderr, "Invalid wait mask for ibwaita(), valid wait bits are 0x%x\n",
+			valid_mask);
+		setIberr(EARG);
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+	}
+	/* ibstop() can't end a wait in the driver, without a timeout it might never end */
+	if (conf->settings.usec_timeout == 0) {
+		setIberr(EARG);
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+	}
+
+	if (gpib_aio_launch(ud, conf, GPIB_AIO_WAIT, NULL, mask) < 0)
+		return general_exit_library(ud, 1, 0, 0, 0, 0, 1);
+
+	return general_exit_library(ud, 0, 0, 0, 0, 0, 1);
+}
+
 void WaitSRQ(int boardID, short *result)
 {
 	ibConf_t *conf;
@@ -23,6 +23,9 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 
 int find_eos(const uint8_t *buffer, size_t length, int eos, int eos_flags)
@@ -43,7 +46,46 @@ int find_eos(const uint8_t *buffer, size_t length, int eos, int eos_flags)
 	return -1;
 }
 
-int send_data(ibConf_t *conf, unsigned int usec_timeout, const void *buffer, size_t count, int send_eoi, size_t *bytes_written)
+int fill_gpib_iovec(struct gpib_iovec *vec, const struct iovec *iov, int iovcnt, size_t *total)
+{
+	int i;
+
+	if (iovcnt <= 0 || iovcnt > GPIB_MAX_IOVEC) {
+		setIberr(EARG);
+		return -1;
+	}
+	*total = 0;
+	for (i = 0; i < iovcnt; i++) {
+		vec[i].base = (uintptr_t)iov[i].iov_base;
+		vec[i].len = iov[i].iov_len;
+		*total += iov[i].iov_len;
+	}
+	return 0;
+}
+
+static void write_error(ibConf_t *conf)
+{
+	switch (errno) {
+		case ETIMEDOUT:
+			conf->timed_out = 1;
+			setIberr(EABO);
+			break;
+		case EINTR:
+			setIberr(EABO);
+			break;
+		case ECOMM:
+			setIberr(ENOL);
+			break;
+		case EFAULT:
+			//fall-through
+		default:
+			setIberr(EDVR);
+			setIbcnt(errno);
+			break;
+	}
+}
+
+static int write_ioctl(ibConf_t *conf, const void *buffer, size_t count, int send_eoi, size_t *bytes_written)
 {
 	ibBoard_t *board;
 	struct gpib_read_write_ioctl write_cmd;
@@ -51,8 +93,6 @@ int send_data(ibConf_t *conf, unsigned int usec_timeout, const void *buffer, siz
 
 	board = interfaceBoard(conf);
 
-	set_timeout(board, usec_timeout);
-
 	assert(sizeof(buffer) <= sizeof(write_cmd.buffer_ptr));
 	write_cmd.buffer_ptr = (uintptr_t)buffer;
 	write_cmd.requested_transfer_count = count;
@@ -61,26 +101,148 @@ int send_data(ibConf_t *conf, unsigned int usec_timeout, const void *buffer, siz
 	write_cmd.handle = conf->handle;
 
 	retval = ioctl(board->fileno, IBWRT, &write_cmd);
-	if (retval < 0)	{
-		switch (errno) {
-			case ETIMEDOUT:
-				conf->timed_out = 1;
-				setIberr(EABO);
-				break;
-			case EINTR:
-				setIberr(EABO);
-				break;
-			case ECOMM:
-				setIberr(ENOL);
-				break;
-			case EFAULT:
-				//fall-through
-			default:
-				setIberr(EDVR);
-				setIbcnt(errno);
-				break;
+	if (retval < 0)
+		write_error(conf);
+	*bytes_written = write_cmd.completed_transfer_count;
+	return retval;
+}
+
+/*
+ * The caller's buffer is const, so swapped data is written from a bounce
+ * buffer small enough to still be in cache when the kernel copies it in.
+ * The segments are swapped as one buffer, and with eoi_on_eos set the eos
+ * character is looked for in the swapped data, as it goes out on the bus.
+ * send_eoi asks for EOI with the final byte.
+ */
+static int write_adjusted(ibConf_t *conf, const struct iovec *iov, int iovcnt,
+	int eoi_on_eos, int send_eoi, size_t *bytes_written)
+{
+	uint8_t bounce[0x4000];	// a whole number of words, so each fill swaps alone
+	size_t total = 0;
+	size_t segment_offset = 0;
+	int segment = 0;
+	int retval = 0;
+	int i;
+
+	*bytes_written = 0;
+	for (i = 0; i < iovcnt; i++)
+		total += iov[i].iov_len;
+
+	while (*bytes_written < total) {
+		size_t fill = 0;
+		size_t offset = 0;
+
+		// gather the next bounce buffer from the segments
+		while (fill < sizeof(bounce) && segment < iovcnt) {
+			size_t n = iov[segment].iov_len - segment_offset;
+
+			if (n > sizeof(bounce) - fill)
+				n = sizeof(bounce) - fill;
+			memcpy(&bounce[fill], (const uint8_t *)iov[segment].iov_base + segment_offset, n);
+			fill += n;
+			segment_offset += n;
+			if (segment_offset == iov[segment].iov_len) {
+				segment++;
+				segment_offset = 0;
+			}
+		}
+		byte_adjust(conf->settings.write_adjust, bounce, bounce, fill);
+
+		while (offset < fill) {
+			size_t block_size = fill - offset;
+			size_t num_bytes;
+			int eoi;
+
+			eoi = send_eoi && *bytes_written + block_size == total;
+			if (eoi_on_eos) {
+				int eos = find_eos(&bounce[offset], block_size, conf->settings.eos,
+					conf->settings.eos_flags);
+
+				if (eos >= 0) {
+					// EOI goes with the eos character itself
+					block_size = eos + 1;
+					eoi = 1;
+				}
+			}
+			retval = write_ioctl(conf, &bounce[offset], block_size, eoi, &num_bytes);
+			*bytes_written += num_bytes;
+			if (retval < 0 || num_bytes < block_size)
+				return retval;
+			offset += block_size;
 		}
 	}
+	return retval;
+}
+
+int send_data(ibConf_t *conf, unsigned int usec_timeout, const void *buffer, size_t count, int send_eoi, size_t *bytes_written)
+{
+	int retval;
+
+	set_timeout(interfaceBoard(conf), usec_timeout);
+
+	if (conf->settings.write_adjust) {
+		struct iovec iov = {(void *)buffer, count};
+
+		retval = write_adjusted(conf, &iov, 1, 0, send_eoi, bytes_written);
+	} else
+		retval = write_ioctl(conf, buffer, count, send_eoi, bytes_written);
+	conf->end = send_eoi && (*bytes_written == count);
+	if (retval < 0)
+		return retval;
+	return 0;
+}
+
+// writes all the segments with one ioctl, EOI is only sent with the final byte
+static int send_data_vec(ibConf_t *conf, unsigned int usec_timeout, const struct iovec *iov,
+	int iovcnt, int send_eoi, size_t *bytes_written)
+{
+	ibBoard_t *board;
+	struct gpib_read_write_vec_ioctl write_cmd;
+	struct gpib_iovec vec[GPIB_MAX_IOVEC];
+	size_t count;
+	int retval;
+
+	*bytes_written = 0;
+	if (fill_gpib_iovec(vec, iov, iovcnt, &count) < 0)
+		return -1;
+
+	board = interfaceBoard(conf);
+
+	set_timeout(board, usec_timeout);
+
+	// swapped data has to pass through user space
+	if (conf->settings.write_adjust) {
+		retval = write_adjusted(conf, iov, iovcnt, 0, send_eoi, bytes_written);
+		conf->end = send_eoi && (*bytes_written == count);
+		return retval < 0 ? retval : 0;
+	}
+
+	write_cmd.iov_ptr = (uintptr_t)vec;
+	write_cmd.iov_count = iovcnt;
+	write_cmd.completed_transfer_count = 0;
+	write_cmd.end = send_eoi;
+	write_cmd.handle = conf->handle;
+	write_cmd.end_segment = 0;
+	write_cmd.end_offset = 0;
+
+	retval = ioctl(board->fileno, IBWRTV, &write_cmd);
+	if (retval < 0 && errno == ENOTTY) {
+		int i;
+
+		// driver predates IBWRTV, fall back to one IBWRT per segment
+		for (i = 0; i < iovcnt; i++) {
+			size_t num_bytes;
+
+			retval = send_data(conf, usec_timeout, iov[i].iov_base, iov[i].iov_len,
+				send_eoi && i == iovcnt - 1, &num_bytes);
+			*bytes_written += num_bytes;
+			if (retval < 0)
+				return retval;
+		}
+		return 0;
+	}
+	if (retval < 0)
+		write_error(conf);
 	*bytes_written = write_cmd.completed_transfer_count;
 	conf->end = send_eoi && (*bytes_written == count);
 	if (retval < 0)
@@ -100,6 +262,17 @@ int send_data_smart_eoi(ibConf_t *conf,  unsigned int usec_timeout,
 
 	eoi_on_eos = conf->settings.eos_flags & XEOS;
 
+	if (eoi_on_eos && conf->settings.write_adjust) {
+		struct iovec iov = {(void *)buffer, count};
+
+		/* The eos character is looked for after swapping, and the whole
+		 * buffer is written at once so the swap stays word aligned. */
+		set_timeout(interfaceBoard(conf), usec_timeout);
+		retval = write_adjusted(conf, &iov, 1, 1, force_eoi, bytes_written);
+		conf->end = force_eoi && (*bytes_written == count);
+		return retval < 0 ? -1 : 0;
+	}
+
 	block_size = count;
 
 	if (eoi_on_eos)	{
@@ -107,7 +280,8 @@ int send_data_smart_eoi(ibConf_t *conf,  unsigned int usec_timeout,
 		if (retval < 0) {
 			eos_found = 0;
 		} else {
-			block_size = retval;
+			// EOI goes with the eos character itself
+			block_size = retval + 1;
 			eos_found = 1;
 		}
 	}
@@ -175,6 +349,77 @@ int ibwrt(int ud, const void *rd, long cnt)
 	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
 }
 
+int my_ibwrtv(ibConf_t *conf, unsigned int usec_timeout,
+	const struct iovec *iov, int iovcnt, size_t *bytes_written)
+{
+	size_t block_size;
+	int retval = 0;
+	int i;
+
+	*bytes_written = 0;
+
+	if (!conf->is_interface) {
+		// set up addressing
+		if (send_setup(conf, usec_timeout) < 0)
+			return -1;
+	}
+
+	if (conf->settings.write_adjust) {
+		// the segments are swapped as one buffer, words may straddle them
+		set_timeout(interfaceBoard(conf), usec_timeout);
+		retval = write_adjusted(conf, iov, iovcnt, conf->settings.eos_flags & XEOS,
+			conf->settings.send_eoi, bytes_written);
+	} else if (conf->settings.eos_flags & XEOS) {
+		// EOI may be due in the middle of a segment, so scan each one for eos
+		for (i = 0; i < iovcnt && retval == 0; i++) {
+			const uint8_t *buffer = iov[i].iov_base;
+			size_t count = iov[i].iov_len;
+
+			while (count) {
+				retval = send_data_smart_eoi(conf, usec_timeout, buffer, count,
+					conf->settings.send_eoi && i == iovcnt - 1, &block_size);
+				*bytes_written += block_size;
+				if (retval < 0)
+					break;
+				count -= block_size;
+				buffer += block_size;
+			}
+		}
+	} else {
+		retval = send_data_vec(conf, usec_timeout, iov, iovcnt,
+			conf->settings.send_eoi, bytes_written);
+	}
+
+	if (!conf->is_interface && conf->settings.send_unt_unl) {
+		if (unlisten_untalk(conf) < 0)
+			retval = -1;
+	}
+
+	return retval;
+}
+
+int ibwrtv(int ud, const struct iovec *iov, int iovcnt)
+{
+	ibConf_t *conf;
+	size_t count;
+	int retval;
+
+	conf = enter_library(ud);
+	if (!conf)
+		return exit_library(ud, 1);
+
+	conf->end = 0;
+
+	retval = my_ibwrtv(conf, conf->settings.usec_timeout, iov, iovcnt, &count);
+	if (retval < 0)	{
+		if (ThreadIberr() != EDVR) setIbcnt(count);
+		return exit_library(ud, 1);
+	}
+	setIbcnt(count);
+
+	return general_exit_library(ud, 0, 0, 0, DCAS, 0, 0);
+}
+
 int ibwrta(int ud, const void *buffer, long cnt)
 {
 	ibConf_t *conf;
@@ -191,30 +436,99 @@ int ibwrta(int ud, const void *buffer, long cnt)
 	return general_exit_library(ud, 0, 0, 0, 0, 0, 1);
 }
 
-int my_ibwrtf(ibConf_t *conf, const char *file_path, size_t *bytes_written)
+/*
+ * Has the driver stream count bytes of the file to the bus, without the
+ * data passing through user space.  Returns 1 if the driver can't.
+ */
+static int write_file_ioctl(ibConf_t *conf, int fd, size_t count, size_t *bytes_written)
 {
 	ibBoard_t *board;
-	long count;
+	struct gpib_file_io_ioctl write_cmd;
+	int retval;
+
+	board = interfaceBoard(conf);
+
+	memset(&write_cmd, 0, sizeof(write_cmd));
+	write_cmd.fd = fd;
+	write_cmd.handle = conf->handle;
+	write_cmd.offset = 0;
+	write_cmd.requested_transfer_count = count;
+	write_cmd.end = conf->settings.send_eoi;
+	write_cmd.eos = conf->settings.eos;
+	write_cmd.eos_flags = conf->settings.eos_flags;
+
+	retval = ioctl(board->fileno, IBWRTF, &write_cmd);
+	if (retval < 0 && errno == ENOTTY)
+		return 1;
+	*bytes_written = write_cmd.completed_transfer_count;
+	conf->end = write_cmd.end && *bytes_written == count;
+	if (write_cmd.file_error) {
+		setIberr(EFSO);
+		setIbcnt(write_cmd.file_error);
+		return -1;
+	}
+	if (retval < 0) {
+		write_error(conf);
+		return -1;
+	}
+	return 0;
+}
+
+static int write_file_chunks(ibConf_t *conf, int fd, size_t count, size_t *bytes_written)
+{
+	uint8_t buffer[ 0x4000 ];
 	size_t block_size;
+	int retval = 0;
+
+	while (count) {
+		ssize_t read_count;
+		int send_eoi;
+		size_t buffer_offset = 0;
+
+		read_count = read(fd, buffer, sizeof(buffer));
+		if (read_count <= 0) {
+			setIberr(EFSO);
+			setIbcnt(read_count < 0 ? errno : EIO);
+			return -1;
+		}
+		while (buffer_offset < read_count) {
+			send_eoi = conf->settings.send_eoi && (count == read_count - buffer_offset);
+			retval = send_data_smart_eoi(conf, conf->settings.usec_timeout, buffer + buffer_offset,
+				read_count - buffer_offset, send_eoi, &block_size);
+			count -= block_size;
+			buffer_offset += block_size;
+			*bytes_written += block_size;
+			if (retval < 0)
+				return retval;
+		}
+	}
+
+	return retval;
+}
+
+int my_ibwrtf(ibConf_t *conf, const char *file_path, size_t *bytes_written)
+{
+	ibBoard_t *board;
+	size_t count;
 	int retval;
-	FILE *data_file;
+	int fd;
 	struct stat file_stats;
-	uint8_t buffer[ 0x4000 ];
 
 	*bytes_written = 0;
 	board = interfaceBoard(conf);
 
-	data_file = fopen(file_path, "r");
-	if (!data_file)	{
+	fd = open(file_path, O_RDONLY);
+	if (fd < 0)	{
 		setIberr(EFSO);
 		setIbcnt(errno);
 		return -1;
 	}
 
-	retval = fstat(fileno(data_file), &file_stats);
+	retval = fstat(fd, &file_stats);
 	if (retval < 0)	{
 		setIberr(EFSO);
 		setIbcnt(errno);
+		close(fd);
 		return -1;
 	}
 
@@ -222,41 +536,28 @@ int my_ibwrtf(ibConf_t *conf, const char *file_path, size_t *bytes_written)
 
 	if (!conf->is_interface) {
 		// set up addressing
-		if (send_setup(conf, conf->settings.usec_timeout) < 0)
+		if (send_setup(conf, conf->settings.usec_timeout) < 0) {
+			close(fd);
 			return -1;
+		}
 	}
 
 	set_timeout(board, conf->settings.usec_timeout);
 
-	while (count) {
-		size_t fread_count;
-		int send_eoi;
-		size_t buffer_offset = 0;
+	// swapped data has to pass through user space
+	retval = 1;
+	if (count && conf->settings.write_adjust == 0)
+		retval = write_file_ioctl(conf, fd, count, bytes_written);
+	if (retval > 0)
+		retval = write_file_chunks(conf, fd, count, bytes_written);
 
-		fread_count = fread(buffer, 1, sizeof(buffer), data_file);
-		if (!fread_count) {
-			setIberr(EFSO);
-			setIbcnt(errno);
+	close(fd);
+
+	if (!conf->is_interface && conf->settings.send_unt_unl) {
+		if (unlisten_untalk(conf) < 0)
 			retval = -1;
-			break;
-		}
-		while (buffer_offset < fread_count) {
-			send_eoi = conf->settings.send_eoi && (count == fread_count - buffer_offset);
-			retval = send_data_smart_eoi(conf, conf->settings.usec_timeout, buffer + buffer_offset,
-				fread_count - buffer_offset, send_eoi, &block_size);
-			count -= block_size;
-			buffer_offset += block_size;
-			*bytes_written += block_size;
-			if (retval < 0)	{
-				count = 0;
-				break;
-			}
-		}
 	}
 
-	if (!conf->is_interface && conf->settings.send_unt_unl)
-		retval = unlisten_untalk(conf);
-
 	return retval;
 }
 
@@ -305,21 +606,22 @@ int InternalSendDataBytes(ibConf_t *conf, const void *buffer,
 			break;
 	}
 
-	retval = send_data(conf, conf->settings.usec_timeout, buffer, count, eotmode == DABend, &num_bytes);
-	bytes_written += num_bytes;
-	if (retval < 0)	{
-		setIbcnt(bytes_written);
-		return retval;
-	}
 	if (eotmode == NLend) {
-		retval = send_data(conf, conf->settings.usec_timeout, "\n", 1, 1, &num_bytes);
-		bytes_written += num_bytes;
-		if (retval < 0)	{
-			setIbcnt(bytes_written);
-			return retval;
-		}
+		struct iovec iov[2];
+
+		// send the data and the newline carrying EOI with a single ioctl
+		iov[0].iov_base = (void *)buffer;
+		iov[0].iov_len = count;
+		iov[1].iov_base = "\n";
+		iov[1].iov_len = 1;
+		retval = send_data_vec(conf, conf->settings.usec_timeout, iov, 2, 1, &num_bytes);
+	} else {
+		retval = send_data(conf, conf->settings.usec_timeout, buffer, count, eotmode == DABend, &num_bytes);
 	}
+	bytes_written += num_bytes;
 	setIbcnt(bytes_written);
+	if (retval < 0)
+		return retval;
 	return 0;
 }
 
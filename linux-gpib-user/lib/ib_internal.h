@@ -23,6 +23,7 @@
 #include "gpib/gpib_ioctl.h"
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <assert.h>
 
 #include "ibConf.h"
@@ -47,6 +48,24 @@ int ibFindDevIndex(const char *name);
 ssize_t my_ibcmd(ibConf_t *conf, unsigned int usec_timout, const uint8_t *buffer, size_t length);
 int my_ibrd(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read);
 int my_ibwrt(ibConf_t *conf, unsigned int usec_timeout, const uint8_t *buffer, size_t count, size_t *bytes_written);
+int read_data(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read);
+int read_data_raw(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count, size_t *bytes_read);
+int my_ibrdblk(ibConf_t *conf, unsigned int usec_timeout, uint8_t *buffer, size_t count,
+	int (*callback)(void *context, const void *data, long count, long block_length),
+	void *context, size_t *bytes_read);
+int my_ibrdv(ibConf_t *conf, unsigned int usec_timeout, const struct iovec *iov, int iovcnt, size_t *bytes_read);
+int my_ibwrtv(ibConf_t *conf, unsigned int usec_timeout, const struct iovec *iov, int iovcnt, size_t *bytes_written);
+int send_data_smart_eoi(ibConf_t *conf, unsigned int usec_timeout,
+	const void *buffer, size_t count, int force_eoi, size_t *bytes_written);
+int my_trigger(ibConf_t *conf, const Addr4882_t addressList[]);
+int fill_gpib_iovec(struct gpib_iovec *vec, const struct iovec *iov, int iovcnt, size_t *total);
+void byte_adjust(int mode, uint8_t *dst, const uint8_t *src, size_t length);
+void byte_adjust_scalar(int mode, uint8_t *dst, const uint8_t *src, size_t length);
+void byte_adjust_iovec(int mode, const struct iovec *iov, int iovcnt, size_t length);
+int internal_ibdma(ibConf_t *conf, int enable);
+int query_dma(ibConf_t *conf, int *enabled);
+int set_dma_threshold(ibConf_t *conf, unsigned int threshold);
+int query_dma_threshold(ibConf_t *conf);
 unsigned int send_setup_string(const ibConf_t *conf, uint8_t *cmdString);
 unsigned int create_send_setup(const ibBoard_t *board,
 	const Addr4882_t addressList[], uint8_t *cmdString);
@@ -141,9 +160,27 @@ enum gpib_aio_varieties
 	GPIB_AIO_COMMAND,
 	GPIB_AIO_READ,
 	GPIB_AIO_WRITE,
+	GPIB_AIO_WAIT,
 };
 int gpib_aio_launch(int ud, ibConf_t *conf, int gpib_aio_type,
 	void *buffer, long cnt);
 int gpib_aio_join(struct async_operation *async);
 
+void ibstream_release(ibBoard_t *board);
+
+/* configuration sharing through gpibd */
+const char *gpibd_socket_path(void);
+int gpibd_init_devices(void);
+int gpibd_listen(const char *path);
+int gpibd_send_config(int sock);
+int gpibd_fetch_config(void);
+
+/* binary cache of the parsed configuration file */
+const char *gpib_conf_cache_path(const char *config_file);
+int gpib_conf_cache_load(const char *config_file, ibConf_t *configs, unsigned int configs_length,
+	ibBoard_t *boards, unsigned int boards_length, int minor);
+int gpib_conf_cache_store(const char *config_file, const ibConf_t *configs, unsigned int configs_length,
+	const ibBoard_t *boards, unsigned int boards_length);
+int gpib_conf_cache_update(const char *config_file);
+
 #endif	/* _IB_INTERNAL_H */
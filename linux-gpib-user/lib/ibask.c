@@ -228,15 +228,11 @@ int ibask(int ud, int option, int *value)
 			return exit_library(ud, 0);
 			break;
 		case IbaReadAdjust:
-			/* XXX I guess I could implement byte swapping stuff,
-			 * it's pretty stupid though */
-			*value = 0;
+			*value = conf->settings.read_adjust;
 			return exit_library(ud, 0);
 			break;
 		case IbaWriteAdjust:
-			/* XXX I guess I could implement byte swapping stuff,
-			 * it's pretty stupid though */
-			*value = 0;
+			*value = conf->settings.write_adjust;
 			return exit_library(ud, 0);
 			break;
 		case IbaEndBitIsNormal:
@@ -302,8 +298,8 @@ int ibask(int ud, int option, int *value)
 				return exit_library(ud, 0);
 				break;
 			case IbaDMA:
-				// XXX bogus, but pretty unimportant
-				*value = board->dma;
+				if (query_dma(conf, value) < 0)
+					return exit_library(ud, 1);
 				return exit_library(ud, 0);
 				break;
 			case IbaEventQueue:
@@ -349,6 +345,13 @@ int ibask(int ud, int option, int *value)
 				*value = !retval;
 				return exit_library(ud, 0);
 				break;
+			case IbaDMAThreshold:
+				retval = query_dma_threshold(conf);
+				if (retval < 0)
+					return exit_library(ud, 1);
+				*value = retval;
+				return exit_library(ud, 0);
+				break;
 			default:
 				break;
 		}
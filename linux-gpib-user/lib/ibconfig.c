@@ -174,24 +174,20 @@ int ibconfig(int ud, int option, int value)
 			return exit_library(ud, 0);
 			break;
 		case IbcReadAdjust:
-			// XXX
-			if (value) {
-				fprintf(stderr, "libgpib: byte swapping on reads not implemented\n");
-				setIberr(ECAP);
+			if (value != NO_SWAP && value != SWAP_PAIRS && value != SWAP_QUADS) {
+				setIberr(EARG);
 				return exit_library(ud, 1);
-			} else {
-				return exit_library(ud, 0);
 			}
+			conf->settings.read_adjust = value;
+			return exit_library(ud, 0);
 			break;
 		case IbcWriteAdjust:
-			// XXX
-			if (value) {
-				fprintf(stderr, "libgpib: byte swapping on writes not implemented\n");
-				setIberr(ECAP);
+			if (value != NO_SWAP && value != SWAP_PAIRS && value != SWAP_QUADS) {
+				setIberr(EARG);
 				return exit_library(ud, 1);
-			} else {
-				return exit_library(ud, 0);
 			}
+			conf->settings.write_adjust = value;
+			return exit_library(ud, 0);
 			break;
 		case IbcEndBitIsNormal:
 			if (value) {
@@ -265,14 +261,18 @@ int ibconfig(int ud, int option, int value)
 				return exit_library(ud, 0);
 				break;
 			case IbcDMA:
-				// XXX
-				if (value) {
-					return exit_library(ud, 0);
-				} else {
-					fprintf(stderr, "libgpib: disabling DMA not supported\n");
-					setIberr(ECAP);
+				if (internal_ibdma(conf, value) < 0)
+					return exit_library(ud, 1);
+				return exit_library(ud, 0);
+				break;
+			case IbcDMAThreshold:
+				if (value <= 0) {
+					setIberr(EARG);
 					return exit_library(ud, 1);
 				}
+				if (set_dma_threshold(conf, value) < 0)
+					return exit_library(ud, 1);
+				return exit_library(ud, 0);
 				break;
 			case IbcEventQueue:
 				if (value) {
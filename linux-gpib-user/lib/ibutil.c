@@ -73,6 +73,8 @@ int release_descriptor(int ud)
 {
 	if (ud >= GPIB_MAX_NUM_BOARDS  && ud < GPIB_CONFIGS_LENGTH && ibConfigs[ud]) {
 		// need to take more care to clean up before freeing XXX
+		if (ibConfigs[ud]->async.notify_fd >= 0)
+			close(ibConfigs[ud]->async.notify_fd);
 		free(ibConfigs[ud]);
 		ibConfigs[ud] = NULL;
 		return 0;
@@ -137,6 +139,44 @@ static void gpib_atfork_child(void)
 		}
 }
 
+/*
+ * Open addressed hash of ibFindConfigs[] names for ibFindDevIndex().
+ * Slots hold index + 1, so zero marks an empty slot.
+ */
+#define NAME_HASH_LENGTH (2 * FIND_CONFIGS_LENGTH)
+static uint8_t name_hash[NAME_HASH_LENGTH];
+static int name_hash_built;
+
+static unsigned int name_hash_value(const char *name)
+{
+	unsigned int hash = 2166136261u;	/* FNV-1a */
+
+	for (; *name; name++)
+		hash = (hash ^ (uint8_t)*name) * 16777619u;
+	return hash;
+}
+
+static void build_name_hash(void)
+{
+	unsigned int slot;
+	int i;
+
+	memset(name_hash, 0, sizeof(name_hash));
+	/*
+	 * Lookups probe forward from a name's home slot, so inserting in
+	 * index order puts the first of duplicate names ahead of the others.
+	 */
+	for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+		if (ibFindConfigs[i].name[0] == 0)
+			continue;
+		slot = name_hash_value(ibFindConfigs[i].name) % NAME_HASH_LENGTH;
+		while (name_hash[slot])
+			slot = (slot + 1) % NAME_HASH_LENGTH;
+		name_hash[slot] = i + 1;
+	}
+	name_hash_built = 1;
+}
+
 int ibParseConfigFile(int minor)
 {
 	int retval = 0;
@@ -159,13 +199,30 @@ int ibParseConfigFile(int minor)
 	else
 		filename = DEFAULT_CONFIG_FILE;
 
-	retval = parse_gpib_conf(filename, ibFindConfigs, FIND_CONFIGS_LENGTH,
-				 ibBoard, GPIB_MAX_NUM_BOARDS ,minor);
+	/*
+	 * Use the configuration of a running gpibd, unless a private config
+	 * was asked for.  Not for a board's minor either, which may need an
+	 * interface entry parse_gpib_conf() makes up when gpib.conf has none.
+	 */
+	if (envptr == NULL && minor < 0 && gpibd_fetch_config() == 0) {
+		retval = 0;
+	} else if (gpib_conf_cache_load(filename, ibFindConfigs, FIND_CONFIGS_LENGTH,
+					ibBoard, GPIB_MAX_NUM_BOARDS, minor) == 0) {
+		retval = 0;
+	} else {
+		retval = parse_gpib_conf(filename, ibFindConfigs, FIND_CONFIGS_LENGTH,
+					 ibBoard, GPIB_MAX_NUM_BOARDS ,minor);
+		/* best effort, only works if we may write the cache */
+		if (retval == 0 && minor < 0)
+			gpib_conf_cache_store(filename, ibFindConfigs, FIND_CONFIGS_LENGTH,
+					      ibBoard, GPIB_MAX_NUM_BOARDS);
+	}
 	if (retval < 0)	{
 		setIberr(ECNF);
 		pthread_mutex_unlock(&config_lock);
 		return retval;
 	}
+	build_name_hash();
 	retval = setup_global_board_descriptors();
 
 	if (minor < 0)  /* called from ibfind so interface entry must be present */
@@ -214,12 +271,23 @@ done:
 
 int ibFindDevIndex(const char *name)
 {
+	unsigned int slot;
 	int i;
 
 	if (strcmp("", name) == 0)
 		return -1;
 
-	for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+	if (name_hash_built == 0) {
+		for (i = 0; i < FIND_CONFIGS_LENGTH; i++) {
+			if (!strcmp(ibFindConfigs[i].name, name))
+				return i;
+		}
+		return -1;
+	}
+
+	for (slot = name_hash_value(name) % NAME_HASH_LENGTH; name_hash[slot];
+	     slot = (slot + 1) % NAME_HASH_LENGTH) {
+		i = name_hash[slot] - 1;
 		if (!strcmp(ibFindConfigs[i].name, name))
 			return i;
 	}
@@ -253,6 +321,8 @@ void init_descriptor_settings(descriptor_settings_t *settings)
 	settings->local_lockout = 0;
 	settings->readdr = 0;
 	settings->send_unt_unl = 0;
+	settings->read_adjust = NO_SWAP;
+	settings->write_adjust = NO_SWAP;
 }
 
 void init_ibconf(ibConf_t *conf)
@@ -0,0 +1,136 @@
+/***************************************************************************
+                             adjust_bench.c
+                             -------------------
+
+Checks the vector byte swapping kernels used for IbcReadAdjust and
+IbcWriteAdjust against the scalar ones, and times them.  Each case copies
+a buffer (standing in for the kernel's copy to user space) and then swaps
+it, either in one pass over the whole buffer afterwards or in blocks
+while each block is still in cache, which is what libgpib does.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ib_internal.h"
+#include "bench.h"
+
+#define BLOCK_SIZE 0x4000
+
+typedef void (*adjust_func)(int mode, uint8_t *dst, const uint8_t *src, size_t length);
+
+static void post_pass(adjust_func adjust, int mode, uint8_t *dst, const uint8_t *src, size_t length)
+{
+	memcpy(dst, src, length);
+	adjust(mode, dst, dst, length);
+}
+
+static void blocked(adjust_func adjust, int mode, uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t offset;
+
+	for (offset = 0; offset < length; offset += BLOCK_SIZE) {
+		size_t num_bytes = length - offset < BLOCK_SIZE ? length - offset : BLOCK_SIZE;
+
+		memcpy(&dst[offset], &src[offset], num_bytes);
+		adjust(mode, &dst[offset], &dst[offset], num_bytes);
+	}
+}
+
+static int check(int mode)
+{
+	static const uint8_t known[] = {1, 2, 3, 4, 5};
+	static const uint8_t pairs[] = {2, 1, 4, 3, 5};
+	static const uint8_t quads[] = {4, 3, 2, 1, 5};
+	uint8_t src[259], expected[sizeof(src)], result[sizeof(src)];
+	size_t offset, length, i;
+
+	byte_adjust(mode, result, known, sizeof(known));
+	if (memcmp(result, mode == SWAP_PAIRS ? pairs : quads, sizeof(known))) {
+		fprintf(stderr, "mode %i: wrong byte order\n", mode);
+		return -1;
+	}
+	for (i = 0; i < sizeof(src); i++)
+		src[i] = rand();
+	/* every alignment and every tail length */
+	for (offset = 0; offset < 4; offset++) {
+		for (length = 0; offset + length <= sizeof(src); length++) {
+			byte_adjust_scalar(mode, expected, &src[offset], length);
+			byte_adjust(mode, result, &src[offset], length);
+			if (memcmp(expected, result, length)) {
+				fprintf(stderr, "mode %i offset %zu length %zu: copy differs\n",
+					mode, offset, length);
+				return -1;
+			}
+			memcpy(result, &src[offset], length);
+			byte_adjust(mode, result, result, length);
+			if (memcmp(expected, result, length)) {
+				fprintf(stderr, "mode %i offset %zu length %zu: in place differs\n",
+					mode, offset, length);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static void run(const char *name, void (*pass)(adjust_func, int, uint8_t *, const uint8_t *, size_t),
+	adjust_func adjust, int mode, uint8_t *dst, const uint8_t *src, size_t length)
+{
+	size_t total = 0;
+	double start, elapsed;
+
+	start = now_usec();
+	do {
+		pass(adjust, mode, dst, src, length);
+		total += length;
+		elapsed = now_usec() - start;
+	} while (elapsed < 2e5);
+	printf("  %-22s %8.0f MB/s\n", name, total / elapsed);
+}
+
+int main(int argc, char *argv[])
+{
+	static const size_t lengths[] = {0x1000, 0x40000, 0x1000000};
+	static const int modes[] = {SWAP_PAIRS, SWAP_QUADS};
+	uint8_t *src, *dst;
+	unsigned int i, j;
+
+	for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+		if (check(modes[i]) < 0)
+			return 1;
+	}
+	if (argc > 1 && strcmp(argv[1], "--check") == 0)
+		return 0;
+
+	src = malloc(lengths[2]);
+	dst = malloc(lengths[2]);
+	if (!src || !dst)
+		return 1;
+	memset(src, 0x5a, lengths[2]);
+	memset(dst, 0, lengths[2]);
+
+	for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+		for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+			printf("%s, %zu bytes\n", modes[i] == SWAP_PAIRS ? "pairs" : "quads", lengths[j]);
+			run("copy, scalar pass", post_pass, byte_adjust_scalar, modes[i], dst, src, lengths[j]);
+			run("copy, vector pass", post_pass, byte_adjust, modes[i], dst, src, lengths[j]);
+			run("copy+vector blocked", blocked, byte_adjust, modes[i], dst, src, lengths[j]);
+		}
+	}
+	free(src);
+	free(dst);
+	return 0;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+                             bench.h
+                             -------------------
+
+Timing and report helpers shared by the benchmarks in this directory.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+/* RUSAGE_THREAD needs _GNU_SOURCE defined before any system header */
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#ifdef _PUBLIC_GPIB_H
+#define PRINT_FAILED(what) \
+	fprintf(stderr, "FAILED: %s, ibsta 0x%x, iberr %i, ibcntl %li\n", \
+		what, ThreadIbsta(), ThreadIberr(), ThreadIbcntl())
+#endif
+
+static inline double now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static inline double now_usec(void)
+{
+	return now_nsec() / 1e3;
+}
+
+/* user and system time of the calling thread */
+static inline double cpu_usec(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_THREAD, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+		usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/* bytes per microsecond is MB/s */
+static inline void report_rate(const char *what, double bytes, double wall_usec)
+{
+	printf("%-10s %10.2f MB/s\n", what, bytes / wall_usec);
+}
+
+/*
+ * Prints wall and cpu time per unit without ending the line, so the
+ * caller can add columns of its own.
+ */
+static inline void report_per_unit(const char *what, double wall_usec, double cpu,
+	double count, const char *unit)
+{
+	if (count <= 0)
+		count = 1;
+	printf("%-10s %10.2f us/%s %10.2f cpu us/%s", what, wall_usec / count, unit,
+		cpu / count, unit);
+}
+
+#endif	/* _BENCH_H */
@@ -0,0 +1,466 @@
+/***************************************************************************
+                             bitbang_sim.c
+                             -------------------
+
+Device emulator and benchmark for the gpib_bitbang driver running on a
+simulated gpio chip (the kernel's gpio-sim module, pin_map="sim").  The
+emulator drives the far side of the simulated GPIB lines through the
+gpio-sim sysfs attributes and behaves like a single echo device: what is
+written to it is sent back when it is addressed to talk.  The benchmark
+times writes, reads and commands through libgpib while it runs.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "gpib/ib.h"
+#include "bench.h"
+
+/* simulated line numbers, the elektronomikon wiring of gpib_bitbang.c */
+enum sim_lines
+{
+	LINE_D01 = 20, LINE_D02 = 26, LINE_D03 = 16, LINE_D04 = 19,
+	LINE_D05 = 13, LINE_D06 = 12, LINE_D07 = 6, LINE_D08 = 5,
+	LINE_EOI = 9, LINE_DAV = 10, LINE_NRFD = 24, LINE_NDAC = 23,
+	LINE_IFC = 22, LINE_SRQ = 11, LINE_ATN = 25, LINE_REN = 27,
+	NUM_SIM_LINES = 28
+};
+
+static const int data_lines[8] = {LINE_D01, LINE_D02, LINE_D03, LINE_D04,
+	LINE_D05, LINE_D06, LINE_D07, LINE_D08};
+static const int bus_lines[] = {LINE_D01, LINE_D02, LINE_D03, LINE_D04,
+	LINE_D05, LINE_D06, LINE_D07, LINE_D08, LINE_EOI, LINE_DAV, LINE_NRFD,
+	LINE_NDAC, LINE_IFC, LINE_SRQ, LINE_ATN, LINE_REN};
+
+#define MESSAGE_LENGTH 0x10000
+
+struct sim_line
+{
+	int value_fd;
+	int pull_fd;
+	int pull;
+};
+
+struct sim_device
+{
+	struct sim_line lines[NUM_SIM_LINES];
+	unsigned int pad;
+	volatile sig_atomic_t stop;
+	int listen;
+	int talk;
+	uint8_t message[MESSAGE_LENGTH];
+	size_t message_length;
+	size_t response_length;
+	size_t out_pos;
+	size_t out_length;
+	unsigned long bytes_handshaken;
+};
+
+struct program_options
+{
+	const char *sysfs;
+	int minor;
+	unsigned int pad;
+	int num_loops;
+	size_t length;
+	size_t response_length;
+	int emulate_only;
+};
+
+static struct sim_device sim;
+
+/*
+ * Both sides of a line meet in gpio-sim: "value" is what the driver sees
+ * or drives, "pull" is what we drive.  A released (high) pull lets the
+ * driver's output win, like the open collector bus.
+ */
+static int read_line(struct sim_device *dev, int line)
+{
+	char c;
+
+	if (pread(dev->lines[line].value_fd, &c, 1, 0) != 1)
+		return 1;
+	return c == '1';
+}
+
+static void set_line(struct sim_device *dev, int line, int value)
+{
+	struct sim_line *l = &dev->lines[line];
+	const char *pull = value ? "pull-up" : "pull-down";
+
+	if (l->pull == value)
+		return;
+	if (pwrite(l->pull_fd, pull, strlen(pull), 0) < 0)
+		perror("bitbang_sim: pull");
+	l->pull = value;
+}
+
+static void release_bus(struct sim_device *dev)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(bus_lines) / sizeof(bus_lines[0]); i++)
+		set_line(dev, bus_lines[i], 1);
+}
+
+static int open_lines(struct sim_device *dev, const char *sysfs)
+{
+	char path[4096];
+	unsigned int i;
+
+	for (i = 0; i < NUM_SIM_LINES; i++) {
+		dev->lines[i].value_fd = -1;
+		dev->lines[i].pull_fd = -1;
+	}
+	for (i = 0; i < sizeof(bus_lines) / sizeof(bus_lines[0]); i++) {
+		struct sim_line *l = &dev->lines[bus_lines[i]];
+
+		snprintf(path, sizeof(path), "%s/sim_gpio%d/value", sysfs, bus_lines[i]);
+		l->value_fd = open(path, O_RDONLY | O_CLOEXEC);
+		snprintf(path, sizeof(path), "%s/sim_gpio%d/pull", sysfs, bus_lines[i]);
+		l->pull_fd = open(path, O_WRONLY | O_CLOEXEC);
+		if (l->value_fd < 0 || l->pull_fd < 0) {
+			fprintf(stderr, "bitbang_sim: failed to open %s: %s\n", path, strerror(errno));
+			return -1;
+		}
+		l->pull = -1;
+	}
+	release_bus(dev);
+	return 0;
+}
+
+/* wait for line to reach value while ATN keeps its state */
+static int wait_line(struct sim_device *dev, int line, int value, int atn)
+{
+	while (read_line(dev, line) != value) {
+		if (dev->stop || read_line(dev, LINE_ATN) != atn ||
+		    read_line(dev, LINE_IFC) == 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* acceptor handshake for one byte, data lines and EOI are active low */
+static int accept_byte(struct sim_device *dev, int atn, uint8_t *byte, int *eoi)
+{
+	int i;
+
+	set_line(dev, LINE_NDAC, 0);
+	set_line(dev, LINE_NRFD, 1);
+	if (wait_line(dev, LINE_DAV, 0, atn))
+		return -1;
+	set_line(dev, LINE_NRFD, 0);
+	*byte = 0;
+	for (i = 0; i < 8; i++) {
+		if (read_line(dev, data_lines[i]) == 0)
+			*byte |= 1 << i;
+	}
+	*eoi = read_line(dev, LINE_EOI) == 0;
+	set_line(dev, LINE_NDAC, 1);
+	while (read_line(dev, LINE_DAV) == 0 && !dev->stop)
+		;
+	set_line(dev, LINE_NDAC, 0);
+	dev->bytes_handshaken++;
+	return 0;
+}
+
+/* source handshake for one byte */
+static int source_byte(struct sim_device *dev, uint8_t byte, int eoi)
+{
+	int i, retval = 0;
+
+	if (wait_line(dev, LINE_NRFD, 1, 1))
+		return -1;
+	for (i = 0; i < 8; i++)
+		set_line(dev, data_lines[i], !(byte & (1 << i)));
+	set_line(dev, LINE_EOI, !eoi);
+	set_line(dev, LINE_DAV, 0);
+	if (wait_line(dev, LINE_NDAC, 1, 1))
+		retval = -1;
+	set_line(dev, LINE_DAV, 1);
+	set_line(dev, LINE_EOI, 1);
+	if (retval == 0)
+		dev->bytes_handshaken++;
+	return retval;
+}
+
+static void load_response(struct sim_device *dev)
+{
+	size_t i;
+
+	dev->out_pos = 0;
+	if (dev->response_length) {
+		for (i = 0; i < dev->response_length && i < MESSAGE_LENGTH; i++)
+			dev->message[i] = i;
+		dev->out_length = i;
+	} else {
+		dev->out_length = dev->message_length;
+	}
+}
+
+static void do_command(struct sim_device *dev, uint8_t command)
+{
+	command &= 0x7f;
+	if (command == UNL) {
+		dev->listen = 0;
+	} else if (command == UNT) {
+		dev->talk = 0;
+	} else if (command == DCL || command == SDC) {
+		dev->message_length = 0;
+		dev->out_length = 0;
+	} else if (command == MLA(dev->pad)) {
+		dev->listen = 1;
+		dev->message_length = 0;
+	} else if ((command & 0x60) == 0x40) {
+		dev->talk = command == MTA(dev->pad);
+		if (dev->talk)
+			load_response(dev);
+	}
+}
+
+static void *emulate(void *arg)
+{
+	struct sim_device *dev = arg;
+	uint8_t byte;
+	int eoi;
+
+	while (dev->stop == 0) {
+		if (read_line(dev, LINE_IFC) == 0) {
+			dev->listen = 0;
+			dev->talk = 0;
+			release_bus(dev);
+			continue;
+		}
+		if (read_line(dev, LINE_ATN) == 0) {
+			/* every device takes part in command handshakes */
+			set_line(dev, LINE_DAV, 1);
+			if (accept_byte(dev, 0, &byte, &eoi) == 0)
+				do_command(dev, byte);
+		} else if (dev->listen) {
+			if (accept_byte(dev, 1, &byte, &eoi) == 0 &&
+			    dev->message_length < MESSAGE_LENGTH)
+				dev->message[dev->message_length++] = byte;
+		} else if (dev->talk && dev->out_pos < dev->out_length) {
+			set_line(dev, LINE_NRFD, 1);
+			set_line(dev, LINE_NDAC, 1);
+			byte = dev->message[dev->out_pos];
+			if (source_byte(dev, byte, dev->out_pos + 1 == dev->out_length) == 0)
+				dev->out_pos++;
+		} else {
+			release_bus(dev);
+		}
+	}
+	release_bus(dev);
+	return NULL;
+}
+
+static void report(const char *what, double wall, double cpu, unsigned long bytes)
+{
+	report_per_unit(what, wall, cpu, bytes, "byte");
+	printf(" %10lu bytes\n", bytes);
+}
+
+static int bench(const struct program_options *options)
+{
+	static const uint8_t commands[] = {UNL, UNT};
+	uint8_t *out, *in;
+	unsigned long handshaken;
+	double wall, cpu;
+	size_t i;
+	int ud, loop;
+	int retval = -1;
+
+	out = malloc(options->length);
+	in = malloc(options->length);
+	if (out == NULL || in == NULL)
+		goto out;
+	for (i = 0; i < options->length; i++)
+		out[i] = 'A' + i % 26;
+
+	ud = ibdev(options->minor, options->pad, 0, T3s, 1, 0);
+	if (ud < 0) {
+		PRINT_FAILED("ibdev");
+		goto out;
+	}
+
+	handshaken = sim.bytes_handshaken;
+	wall = now_usec();
+	cpu = cpu_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (ibcmd(options->minor, commands, sizeof(commands)) & ERR) {
+			PRINT_FAILED("ibcmd");
+			goto out_onl;
+		}
+	}
+	report("command", now_usec() - wall, cpu_usec() - cpu,
+		sim.bytes_handshaken - handshaken);
+
+	wall = cpu = 0;
+	for (loop = 0; loop < options->num_loops; loop++) {
+		double start = now_usec(), start_cpu = cpu_usec();
+
+		if (ibwrt(ud, out, options->length) & ERR) {
+			PRINT_FAILED("ibwrt");
+			goto out_onl;
+		}
+		wall += now_usec() - start;
+		cpu += cpu_usec() - start_cpu;
+		if (options->response_length)
+			continue;
+		if ((ibrd(ud, in, options->length) & ERR) ||
+		    ThreadIbcntl() != (long)options->length ||
+		    memcmp(in, out, options->length)) {
+			PRINT_FAILED("echo");
+			goto out_onl;
+		}
+	}
+	report("write", wall, cpu, options->length * options->num_loops);
+
+	wall = cpu = 0;
+	for (loop = 0; loop < options->num_loops; loop++) {
+		double start = now_usec(), start_cpu = cpu_usec();
+
+		if (ibrd(ud, in, options->length) & ERR) {
+			PRINT_FAILED("ibrd");
+			goto out_onl;
+		}
+		wall += now_usec() - start;
+		cpu += cpu_usec() - start_cpu;
+	}
+	report("read", wall, cpu, options->length * options->num_loops);
+	retval = 0;
+
+out_onl:
+	ibonl(ud, 0);
+out:
+	free(out);
+	free(in);
+	return retval;
+}
+
+static void help(void)
+{
+	printf("bitbang_sim [options] - emulate a device on a gpio-sim gpib_bitbang bus\n");
+	printf("\t-c, --sysfs DIR\n"
+		"\t\tsysfs directory of the simulated gpio chip (required).\n");
+	printf("\t-e, --emulate-only\n"
+		"\t\tRun the device emulator until interrupted, without benchmarking.\n");
+	printf("\t-l, --length N\n"
+		"\t\tBytes per write and read (default 1024).\n");
+	printf("\t-M, --minor N\n"
+		"\t\tBoard index of the gpib_bitbang board (default 0).\n");
+	printf("\t-n, --num_loops N\n"
+		"\t\tTransfers timed per test (default 100).\n");
+	printf("\t-p, --pad N\n"
+		"\t\tPrimary address of the emulated device (default 1).\n");
+	printf("\t-r, --response N\n"
+		"\t\tAnswer reads with N generated bytes instead of echoing writes.\n");
+}
+
+static void quit_handler(int sig)
+{
+	sim.stop = 1;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"sysfs", required_argument, NULL, 'c'},
+		{"emulate-only", no_argument, NULL, 'e'},
+		{"help", no_argument, NULL, 'h'},
+		{"length", required_argument, NULL, 'l'},
+		{"minor", required_argument, NULL, 'M'},
+		{"num_loops", required_argument, NULL, 'n'},
+		{"pad", required_argument, NULL, 'p'},
+		{"response", required_argument, NULL, 'r'},
+		{0, 0, 0, 0}
+	};
+	struct program_options opts = {
+		.minor = 0,
+		.pad = 1,
+		.num_loops = 100,
+		.length = 1024,
+	};
+	pthread_t thread;
+	int retval;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:ehl:M:n:p:r:", options, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			opts.sysfs = optarg;
+			break;
+		case 'e':
+			opts.emulate_only = 1;
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 'l':
+			opts.length = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			opts.minor = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			opts.num_loops = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			opts.pad = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			opts.response_length = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+	if (opts.sysfs == NULL || opts.pad > (unsigned int)gpib_addr_max ||
+	    opts.length == 0 || opts.length > MESSAGE_LENGTH) {
+		help();
+		return 1;
+	}
+	if (opts.response_length)
+		opts.length = opts.response_length;
+
+	sim.pad = opts.pad;
+	sim.response_length = opts.response_length;
+	if (open_lines(&sim, opts.sysfs) < 0)
+		return 1;
+
+	signal(SIGINT, quit_handler);
+	signal(SIGTERM, quit_handler);
+	if (opts.emulate_only) {
+		emulate(&sim);
+		return 0;
+	}
+
+	if (pthread_create(&thread, NULL, emulate, &sim)) {
+		fprintf(stderr, "bitbang_sim: failed to start emulator thread\n");
+		return 1;
+	}
+	retval = bench(&opts);
+	sim.stop = 1;
+	pthread_join(thread, NULL);
+	return retval ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+/***************************************************************************
+                             fake_gpib.c
+                             -------------------
+
+A fake /dev/gpibN for measuring the library's own overhead, to be loaded
+with LD_PRELOAD.  Opening /dev/gpibN returns a descriptor whose ioctls are
+answered in memory: every transfer completes at once with the requested
+byte count, reads end with END, the board is always controller-in-charge
+and waits are satisfied immediately.  Data buffers are not touched, so the
+time per call is that of the library alone.  It also counts the ioctls,
+opens and closes of fake devices, and the calls to malloc() and friends,
+which lib_bench reads through fake_gpib_counters().
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+/* the fortified open() is an inline wrapper which can't be replaced */
+#undef _FORTIFY_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "gpib/gpib_ioctl.h"
+#include "gpib/gpib.h"
+#include "fake_gpib.h"
+
+#define FAKE_MAX_FDS 1024
+
+/* minor + 1 of the fake board open on each file descriptor, 0 if none */
+static int fake_fds[FAKE_MAX_FDS];
+static struct fake_gpib_counters counters;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static void count(unsigned long *counter)
+{
+	__atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+const struct fake_gpib_counters *fake_gpib_counters(void)
+{
+	return &counters;
+}
+
+void *malloc(size_t size)
+{
+	count(&counters.allocs);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	count(&counters.allocs);
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	count(&counters.allocs);
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	if (ptr)
+		count(&counters.frees);
+	__libc_free(ptr);
+}
+
+static int fake_minor(const char *path)
+{
+	unsigned int minor;
+	char extra;
+
+	if (sscanf(path, "/dev/gpib%u%c", &minor, &extra) != 1)
+		return -1;
+	return minor;
+}
+
+static int fake_open(const char *path, int flags, mode_t mode)
+{
+	int minor = fake_minor(path);
+	int fd;
+
+	if (minor < 0)
+		return syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+
+	count(&counters.opens);
+	fd = syscall(SYS_openat, AT_FDCWD, "/dev/null", O_RDWR | (flags & O_CLOEXEC));
+	if (fd < 0)
+		return -1;
+	if (fd >= FAKE_MAX_FDS) {
+		syscall(SYS_close, fd);
+		errno = EMFILE;
+		return -1;
+	}
+	fake_fds[fd] = minor + 1;
+	return fd;
+}
+
+int open(const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	va_list ap;
+
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+	return fake_open(path, flags, mode);
+}
+
+int open64(const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	va_list ap;
+
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+	return fake_open(path, flags, mode);
+}
+
+int close(int fd)
+{
+	if (fd >= 0 && fd < FAKE_MAX_FDS && fake_fds[fd]) {
+		count(&counters.closes);
+		fake_fds[fd] = 0;
+	}
+	return syscall(SYS_close, fd);
+}
+
+static void fake_wait(struct gpib_wait_ioctl *cmd)
+{
+	/* nothing is ever waited for, so report what was asked for as having happened */
+	cmd->ibsta = CMPL | CIC | (cmd->wait_mask & (RQS | SRQI | END));
+}
+
+static long fake_iovec_length(const struct gpib_read_write_vec_ioctl *cmd)
+{
+	const struct gpib_iovec *iov = (const struct gpib_iovec *)(uintptr_t)cmd->iov_ptr;
+	long length = 0;
+	unsigned int i;
+
+	for (i = 0; i < cmd->iov_count; i++)
+		length += iov[i].len;
+	return length;
+}
+
+static int fake_ioctl(unsigned long request, void *arg)
+{
+	struct gpib_read_write_ioctl *rw = arg;
+	struct gpib_read_write_vec_ioctl *rwv = arg;
+	struct gpib_open_dev_ioctl *open_dev = arg;
+	struct gpib_board_info_ioctl *info = arg;
+	static unsigned int next_handle = 1;
+
+	switch (request) {
+	case IBRD:
+		rw->completed_transfer_count = rw->requested_transfer_count;
+		rw->end = 1;
+		return 0;
+	case IBWRT:
+	case IBCMD:
+		rw->completed_transfer_count = rw->requested_transfer_count;
+		return 0;
+	case IBRDV:
+		rwv->completed_transfer_count = fake_iovec_length(rwv);
+		rwv->end = 1;
+		rwv->end_segment = rwv->iov_count ? rwv->iov_count - 1 : 0;
+		rwv->end_offset = rwv->iov_count ?
+			((struct gpib_iovec *)(uintptr_t)rwv->iov_ptr)[rwv->end_segment].len : 0;
+		return 0;
+	case IBWRTV:
+		rwv->completed_transfer_count = fake_iovec_length(rwv);
+		return 0;
+	case IBWAIT:
+		fake_wait(arg);
+		return 0;
+	case IBOPENDEV:
+		open_dev->handle = __atomic_fetch_add(&next_handle, 1, __ATOMIC_RELAXED);
+		return 0;
+	case IBBOARD_INFO:
+		memset(info, 0, sizeof(*info));
+		info->sad = -1;
+		info->is_system_controller = 1;
+		return 0;
+	case IBRSP:
+		((struct gpib_serial_poll_ioctl *)arg)->status_byte = 0;
+		return 0;
+	case IBSPOLL_BYTES:
+		((struct gpib_spoll_bytes_ioctl *)arg)->num_bytes = 0;
+		return 0;
+	case IBEVENT:
+	case IBLINES:
+	case IBPP2_GET:
+		*(short *)arg = 0;
+		return 0;
+	case IBRPP:
+		*(uint8_t *)arg = 0;
+		return 0;
+	case IBQUERY_BOARD_RSV:
+		*(int *)arg = 0;
+		return 0;
+	/* not emulated, the library falls back or reports the error */
+	case IBRDF:
+	case IBWRTF:
+	case IBSTREAM_START:
+	case IBSTREAM_STOP:
+	case IBPROBE_LISTENERS:
+	case IBXFER_ENGINE:
+	case IBRESPONDER_START:
+	case IBRESPONDER_STOP:
+	case IBRESPONDER_QUEUE:
+	case IBRESPONDER_READ:
+		errno = ENOTTY;
+		return -1;
+	default:
+		/* settings and bus management which have nothing to report */
+		return 0;
+	}
+}
+
+int ioctl(int fd, unsigned long request, ...)
+{
+	void *arg;
+	va_list ap;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (fd < 0 || fd >= FAKE_MAX_FDS || fake_fds[fd] == 0)
+		return syscall(SYS_ioctl, fd, request, arg);
+
+	count(&counters.ioctls);
+	return fake_ioctl(request, arg);
+}
@@ -0,0 +1,32 @@
+/***************************************************************************
+                             fake_gpib.h
+                             -------------------
+
+Counters kept by the fake /dev/gpibN of fake_gpib.c.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _FAKE_GPIB_H
+#define _FAKE_GPIB_H
+
+struct fake_gpib_counters
+{
+	unsigned long ioctls;	/* on fake devices */
+	unsigned long opens;	/* of fake devices */
+	unsigned long closes;	/* of fake devices */
+	unsigned long allocs;	/* calls to malloc(), calloc() and realloc() */
+	unsigned long frees;	/* calls to free() with a non-NULL pointer */
+};
+
+/* weak, so a program can tell whether it was started with the fake preloaded */
+extern const struct fake_gpib_counters *fake_gpib_counters(void) __attribute__((weak));
+
+#endif	/* _FAKE_GPIB_H */
@@ -0,0 +1,205 @@
+/***************************************************************************
+                             file_bench.c
+                             -------------------
+
+Times ibwrtf() and ibrdf() with a large file, which the driver streams
+between the file and the bus, against ibwrt() and ibrd() of the same
+amount of data from and into memory, and prints MB/s for each.  It is
+meant to be run on an emulated board (see the "runemu" script), with the
+emulated instrument set to talk messages of the same length.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "gpib/ib.h"
+#include "bench.h"
+
+struct program_options
+{
+	int minor;
+	unsigned int pad;
+	int num_loops;
+	size_t length;
+	const char *path;
+};
+
+static int make_file(const struct program_options *options, const uint8_t *data)
+{
+	FILE *file;
+
+	file = fopen(options->path, "w");
+	if (file == NULL) {
+		perror(options->path);
+		return -1;
+	}
+	if (fwrite(data, 1, options->length, file) != options->length) {
+		perror(options->path);
+		fclose(file);
+		return -1;
+	}
+	return fclose(file);
+}
+
+static int bench(const struct program_options *options)
+{
+	uint8_t *data;
+	double bytes = options->length * (double)options->num_loops;
+	double wall;
+	size_t i;
+	int ud, loop;
+	int retval = -1;
+
+	data = malloc(options->length);
+	if (data == NULL)
+		return -1;
+	for (i = 0; i < options->length; i++)
+		data[i] = 'A' + i % 26;
+	if (make_file(options, data) < 0)
+		goto out;
+
+	ud = ibdev(options->minor, options->pad, 0, T30s, 1, 0);
+	if (ud < 0) {
+		PRINT_FAILED("ibdev");
+		goto out;
+	}
+
+	wall = now_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (ibwrt(ud, data, options->length) & ERR) {
+			PRINT_FAILED("ibwrt");
+			goto out_onl;
+		}
+	}
+	report_rate("ibwrt", bytes, now_usec() - wall);
+
+	wall = now_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (ibwrtf(ud, options->path) & ERR) {
+			PRINT_FAILED("ibwrtf");
+			goto out_onl;
+		}
+	}
+	report_rate("ibwrtf", bytes, now_usec() - wall);
+
+	wall = now_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (ibrd(ud, data, options->length) & ERR) {
+			PRINT_FAILED("ibrd");
+			goto out_onl;
+		}
+	}
+	report_rate("ibrd", bytes, now_usec() - wall);
+
+	wall = 0;
+	for (loop = 0; loop < options->num_loops; loop++) {
+		double start;
+
+		// ibrdf() appends, so start each read with an empty file
+		if (truncate(options->path, 0) < 0) {
+			perror(options->path);
+			goto out_onl;
+		}
+		start = now_usec();
+		if (ibrdf(ud, options->path) & ERR) {
+			PRINT_FAILED("ibrdf");
+			goto out_onl;
+		}
+		wall += now_usec() - start;
+		if ((size_t)ThreadIbcntl() != options->length)
+			fprintf(stderr, "ibrdf read %li bytes, the instrument should talk %zu\n",
+				ThreadIbcntl(), options->length);
+	}
+	report_rate("ibrdf", bytes, wall);
+	retval = 0;
+
+out_onl:
+	ibonl(ud, 0);
+out:
+	unlink(options->path);
+	free(data);
+	return retval;
+}
+
+static void help(void)
+{
+	printf("file_bench [options] - time ibwrtf() and ibrdf()\n");
+	printf("\t-f, --file PATH\n"
+		"\t\tTemporary file to use (default /tmp/file_bench.dat).\n");
+	printf("\t-l, --length N\n"
+		"\t\tBytes per transfer (default 16 MiB).\n");
+	printf("\t-M, --minor N\n"
+		"\t\tBoard index (default 0).\n");
+	printf("\t-n, --num_loops N\n"
+		"\t\tTransfers timed per test (default 4).\n");
+	printf("\t-p, --pad N\n"
+		"\t\tPrimary address of the device (default 1).\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"file", required_argument, NULL, 'f'},
+		{"help", no_argument, NULL, 'h'},
+		{"length", required_argument, NULL, 'l'},
+		{"minor", required_argument, NULL, 'M'},
+		{"num_loops", required_argument, NULL, 'n'},
+		{"pad", required_argument, NULL, 'p'},
+		{0, 0, 0, 0}
+	};
+	struct program_options opts = {
+		.minor = 0,
+		.pad = 1,
+		.num_loops = 4,
+		.length = 0x1000000,
+		.path = "/tmp/file_bench.dat",
+	};
+	int c;
+
+	while ((c = getopt_long(argc, argv, "f:hl:M:n:p:", options, NULL)) != -1) {
+		switch (c) {
+		case 'f':
+			opts.path = optarg;
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 'l':
+			opts.length = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			opts.minor = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			opts.num_loops = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			opts.pad = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+
+	if (opts.length == 0 || opts.num_loops <= 0 || opts.pad > (unsigned int)gpib_addr_max) {
+		help();
+		return 1;
+	}
+
+	return bench(&opts) ? 1 : 0;
+}
@@ -0,0 +1,276 @@
+/***************************************************************************
+                             lib_bench.c
+                             -------------------
+
+Times the library's own overhead per call for ibwrt(), ibrd(), ibrsp(),
+ibwait(), Send(), Receive() and AllSPoll() over a range of transfer
+sizes.  Run with the fake /dev/gpibN of fake_gpib.c preloaded (see the
+"runfake" script), every transfer completes at once without touching the
+data, so what is left is the library's locking, status bookkeeping and
+ioctls.  The ioctls, opens and closes of the fake device and the
+allocations made per call are printed along with the time.  Without the
+fake it times a real board, and prints only the time.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "gpib/ib.h"
+#include "bench.h"
+#include "fake_gpib.h"
+
+#define MAX_SPOLL_COUNT 30
+
+struct program_options
+{
+	int minor;
+	unsigned int pad;
+	int count;
+	int num_loops;
+	size_t max_length;
+};
+
+struct bench_context
+{
+	const struct program_options *options;
+	int board;
+	int ud;
+	void *buffer;
+	size_t length;
+	Addr4882_t addresses[MAX_SPOLL_COUNT + 1];
+	short results[MAX_SPOLL_COUNT];
+};
+
+struct bench_case
+{
+	const char *name;
+	int sized;	/* whether the transfer size matters */
+	int (*call)(struct bench_context *context);
+};
+
+static int bench_ibwrt(struct bench_context *context)
+{
+	return ibwrt(context->ud, context->buffer, context->length) & ERR;
+}
+
+static int bench_ibrd(struct bench_context *context)
+{
+	return ibrd(context->ud, context->buffer, context->length) & ERR;
+}
+
+static int bench_ibrsp(struct bench_context *context)
+{
+	char status_byte;
+
+	return ibrsp(context->ud, &status_byte) & ERR;
+}
+
+static int bench_ibwait(struct bench_context *context)
+{
+	return ibwait(context->ud, 0) & ERR;
+}
+
+static int bench_send(struct bench_context *context)
+{
+	Send(context->board, context->addresses[0], context->buffer, context->length, NLend);
+	return ThreadIbsta() & ERR;
+}
+
+static int bench_receive(struct bench_context *context)
+{
+	Receive(context->board, context->addresses[0], context->buffer, context->length, STOPend);
+	return ThreadIbsta() & ERR;
+}
+
+static int bench_allspoll(struct bench_context *context)
+{
+	AllSPoll(context->board, context->addresses, context->results);
+	return ThreadIbsta() & ERR;
+}
+
+static const struct bench_case bench_cases[] = {
+	{"ibwrt", 1, bench_ibwrt},
+	{"ibrd", 1, bench_ibrd},
+	{"Send", 1, bench_send},
+	{"Receive", 1, bench_receive},
+	{"ibrsp", 0, bench_ibrsp},
+	{"ibwait", 0, bench_ibwait},
+	{"AllSPoll", 0, bench_allspoll},
+};
+
+static int run_case(const struct bench_case *bench, struct bench_context *context)
+{
+	const struct fake_gpib_counters *counters = NULL;
+	struct fake_gpib_counters before;
+	int num_loops = context->options->num_loops;
+	double wall;
+	int loop;
+
+	if (fake_gpib_counters)
+		counters = fake_gpib_counters();
+
+	// once untimed, so first-call setup doesn't count
+	if (bench->call(context)) {
+		PRINT_FAILED(bench->name);
+		return -1;
+	}
+
+	if (counters)
+		before = *counters;
+	wall = now_nsec();
+	for (loop = 0; loop < num_loops; loop++) {
+		if (bench->call(context)) {
+			PRINT_FAILED(bench->name);
+			return -1;
+		}
+	}
+	wall = now_nsec() - wall;
+
+	printf("%-10s %10zu %12.1f", bench->name, bench->sized ? context->length : 0,
+		wall / num_loops);
+	if (counters)
+		printf(" %10.2f %10.2f %10.2f",
+			(double)(counters->ioctls - before.ioctls) / num_loops,
+			(double)(counters->opens + counters->closes -
+				 before.opens - before.closes) / num_loops,
+			(double)(counters->allocs - before.allocs) / num_loops);
+	printf("\n");
+	return 0;
+}
+
+static int bench(const struct program_options *options)
+{
+	struct bench_context context;
+	unsigned int i;
+	int retval = -1;
+
+	memset(&context, 0, sizeof(context));
+	context.options = options;
+	context.board = options->minor;
+	for (i = 0; i < (unsigned int)options->count; i++)
+		context.addresses[i] = MakeAddr(options->pad + i, 0);
+	context.addresses[i] = NOADDR;
+
+	context.buffer = calloc(1, options->max_length);
+	if (context.buffer == NULL)
+		return -1;
+
+	context.ud = ibdev(options->minor, options->pad, 0, T3s, 1, 0);
+	if (context.ud < 0) {
+		PRINT_FAILED("ibdev");
+		goto out;
+	}
+
+	if (fake_gpib_counters == NULL)
+		fprintf(stderr, "fake_gpib isn't preloaded, timing a real board\n");
+	printf("%-10s %10s %12s", "call", "bytes", "ns/call");
+	if (fake_gpib_counters)
+		printf(" %10s %10s %10s", "ioctls", "open+close", "allocs");
+	printf("\n");
+
+	for (i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+		const struct bench_case *bench = &bench_cases[i];
+
+		if (bench->sized == 0) {
+			context.length = 0;
+			if (run_case(bench, &context) < 0)
+				goto out_onl;
+			continue;
+		}
+		for (context.length = 1; context.length <= options->max_length; context.length *= 16) {
+			if (run_case(bench, &context) < 0)
+				goto out_onl;
+		}
+	}
+	retval = 0;
+
+out_onl:
+	ibonl(context.ud, 0);
+out:
+	free(context.buffer);
+	return retval;
+}
+
+static void help(void)
+{
+	printf("lib_bench [options] - time libgpib's overhead per call\n");
+	printf("\t-c, --count N\n"
+		"\t\tDevices serial polled by AllSPoll(), at consecutive addresses (default 4).\n");
+	printf("\t-l, --length N\n"
+		"\t\tLargest transfer, sizes go up by 16 times from 1 (default 1 MiB).\n");
+	printf("\t-M, --minor N\n"
+		"\t\tBoard index (default 0).\n");
+	printf("\t-n, --num_loops N\n"
+		"\t\tCalls timed per test (default 100000).\n");
+	printf("\t-p, --pad N\n"
+		"\t\tPrimary address of the first device (default 1).\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"count", required_argument, NULL, 'c'},
+		{"help", no_argument, NULL, 'h'},
+		{"length", required_argument, NULL, 'l'},
+		{"minor", required_argument, NULL, 'M'},
+		{"num_loops", required_argument, NULL, 'n'},
+		{"pad", required_argument, NULL, 'p'},
+		{0, 0, 0, 0}
+	};
+	struct program_options opts = {
+		.minor = 0,
+		.pad = 1,
+		.count = 4,
+		.num_loops = 100000,
+		.max_length = 0x100000,
+	};
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:hl:M:n:p:", options, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			opts.count = strtol(optarg, NULL, 0);
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 'l':
+			opts.max_length = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			opts.minor = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			opts.num_loops = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			opts.pad = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+
+	if (opts.max_length == 0 || opts.num_loops <= 0 || opts.count <= 0 ||
+	    opts.count > MAX_SPOLL_COUNT ||
+	    opts.pad + opts.count - 1 > (unsigned int)gpib_addr_max) {
+		help();
+		return 1;
+	}
+
+	return bench(&opts) ? 1 : 0;
+}
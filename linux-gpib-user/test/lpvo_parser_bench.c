@@ -0,0 +1,272 @@
+/***************************************************************************
+                             lpvo_parser_bench.c
+                             -------------------
+
+Times the read reply parser of the lpvo_usb_gpib kernel driver
+(lpvo_read_parser.h) in user space.  It is fed either adapter output
+recorded to files, one <DLE><STX> ... <DLE><ETX><ACK> reply per file with
+the ftdi status bytes already stripped, or replies generated here with a
+given share of escaped <DLE> bytes.  Replies are handed over in blocks of
+the size the driver's bulk reads return.  Generated replies are also
+checked to come out as they went in.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+/* what lpvo_read_parser.h takes from the kernel */
+typedef uint8_t u8;
+struct device {
+	const char *name;
+};
+#define dev_err(dev, fmt, ...) fprintf(stderr, "%s: " fmt, (dev)->name, ##__VA_ARGS__)
+#define dev_dbg(dev, fmt, ...) do { } while (0)
+
+#include "lpvo_read_parser.h"
+
+struct program_options
+{
+	int num_loops;
+	size_t length;
+	size_t block_size;
+	unsigned int dle_percent;
+	u8 eos;
+};
+
+struct reply
+{
+	const char *name;
+	u8 *stream;	/* what the adapter sends */
+	size_t stream_length;
+	u8 *data;	/* what it carries, NULL if not known */
+	size_t data_length;
+};
+
+static struct device bench_device = { "lpvo_parser_bench" };
+
+static int generate_reply(struct reply *reply, const struct program_options *options)
+{
+	size_t i, n = 0;
+
+	reply->name = "generated";
+	reply->data_length = options->length;
+	reply->data = malloc(options->length);
+	reply->stream = malloc(2 * options->length + 5);
+	if (reply->data == NULL || reply->stream == NULL)
+		return -1;
+
+	reply->stream[n++] = DLE;
+	reply->stream[n++] = STX;
+	for (i = 0; i < options->length; i++) {
+		u8 c;
+
+		if ((unsigned int)(rand() % 100) < options->dle_percent)
+			c = DLE;
+		else
+			c = 0x20 + rand() % 0x5f;	/* printable, so never DLE */
+		/* a generated reply always runs to its end */
+		if (c == options->eos)
+			c = c == 'x' ? 'y' : 'x';
+		reply->data[i] = c;
+		if (c == DLE)
+			reply->stream[n++] = DLE;
+		reply->stream[n++] = c;
+	}
+	reply->stream[n++] = DLE;
+	reply->stream[n++] = ETX;
+	reply->stream[n++] = ACK;
+	reply->stream_length = n;
+	return 0;
+}
+
+static int load_reply(struct reply *reply, const char *path)
+{
+	FILE *file;
+	long length;
+
+	reply->name = path;
+	reply->data = NULL;
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+	if (fseek(file, 0, SEEK_END) < 0 || (length = ftell(file)) < 0 ||
+	    fseek(file, 0, SEEK_SET) < 0) {
+		perror(path);
+		fclose(file);
+		return -1;
+	}
+	reply->stream_length = length;
+	reply->stream = malloc(length ? length : 1);
+	if (reply->stream == NULL ||
+	    fread(reply->stream, 1, length, file) != (size_t)length) {
+		fprintf(stderr, "%s: failed to read\n", path);
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+	/* the decoded length is at most the stream length */
+	reply->data_length = length;
+	return 0;
+}
+
+/* parse one reply as usb_gpib_read() does; returns the feed status */
+static int parse_reply(const struct reply *reply, const struct program_options *options,
+		       u8 *buffer, size_t length, struct read_parser *parser)
+{
+	size_t offset = 0;
+	int retval = 0;
+
+	read_parser_init(parser, buffer, length, options->eos);
+	while (retval == 0 && offset < reply->stream_length) {
+		size_t n = reply->stream_length - offset;
+
+		if (n > options->block_size)
+			n = options->block_size;
+		retval = read_parser_feed(&bench_device, parser, reply->stream + offset, n);
+		offset += n;
+	}
+	return retval;
+}
+
+static int bench_reply(const struct reply *reply, const struct program_options *options)
+{
+	struct read_parser parser;
+	u8 *buffer;
+	double wall;
+	int loop;
+	int retval;
+
+	buffer = malloc(reply->data_length ? reply->data_length : 1);
+	if (buffer == NULL)
+		return -1;
+
+	retval = parse_reply(reply, options, buffer, reply->data_length, &parser);
+	if (retval != 1) {
+		fprintf(stderr, "%s: %s\n", reply->name,
+			retval ? strerror(-retval) : "reply ends without <DLE><ETX><ACK>");
+		free(buffer);
+		return -1;
+	}
+	if (reply->data && (parser.count != reply->data_length ||
+			    memcmp(buffer, reply->data, parser.count))) {
+		fprintf(stderr, "%s: parsed data differs from what was sent\n", reply->name);
+		free(buffer);
+		return -1;
+	}
+
+	wall = now_nsec();
+	for (loop = 0; loop < options->num_loops; loop++)
+		parse_reply(reply, options, buffer, reply->data_length, &parser);
+	wall = now_nsec() - wall;
+
+	printf("%-24s %10zu %10zu %12.1f %10.1f\n", reply->name, reply->stream_length,
+	       parser.count, wall / options->num_loops,
+	       reply->stream_length * (double)options->num_loops / wall * 1e3);
+	free(buffer);
+	return 0;
+}
+
+static void help(void)
+{
+	printf("lpvo_parser_bench [options] [FILE...] - time the lpvo_usb_gpib read parser\n");
+	printf("\tEach FILE holds one recorded reply, without the ftdi status bytes.\n"
+	       "\tWithout files a reply is generated.\n");
+	printf("\t-b, --block N\n"
+	       "\t\tBytes handed to the parser at a time (default 4094).\n");
+	printf("\t-d, --dle N\n"
+	       "\t\tPercentage of generated data bytes which are <DLE> (default 1).\n");
+	printf("\t-e, --eos N\n"
+	       "\t\tEnd of string byte, the driver always stops reading at it (default 0).\n");
+	printf("\t-l, --length N\n"
+	       "\t\tData bytes of the generated reply (default 65536).\n");
+	printf("\t-n, --num_loops N\n"
+	       "\t\tTimes each reply is parsed (default 1000).\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"block", required_argument, NULL, 'b'},
+		{"dle", required_argument, NULL, 'd'},
+		{"eos", required_argument, NULL, 'e'},
+		{"help", no_argument, NULL, 'h'},
+		{"length", required_argument, NULL, 'l'},
+		{"num_loops", required_argument, NULL, 'n'},
+		{0, 0, 0, 0}
+	};
+	struct program_options opts = {
+		.num_loops = 1000,
+		.length = 0x10000,
+		.block_size = 4094,
+		.dle_percent = 1,
+		.eos = 0,
+	};
+	struct reply reply;
+	int retval = 0;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "b:d:e:hl:n:", options, NULL)) != -1) {
+		switch (c) {
+		case 'b':
+			opts.block_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			opts.dle_percent = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			opts.eos = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 'l':
+			opts.length = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			opts.num_loops = strtol(optarg, NULL, 0);
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+	if (opts.block_size == 0 || opts.num_loops <= 0 || opts.dle_percent > 100) {
+		help();
+		return 1;
+	}
+
+	printf("%-24s %10s %10s %12s %10s\n", "reply", "stream", "data", "ns/reply", "MB/s");
+	if (optind == argc) {
+		if (generate_reply(&reply, &opts) < 0)
+			return 1;
+		retval = bench_reply(&reply, &opts);
+		free(reply.stream);
+		free(reply.data);
+		return retval ? 1 : 0;
+	}
+	for (; optind < argc; optind++) {
+		if (load_reply(&reply, argv[optind]) < 0 || bench_reply(&reply, &opts) < 0)
+			retval = -1;
+		free(reply.stream);
+	}
+	return retval ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+/***************************************************************************
+                             query_bench.c
+                             -------------------
+
+Times a round of queries to several devices done with one ibwrt() and
+ibrd() per device against the same round done with one ibquerylist()
+call.  It is meant to be run on an emulated board (see the "runemu"
+script) where the gpib_emu instrument answers at consecutive primary
+addresses, but works with any devices that reply to the query.
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "gpib/ib.h"
+#include "bench.h"
+
+#define REPLY_SIZE 0x100
+
+struct program_options
+{
+	int minor;
+	unsigned int pad;
+	int count;
+	int num_loops;
+	int trigger;
+	const char *query;
+};
+
+static void report(const char *what, double wall, double cpu, const struct program_options *options)
+{
+	double rounds = options->num_loops;
+
+	report_per_unit(what, wall, cpu, rounds, "round");
+	printf(" %8.1f us/query\n", wall / rounds / options->count);
+}
+
+static int naive_round(const struct program_options *options, const int *uds, char (*replies)[REPLY_SIZE])
+{
+	size_t length = strlen(options->query);
+	int i;
+
+	for (i = 0; i < options->count; i++) {
+		if (ibwrt(uds[i], options->query, length) & ERR) {
+			PRINT_FAILED("ibwrt");
+			return -1;
+		}
+	}
+	if (options->trigger) {
+		for (i = 0; i < options->count; i++) {
+			if (ibtrg(uds[i]) & ERR) {
+				PRINT_FAILED("ibtrg");
+				return -1;
+			}
+		}
+	}
+	for (i = 0; i < options->count; i++) {
+		if (ibrd(uds[i], replies[i], REPLY_SIZE) & ERR) {
+			PRINT_FAILED("ibrd");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int batch_round(const struct program_options *options, struct gpib_query *queries)
+{
+	int i;
+
+	if (ibquerylist(queries, options->count, options->trigger ? GPIB_QUERY_TRIGGER : 0) & ERR) {
+		PRINT_FAILED("ibquerylist");
+		for (i = 0; i < options->count; i++) {
+			if (queries[i].status & ERR)
+				fprintf(stderr, "\tentry %i: ibsta 0x%x, iberr %i\n",
+					i, queries[i].status, queries[i].error);
+		}
+		return -1;
+	}
+	return 0;
+}
+
+static int bench(const struct program_options *options)
+{
+	struct gpib_query *queries;
+	char (*replies)[REPLY_SIZE];
+	int *uds;
+	double wall, cpu;
+	int i, loop;
+	int retval = -1;
+
+	uds = calloc(options->count, sizeof(*uds));
+	queries = calloc(options->count, sizeof(*queries));
+	replies = calloc(options->count, sizeof(*replies));
+	if (uds == NULL || queries == NULL || replies == NULL)
+		goto out;
+
+	for (i = 0; i < options->count; i++)
+		uds[i] = -1;
+	for (i = 0; i < options->count; i++) {
+		uds[i] = ibdev(options->minor, options->pad + i, 0, T3s, 1, 0);
+		if (uds[i] < 0) {
+			PRINT_FAILED("ibdev");
+			goto out_onl;
+		}
+		queries[i].ud = uds[i];
+		queries[i].command = options->query;
+		queries[i].command_length = strlen(options->query);
+		queries[i].reply = replies[i];
+		queries[i].reply_size = REPLY_SIZE;
+	}
+
+	// once each to warm up and check the devices answer
+	if (naive_round(options, uds, replies) < 0 || batch_round(options, queries) < 0)
+		goto out_onl;
+
+	wall = now_usec();
+	cpu = cpu_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (naive_round(options, uds, replies) < 0)
+			goto out_onl;
+	}
+	report("ibwrt/ibrd", now_usec() - wall, cpu_usec() - cpu, options);
+
+	wall = now_usec();
+	cpu = cpu_usec();
+	for (loop = 0; loop < options->num_loops; loop++) {
+		if (batch_round(options, queries) < 0)
+			goto out_onl;
+	}
+	report("querylist", now_usec() - wall, cpu_usec() - cpu, options);
+	retval = 0;
+
+out_onl:
+	for (i = 0; i < options->count; i++) {
+		if (uds[i] >= 0)
+			ibonl(uds[i], 0);
+	}
+out:
+	free(uds);
+	free(queries);
+	free(replies);
+	return retval;
+}
+
+static void help(void)
+{
+	printf("query_bench [options] - time queries to several devices\n");
+	printf("\t-c, --count N\n"
+		"\t\tNumber of devices, at consecutive primary addresses (default 12).\n");
+	printf("\t-M, --minor N\n"
+		"\t\tBoard index (default 0).\n");
+	printf("\t-n, --num_loops N\n"
+		"\t\tRounds of queries timed per test (default 100).\n");
+	printf("\t-p, --pad N\n"
+		"\t\tPrimary address of the first device (default 1).\n");
+	printf("\t-q, --query STRING\n"
+		"\t\tQuery sent to each device (default \"MEAS?\\n\").\n");
+	printf("\t-t, --trigger\n"
+		"\t\tTrigger the devices between the queries and the replies.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{"count", required_argument, NULL, 'c'},
+		{"help", no_argument, NULL, 'h'},
+		{"minor", required_argument, NULL, 'M'},
+		{"num_loops", required_argument, NULL, 'n'},
+		{"pad", required_argument, NULL, 'p'},
+		{"query", required_argument, NULL, 'q'},
+		{"trigger", no_argument, NULL, 't'},
+		{0, 0, 0, 0}
+	};
+	struct program_options opts = {
+		.minor = 0,
+		.pad = 1,
+		.count = 12,
+		.num_loops = 100,
+		.query = "MEAS?\n",
+	};
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:hM:n:p:q:t", options, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			opts.count = strtol(optarg, NULL, 0);
+			break;
+		case 'h':
+			help();
+			return 0;
+		case 'M':
+			opts.minor = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			opts.num_loops = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			opts.pad = strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			opts.query = optarg;
+			break;
+		case 't':
+			opts.trigger = 1;
+			break;
+		default:
+			help();
+			return 1;
+		}
+	}
+
+	if (opts.count <= 0 || opts.num_loops <= 0 ||
+	    opts.pad + opts.count - 1 > (unsigned int)gpib_addr_max) {
+		help();
+		return 1;
+	}
+
+	return bench(&opts) ? 1 : 0;
+}